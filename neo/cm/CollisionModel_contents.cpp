@@ -35,6 +35,7 @@ If you have questions concerning this license or the applicable additional terms
 */
 
 #include "sys/platform.h"
+#include "framework/Profiler.h"
 
 #include "cm/CollisionModel_local.h"
 
@@ -626,6 +627,7 @@ int idCollisionModelManagerLocal::Contents( const idVec3 &start,
 									const idTraceModel *trm, const idMat3 &trmAxis, int contentMask,
 									cmHandle_t model, const idVec3 &modelOrigin, const idMat3 &modelAxis ) {
 	trace_t results;
+	PROFILE_SCOPE( "CM_Contents" );
 
 	if ( model < 0 || model > idCollisionModelManagerLocal::maxModels || model > MAX_SUBMODELS ) {
 		common->Printf("idCollisionModelManagerLocal::Contents: invalid model handle\n");
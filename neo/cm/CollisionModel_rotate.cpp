@@ -35,6 +35,7 @@ If you have questions concerning this license or the applicable additional terms
 */
 
 #include "sys/platform.h"
+#include "framework/Profiler.h"
 
 #include "cm/CollisionModel_local.h"
 
@@ -1615,6 +1616,7 @@ void idCollisionModelManagerLocal::Rotation( trace_t *results, const idVec3 &sta
 										cmHandle_t model, const idVec3 &modelOrigin, const idMat3 &modelAxis ) {
 	idVec3 tmp;
 	float maxa, stepa, a, lasta;
+	PROFILE_SCOPE( "CM_Rotation" );
 
 	assert( ((byte *)&start) < ((byte *)results) || ((byte *)&start) > (((byte *)results) + sizeof( trace_t )) );
 	assert( ((byte *)&trmAxis) < ((byte *)results) || ((byte *)&trmAxis) > (((byte *)results) + sizeof( trace_t )) );
@@ -37,6 +37,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "sys/platform.h"
 #include "framework/Session.h"
 #include "renderer/RenderWorld.h"
+#include "framework/Profiler.h"
 
 #include "cm/CollisionModel_local.h"
 
@@ -773,6 +774,7 @@ void idCollisionModelManagerLocal::Translation( trace_t *results, const idVec3 &
 	cm_trmEdge_t *edge;
 	cm_trmVertex_t *vert;
 	ALIGN16( static cm_traceWork_t tw );
+	PROFILE_SCOPE( "CM_Translation" );
 
 	assert( ((byte *)&start) < ((byte *)results) || ((byte *)&start) >= (((byte *)results) + sizeof( trace_t )) );
 	assert( ((byte *)&end) < ((byte *)results) || ((byte *)&end) >= (((byte *)results) + sizeof( trace_t )) );
@@ -42,6 +42,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "framework/Game.h"
 #include "framework/KeyInput.h"
 #include "framework/EventLoop.h"
+#include "framework/Profiler.h"
 #include "renderer/Image.h"
 #include "renderer/Model.h"
 #include "renderer/ModelManager.h"
@@ -1433,7 +1434,7 @@ void Com_ReloadEngine_f(const idCmdArgs& args) {
   }
   commonLocal.ShutdownGame(true);
   commonLocal.InitGame();
-  if ( !menu /*&& !idAsyncNetwork::serverDedicated.GetBool()*/) {
+  if ( !menu && !idAsyncNetwork::serverDedicated.GetBool()) {
     Sys_ShowConsole(0, false);
   }
   common->Printf("============= ReloadEngine end ===============\n");
@@ -2127,6 +2128,9 @@ void idCommonLocal::Frame(void) {
   try {
 #endif
 
+  // close the previous profile frame and start a new one
+  profiler->Frame();
+
   // pump all the events
   Sys_GenerateEvents();
 
@@ -2142,11 +2146,17 @@ void idCommonLocal::Frame(void) {
   }
 #endif
 
-  eventLoop->RunEventLoop();               // EMTERPRETIFY function (might yields)
+  {
+    PROFILE_SCOPE("EventLoop");
+    eventLoop->RunEventLoop();               // EMTERPRETIFY function (might yields)
+  }
 
 #ifdef NOMT
+  {
+    PROFILE_SCOPE("Async");
     // In single threaded mode, manually call the async timer update code at each frame
     common->Async();
+  }
 
     // D3WASM: Disable background download thread for now (not really used)
     //fileSystem->RunThread();
@@ -2157,13 +2167,17 @@ void idCommonLocal::Frame(void) {
   idAsyncNetwork::RunFrame();
 
   if ( idAsyncNetwork::IsActive()) {
-    //if (idAsyncNetwork::serverDedicated.GetInteger() != 1) {
-    session->GuiFrameEvents();            // EMTERPRETIFY function (might yields)
-    session->UpdateScreen(false);
-    //}
+    if (idAsyncNetwork::serverDedicated.GetInteger() != 1) {
+      session->GuiFrameEvents();            // EMTERPRETIFY function (might yields)
+      session->UpdateScreen(false);
+    }
   }
   else {
-    session->Frame();                     // EMTERPRETIFY function (might yields)
+    {
+      PROFILE_SCOPE("Session");
+      session->Frame();                     // EMTERPRETIFY function (might yields)
+    }
+    PROFILE_SCOPE("UpdateScreen");
     session->UpdateScreen(false);
   }
 
@@ -2411,6 +2425,7 @@ gameImport.uiManager				= ::uiManager;
 gameImport.declManager				= ::declManager;
 gameImport.AASFileManager			= ::AASFileManager;
 gameImport.collisionModelManager	= ::collisionModelManager;
+gameImport.profiler					= ::profiler;
 
 gameExport							= *GetGameAPI( &gameImport );
 
@@ -2446,6 +2461,9 @@ void idCommonLocal::UnloadGameDLL(void) {
 
 #ifdef __DOOM_DLL__
 
+  // zone names recorded by the game point into the DLL
+  profiler->Clear();
+
   if ( gameDLL ) {
 Sys_DLL_Unload( gameDLL );
 gameDLL = 0;
@@ -2595,6 +2613,9 @@ void idCommonLocal::Init(int argc, char** argv) {
     // init commands
     InitCommands();
 
+    // init the frame profiler commands
+    profiler->Init();
+
 #ifdef ID_WRITE_VERSION
     config_compressor = idCompressor::AllocArithmetic();
 #endif
@@ -2651,7 +2672,7 @@ void idCommonLocal::Shutdown(void) {
   }
 #endif
 
-  //idAsyncNetwork::server.Kill();
+  idAsyncNetwork::server.Kill();
   idAsyncNetwork::client.Shutdown();
 
   // save persistent console history
@@ -2663,6 +2684,9 @@ void idCommonLocal::Shutdown(void) {
   // shut down non-portable system services
   Sys_Shutdown();
 
+  // free the recorded profile frames
+  profiler->Shutdown();
+
   // shut down the console
   console->Shutdown();
 
@@ -2768,6 +2792,13 @@ void idCommonLocal::InitGame(void) {
   // re-override anything from the config files with command line args
   StartupVariable(NULL, false);
 
+#ifdef ID_DEDICATED
+  // the dedicated server never opens a window, a GL context or the sound hardware
+  com_skipRenderer.SetBool(true);
+  cvarSystem->SetCVarBool("s_noSound", true);
+  idAsyncNetwork::serverDedicated.SetInteger(1);
+#endif
+
   // if any archived cvars are modified after this, we will trigger a writing of the config file
   cvarSystem->ClearModifiedFlags(CVAR_ARCHIVE);
 
@@ -2487,6 +2487,436 @@ void idCompressor_LZW::DecompressBlock() {
 	blockSize = Min( writeByte, LZW_BLOCK_SIZE );
 }
 
+/*
+=================================================================================
+
+	idCompressor_LZ
+
+	Byte oriented LZ77 in the style of LZ4.  None of the bit stream compressors
+	above come close in decompression speed, because every literal and match is
+	assembled from individual bits.  Here all fields are whole bytes, literals are
+	copied with memcpy and matches that don't overlap themselves are copied in one
+	go.  The compression ratio is somewhat worse than LZSS.
+
+	The input is split in blocks that are compressed independently:
+
+		int		uncompressed size
+		int		stored size, equal to the uncompressed size if the block was stored
+		byte	data[stored size]
+
+	Each sequence in a block starts with a token byte, the high nibble is the
+	literal count and the low nibble is the match length minus LZ_MIN_MATCH.  A
+	nibble of 15 is followed by extra bytes that are added to it until a byte
+	is not 255.  Then follow the literals, a 16 bit little endian offset and the
+	extra match length bytes.  The last sequence of a block only has literals.
+
+	Matches are found with hash chains on the next four bytes.
+
+=================================================================================
+*/
+
+const int LZ_BLOCK_SIZE			= 128 * 1024;
+const int LZ_HASH_BITS			= 14;
+const int LZ_HASH_SIZE			= ( 1 << LZ_HASH_BITS );
+const int LZ_MAX_OFFSET			= 65535;
+const int LZ_MIN_MATCH			= 4;
+const int LZ_MAX_CHAIN			= 16;
+const int LZ_MAX_STORED			= LZ_BLOCK_SIZE + LZ_BLOCK_SIZE / 255 + 16;
+
+class idCompressor_LZ : public idCompressor_None {
+public:
+					idCompressor_LZ( void ) {}
+
+	void			Init( idFile *f, bool compress, int wordLength );
+	void			FinishCompress( void );
+	float			GetCompressionRatio( void ) const;
+
+	int				Write( const void *inData, int inLength );
+	int				Read( void *outData, int outLength );
+
+protected:
+	byte			block[LZ_BLOCK_SIZE];
+	int				blockSize;
+	int				blockIndex;
+
+	byte			stored[LZ_MAX_STORED];
+
+	int				hashTable[LZ_HASH_SIZE];
+	int				hashNext[LZ_BLOCK_SIZE];
+
+	int				uncompressedBytes;
+	int				compressedBytes;
+
+protected:
+	void			CompressBlock( void );
+	int				DecompressBlock( byte *out );
+	int				EncodeBlock( const byte *in, int inLength, byte *out );
+	static int		DecodeBlock( const byte *in, int inLength, byte *out, int outLength );
+	static int		Hash( const byte *p );
+	static byte *	WriteLength( byte *out, int length );
+};
+
+/*
+================
+idCompressor_LZ::Init
+================
+*/
+void idCompressor_LZ::Init( idFile *f, bool compress, int wordLength ) {
+	this->file = f;
+	this->compress = compress;
+
+	blockSize = 0;
+	blockIndex = 0;
+
+	uncompressedBytes = 0;
+	compressedBytes = 0;
+}
+
+/*
+================
+idCompressor_LZ::GetCompressionRatio
+================
+*/
+float idCompressor_LZ::GetCompressionRatio( void ) const {
+	if ( !uncompressedBytes ) {
+		return 0.0f;
+	}
+	return ( uncompressedBytes - compressedBytes ) * 100.0f / uncompressedBytes;
+}
+
+/*
+================
+idCompressor_LZ::Hash
+================
+*/
+ID_INLINE int idCompressor_LZ::Hash( const byte *p ) {
+	unsigned int v = p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( (unsigned int)p[3] << 24 );
+	return ( v * 2654435761u ) >> ( 32 - LZ_HASH_BITS );
+}
+
+/*
+================
+idCompressor_LZ::WriteLength
+================
+*/
+ID_INLINE byte *idCompressor_LZ::WriteLength( byte *out, int length ) {
+	while ( length >= 255 ) {
+		*out++ = 255;
+		length -= 255;
+	}
+	*out++ = length;
+	return out;
+}
+
+/*
+================
+idCompressor_LZ::EncodeBlock
+
+Returns the number of bytes written to out, which may be a little more than inLength.
+================
+*/
+int idCompressor_LZ::EncodeBlock( const byte *in, int inLength, byte *out ) {
+	int i, j, n, hash, chain, anchor, literals, bestLength, bestOffset;
+	byte *op, *token;
+
+	const int lastMatch = inLength - LZ_MIN_MATCH;
+
+	memset( hashTable, -1, sizeof( hashTable ) );
+
+	op = out;
+	anchor = 0;
+
+	for ( i = 0; i <= lastMatch; ) {
+		const int maxLength = inLength - i;
+
+		// walk the hash chain for the longest match
+		bestLength = 0;
+		bestOffset = 0;
+		hash = Hash( in + i );
+		for ( j = hashTable[hash], chain = 0; j >= 0 && i - j <= LZ_MAX_OFFSET && chain < LZ_MAX_CHAIN; j = hashNext[j], chain++ ) {
+			if ( in[j + bestLength] != in[i + bestLength] ) {
+				continue;
+			}
+			for ( n = 0; n < maxLength && in[j + n] == in[i + n]; n++ ) {
+			}
+			if ( n > bestLength ) {
+				bestLength = n;
+				bestOffset = i - j;
+				if ( n == maxLength ) {
+					break;
+				}
+			}
+		}
+
+		hashNext[i] = hashTable[hash];
+		hashTable[hash] = i;
+
+		if ( bestLength < LZ_MIN_MATCH ) {
+			i++;
+			continue;
+		}
+
+		// literals since the last match
+		literals = i - anchor;
+		token = op++;
+		*token = ( Min( literals, 15 ) << 4 ) | Min( bestLength - LZ_MIN_MATCH, 15 );
+		if ( literals >= 15 ) {
+			op = WriteLength( op, literals - 15 );
+		}
+		memcpy( op, in + anchor, literals );
+		op += literals;
+
+		// the match
+		*op++ = bestOffset & 255;
+		*op++ = bestOffset >> 8;
+		if ( bestLength - LZ_MIN_MATCH >= 15 ) {
+			op = WriteLength( op, bestLength - LZ_MIN_MATCH - 15 );
+		}
+
+		// add the matched positions to the hash chains
+		for ( n = i + bestLength, i++; i < n; i++ ) {
+			if ( i <= lastMatch ) {
+				hash = Hash( in + i );
+				hashNext[i] = hashTable[hash];
+				hashTable[hash] = i;
+			}
+		}
+		anchor = i;
+	}
+
+	// the remaining literals
+	literals = inLength - anchor;
+	*op++ = Min( literals, 15 ) << 4;
+	if ( literals >= 15 ) {
+		op = WriteLength( op, literals - 15 );
+	}
+	memcpy( op, in + anchor, literals );
+	op += literals;
+
+	return op - out;
+}
+
+/*
+================
+idCompressor_LZ::DecodeBlock
+
+Returns the number of bytes written to out or -1 if the data is corrupt.
+================
+*/
+int idCompressor_LZ::DecodeBlock( const byte *in, int inLength, byte *out, int outLength ) {
+	int token, length, offset, extra;
+
+	const byte *ip = in;
+	const byte *inEnd = in + inLength;
+	byte *op = out;
+	byte *outEnd = out + outLength;
+
+	while ( ip < inEnd ) {
+		token = *ip++;
+
+		// literals
+		length = token >> 4;
+		if ( length == 15 ) {
+			do {
+				if ( ip >= inEnd ) {
+					return -1;
+				}
+				extra = *ip++;
+				length += extra;
+			} while ( extra == 255 );
+		}
+		if ( length > inEnd - ip || length > outEnd - op ) {
+			return -1;
+		}
+		memcpy( op, ip, length );
+		ip += length;
+		op += length;
+
+		// the last sequence doesn't have a match
+		if ( ip >= inEnd ) {
+			break;
+		}
+
+		if ( inEnd - ip < 2 ) {
+			return -1;
+		}
+		offset = ip[0] | ( ip[1] << 8 );
+		ip += 2;
+
+		length = token & 15;
+		if ( length == 15 ) {
+			do {
+				if ( ip >= inEnd ) {
+					return -1;
+				}
+				extra = *ip++;
+				length += extra;
+			} while ( extra == 255 );
+		}
+		length += LZ_MIN_MATCH;
+
+		if ( offset == 0 || offset > op - out || length > outEnd - op ) {
+			return -1;
+		}
+
+		const byte *match = op - offset;
+		if ( offset >= length ) {
+			memcpy( op, match, length );
+			op += length;
+		} else {
+			// the match overlaps itself and repeats the last offset bytes
+			for ( ; length > 0; length-- ) {
+				*op++ = *match++;
+			}
+		}
+	}
+
+	return op - out;
+}
+
+/*
+================
+idCompressor_LZ::CompressBlock
+================
+*/
+void idCompressor_LZ::CompressBlock( void ) {
+	int storedSize;
+
+	storedSize = EncodeBlock( block, blockSize, stored );
+
+	file->WriteInt( blockSize );
+	if ( storedSize < blockSize ) {
+		file->WriteInt( storedSize );
+		file->Write( stored, storedSize );
+	} else {
+		// incompressible
+		storedSize = blockSize;
+		file->WriteInt( storedSize );
+		file->Write( block, storedSize );
+	}
+
+	uncompressedBytes += blockSize;
+	compressedBytes += storedSize + 8;
+
+	blockSize = 0;
+}
+
+/*
+================
+idCompressor_LZ::DecompressBlock
+
+Reads the next block into out, which must hold LZ_BLOCK_SIZE bytes.
+Returns the uncompressed size of the block or 0 at the end of the stream.
+================
+*/
+int idCompressor_LZ::DecompressBlock( byte *out ) {
+	int header[2], size, storedSize;
+
+	if ( file->Read( header, sizeof( header ) ) != sizeof( header ) ) {
+		return 0;
+	}
+	size = LittleInt( header[0] );
+	storedSize = LittleInt( header[1] );
+
+	if ( size <= 0 || size > LZ_BLOCK_SIZE || storedSize <= 0 || storedSize > size ) {
+		common->Warning( "idCompressor_LZ: bad block in %s", GetName() );
+		return 0;
+	}
+
+	if ( storedSize == size ) {
+		if ( file->Read( out, size ) != size ) {
+			return 0;
+		}
+	} else {
+		if ( file->Read( stored, storedSize ) != storedSize ) {
+			return 0;
+		}
+		if ( DecodeBlock( stored, storedSize, out, size ) != size ) {
+			common->Warning( "idCompressor_LZ: bad block in %s", GetName() );
+			return 0;
+		}
+	}
+
+	uncompressedBytes += size;
+	compressedBytes += storedSize + 8;
+
+	return size;
+}
+
+/*
+================
+idCompressor_LZ::Write
+================
+*/
+int idCompressor_LZ::Write( const void *inData, int inLength ) {
+	int i, n;
+
+	if ( compress == false || inLength <= 0 ) {
+		return 0;
+	}
+
+	for ( i = 0; i < inLength; i += n ) {
+		n = Min( LZ_BLOCK_SIZE - blockSize, inLength - i );
+		memcpy( block + blockSize, ((const byte *)inData) + i, n );
+		blockSize += n;
+		if ( blockSize == LZ_BLOCK_SIZE ) {
+			CompressBlock();
+		}
+	}
+
+	return inLength;
+}
+
+/*
+================
+idCompressor_LZ::FinishCompress
+================
+*/
+void idCompressor_LZ::FinishCompress( void ) {
+	if ( compress == false ) {
+		return;
+	}
+	if ( blockSize ) {
+		CompressBlock();
+	}
+}
+
+/*
+================
+idCompressor_LZ::Read
+================
+*/
+int idCompressor_LZ::Read( void *outData, int outLength ) {
+	int i, n;
+
+	if ( compress == true || outLength <= 0 ) {
+		return 0;
+	}
+
+	for ( i = 0; i < outLength; i += n ) {
+		if ( blockIndex < blockSize ) {
+			n = Min( blockSize - blockIndex, outLength - i );
+			memcpy( ((byte *)outData) + i, block + blockIndex, n );
+			blockIndex += n;
+		} else if ( outLength - i >= LZ_BLOCK_SIZE ) {
+			// large reads decompress straight into the destination
+			n = DecompressBlock( ((byte *)outData) + i );
+			if ( !n ) {
+				break;
+			}
+		} else {
+			blockSize = DecompressBlock( block );
+			blockIndex = 0;
+			if ( !blockSize ) {
+				break;
+			}
+			n = 0;
+		}
+	}
+
+	return i;
+}
+
 /*
 =================================================================================
 
@@ -2575,3 +3005,12 @@ idCompressor::AllocLZW
 idCompressor * idCompressor::AllocLZW( void ) {
 	return new idCompressor_LZW();
 }
+
+/*
+================
+idCompressor::AllocLZ
+================
+*/
+idCompressor * idCompressor::AllocLZ( void ) {
+	return new idCompressor_LZ();
+}
@@ -53,6 +53,7 @@ public:
 	static idCompressor *	AllocLZSS( void );
 	static idCompressor *	AllocLZSS_WordAligned( void );
 	static idCompressor *	AllocLZW( void );
+	static idCompressor *	AllocLZ( void );
 
 							// initialization
 	virtual void			Init( idFile *f, bool compress, int wordLength ) = 0;
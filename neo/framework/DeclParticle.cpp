@@ -1127,56 +1127,14 @@ int	idParticleStage::ParticleVerts( particleGen_t *g, idVec3 origin, idDrawVert
 	//
 	// constant rotation
 	//
-	float	angle;
-
-	angle = ( initialAngle ) ? initialAngle : 360 * g->random.RandomFloat();
-
-	float	angleMove = rotationSpeed.Integrate( g->frac, g->random ) * particleLife;
-	// have hald the particles rotate each way
-	if ( g->index & 1 ) {
-		angle += angleMove;
-	} else {
-		angle -= angleMove;
-	}
-
-	angle = angle / 180 * idMath::PI;
-	float c = idMath::Cos16( angle );
-	float s = idMath::Sin16( angle );
+	float	c, s;
+	idVec3	axisLeft, axisUp;
 
-	if ( orientation  == POR_Z ) {
-		// oriented in entity space
-		left[0] = s;
-		left[1] = c;
-		left[2] = 0;
-		up[0] = c;
-		up[1] = -s;
-		up[2] = 0;
-	} else if ( orientation == POR_X ) {
-		// oriented in entity space
-		left[0] = 0;
-		left[1] = c;
-		left[2] = s;
-		up[0] = 0;
-		up[1] = -s;
-		up[2] = c;
-	} else if ( orientation == POR_Y ) {
-		// oriented in entity space
-		left[0] = c;
-		left[1] = 0;
-		left[2] = s;
-		up[0] = -s;
-		up[1] = 0;
-		up[2] = c;
-	} else {
-		// oriented in viewer space
-		idVec3	entityLeft, entityUp;
-
-		g->renderEnt->axis.ProjectVector( g->renderView->viewaxis[1], entityLeft );
-		g->renderEnt->axis.ProjectVector( g->renderView->viewaxis[2], entityUp );
+	ParticleRotation( g, c, s );
+	ParticleQuadAxis( g, axisLeft, axisUp );
 
-		left = entityLeft * c + entityUp * s;
-		up = entityUp * c - entityLeft * s;
-	}
+	left = axisLeft * c + axisUp * s;
+	up = axisUp * c - axisLeft * s;
 
 	left *= width;
 	up *= height;
@@ -1198,23 +1156,7 @@ void idParticleStage::ParticleTexCoords( particleGen_t *g, idDrawVert *verts ) c
 	float	s, width;
 	float	t, height;
 
-	if ( animationFrames > 1 ) {
-		width = 1.0f / animationFrames;
-		float	floatFrame;
-		if ( animationRate ) {
-			// explicit, cycling animation
-			floatFrame = g->age * animationRate;
-		} else {
-			// single animation cycle over the life of the particle
-			floatFrame = g->frac * animationFrames;
-		}
-		int	intFrame = (int)floatFrame;
-		g->animationFrameFrac = floatFrame - intFrame;
-		s = width * intFrame;
-	} else {
-		s = 0.0f;
-		width = 1.0f;
-	}
+	ParticleFrame( g, s, width );
 
 	t = 0.0f;
 	height = 1.0f;
@@ -1238,6 +1180,24 @@ idParticleStage::ParticleColors
 ==================
 */
 void idParticleStage::ParticleColors( particleGen_t *g, idDrawVert *verts ) const {
+	byte	color[4];
+
+	ParticleColor( g, color );
+
+	for ( int i = 0 ; i < 4 ; i++ ) {
+		verts[0].color[i] =
+		verts[1].color[i] =
+		verts[2].color[i] =
+		verts[3].color[i] = color[i];
+	}
+}
+
+/*
+==================
+idParticleStage::ParticleColor
+==================
+*/
+void idParticleStage::ParticleColor( const particleGen_t *g, byte rgba[4] ) const {
 	float	fadeFraction = 1.0f;
 
 	// most particles fade in at the beginning and fade out at the end
@@ -1265,10 +1225,85 @@ void idParticleStage::ParticleColors( particleGen_t *g, idDrawVert *verts ) cons
 		} else if ( icolor > 255 ) {
 			icolor = 255;
 		}
-		verts[0].color[i] =
-		verts[1].color[i] =
-		verts[2].color[i] =
-		verts[3].color[i] = icolor;
+		rgba[i] = icolor;
+	}
+}
+
+/*
+==================
+idParticleStage::ParticleFrame
+
+Texture s and width of the current animation frame.
+==================
+*/
+void idParticleStage::ParticleFrame( particleGen_t *g, float &s, float &width ) const {
+	if ( animationFrames > 1 ) {
+		width = 1.0f / animationFrames;
+		float	floatFrame;
+		if ( animationRate ) {
+			// explicit, cycling animation
+			floatFrame = g->age * animationRate;
+		} else {
+			// single animation cycle over the life of the particle
+			floatFrame = g->frac * animationFrames;
+		}
+		int	intFrame = (int)floatFrame;
+		g->animationFrameFrac = floatFrame - intFrame;
+		s = width * intFrame;
+	} else {
+		s = 0.0f;
+		width = 1.0f;
+	}
+}
+
+/*
+==================
+idParticleStage::ParticleRotation
+==================
+*/
+void idParticleStage::ParticleRotation( particleGen_t *g, float &c, float &s ) const {
+	float	angle;
+
+	angle = ( initialAngle ) ? initialAngle : 360 * g->random.RandomFloat();
+
+	float	angleMove = rotationSpeed.Integrate( g->frac, g->random ) * particleLife;
+	// have half the particles rotate each way
+	if ( g->index & 1 ) {
+		angle += angleMove;
+	} else {
+		angle -= angleMove;
+	}
+
+	angle = angle / 180 * idMath::PI;
+	c = idMath::Cos16( angle );
+	s = idMath::Sin16( angle );
+}
+
+/*
+==================
+idParticleStage::ParticleQuadAxis
+
+The unrotated left and up of the quads in entity space, a quad rotated by
+an angle uses left * c + up * s and up * c - left * s.
+==================
+*/
+void idParticleStage::ParticleQuadAxis( const particleGen_t *g, idVec3 &left, idVec3 &up ) const {
+	if ( orientation == POR_Z ) {
+		// oriented in entity space
+		left.Set( 0.0f, 1.0f, 0.0f );
+		up.Set( 1.0f, 0.0f, 0.0f );
+	} else if ( orientation == POR_X ) {
+		// oriented in entity space
+		left.Set( 0.0f, 1.0f, 0.0f );
+		up.Set( 0.0f, 0.0f, 1.0f );
+	} else if ( orientation == POR_Y ) {
+		// oriented in entity space
+		left.Set( 1.0f, 0.0f, 0.0f );
+		up.Set( 0.0f, 0.0f, 1.0f );
+	} else {
+		// oriented in viewer space
+		g->renderEnt->axis.ProjectVector( g->renderView->viewaxis[1], left );
+		g->renderEnt->axis.ProjectVector( g->renderView->viewaxis[2], up );
 	}
 }
 
@@ -1334,6 +1369,155 @@ int idParticleStage::CreateParticle( particleGen_t *g, idDrawVert *verts ) const
 	return numVerts * 2;
 }
 
+/*
+================
+idParticleStage::IsTimeInvariant
+
+The quad of a particle then only depends on its index and cycle,
+so it can be kept until the particle respawns.
+================
+*/
+bool idParticleStage::IsTimeInvariant( void ) const {
+	if ( customPathType != PPATH_STANDARD || gravity != 0.0f || animationFrames > 1 || entityColor ) {
+		return false;
+	}
+	if ( fadeInFraction > 0.0f || fadeOutFraction > 0.0f ) {
+		return false;
+	}
+	if ( speed.table || speed.from != 0.0f || speed.to != 0.0f ) {
+		return false;
+	}
+	if ( rotationSpeed.table || rotationSpeed.from != 0.0f || rotationSpeed.to != 0.0f ) {
+		return false;
+	}
+	if ( size.table || size.from != size.to || aspect.table || aspect.from != aspect.to ) {
+		return false;
+	}
+	return CanBatch();
+}
+
+/*
+================
+idParticleStage::AddToBatch
+
+Evaluates the particle exactly like CreateParticle and returns the
+number of verts it will create, CreateBatchVerts writes them later.
+================
+*/
+int idParticleStage::AddToBatch( particleGen_t *g, idParticleBatch &batch ) const {
+	idVec3	origin;
+	byte	rgba[4];
+	float	s, width;
+	float	c, sn;
+
+	assert( CanBatch() );
+
+	ParticleColor( g, rgba );
+
+	// if we are completely faded out, kill the particle
+	if ( rgba[0] == 0 && rgba[1] == 0 && rgba[2] == 0 && rgba[3] == 0 ) {
+		return 0;
+	}
+
+	ParticleOrigin( g, origin );
+
+	ParticleFrame( g, s, width );
+
+	float	psize = size.Eval( g->frac, g->random );
+	float	paspect = aspect.Eval( g->frac, g->random );
+
+	ParticleRotation( g, c, sn );
+
+	if ( animationFrames <= 1 ) {
+		batch.AddQuad( origin, c, sn, psize, psize * paspect, s, width, rgba );
+		return 4;
+	}
+
+	// if we are doing strip-animation, we need to double the quad and cross fade it
+	float	frac = g->animationFrameFrac;
+	float	iFrac = 1.0f - frac;
+	byte	faded[4];
+
+	for ( int i = 0 ; i < 4 ; i++ ) {
+		faded[i] = rgba[i] * iFrac;
+	}
+	batch.AddQuad( origin, c, sn, psize, psize * paspect, s, width, faded );
+
+	for ( int i = 0 ; i < 4 ; i++ ) {
+		faded[i] = rgba[i] * frac;
+	}
+	batch.AddQuad( origin, c, sn, psize, psize * paspect, s + width, width, faded );
+
+	return 8;
+}
+
+/*
+================
+idParticleStage::CreateBatchVerts
+================
+*/
+int idParticleStage::CreateBatchVerts( const particleGen_t *g, const idParticleBatch &batch, idDrawVert *verts ) const {
+	idVec3	left, up;
+
+	ParticleQuadAxis( g, left, up );
+	SIMDProcessor->CreateParticleQuads( verts, left, up, batch.GetQuads(), batch.Num() );
+
+	return batch.Num() * 4;
+}
+
+/*
+====================================================================================
+
+idParticleBatch
+
+====================================================================================
+*/
+
+/*
+================
+idParticleBatch::Begin
+================
+*/
+void idParticleBatch::Begin( int maxQuads ) {
+	floats.SetGranularity( 1024 );
+	floats.AssureSize( 9 * maxQuads );
+	colors.SetGranularity( 1024 );
+	colors.AssureSize( maxQuads );
+
+	float *f = floats.Ptr();
+	quads.originX = f + 0 * maxQuads;
+	quads.originY = f + 1 * maxQuads;
+	quads.originZ = f + 2 * maxQuads;
+	quads.cosAngle = f + 3 * maxQuads;
+	quads.sinAngle = f + 4 * maxQuads;
+	quads.width = f + 5 * maxQuads;
+	quads.height = f + 6 * maxQuads;
+	quads.s = f + 7 * maxQuads;
+	quads.sWidth = f + 8 * maxQuads;
+	quads.color = colors.Ptr();
+
+	numQuads = 0;
+}
+
+/*
+================
+idParticleBatch::AddQuad
+================
+*/
+void idParticleBatch::AddQuad( const idVec3 &origin, float c, float s, float width, float height, float st, float stWidth, const byte color[4] ) {
+	quads.originX[numQuads] = origin.x;
+	quads.originY[numQuads] = origin.y;
+	quads.originZ[numQuads] = origin.z;
+	quads.cosAngle[numQuads] = c;
+	quads.sinAngle[numQuads] = s;
+	quads.width[numQuads] = width;
+	quads.height[numQuads] = height;
+	quads.s[numQuads] = st;
+	quads.sWidth[numQuads] = stWidth;
+	memcpy( &quads.color[numQuads], color, 4 );
+	numQuads++;
+}
+
 /*
 ==================
 idParticleStage::GetCustomPathName
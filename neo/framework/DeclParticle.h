@@ -33,6 +33,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "idlib/math/Vector.h"
 #include "idlib/math/Matrix.h"
 #include "idlib/math/Random.h"
+#include "idlib/math/Simd.h"
 #include "idlib/bv/Bounds.h"
 #include "framework/DeclManager.h"
 #include "framework/DeclTable.h"
@@ -106,6 +107,27 @@ typedef struct {
 } particleGen_t;
 
 
+//
+// particles of one stage in structure of arrays form, filled by
+// idParticleStage::AddToBatch and turned into quads all at once
+//
+class idParticleBatch {
+public:
+							idParticleBatch( void ) { numQuads = 0; memset( &quads, 0, sizeof( quads ) ); }
+
+	void					Begin( int maxQuads );
+	void					AddQuad( const idVec3 &origin, float c, float s, float width, float height, float st, float stWidth, const byte color[4] );
+	int						Num( void ) const { return numQuads; }
+	const particleQuads_t &	GetQuads( void ) const { return quads; }
+
+private:
+	int						numQuads;
+	particleQuads_t			quads;
+	idList<float>			floats;
+	idList<dword>			colors;
+};
+
+
 //
 // single particle stage
 //
@@ -124,6 +146,20 @@ public:
 	void					ParticleTexCoords( particleGen_t *g, idDrawVert *verts ) const;
 	void					ParticleColors( particleGen_t *g, idDrawVert *verts ) const;
 
+	void					ParticleColor( const particleGen_t *g, byte color[4] ) const;
+	void					ParticleFrame( particleGen_t *g, float &s, float &width ) const;
+	void					ParticleRotation( particleGen_t *g, float &c, float &s ) const;
+	void					ParticleQuadAxis( const particleGen_t *g, idVec3 &left, idVec3 &up ) const;
+
+	// aimed particles can't be batched, their trails need the origin at earlier times
+	bool					CanBatch( void ) const { return orientation != POR_AIMED; }
+	// particles don't move, fade, rotate or animate during their life
+	bool					IsTimeInvariant( void ) const;
+	// same as CreateParticle, but only adds the quads to the batch
+	int						AddToBatch( particleGen_t *g, idParticleBatch &batch ) const;
+	// writes the verts of all the quads in the batch
+	int						CreateBatchVerts( const particleGen_t *g, const idParticleBatch &batch, idDrawVert *verts ) const;
+
 	const char *			GetCustomPathName();
 	const char *			GetCustomPathDesc();
 	int						NumCustomPathParms();
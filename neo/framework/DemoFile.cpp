@@ -34,10 +34,35 @@ If you have questions concerning this license or the applicable additional terms
 #include "framework/DemoFile.h"
 
 idCVar idDemoFile::com_logDemos( "com_logDemos", "0", CVAR_SYSTEM | CVAR_BOOL, "Write demo.log with debug information in it" );
-idCVar idDemoFile::com_compressDemos( "com_compressDemos", "1", CVAR_SYSTEM | CVAR_INTEGER | CVAR_ARCHIVE, "Compression scheme for demo files\n0: None    (Fast, large files)\n1: LZW     (Fast to compress, Fast to decompress, medium/small files)\n2: LZSS    (Slow to compress, Fast to decompress, small files)\n3: Huffman (Fast to compress, Slow to decompress, medium files)\nSee also: The 'CompressDemo' command" );
+idCVar idDemoFile::com_compressDemos( "com_compressDemos", "4", CVAR_SYSTEM | CVAR_INTEGER | CVAR_ARCHIVE, "Compression scheme for demo files\n0: None    (Fast, large files)\n1: LZW     (Fast to compress, Fast to decompress, medium/small files)\n2: LZSS    (Slow to compress, Fast to decompress, small files)\n3: Huffman (Fast to compress, Slow to decompress, medium files)\n4: LZ      (Fast to compress, Very fast to decompress, medium files)\nSee also: The 'CompressDemo' and 'benchmarkCompressors' commands" );
 idCVar idDemoFile::com_preloadDemos( "com_preloadDemos", "0", CVAR_SYSTEM | CVAR_BOOL | CVAR_ARCHIVE, "Load the whole demo in to RAM before running it" );
+idCVar idDemoFile::com_demoKeyframeInterval( "com_demoKeyframeInterval", "300", CVAR_SYSTEM | CVAR_INTEGER | CVAR_ARCHIVE, "Number of frames between keyframes in recorded demos, 0 writes demos without an index that can't be seeked", 0, 100000 );
 
 #define DEMO_MAGIC GAME_NAME " RDEMO"
+#define DEMO_INDEXED_MAGIC GAME_NAME " IDEMO"
+
+/*
+
+Indexed demos are split in blocks that are compressed independently, each
+block starts with an empty hash string table.
+
+	magic, compression scheme, offset of the index block
+	block*:	int type, int frame, int length, int stored length, stored data
+	index:	int DEMO_BLOCK_INDEX, int numKeyframes, int length, int length,
+			numKeyframes * ( int frame, int offset )
+
+Stream blocks hold the regular demo commands.  Keyframe blocks are written
+between frames and hold everything needed to continue playback from there.
+They are skipped during normal playback.  If the demo wasn't closed the index
+is rebuilt from the block headers.
+
+*/
+
+typedef enum {
+	DEMO_BLOCK_STREAM,
+	DEMO_BLOCK_KEYFRAME,
+	DEMO_BLOCK_INDEX
+} demoBlock_t;
 
 /*
 ================
@@ -51,6 +76,22 @@ idDemoFile::idDemoFile() {
 	fileImage = NULL;
 	compressor = NULL;
 	writing = false;
+
+	indexed = false;
+	compression = 0;
+	keyframeInterval = 0;
+	firstBlockOffset = 0;
+	numFrames = 0;
+
+	blockFile = NULL;
+	blockType = DEMO_BLOCK_STREAM;
+	blockFrame = 0;
+
+	blockData = NULL;
+	blockAlloced = 0;
+	blockLength = 0;
+	blockIndex = 0;
+	readKeyframe = false;
 }
 
 /*
@@ -74,6 +115,7 @@ idCompressor *idDemoFile::AllocCompressor( int type ) {
 	case 1: return idCompressor::AllocLZW();
 	case 2: return idCompressor::AllocLZSS();
 	case 3: return idCompressor::AllocHuffman();
+	case 4: return idCompressor::AllocLZ();
 	}
 }
 
@@ -85,7 +127,6 @@ idDemoFile::OpenForReading
 bool idDemoFile::OpenForReading( const char *fileName ) {
 	static const int magicLen = sizeof(DEMO_MAGIC) / sizeof(DEMO_MAGIC[0]);
 	char magicBuffer[magicLen];
-	int compression;
 	int fileLength;
 
 	Close();
@@ -113,6 +154,11 @@ bool idDemoFile::OpenForReading( const char *fileName ) {
 	f->Read(magicBuffer, magicLen);
 	if ( memcmp(magicBuffer, DEMO_MAGIC, magicLen) == 0 ) {
 		f->ReadInt( compression );
+	} else if ( memcmp(magicBuffer, DEMO_INDEXED_MAGIC, magicLen) == 0 ) {
+		f->ReadInt( compression );
+		indexed = true;
+		ReadIndex();
+		return true;
 	} else {
 		// Ideally we would error out if the magic string isn't there,
 		// but for backwards compatibility we are going to assume it's just an uncompressed demo file
@@ -167,12 +213,30 @@ bool idDemoFile::OpenForWriting( const char *fileName ) {
 	}
 
 	writing = true;
+	compression = com_compressDemos.GetInteger();
+	keyframeInterval = com_demoKeyframeInterval.GetInteger();
+	numFrames = 0;
+
+	if ( keyframeInterval > 0 ) {
+		indexed = true;
+
+		f->Write( DEMO_INDEXED_MAGIC, sizeof( DEMO_INDEXED_MAGIC ) );
+		f->WriteInt( compression );
+		f->WriteInt( 0 );				// index offset, written on close
+		firstBlockOffset = f->Tell();
+
+		blockFile = new idFile_Memory( fileName );
+		blockType = DEMO_BLOCK_STREAM;
+		blockFrame = 0;
+
+		return true;
+	}
 
 	f->Write(DEMO_MAGIC, sizeof(DEMO_MAGIC));
-	f->WriteInt( com_compressDemos.GetInteger() );
+	f->WriteInt( compression );
 	f->Flush();
 
-	compressor = AllocCompressor( com_compressDemos.GetInteger() );
+	compressor = AllocCompressor( compression );
 	compressor->Init( f, true, 8 );
 
 	return true;
@@ -187,6 +251,10 @@ void idDemoFile::Close() {
 	if ( writing && compressor ) {
 		compressor->FinishCompress();
 	}
+	if ( writing && indexed && f ) {
+		WriteBlock();
+		WriteIndex();
+	}
 
 	if ( f ) {
 		fileSystem->CloseFile( f );
@@ -204,10 +272,287 @@ void idDemoFile::Close() {
 		delete compressor;
 		compressor = NULL;
 	}
+	if ( blockFile ) {
+		delete blockFile;
+		blockFile = NULL;
+	}
+	if ( blockData ) {
+		Mem_Free( blockData );
+		blockData = NULL;
+	}
+	blockAlloced = 0;
+	blockLength = 0;
+	blockIndex = 0;
+	readKeyframe = false;
+
+	indexed = false;
+	keyframes.Clear();
 
 	demoStrings.DeleteContents( true );
 }
 
+/*
+================
+idDemoFile::ReadIndex
+================
+*/
+void idDemoFile::ReadIndex( void ) {
+	int indexOffset, header[4], i, num, storedLength;
+	demoKeyframe_t keyframe;
+
+	f->ReadInt( indexOffset );
+	firstBlockOffset = f->Tell();
+
+	keyframes.Clear();
+
+	if ( indexOffset > 0 && f->Seek( indexOffset, FS_SEEK_SET ) == 0
+		&& f->Read( header, sizeof( header ) ) == sizeof( header ) && LittleInt( header[0] ) == DEMO_BLOCK_INDEX ) {
+		num = LittleInt( header[1] );
+		for ( i = 0; i < num; i++ ) {
+			if ( f->ReadInt( keyframe.frame ) != 4 || f->ReadInt( keyframe.offset ) != 4 ) {
+				break;
+			}
+			keyframes.Append( keyframe );
+		}
+	} else {
+		// the demo wasn't closed, rebuild the index from the block headers
+		f->Seek( firstBlockOffset, FS_SEEK_SET );
+		while ( f->Read( header, sizeof( header ) ) == sizeof( header ) ) {
+			if ( LittleInt( header[0] ) == DEMO_BLOCK_INDEX ) {
+				break;
+			}
+			if ( LittleInt( header[0] ) == DEMO_BLOCK_KEYFRAME ) {
+				keyframe.frame = LittleInt( header[1] );
+				keyframe.offset = f->Tell() - sizeof( header );
+				keyframes.Append( keyframe );
+			}
+			storedLength = LittleInt( header[3] );
+			if ( storedLength < 0 || f->Seek( storedLength, FS_SEEK_CUR ) != 0 ) {
+				break;
+			}
+		}
+	}
+
+	f->Seek( firstBlockOffset, FS_SEEK_SET );
+}
+
+/*
+================
+idDemoFile::WriteIndex
+================
+*/
+void idDemoFile::WriteIndex( void ) {
+	int indexOffset = f->Tell();
+
+	f->WriteInt( DEMO_BLOCK_INDEX );
+	f->WriteInt( keyframes.Num() );
+	f->WriteInt( keyframes.Num() * 8 );
+	f->WriteInt( keyframes.Num() * 8 );
+	for ( int i = 0; i < keyframes.Num(); i++ ) {
+		f->WriteInt( keyframes[i].frame );
+		f->WriteInt( keyframes[i].offset );
+	}
+
+	f->Seek( firstBlockOffset - 4, FS_SEEK_SET );
+	f->WriteInt( indexOffset );
+}
+
+/*
+================
+idDemoFile::ReadBlock
+
+Loads the next block that should be played back, returns false at the end of the demo.
+================
+*/
+bool idDemoFile::ReadBlock( void ) {
+	int header[4], type, length, storedLength;
+
+	blockLength = 0;
+	blockIndex = 0;
+
+	while ( f->Read( header, sizeof( header ) ) == sizeof( header ) ) {
+		type = LittleInt( header[0] );
+		length = LittleInt( header[2] );
+		storedLength = LittleInt( header[3] );
+
+		if ( type == DEMO_BLOCK_INDEX ) {
+			break;
+		}
+		if ( length < 0 || storedLength < 0 ) {
+			common->Warning( "idDemoFile: bad block in %s", GetName() );
+			break;
+		}
+
+		// keyframes are only needed to start playback after seeking
+		if ( ( type == DEMO_BLOCK_KEYFRAME && !readKeyframe ) || length == 0 ) {
+			if ( f->Seek( storedLength, FS_SEEK_CUR ) != 0 ) {
+				break;
+			}
+			continue;
+		}
+		readKeyframe = false;
+
+		byte *stored = (byte *)Mem_Alloc( Max( storedLength, 1 ) );
+		if ( f->Read( stored, storedLength ) != storedLength ) {
+			Mem_Free( stored );
+			break;
+		}
+
+		if ( length > blockAlloced ) {
+			Mem_Free( blockData );
+			blockData = (byte *)Mem_Alloc( length );
+			blockAlloced = length;
+		}
+
+		idFile_Memory storedFile( GetName(), (const char *)stored, storedLength );
+		idCompressor *blockCompressor = AllocCompressor( compression );
+		blockCompressor->Init( &storedFile, false, 8 );
+		blockLength = blockCompressor->Read( blockData, length );
+		delete blockCompressor;
+
+		Mem_Free( stored );
+
+		if ( blockLength != length ) {
+			common->Warning( "idDemoFile: truncated block in %s", GetName() );
+			blockLength = 0;
+			break;
+		}
+
+		// every block starts with an empty string table
+		demoStrings.DeleteContents( true );
+
+		return true;
+	}
+
+	return false;
+}
+
+/*
+================
+idDemoFile::WriteBlock
+================
+*/
+void idDemoFile::WriteBlock( void ) {
+	if ( blockFile->Length() ) {
+		idFile_Memory stored( GetName() );
+		stored.SetGranularity( 256 * 1024 );
+
+		idCompressor *blockCompressor = AllocCompressor( compression );
+		blockCompressor->Init( &stored, true, 8 );
+		blockCompressor->Write( blockFile->GetDataPtr(), blockFile->Length() );
+		blockCompressor->FinishCompress();
+		delete blockCompressor;
+
+		f->WriteInt( blockType );
+		f->WriteInt( blockFrame );
+		f->WriteInt( blockFile->Length() );
+		f->WriteInt( stored.Length() );
+		f->Write( stored.GetDataPtr(), stored.Length() );
+
+		blockFile->Clear( false );
+		blockFile->SetGranularity( 256 * 1024 );
+	}
+
+	// every block starts with an empty string table
+	demoStrings.DeleteContents( true );
+}
+
+/*
+================
+idDemoFile::EndFrame
+================
+*/
+void idDemoFile::EndFrame( void ) {
+	numFrames++;
+}
+
+/*
+================
+idDemoFile::NeedsKeyframe
+================
+*/
+bool idDemoFile::NeedsKeyframe( void ) const {
+	if ( !writing || !indexed ) {
+		return false;
+	}
+	int lastKeyframe = keyframes.Num() ? keyframes[keyframes.Num() - 1].frame : 0;
+	return numFrames - lastKeyframe >= keyframeInterval;
+}
+
+/*
+================
+idDemoFile::BeginKeyframe
+
+Everything written until EndKeyframe goes in to the keyframe block.
+================
+*/
+void idDemoFile::BeginKeyframe( void ) {
+	demoKeyframe_t keyframe;
+
+	if ( !writing || !indexed ) {
+		return;
+	}
+
+	WriteBlock();
+
+	keyframe.frame = numFrames;
+	keyframe.offset = f->Tell();
+	keyframes.Append( keyframe );
+
+	blockType = DEMO_BLOCK_KEYFRAME;
+	blockFrame = numFrames;
+}
+
+/*
+================
+idDemoFile::EndKeyframe
+================
+*/
+void idDemoFile::EndKeyframe( void ) {
+	if ( !writing || !indexed ) {
+		return;
+	}
+
+	WriteBlock();
+
+	blockType = DEMO_BLOCK_STREAM;
+}
+
+/*
+================
+idDemoFile::SeekToKeyframe
+
+Positions the demo on the last keyframe at or before the given frame, or on
+the start of the demo if there is none.
+================
+*/
+int idDemoFile::SeekToKeyframe( int frame ) {
+	int i;
+
+	if ( writing || !indexed ) {
+		return -1;
+	}
+
+	for ( i = keyframes.Num() - 1; i >= 0; i-- ) {
+		if ( keyframes[i].frame <= frame ) {
+			break;
+		}
+	}
+
+	blockLength = 0;
+	blockIndex = 0;
+
+	if ( i < 0 ) {
+		f->Seek( firstBlockOffset, FS_SEEK_SET );
+		readKeyframe = false;
+		return 0;
+	}
+
+	f->Seek( keyframes[i].offset, FS_SEEK_SET );
+	readKeyframe = true;
+	return keyframes[i].frame;
+}
+
 /*
 ================
 idDemoFile::ReadHashString
@@ -311,7 +656,24 @@ void idDemoFile::WriteDict( const idDict &dict ) {
  ================
  */
 int idDemoFile::Read( void *buffer, int len ) {
-	int read = compressor->Read( buffer, len );
+	int read;
+
+	if ( indexed ) {
+		for ( read = 0; read < len; ) {
+			if ( blockIndex >= blockLength ) {
+				if ( !ReadBlock() ) {
+					break;
+				}
+				continue;
+			}
+			int n = Min( len - read, blockLength - blockIndex );
+			memcpy( (byte *)buffer + read, blockData + blockIndex, n );
+			blockIndex += n;
+			read += n;
+		}
+	} else {
+		read = compressor->Read( buffer, len );
+	}
 	if ( read == 0 && len >= 4 ) {
 		*(demoSystem_t *)buffer = DS_FINISHED;
 	}
@@ -324,5 +686,8 @@ int idDemoFile::Read( void *buffer, int len ) {
  ================
  */
 int idDemoFile::Write( const void *buffer, int len ) {
+	if ( indexed ) {
+		return blockFile->Write( buffer, len );
+	}
 	return compressor->Write( buffer, len );
 }
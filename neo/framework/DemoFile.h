@@ -49,6 +49,12 @@ typedef enum {
 	DS_VERSION
 } demoSystem_t;
 
+// indexed demos can start playback at any keyframe
+typedef struct {
+	int				frame;				// number of frames before the keyframe
+	int				offset;				// file offset of the keyframe block
+} demoKeyframe_t;
+
 class idDemoFile : public idFile {
 public:
 					idDemoFile();
@@ -72,14 +78,46 @@ public:
 	int				Read( void *buffer, int len );
 	int				Write( const void *buffer, int len );
 
+					// counts the frames written, the same DC_END_FRAME commands playback counts
+	void			EndFrame( void );
+					// keyframes hold the full world state and are only read after seeking
+	bool			NeedsKeyframe( void ) const;
+	void			BeginKeyframe( void );
+	void			EndKeyframe( void );
+					// returns the frame of the keyframe playback continues from, or -1 if the demo isn't indexed
+	int				SeekToKeyframe( int frame );
+	const idList<demoKeyframe_t> &GetKeyframes( void ) const { return keyframes; }
+
 private:
 	static idCompressor *AllocCompressor( int type );
 
+	void			ReadIndex( void );
+	bool			ReadBlock( void );
+	void			WriteBlock( void );
+	void			WriteIndex( void );
+
 	bool			writing;
 	byte *			fileImage;
 	idFile *		f;
 	idCompressor *	compressor;
 
+	bool			indexed;
+	int				compression;
+	int				keyframeInterval;
+	int				firstBlockOffset;
+	int				numFrames;			// frames written
+	idList<demoKeyframe_t>	keyframes;
+
+	idFile_Memory *	blockFile;			// block being written
+	int				blockType;
+	int				blockFrame;
+
+	byte *			blockData;			// block being read
+	int				blockAlloced;
+	int				blockLength;
+	int				blockIndex;
+	bool			readKeyframe;
+
 	idList<idStr*>	demoStrings;
 	idFile *		fLog;
 	bool			log;
@@ -88,6 +126,7 @@ private:
 	static idCVar	com_logDemos;
 	static idCVar	com_compressDemos;
 	static idCVar	com_preloadDemos;
+	static idCVar	com_demoKeyframeInterval;
 };
 
 #endif /* !__DEMOFILE_H__ */
@@ -860,6 +860,26 @@ void idFile_Memory::Clear( bool freeMemory ) {
 	}
 }
 
+/*
+=================
+idFile_Memory::TakeData
+=================
+*/
+void idFile_Memory::TakeData( char *data, int length ) {
+	if ( filePtr && allocated > 0 && maxSize == 0 ) {
+		Mem_Free( filePtr );
+	}
+
+	maxSize = 0;
+	fileSize = length;
+	allocated = length;
+	granularity = 16384;
+
+	mode = ( 1 << FS_READ );
+	filePtr = data;
+	curPtr = data;
+}
+
 /*
 =================
 idFile_Memory::SetData
@@ -1230,6 +1250,51 @@ idFile_InZip
 =================================================================================
 */
 
+// inflate states are kept around for the next file opened from a mapped pak,
+// so opening a deflated entry doesn't allocate the 32k window every time
+#define MAX_POOLED_INFLATE_STREAMS	8
+
+static z_stream *	inflatePool[MAX_POOLED_INFLATE_STREAMS];
+static int			numPooledInflateStreams = 0;
+
+/*
+=================
+AllocInflateStream
+=================
+*/
+static z_stream *AllocInflateStream( void ) {
+	z_stream *s;
+
+	if ( numPooledInflateStreams > 0 ) {
+		s = inflatePool[--numPooledInflateStreams];
+		inflateReset( s );
+		return s;
+	}
+
+	s = new z_stream;
+	memset( s, 0, sizeof( *s ) );
+	// raw deflate data, zip entries have no zlib header
+	if ( inflateInit2( s, -MAX_WBITS ) != Z_OK ) {
+		delete s;
+		return NULL;
+	}
+	return s;
+}
+
+/*
+=================
+FreeInflateStream
+=================
+*/
+static void FreeInflateStream( z_stream *s ) {
+	if ( numPooledInflateStreams < MAX_POOLED_INFLATE_STREAMS ) {
+		inflatePool[numPooledInflateStreams++] = s;
+		return;
+	}
+	inflateEnd( s );
+	delete s;
+}
+
 /*
 =================
 idFile_InZip::idFile_InZip
@@ -1240,6 +1305,10 @@ idFile_InZip::idFile_InZip( void ) {
 	zipFilePos = 0;
 	fileSize = 0;
 	memset( &z, 0, sizeof( z ) );
+	mapped = NULL;
+	mappedSize = 0;
+	mappedPos = 0;
+	stream = NULL;
 }
 
 /*
@@ -1248,10 +1317,70 @@ idFile_InZip::~idFile_InZip
 =================
 */
 idFile_InZip::~idFile_InZip( void ) {
+	if ( mapped ) {
+		if ( stream ) {
+			FreeInflateStream( (z_stream *)stream );
+		}
+		return;
+	}
 	unzCloseCurrentFile( z );
 	unzClose( z );
 }
 
+/*
+=================
+idFile_InZip::OpenMapped
+
+Reads the entry straight from the memory mapped pak instead of through a
+cloned unzip handle.  Stored entries are plain copies out of the mapping,
+deflated ones are inflated from it directly into the buffer passed to Read.
+=================
+*/
+bool idFile_InZip::OpenMapped( const byte *data, int compressedSize, bool deflated ) {
+	mapped = data;
+	mappedSize = compressedSize;
+	mappedPos = 0;
+	if ( !deflated ) {
+		return true;
+	}
+
+	z_stream *s = AllocInflateStream();
+	if ( !s ) {
+		mapped = NULL;
+		return false;
+	}
+	s->next_in = (Bytef *)data;
+	s->avail_in = compressedSize;
+	stream = s;
+	return true;
+}
+
+/*
+=================
+idFile_InZip::InflateMapped
+=================
+*/
+int idFile_InZip::InflateMapped( void *buffer, int len ) {
+	z_stream *s = (z_stream *)stream;
+	int err;
+
+	s->next_out = (Bytef *)buffer;
+	s->avail_out = len;
+	while ( s->avail_out ) {
+		err = inflate( s, Z_SYNC_FLUSH );
+		if ( err == Z_STREAM_END ) {
+			break;
+		}
+		if ( err != Z_OK ) {
+			common->Warning( "idFile_InZip::Read: inflate failed on %s", name.c_str() );
+			break;
+		}
+	}
+	len -= s->avail_out;
+	mappedPos += len;
+	return len;
+}
+
 /*
 =================
 idFile_InZip::Read
@@ -1260,7 +1389,23 @@ Properly handles partial reads
 =================
 */
 int idFile_InZip::Read( void *buffer, int len ) {
-	int l = unzReadCurrentFile( z, buffer, len );
+	int l;
+
+	if ( mapped ) {
+		len = Min( len, fileSize - mappedPos );
+		if ( len <= 0 ) {
+			return 0;
+		}
+		if ( stream ) {
+			l = InflateMapped( buffer, len );
+		} else {
+			memcpy( buffer, mapped + mappedPos, len );
+			mappedPos += len;
+			l = len;
+		}
+	} else {
+		l = unzReadCurrentFile( z, buffer, len );
+	}
 	fileSystem->AddToReadCount( l );
 	return l;
 }
@@ -1299,6 +1444,9 @@ idFile_InZip::Tell
 =================
 */
 int idFile_InZip::Tell( void ) {
+	if ( mapped ) {
+		return mappedPos;
+	}
 	return unztell( z );
 }
 
@@ -1333,6 +1481,40 @@ int idFile_InZip::Seek( long offset, fsOrigin_t origin ) {
 	int res, i;
 	char *buf;
 
+	if ( mapped ) {
+		switch( origin ) {
+			case FS_SEEK_END:	offset = fileSize - offset; break;
+			case FS_SEEK_SET:	break;
+			case FS_SEEK_CUR:	offset += mappedPos; break;
+			default: {
+				common->FatalError( "idFile_InZip::Seek: bad origin for %s\n", name.c_str() );
+				break;
+			}
+		}
+		if ( offset < 0 || offset > fileSize ) {
+			return -1;
+		}
+		if ( !stream ) {
+			mappedPos = offset;
+			return 0;
+		}
+		// deflated data can only be skipped forward, start over for backward seeks
+		if ( offset < mappedPos ) {
+			z_stream *s = (z_stream *)stream;
+			inflateReset( s );
+			s->next_in = (Bytef *)mapped;
+			s->avail_in = mappedSize;
+			mappedPos = 0;
+		}
+		buf = (char *) _alloca16( ZIP_SEEK_BUF_SIZE );
+		while ( mappedPos < offset ) {
+			if ( InflateMapped( buf, Min( (long)ZIP_SEEK_BUF_SIZE, offset - mappedPos ) ) <= 0 ) {
+				return -1;
+			}
+		}
+		return 0;
+	}
+
 	switch( origin ) {
 		case FS_SEEK_END: {
 			offset = fileSize - offset;
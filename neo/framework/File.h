@@ -145,6 +145,8 @@ public:
 	virtual void			Clear( bool freeMemory = true );
 							// set data for reading
 	void					SetData( const char *data, int length );
+							// set data for reading and free it with the file, data must come from Mem_Alloc
+	void					TakeData( char *data, int length );
 							// returns const pointer to the memory buffer
 	const char *			GetDataPtr( void ) const { return filePtr; }
 							// set the file granularity
@@ -237,12 +239,23 @@ public:
 	virtual void			Flush( void );
 	virtual int				Seek( long offset, fsOrigin_t origin );
 
+							// the file data inside the memory mapped pak, only for entries stored without compression
+	const byte *			GetMappedData( void ) const { return ( mapped && !stream ) ? mapped : NULL; }
+
 private:
 	idStr					name;			// name of the file in the pak
 	idStr					fullPath;		// full file path including pak file name
 	ZPOS64_T				zipFilePos;		// zip file info position in pak
 	int						fileSize;		// size of the file
-	void *					z;				// unzip info
+	void *					z;				// unzip info, NULL when reading from a mapped pak
+
+	const byte *			mapped;			// start of the entry in the memory mapped pak
+	int						mappedSize;		// compressed size of the entry
+	int						mappedPos;		// read position in the uncompressed data
+	void *					stream;			// inflate state for deflated entries, from a shared pool
+
+	bool					OpenMapped( const byte *data, int compressedSize, bool deflated );
+	int						InflateMapped( void *buffer, int len );
 };
 
 #endif /* !__FILE_H__ */
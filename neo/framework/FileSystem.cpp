@@ -253,6 +253,11 @@ typedef struct fileInPack_s {
 	idStr				name;						// name of the file
 	ZPOS64_T			pos;						// file info position in zip
 	struct fileInPack_s * next;						// next file in the hash
+	ZPOS64_T			headerPos;					// local header position in the zip
+	int					dataPos;					// data position in the zip, -1 until the local header was read
+	int					method;						// 0 = stored, Z_DEFLATED, -1 = can't be read from the mapping
+	int					compressedSize;
+	int					uncompressedSize;
 } fileInPack_t;
 
 typedef enum {
@@ -281,6 +286,7 @@ typedef struct {
 	bool				isNew;						// for downloaded paks
 	fileInPack_t		*hashTable[FILE_HASH_SIZE];
 	fileInPack_t		*buildBuffer;
+	const byte *		mapped;						// the whole pak mapped read-only, NULL if not mapped
 } pack_t;
 
 typedef struct {
@@ -322,6 +328,41 @@ private:
 	idStr				extension;
 };
 
+// global path index, one slot per normalized relative path
+typedef struct {
+	unsigned int		hash;
+	int					name;				// offset in pathNames, -1 for a free slot
+	int					first;				// first source in search order
+	int					last;
+} pathIndexSlot_t;
+
+// a search path that has the file
+typedef struct {
+	searchpath_t *		search;
+	fileInPack_t *		pakFile;			// NULL for directories
+	int					next;				// next source in search order, -1 at the end
+} pathSource_t;
+
+#define MAX_PREFETCH_THREADS	4
+
+typedef enum {
+	PREFETCH_QUEUED,		// waiting for a worker
+	PREFETCH_LOADING,		// a worker is filling the staging buffer
+	PREFETCH_READY,			// staged, waiting for the level load to open it
+	PREFETCH_DONE			// handed out, cancelled or failed
+} prefetchState_t;
+
+typedef struct {
+	idStr				name;
+	pack_t *			pak;
+	const byte *		source;				// entry data in the memory mapped pak
+	int					compressedSize;
+	bool				deflated;
+	byte *				data;				// staging buffer, 0 terminated
+	int					length;
+	volatile int		state;
+} prefetchFile_t;
+
 #ifdef NOMT
 int BackgroundDownloadThread( void *pexit );
 #endif
@@ -340,6 +381,7 @@ public:
 	virtual void			FreeModList( idModList *modList );
 	virtual idFileList *	ListFiles( const char *relativePath, const char *extension, bool sort = false, bool fullRelativePath = false, const char* gamedir = NULL );
 	virtual idFileList *	ListFilesTree( const char *relativePath, const char *extension, bool sort = false, const char* gamedir = NULL );
+	virtual idFileList *	ListPakFiles( const char *pakName, const char *extension, bool sort = false );
 	virtual void			FreeFileList( idFileList *fileList );
 	virtual const char *	OSPathToRelativePath( const char *OSPath );
 	virtual const char *	RelativePathToOSPath( const char *relativePath, const char *basePath );
@@ -353,6 +395,8 @@ public:
 	virtual	void			ClearPureChecksums( void );
 	virtual int				ReadFile( const char *relativePath, void **buffer, ID_TIME_T *timestamp );
 	virtual void			FreeFile( void *buffer );
+	virtual int				ReadFileView( const char *relativePath, const void **view, ID_TIME_T *timestamp = NULL );
+	virtual void			FreeFileView( const void *view );
 	virtual int				WriteFile( const char *relativePath, const void *buffer, int size, const char *basePath = "fs_savepath" );
 	virtual void			RemoveFile( const char *relativePath );
 	virtual idFile *		OpenFileReadFlags( const char *relativePath, int searchFlags, pack_t **foundInPak = NULL, bool allowCopyFiles = true, const char* gamedir = NULL );
@@ -380,12 +424,16 @@ public:
 	virtual const idDict *	GetMapDecl( int i );
 	virtual void			FindMapScreenshot( const char *path, char *buf, int len );
 	virtual bool			FilenameCompare( const char *s1, const char *s2 ) const;
+	virtual void			BeginLevelLoad( const char *mapName );
+	virtual void			EndLevelLoad( void );
 
 	static void				Dir_f( const idCmdArgs &args );
 	static void				DirTree_f( const idCmdArgs &args );
 	static void				Path_f( const idCmdArgs &args );
 	static void				TouchFile_f( const idCmdArgs &args );
 	static void				TouchFileList_f( const idCmdArgs &args );
+	static void				BenchPaks_f( const idCmdArgs &args );
+	static void				BenchPaths_f( const idCmdArgs &args );
 
 private:
 	friend int				BackgroundDownloadThread( void *pexit );
@@ -412,6 +460,7 @@ private:
 	static idCVar			fs_game_base;
 	static idCVar			fs_caseSensitiveOS;
 	static idCVar			fs_searchAddons;
+	static idCVar			fs_mapPaks;
 
 	backgroundDownload_t *	backgroundDownloads;
 	backgroundDownload_t	defaultBackgroundDownload;
@@ -429,7 +478,38 @@ private:
 
 	int						d3xp;	// 0: didn't check, -1: not installed, 1: installed
 
+	idStr					loadListName;		// recorded file list of the map being loaded, empty outside of a level load
+	idStrList				loadList;			// pak files opened during the level load, in order
+	idHashIndex				loadListHash;
+
+	idList<prefetchFile_t>	prefetchFiles;		// files staged for the level load
+	idHashIndex				prefetchHash;
+	int						prefetchNext;		// next file for the workers to claim
+	int						prefetchBytes;
+	int						prefetchWorkerUsec;	// time spent reading and inflating
+	int						prefetchStartTime;
+	int						prefetchHits;		// staged before the load asked for it
+	int						prefetchLate;		// the load had to wait for the worker
+	int						prefetchMisses;		// not staged yet, read the normal way
+	bool					prefetchExit;
+	int						numPrefetchThreads;
+	xthreadInfo				prefetchThreads[ MAX_PREFETCH_THREADS ];
+
+	idList<pathIndexSlot_t>	pathIndex;			// open addressed, power of two size
+	idList<pathSource_t>	pathSources;
+	idList<char>			pathNames;			// normalized names, 0 terminated
+	int						pathIndexCount;
+	idStrList				pathsWritten;		// written since the index was built, always searched the long way
+	idHashIndex				pathsWrittenHash;
+
+	static idCVar			fs_pathIndex;
+	static idCVar			fs_prefetch;
+	static idCVar			fs_prefetchThreads;
+	static idCVar			fs_prefetchMB;
+
 private:
+	friend int				PrefetchThread( void *parm );
+
 	void					ReplaceSeparators( idStr &path, char sep = PATHSEPERATOR_CHAR );
 	int						HashFileName( const char *fname ) const;
 	int						ListOSFiles( const char *directory, const char *extension, idStrList &list );
@@ -452,11 +532,23 @@ private:
 	pack_t *				GetPackForChecksum( int checksum, bool searchAddons = false );
 							// searches all the paks, no pure check
 	pack_t *				FindPakForFileChecksum( const char *relativePath, int fileChecksum, bool bReference );
-	idFile_InZip *			ReadFileFromZip( pack_t *pak, fileInPack_t *pakFile, const char *relativePath );
+	idFile_InZip *			ReadFileFromZip( pack_t *pak, fileInPack_t *pakFile, const char *relativePath, bool allowMapped = true );
+	void					ClosePack( pack_t *pak );
 	int						GetFileChecksum( idFile *file );
 	pureStatus_t			GetPackStatus( pack_t *pak );
 	addonInfo_t *			ParseAddonDef( const char *buf, const int len );
 	void					FollowAddonDependencies( pack_t *pak );
+	void					BuildPathIndex( void );
+	void					ClearPathIndex( void );
+	void					AddPathSource( const char *name, searchpath_t *search, fileInPack_t *pakFile );
+	int						FindPathSource( const char *relativePath ) const;
+	searchpath_t *			NextSearchPath( searchpath_t *search, int &source ) const;
+	void					NotePathWritten( const char *relativePath );
+	bool					PathWasWritten( const char *relativePath ) const;
+	void					RecordLoadedFile( const char *relativePath );
+	idFile *				OpenPrefetchedFile( const char *relativePath, int searchFlags, pack_t **foundInPak );
+	void					StopPrefetchThreads( void );
+	void					ClearPrefetch( void );
 
 	static size_t			CurlWriteFunction( void *ptr, size_t size, size_t nmemb, void *stream );
 							// curl_progress_callback in curl.h
@@ -482,6 +574,17 @@ idCVar	idFileSystemLocal::fs_game( "fs_game", "", CVAR_SYSTEM | CVAR_INIT | CVAR
 idCVar  idFileSystemLocal::fs_game_base( "fs_game_base", "", CVAR_SYSTEM | CVAR_INIT | CVAR_SERVERINFO, "alternate mod path, searched after the main fs_game path, before the basedir" );
 idCVar	idFileSystemLocal::fs_caseSensitiveOS( "fs_caseSensitiveOS", "1", CVAR_SYSTEM | CVAR_BOOL, "" );
 idCVar	idFileSystemLocal::fs_searchAddons( "fs_searchAddons", "0", CVAR_SYSTEM | CVAR_BOOL, "search all addon pk4s ( disables addon functionality )" );
+idCVar	idFileSystemLocal::fs_mapPaks( "fs_mapPaks", "1", CVAR_SYSTEM | CVAR_INIT | CVAR_BOOL, "memory map pk4 files and read their entries directly from the mapping" );
+idCVar	idFileSystemLocal::fs_pathIndex( "fs_pathIndex", "1", CVAR_SYSTEM | CVAR_BOOL, "look files up in the path index built at startup instead of probing every search path" );
+#if defined( __EMSCRIPTEN__ ) || defined( NOMT )
+// the paks are already in memory on the web, staging them again only costs heap,
+// and without worker threads the files would all be read before the load starts
+idCVar	idFileSystemLocal::fs_prefetch( "fs_prefetch", "0", CVAR_SYSTEM | CVAR_BOOL, "stage the files recorded during the previous load of a map while it loads" );
+#else
+idCVar	idFileSystemLocal::fs_prefetch( "fs_prefetch", "1", CVAR_SYSTEM | CVAR_BOOL, "stage the files recorded during the previous load of a map while it loads" );
+#endif
+idCVar	idFileSystemLocal::fs_prefetchThreads( "fs_prefetchThreads", "2", CVAR_SYSTEM | CVAR_INTEGER, "number of prefetch worker threads", 1, MAX_PREFETCH_THREADS );
+idCVar	idFileSystemLocal::fs_prefetchMB( "fs_prefetchMB", "192", CVAR_SYSTEM | CVAR_INTEGER, "maximum megabytes of staged prefetch data", 0, 1024 );
 
 idFileSystemLocal	fileSystemLocal;
 idFileSystem *		fileSystem = &fileSystemLocal;
@@ -503,6 +606,17 @@ idFileSystemLocal::idFileSystemLocal( void ) {
 	memset( &backgroundThread, 0, sizeof( backgroundThread ) );
 	backgroundThread_exit = false;
 	addonPaks = NULL;
+	pathIndexCount = 0;
+	prefetchNext = 0;
+	prefetchBytes = 0;
+	prefetchWorkerUsec = 0;
+	prefetchStartTime = 0;
+	prefetchHits = 0;
+	prefetchLate = 0;
+	prefetchMisses = 0;
+	prefetchExit = false;
+	numPrefetchThreads = 0;
+	memset( prefetchThreads, 0, sizeof( prefetchThreads ) );
 }
 
 /*
@@ -1127,6 +1241,78 @@ void idFileSystemLocal::FreeFile( void *buffer ) {
 	Mem_Free( buffer );
 }
 
+/*
+============
+idFileSystemLocal::ReadFileView
+
+Entries stored without compression in a memory mapped pak are returned as a
+pointer into the mapping, without any copy.  Everything else is loaded with
+ReadFile.  The view is read-only and not guaranteed to be nul terminated.
+============
+*/
+int idFileSystemLocal::ReadFileView( const char *relativePath, const void **view, ID_TIME_T *timestamp ) {
+	idFile *	f;
+	pack_t *	pak;
+	int			len;
+
+	if ( !searchPaths ) {
+		common->FatalError( "Filesystem call made without initialization\n" );
+	}
+
+	*view = NULL;
+
+	// configs may come from the journal
+	if ( idStr::CheckExtension( relativePath, ".cfg" ) ) {
+		return ReadFile( relativePath, const_cast<void **>( view ), timestamp );
+	}
+
+	pak = NULL;
+	f = OpenFileReadFlags( relativePath, FSFLAG_SEARCH_DIRS | FSFLAG_SEARCH_PAKS, &pak );
+	if ( f == NULL ) {
+		if ( timestamp ) {
+			*timestamp = FILE_NOT_FOUND_TIMESTAMP;
+		}
+		return -1;
+	}
+
+	if ( pak != NULL && static_cast<idFile_InZip *>( f )->GetMappedData() != NULL ) {
+		len = f->Length();
+		*view = static_cast<idFile_InZip *>( f )->GetMappedData();
+		if ( timestamp ) {
+			*timestamp = f->Timestamp();
+		}
+		AddToReadCount( len );
+		CloseFile( f );
+		loadCount++;
+		loadStack++;
+		return len;
+	}
+
+	CloseFile( f );
+	return ReadFile( relativePath, const_cast<void **>( view ), timestamp );
+}
+
+/*
+=============
+idFileSystemLocal::FreeFileView
+=============
+*/
+void idFileSystemLocal::FreeFileView( const void *view ) {
+	searchpath_t *search;
+
+	if ( !view ) {
+		common->FatalError( "idFileSystemLocal::FreeFileView( NULL )" );
+	}
+	for ( search = searchPaths; search; search = search->next ) {
+		const pack_t *pak = search->pack;
+		if ( pak && pak->mapped && (const byte *)view >= pak->mapped && (const byte *)view < pak->mapped + pak->length ) {
+			loadStack--;
+			return;
+		}
+	}
+	FreeFile( const_cast<void *>( view ) );
+}
+
 /*
 ============
 idFileSystemLocal::WriteFile
@@ -1277,12 +1463,17 @@ pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
 	int				confHash;
 	fileInPack_t	*pakFile;
 
+	const byte *	mapped;
+	ZPOS64_T		headerPos;
+
 	f = OpenOSFile( zipfile, "rb" );
 	if ( !f ) {
 		return NULL;
 	}
 	fseek( f, 0, SEEK_END );
 	len = ftell( f );
+	// map the pak once, files opened from it won't need their own OS handle
+	mapped = fs_mapPaks.GetBool() ? (const byte *)Sys_MapFile( f, len ) : NULL;
 	fclose( f );
 
 	fs_numHeaderLongs = 0;
@@ -1291,6 +1482,7 @@ pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
 	err = unzGetGlobalInfo64( uf, &gi );
 
 	if ( err != UNZ_OK ) {
+		Sys_UnmapFile( mapped, len );
 		return NULL;
 	}
 
@@ -1310,6 +1502,7 @@ pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
 	pack->addon_info = NULL;
 	pack->pureStatus = PURE_UNKNOWN;
 	pack->isNew = false;
+	pack->mapped = mapped;
 
 	pack->length = len;
 
@@ -1329,6 +1522,18 @@ pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
 		buildBuffer[i].name.BackSlashesToSlashes();
 		// store the file position in the zip
 		buildBuffer[i].pos = unzGetOffset64( uf );
+		// remember what is needed to read the entry from the mapping, the local header itself is only read on open
+		buildBuffer[i].dataPos = -1;
+		buildBuffer[i].compressedSize = (int)file_info.compressed_size;
+		buildBuffer[i].uncompressedSize = (int)file_info.uncompressed_size;
+		if ( mapped && ( file_info.compression_method == 0 || file_info.compression_method == Z_DEFLATED ) && !( file_info.flag & 1 )
+				&& unzGetCurrentFileLocalHeader64( uf, &headerPos ) == UNZ_OK ) {
+			buildBuffer[i].headerPos = headerPos;
+			buildBuffer[i].method = file_info.compression_method;
+		} else {
+			buildBuffer[i].headerPos = 0;
+			buildBuffer[i].method = -1;
+		}
 		// add the file to the hash
 		buildBuffer[i].next = pack->hashTable[hash];
 		pack->hashTable[hash] = &buildBuffer[i];
@@ -1340,7 +1545,7 @@ pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
 	confHash = HashFileName(BINARY_CONFIG);
 	for (pakFile = pack->hashTable[confHash]; pakFile; pakFile = pakFile->next) {
 		if (!FilenameCompare(pakFile->name, BINARY_CONFIG)) {
-			unzClose(uf);
+			ClosePack(pack);
 			delete[] buildBuffer;
 			delete pack;
 			Mem_Free( fs_headerLongs );
@@ -1408,6 +1613,7 @@ int idFileSystemLocal::AddZipFile( const char *path ) {
 		last = last->next;
 	}
 	last->next = search;
+	BuildPathIndex();
 	common->Printf( "Appended pk4 %s with checksum 0x%x\n", pak->pakFilename.c_str(), pak->checksum );
 	return pak->checksum;
 }
@@ -1675,6 +1881,56 @@ idFileList *idFileSystemLocal::ListFilesTree( const char *relativePath, const ch
 	return fileList;
 }
 
+/*
+===============
+idFileSystemLocal::ListPakFiles
+===============
+*/
+idFileList *idFileSystemLocal::ListPakFiles( const char *pakName, const char *extension, bool sort ) {
+	searchpath_t *search;
+	idStrList extensionList;
+	idStr name;
+	int i, j;
+
+	if ( !searchPaths ) {
+		common->FatalError( "Filesystem call made without initialization\n" );
+	}
+
+	GetExtensionList( extension, extensionList );
+
+	for ( search = searchPaths; search; search = search->next ) {
+		if ( !search->pack ) {
+			continue;
+		}
+		search->pack->pakFilename.ExtractFileName( name );
+		if ( name.Icmp( pakName ) != 0 ) {
+			continue;
+		}
+
+		idFileList *fileList = new idFileList();
+		fileList->list.SetGranularity( 4096 );
+
+		const pack_t *pak = search->pack;
+		for ( i = 0; i < pak->numfiles; i++ ) {
+			const idStr &file = pak->buildBuffer[i].name;
+			for ( j = 0; j < extensionList.Num(); j++ ) {
+				if ( file.Length() >= extensionList[j].Length() && extensionList[j].Icmp( file.c_str() + file.Length() - extensionList[j].Length() ) == 0 ) {
+					fileList->list.Append( file );
+					break;
+				}
+			}
+		}
+
+		if ( sort ) {
+			idStrListSortPaths( fileList->list );
+		}
+
+		return fileList;
+	}
+
+	return NULL;
+}
+
 /*
 ===============
 idFileSystemLocal::FreeFileList
@@ -2053,6 +2309,124 @@ void idFileSystemLocal::TouchFileList_f( const idCmdArgs &args ) {
 
 }
 
+/*
+================
+idFileSystemLocal::BenchPaks_f
+
+Opens and reads every file of every pak in the search path, once through
+unzip and once from the memory mapped paks, and reports the throughput.
+Needs nothing but the file system, so it runs fine with com_skipRenderer.
+================
+*/
+void idFileSystemLocal::BenchPaks_f( const idCmdArgs &args ) {
+	searchpath_t *	search;
+	fileInPack_t *	pakFile;
+	idList<byte>	buffer;
+	int				pass, i, numFiles, numMapped, start, usec;
+	double			bytes;
+
+	for ( pass = 0; pass < 2; pass++ ) {
+		bool allowMapped = ( pass == 1 );
+
+		numFiles = 0;
+		numMapped = 0;
+		bytes = 0.0;
+		start = Sys_Microseconds();
+
+		for ( search = fileSystemLocal.searchPaths; search; search = search->next ) {
+			pack_t *pak = search->pack;
+			if ( !pak ) {
+				continue;
+			}
+			for ( i = 0; i < pak->numfiles; i++ ) {
+				pakFile = &pak->buildBuffer[i];
+				if ( pakFile->name.Length() && pakFile->name[pakFile->name.Length() - 1] == '/' ) {
+					continue;	// directory entry
+				}
+				idFile_InZip *f = fileSystemLocal.ReadFileFromZip( pak, pakFile, pakFile->name, allowMapped );
+				if ( f->mapped ) {
+					numMapped++;
+				}
+				int len = f->Length();
+				if ( buffer.Num() < len + 1 ) {
+					buffer.SetNum( len + 1 );
+				}
+				bytes += f->Read( buffer.Ptr(), len );
+				fileSystemLocal.CloseFile( f );
+				numFiles++;
+			}
+		}
+
+		usec = Max( 1, (int)( Sys_Microseconds() - start ) );
+		common->Printf( "%-8s %6d files (%d mapped) %8.2f MB in %7.3f s: %9.1f files/s %8.2f MB/s\n",
+			allowMapped ? "mapped" : "unzip", numFiles, numMapped, bytes / ( 1024.0 * 1024.0 ), usec * 0.000001,
+			numFiles * 1000000.0 / usec, bytes / ( 1024.0 * 1024.0 ) * 1000000.0 / usec );
+	}
+}
+
+/*
+================
+idFileSystemLocal::BenchPaths_f
+
+Opens pak files and their .dds variants, which mostly don't exist, in
+three hit/miss mixes, walking the search paths and through the path index.
+================
+*/
+void idFileSystemLocal::BenchPaths_f( const idCmdArgs &args ) {
+	searchpath_t *	search;
+	idStrList		hits, misses;
+	int				i, mix, pass, numLookups, found, usec[2];
+	unsigned int	start;
+	static const int hitPercent[3] = { 100, 50, 0 };
+
+	if ( !fileSystemLocal.pathIndexCount ) {
+		common->Printf( "the path index isn't built, set fs_pathIndex 1 and restart the file system\n" );
+		return;
+	}
+
+	numLookups = ( args.Argc() > 1 ) ? Max( 1, atoi( args.Argv( 1 ) ) ) : 20000;
+
+	for ( search = fileSystemLocal.searchPaths; search && hits.Num() < 4096; search = search->next ) {
+		if ( !search->pack ) {
+			continue;
+		}
+		for ( i = 0; i < search->pack->numfiles && hits.Num() < 4096; i += 7 ) {
+			const idStr &name = search->pack->buildBuffer[i].name;
+			if ( name.Length() && name[name.Length() - 1] != '/' ) {
+				hits.Append( name );
+				idStr variant = "dds/" + name;
+				variant.SetFileExtension( ".dds" );
+				misses.Append( variant );
+			}
+		}
+	}
+	if ( !hits.Num() ) {
+		common->Printf( "no pak files to look up\n" );
+		return;
+	}
+
+	bool indexWasOn = fs_pathIndex.GetBool();
+	for ( mix = 0; mix < 3; mix++ ) {
+		for ( pass = 0; pass < 2; pass++ ) {
+			fs_pathIndex.SetBool( pass == 1 );
+			found = 0;
+			start = Sys_Microseconds();
+			for ( i = 0; i < numLookups; i++ ) {
+				const idStrList &names = ( ( i * 100 / numLookups ) < hitPercent[mix] ) ? hits : misses;
+				idFile *f = fileSystemLocal.OpenFileReadFlags( names[i % names.Num()], FSFLAG_SEARCH_DIRS | FSFLAG_SEARCH_PAKS | FSFLAG_PURE_NOREF, NULL, false );
+				if ( f ) {
+					fileSystemLocal.CloseFile( f );
+					found++;
+				}
+			}
+			usec[pass] = Max( 1, (int)( Sys_Microseconds() - start ) );
+		}
+		common->Printf( "%3d%% hits: %6d lookups, %6d found: walk %10.0f/s, index %10.0f/s, %5.1fx\n", hitPercent[mix], numLookups, found,
+			numLookups * 1000000.0 / usec[0], numLookups * 1000000.0 / usec[1], (float)usec[0] / usec[1] );
+	}
+	fs_pathIndex.SetBool( indexWasOn );
+}
+
 
 /*
 ================
@@ -2349,12 +2723,16 @@ void idFileSystemLocal::Startup( void ) {
 		}
 	}
 
+	BuildPathIndex();
+
 	// add our commands
 	cmdSystem->AddCommand( "dir", Dir_f, CMD_FL_SYSTEM, "lists a folder", idCmdSystem::ArgCompletion_FileName );
 	cmdSystem->AddCommand( "dirtree", DirTree_f, CMD_FL_SYSTEM, "lists a folder with subfolders" );
 	cmdSystem->AddCommand( "path", Path_f, CMD_FL_SYSTEM, "lists search paths" );
 	cmdSystem->AddCommand( "touchFile", TouchFile_f, CMD_FL_SYSTEM, "touches a file" );
 	cmdSystem->AddCommand( "touchFileList", TouchFileList_f, CMD_FL_SYSTEM, "touches a list of files" );
+	cmdSystem->AddCommand( "benchPaks", BenchPaks_f, CMD_FL_SYSTEM, "reads every file in the loaded paks and reports files/s and MB/s" );
+	cmdSystem->AddCommand( "benchPaths", BenchPaths_f, CMD_FL_SYSTEM, "times file lookups with and without the path index" );
 
 	// print the current search paths
 	Path_f( idCmdArgs() );
@@ -2724,6 +3102,9 @@ Frees all resources and closes all files
 void idFileSystemLocal::Shutdown( bool reloading ) {
 	searchpath_t *sp, *next, *loop;
 
+	ClearPrefetch();
+	loadListName.Clear();
+
 	backgroundThread_exit = true;
 #ifdef NOMT
 	// Emscripten: if we do usual code, this will restart the background thread code
@@ -2742,6 +3123,7 @@ void idFileSystemLocal::Shutdown( bool reloading ) {
 	loadedFileFromDir = false;
 
 	ClearDirCache();
+	ClearPathIndex();
 
 	// free everything - loop through searchPaths and addonPaks
 	for ( loop = searchPaths; loop; loop == searchPaths ? loop = addonPaks : loop = NULL ) {
@@ -2749,7 +3131,7 @@ void idFileSystemLocal::Shutdown( bool reloading ) {
 			next = sp->next;
 
 			if ( sp->pack ) {
-				unzClose( sp->pack->handle );
+				ClosePack( sp->pack );
 				delete [] sp->pack->buildBuffer;
 				if ( sp->pack->addon_info ) {
 					sp->pack->addon_info->mapDecls.DeleteContents( true );
@@ -2772,6 +3154,8 @@ void idFileSystemLocal::Shutdown( bool reloading ) {
 	cmdSystem->RemoveCommand( "dir" );
 	cmdSystem->RemoveCommand( "dirtree" );
 	cmdSystem->RemoveCommand( "touchFile" );
+	cmdSystem->RemoveCommand( "benchPaks" );
+	cmdSystem->RemoveCommand( "benchPaths" );
 
 	mapDict.Clear();
 }
@@ -2902,10 +3286,40 @@ pureStatus_t idFileSystemLocal::GetPackStatus( pack_t *pak ) {
 idFileSystemLocal::ReadFileFromZip
 ===========
 */
-idFile_InZip * idFileSystemLocal::ReadFileFromZip( pack_t *pak, fileInPack_t *pakFile, const char *relativePath ) {
+idFile_InZip * idFileSystemLocal::ReadFileFromZip( pack_t *pak, fileInPack_t *pakFile, const char *relativePath, bool allowMapped ) {
 	// relativePath == pakFile->name according to FilenameCompare()
 	// pakFile->Pos is position of that file within the zip
 
+	if ( pak->mapped && allowMapped && pakFile->method >= 0 ) {
+		if ( pakFile->dataPos < 0 ) {
+			// skip the local header, its name and extra field lengths may differ from the central directory
+			const byte *header = pak->mapped + pakFile->headerPos;
+			if ( pakFile->headerPos + 30 <= (ZPOS64_T)pak->length
+					&& header[0] == 'P' && header[1] == 'K' && header[2] == 3 && header[3] == 4 ) {
+				int dataPos = (int)pakFile->headerPos + 30 + ( header[26] | ( header[27] << 8 ) ) + ( header[28] | ( header[29] << 8 ) );
+				if ( dataPos + pakFile->compressedSize <= pak->length ) {
+					pakFile->dataPos = dataPos;
+				}
+			}
+			if ( pakFile->dataPos < 0 ) {
+				common->DPrintf( "%s: bad local header for %s, reading it through unzip\n", pak->pakFilename.c_str(), relativePath );
+				pakFile->method = -1;
+			}
+		}
+		if ( pakFile->dataPos >= 0 ) {
+			idFile_InZip *file = new idFile_InZip();
+			file->z = NULL;
+			file->name = relativePath;
+			file->fullPath = pak->pakFilename + "/" + relativePath;
+			file->zipFilePos = pakFile->pos;
+			file->fileSize = pakFile->uncompressedSize;
+			if ( file->OpenMapped( pak->mapped + pakFile->dataPos, pakFile->compressedSize, pakFile->method == Z_DEFLATED ) ) {
+				return file;
+			}
+			delete file;
+		}
+	}
+
 	// set position in pk4 file to the file (in the zip/pk4) we want a handle on
 	unzSetOffset64( pak->handle, pakFile->pos );
 
@@ -2934,6 +3348,269 @@ idFile_InZip * idFileSystemLocal::ReadFileFromZip( pack_t *pak, fileInPack_t *pa
 	return file;
 }
 
+/*
+===========
+idFileSystemLocal::ClosePack
+===========
+*/
+void idFileSystemLocal::ClosePack( pack_t *pak ) {
+	unzClose( pak->handle );
+	Sys_UnmapFile( pak->mapped, pak->length );
+	pak->mapped = NULL;
+}
+
+/*
+===========
+NormalizePath
+
+Folds a relative path the way FilenameCompare compares it.
+Returns the hash of the folded path, or 0 if it doesn't fit.
+===========
+*/
+static unsigned int NormalizePath( const char *path, char *out, int outSize ) {
+	unsigned int hash = 2166136261u;
+	int i;
+
+	for ( i = 0; path[i]; i++ ) {
+		if ( i >= outSize - 1 ) {
+			return 0;
+		}
+		char c = path[i];
+		if ( c >= 'A' && c <= 'Z' ) {
+			c += 'a' - 'A';
+		} else if ( c == '\\' || c == ':' ) {
+			c = '/';
+		}
+		out[i] = c;
+		hash = ( hash ^ (byte)c ) * 16777619u;
+	}
+	out[i] = '\0';
+	return hash ? hash : 1;
+}
+
+/*
+===========
+idFileSystemLocal::BuildPathIndex
+
+Maps every file of every search path to the list of search paths that have it,
+in search order. Directories are listed once here, files written through the
+file system afterwards are looked up the long way.
+===========
+*/
+void idFileSystemLocal::BuildPathIndex( void ) {
+	searchpath_t *		search;
+	idList<idStrList>	dirFiles;
+	idStrList			subDirs, files;
+	int					i, j, numFiles, size;
+
+	ClearPathIndex();
+
+	if ( !fs_pathIndex.GetBool() ) {
+		return;
+	}
+
+	int start = Sys_Milliseconds();
+
+	// list the directories first to know how big the table has to be
+	numFiles = 0;
+	for ( search = searchPaths; search; search = search->next ) {
+		if ( search->pack ) {
+			numFiles += search->pack->numfiles;
+			continue;
+		}
+		idStrList &list = dirFiles.Alloc();
+		idStr root = BuildOSPath( search->dir->path, search->dir->gamedir, "" );
+		root.StripTrailing( PATHSEPERATOR_CHAR );
+		subDirs.Clear();
+		subDirs.Append( "" );
+		for ( i = 0; i < subDirs.Num(); i++ ) {
+			idStr osDir = root;
+			if ( subDirs[i].Length() ) {
+				osDir += PATHSEPERATOR_STR;
+				osDir += subDirs[i];
+			}
+			Sys_ListFiles( osDir, "", files );
+			for ( j = 0; j < files.Num(); j++ ) {
+				list.Append( subDirs[i].Length() ? subDirs[i] + "/" + files[j] : files[j] );
+			}
+			Sys_ListFiles( osDir, "/", files );
+			for ( j = 0; j < files.Num(); j++ ) {
+				if ( files[j][0] == '.' || subDirs[i].Length() > MAX_OSPATH / 2 ) {
+					continue;
+				}
+				subDirs.Append( subDirs[i].Length() ? subDirs[i] + "/" + files[j] : files[j] );
+			}
+		}
+		numFiles += list.Num();
+	}
+
+	// keep the table at most half full so misses stop early
+	for ( size = 1024; size < numFiles * 2; size <<= 1 ) {
+	}
+	pathIndex.SetNum( size );
+	for ( i = 0; i < size; i++ ) {
+		pathIndex[i].name = -1;
+	}
+	pathSources.Resize( numFiles );
+	pathNames.Resize( numFiles * 32 );
+
+	j = 0;
+	for ( search = searchPaths; search; search = search->next ) {
+		if ( search->pack ) {
+			for ( i = 0; i < search->pack->numfiles; i++ ) {
+				AddPathSource( search->pack->buildBuffer[i].name, search, &search->pack->buildBuffer[i] );
+			}
+		} else {
+			const idStrList &list = dirFiles[j++];
+			for ( i = 0; i < list.Num(); i++ ) {
+				AddPathSource( list[i], search, NULL );
+			}
+		}
+	}
+
+	common->Printf( "path index: %d files, %d sources, %d KB in %d msec\n", pathIndexCount, pathSources.Num(),
+					(int)( ( pathIndex.Allocated() + pathSources.Allocated() + pathNames.Allocated() ) >> 10 ), Sys_Milliseconds() - start );
+}
+
+/*
+===========
+idFileSystemLocal::ClearPathIndex
+===========
+*/
+void idFileSystemLocal::ClearPathIndex( void ) {
+	pathIndex.Clear();
+	pathSources.Clear();
+	pathNames.Clear();
+	pathIndexCount = 0;
+	pathsWritten.Clear();
+	pathsWrittenHash.Clear();
+}
+
+/*
+===========
+idFileSystemLocal::AddPathSource
+===========
+*/
+void idFileSystemLocal::AddPathSource( const char *name, searchpath_t *search, fileInPack_t *pakFile ) {
+	char			folded[MAX_OSPATH];
+	unsigned int	hash;
+	int				i, mask, len;
+
+	hash = NormalizePath( name, folded, sizeof( folded ) );
+	if ( !hash ) {
+		return;
+	}
+
+	mask = pathIndex.Num() - 1;
+	for ( i = hash & mask; pathIndex[i].name >= 0; i = ( i + 1 ) & mask ) {
+		if ( pathIndex[i].hash == hash && !idStr::Cmp( &pathNames[pathIndex[i].name], folded ) ) {
+			break;
+		}
+	}
+
+	pathIndexSlot_t &slot = pathIndex[i];
+	if ( slot.name < 0 ) {
+		len = idStr::Length( folded ) + 1;
+		if ( pathNames.Num() + len > pathNames.NumAllocated() ) {
+			pathNames.Resize( Max( pathNames.NumAllocated() * 2, pathNames.Num() + len ) );
+		}
+		slot.hash = hash;
+		slot.name = pathNames.Num();
+		slot.first = -1;
+		slot.last = -1;
+		pathNames.SetNum( pathNames.Num() + len, false );
+		memcpy( &pathNames[slot.name], folded, len );
+		pathIndexCount++;
+	} else if ( pathSources[slot.last].search == search ) {
+		// the same name twice in a pak, the first one wins
+		return;
+	}
+
+	pathSource_t &source = pathSources.Alloc();
+	source.search = search;
+	source.pakFile = pakFile;
+	source.next = -1;
+	if ( slot.last >= 0 ) {
+		pathSources[slot.last].next = pathSources.Num() - 1;
+	} else {
+		slot.first = pathSources.Num() - 1;
+	}
+	slot.last = pathSources.Num() - 1;
+}
+
+/*
+===========
+idFileSystemLocal::FindPathSource
+
+Returns the first source of the file, or -1 if no search path has it.
+===========
+*/
+int idFileSystemLocal::FindPathSource( const char *relativePath ) const {
+	char			folded[MAX_OSPATH];
+	unsigned int	hash;
+	int				i, mask;
+
+	hash = NormalizePath( relativePath, folded, sizeof( folded ) );
+	if ( !hash ) {
+		return -1;
+	}
+
+	mask = pathIndex.Num() - 1;
+	for ( i = hash & mask; pathIndex[i].name >= 0; i = ( i + 1 ) & mask ) {
+		if ( pathIndex[i].hash == hash && !idStr::Cmp( &pathNames[pathIndex[i].name], folded ) ) {
+			return pathIndex[i].first;
+		}
+	}
+	return -1;
+}
+
+/*
+===========
+idFileSystemLocal::NextSearchPath
+
+Steps through all search paths, or only the indexed sources when source >= 0.
+===========
+*/
+searchpath_t *idFileSystemLocal::NextSearchPath( searchpath_t *search, int &source ) const {
+	if ( source < 0 ) {
+		return search->next;
+	}
+	source = pathSources[source].next;
+	return ( source >= 0 ) ? pathSources[source].search : NULL;
+}
+
+/*
+===========
+idFileSystemLocal::NotePathWritten
+===========
+*/
+void idFileSystemLocal::NotePathWritten( const char *relativePath ) {
+	char folded[MAX_OSPATH];
+
+	if ( pathIndexCount && NormalizePath( relativePath, folded, sizeof( folded ) ) ) {
+		AddUnique( folded, pathsWritten, pathsWrittenHash );
+	}
+}
+
+/*
+===========
+idFileSystemLocal::PathWasWritten
+===========
+*/
+bool idFileSystemLocal::PathWasWritten( const char *relativePath ) const {
+	char folded[MAX_OSPATH];
+
+	if ( !NormalizePath( relativePath, folded, sizeof( folded ) ) ) {
+		return true;
+	}
+	for ( int i = pathsWrittenHash.First( pathsWrittenHash.GenerateKey( folded ) ); i >= 0; i = pathsWrittenHash.Next( i ) ) {
+		if ( !pathsWritten[i].Cmp( folded ) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
 /*
 ===========
 idFileSystemLocal::OpenFileReadFlags
@@ -2951,6 +3628,7 @@ idFile *idFileSystemLocal::OpenFileReadFlags( const char *relativePath, int sear
 	fileInPack_t *	pakFile;
 	directory_t *	dir;
 	int				hash;
+	int				source;
 	FILE *			fp;
 
 	if ( !searchPaths ) {
@@ -2988,13 +3666,30 @@ idFile *idFileSystemLocal::OpenFileReadFlags( const char *relativePath, int sear
 		return NULL;
 	}
 
+	// files staged by the level load prefetch were resolved with the same search rules
+	if ( prefetchFiles.Num() && ( searchFlags & FSFLAG_SEARCH_PAKS ) && !( gamedir && gamedir[0] ) ) {
+		idFile *file = OpenPrefetchedFile( relativePath, searchFlags, foundInPak );
+		if ( file ) {
+			return file;
+		}
+	}
+
 	//
 	// search through the path, one element at a time
+	// the path index limits that to the search paths that have the file
 	//
 
 	hash = HashFileName( relativePath );
 
-	for ( search = searchPaths; search; search = search->next ) {
+	if ( pathIndexCount && fs_pathIndex.GetBool() && ( !pathsWritten.Num() || !PathWasWritten( relativePath ) ) ) {
+		source = FindPathSource( relativePath );
+		search = ( source >= 0 ) ? pathSources[source].search : NULL;
+	} else {
+		source = -1;
+		search = searchPaths;
+	}
+
+	for ( ; search; search = NextSearchPath( search, source ) ) {
 		if ( search->dir && ( searchFlags & FSFLAG_SEARCH_DIRS ) ) {
 			// check a file in the directory tree
 
@@ -3112,7 +3807,7 @@ idFile *idFileSystemLocal::OpenFileReadFlags( const char *relativePath, int sear
 
 			// look through all the pak file elements
 			pak = search->pack;
-			for ( pakFile = pak->hashTable[hash]; pakFile; pakFile = pakFile->next ) {
+			for ( pakFile = ( source >= 0 ) ? pathSources[source].pakFile : pak->hashTable[hash]; pakFile; pakFile = pakFile->next ) {
 				// case and separator insensitive comparisons
 				if ( !FilenameCompare( pakFile->name, relativePath ) ) {
 					idFile_InZip *file = ReadFileFromZip( pak, pakFile, relativePath );
@@ -3132,6 +3827,10 @@ idFile *idFileSystemLocal::OpenFileReadFlags( const char *relativePath, int sear
 					if ( fs_debug.GetInteger( ) ) {
 						common->Printf( "idFileSystem::OpenFileRead: %s (found in '%s')\n", relativePath, pak->pakFilename.c_str() );
 					}
+
+					if ( loadListName.Length() ) {
+						RecordLoadedFile( relativePath );
+					}
 					return file;
 				}
 			}
@@ -3175,6 +3874,365 @@ idFile *idFileSystemLocal::OpenFileRead( const char *relativePath, bool allowCop
 	return OpenFileReadFlags( relativePath, FSFLAG_SEARCH_DIRS | FSFLAG_SEARCH_PAKS, NULL, allowCopyFiles, gamedir );
 }
 
+/*
+===========
+idFileSystemLocal::RecordLoadedFile
+===========
+*/
+void idFileSystemLocal::RecordLoadedFile( const char *relativePath ) {
+	idStr name = relativePath;
+
+	// configs are small and may change between runs
+	if ( name.CheckExtension( ".cfg" ) ) {
+		return;
+	}
+	name.BackSlashesToSlashes();
+	name.ToLower();
+	AddUnique( name, loadList, loadListHash );
+}
+
+/*
+===========
+idFileSystemLocal::OpenPrefetchedFile
+
+Hands out a staged file, waiting for it if a worker is still on it.
+A file nobody has started on is taken off the queue and read the normal way.
+===========
+*/
+idFile *idFileSystemLocal::OpenPrefetchedFile( const char *relativePath, int searchFlags, pack_t **foundInPak ) {
+	int i, state;
+	idStr name = relativePath;
+
+	name.BackSlashesToSlashes();
+	name.ToLower();
+	for ( i = prefetchHash.First( prefetchHash.GenerateKey( name ) ); i >= 0; i = prefetchHash.Next( i ) ) {
+		if ( prefetchFiles[i].name.Cmp( name ) == 0 ) {
+			break;
+		}
+	}
+	if ( i < 0 ) {
+		return NULL;
+	}
+
+	prefetchFile_t &pf = prefetchFiles[i];
+
+	Sys_EnterCriticalSection( CRITICAL_SECTION_TWO );
+	state = pf.state;
+	if ( state == PREFETCH_QUEUED ) {
+		pf.state = PREFETCH_DONE;
+	}
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_TWO );
+
+	switch ( state ) {
+		case PREFETCH_QUEUED:
+			prefetchMisses++;
+			return NULL;
+		case PREFETCH_LOADING:
+			prefetchLate++;
+			while ( pf.state == PREFETCH_LOADING ) {
+				Sys_Sleep( 1 );
+			}
+			break;
+		case PREFETCH_READY:
+			prefetchHits++;
+			break;
+		default:
+			// already handed out or failed
+			return NULL;
+	}
+
+	if ( pf.state != PREFETCH_READY ) {
+		return NULL;
+	}
+	pf.state = PREFETCH_DONE;
+
+	idFile_Memory *file = new idFile_Memory( relativePath );
+	file->TakeData( (char *)pf.data, pf.length );
+	pf.data = NULL;
+
+	if ( foundInPak ) {
+		*foundInPak = pf.pak;
+	}
+	if ( !pf.pak->referenced && !( searchFlags & FSFLAG_PURE_NOREF ) ) {
+		pf.pak->referenced = true;
+	}
+	if ( fs_debug.GetInteger( ) ) {
+		common->Printf( "idFileSystem::OpenFileRead: %s (prefetched from '%s')\n", relativePath, pf.pak->pakFilename.c_str() );
+	}
+
+	RecordLoadedFile( relativePath );
+	return file;
+}
+
+#ifndef NOMT
+/*
+===========
+PrefetchThread
+
+Claims the queued files in the order the last load opened them
+and stages them straight from the memory mapped paks.
+===========
+*/
+int PrefetchThread( void *parm ) {
+	idFileSystemLocal *fs = (idFileSystemLocal *)parm;
+	z_stream zs;
+
+	memset( &zs, 0, sizeof( zs ) );
+	if ( inflateInit2( &zs, -MAX_WBITS ) != Z_OK ) {
+		return 0;
+	}
+
+	while ( 1 ) {
+		prefetchFile_t *pf = NULL;
+
+		Sys_EnterCriticalSection( CRITICAL_SECTION_TWO );
+		while ( !fs->prefetchExit && fs->prefetchNext < fs->prefetchFiles.Num() ) {
+			prefetchFile_t &next = fs->prefetchFiles[ fs->prefetchNext++ ];
+			if ( next.state == PREFETCH_QUEUED ) {
+				next.state = PREFETCH_LOADING;
+				pf = &next;
+				break;
+			}
+		}
+		Sys_LeaveCriticalSection( CRITICAL_SECTION_TWO );
+
+		if ( !pf ) {
+			break;
+		}
+
+		unsigned int start = Sys_Microseconds();
+		bool ok = true;
+		if ( pf->deflated ) {
+			inflateReset( &zs );
+			zs.next_in = (Bytef *)pf->source;
+			zs.avail_in = pf->compressedSize;
+			zs.next_out = pf->data;
+			zs.avail_out = pf->length;
+			ok = ( inflate( &zs, Z_FINISH ) == Z_STREAM_END && zs.avail_out == 0 );
+		} else {
+			memcpy( pf->data, pf->source, pf->length );
+		}
+		unsigned int usec = Sys_Microseconds() - start;
+
+		Sys_EnterCriticalSection( CRITICAL_SECTION_TWO );
+		pf->state = ok ? PREFETCH_READY : PREFETCH_DONE;
+		fs->prefetchWorkerUsec += usec;
+		Sys_LeaveCriticalSection( CRITICAL_SECTION_TWO );
+	}
+
+	inflateEnd( &zs );
+	return 0;
+}
+#endif
+
+/*
+===========
+idFileSystemLocal::BeginLevelLoad
+
+Queues the pak files the previous load of the map opened. With worker
+threads only entries of memory mapped paks are staged, without them
+the files are read in one sweep before the load starts.
+===========
+*/
+void idFileSystemLocal::BeginLevelLoad( const char *mapName ) {
+	idStr		listName;
+	idStrList	names;
+	idHashIndex	namesHash;
+	int			i, budget;
+
+	ClearPrefetch();
+	loadList.Clear();
+	loadListHash.Clear();
+	loadListName.Clear();
+
+	listName = "prefetch/";
+	listName += mapName;
+	listName.SetFileExtension( ".txt" );
+	listName.BackSlashesToSlashes();
+
+	prefetchStartTime = Sys_Milliseconds();
+
+	idFile *list = fs_prefetch.GetBool() ? OpenExplicitFileRead( BuildOSPath( fs_savepath.GetString(), gameFolder, listName ) ) : NULL;
+	if ( list ) {
+		int len = list->Length();
+		char *text = (char *)Mem_Alloc( len + 1 );
+		list->Read( text, len );
+		text[len] = '\0';
+		CloseFile( list );
+
+		for ( char *line = text; *line; ) {
+			char *end = strchr( line, '\n' );
+			if ( end ) {
+				*end = '\0';
+			}
+			idStr name = line;
+			name.StripTrailingWhitespace();
+			if ( name.Length() ) {
+				AddUnique( name, names, namesHash );
+			}
+			if ( !end ) {
+				break;
+			}
+			line = end + 1;
+		}
+		Mem_Free( text );
+	}
+
+	budget = fs_prefetchMB.GetInteger() * 1024 * 1024;
+	prefetchFiles.SetGranularity( Max( names.Num(), 16 ) );
+
+	for ( i = 0; i < names.Num(); i++ ) {
+		pack_t *pak;
+		prefetchFile_t pf;
+
+		idFile *f = OpenFileReadFlags( names[i], FSFLAG_SEARCH_DIRS | FSFLAG_SEARCH_PAKS | FSFLAG_PURE_NOREF, &pak );
+		if ( !f ) {
+			continue;
+		}
+		if ( !pak || f->Length() > budget ) {
+			// overridden by a loose file or over the budget
+			CloseFile( f );
+			continue;
+		}
+
+		idFile_InZip *zf = static_cast<idFile_InZip *>( f );
+		pf.name = names[i];
+		pf.pak = pak;
+		pf.source = zf->mapped;
+		pf.compressedSize = zf->mappedSize;
+		pf.deflated = ( zf->stream != NULL );
+		pf.length = f->Length();
+#ifndef NOMT
+		if ( !pf.source ) {
+			// the workers only read from mapped paks
+			CloseFile( f );
+			continue;
+		}
+#endif
+		pf.data = (byte *)Mem_Alloc( pf.length + 1 );
+		pf.data[pf.length] = 0;
+		pf.state = PREFETCH_QUEUED;
+#ifdef NOMT
+		unsigned int start = Sys_Microseconds();
+		pf.state = ( f->Read( pf.data, pf.length ) == pf.length ) ? PREFETCH_READY : PREFETCH_DONE;
+		prefetchWorkerUsec += Sys_Microseconds() - start;
+#endif
+		CloseFile( f );
+
+		budget -= pf.length;
+		prefetchBytes += pf.length;
+		prefetchHash.Add( prefetchHash.GenerateKey( pf.name ), prefetchFiles.Append( pf ) );
+	}
+
+#ifndef NOMT
+	if ( prefetchFiles.Num() ) {
+		prefetchExit = false;
+		prefetchNext = 0;
+		numPrefetchThreads = idMath::ClampInt( 1, MAX_PREFETCH_THREADS, fs_prefetchThreads.GetInteger() );
+		for ( i = 0; i < numPrefetchThreads; i++ ) {
+			Sys_CreateThread( PrefetchThread, this, prefetchThreads[i], "prefetch" );
+		}
+	}
+#endif
+
+	if ( prefetchFiles.Num() ) {
+		common->Printf( "prefetch: %d of %d recorded files, %.1f MB\n", prefetchFiles.Num(), names.Num(), prefetchBytes / ( 1024.0f * 1024.0f ) );
+	}
+
+	// start recording after the queueing, so it doesn't show up in the list
+	loadListName = listName;
+}
+
+/*
+===========
+idFileSystemLocal::EndLevelLoad
+===========
+*/
+void idFileSystemLocal::EndLevelLoad( void ) {
+	int i, unused, opened;
+
+	if ( !loadListName.Length() ) {
+		return;
+	}
+
+	int loadTime = Sys_Milliseconds() - prefetchStartTime;
+
+	StopPrefetchThreads();
+
+	if ( prefetchFiles.Num() ) {
+		unused = 0;
+		for ( i = 0; i < prefetchFiles.Num(); i++ ) {
+			if ( prefetchFiles[i].state == PREFETCH_READY ) {
+				unused++;
+			}
+		}
+		opened = prefetchHits + prefetchLate + prefetchMisses;
+		common->Printf( "prefetch: %d of %d opened files were staged in time (%d%% overlap), %d late, %d missed, %d unused\n",
+						prefetchHits, opened, opened ? prefetchHits * 100 / opened : 0, prefetchLate, prefetchMisses, unused );
+#ifdef NOMT
+		common->Printf( "prefetch: %d msec staging before the load, %d msec level load\n", prefetchWorkerUsec / 1000, loadTime );
+#else
+		common->Printf( "prefetch: %d msec of work on %d threads, %d msec level load\n", prefetchWorkerUsec / 1000, numPrefetchThreads, loadTime );
+#endif
+	}
+
+	if ( fs_prefetch.GetBool() && loadList.Num() ) {
+		idFile *f = OpenFileWrite( loadListName );
+		if ( f ) {
+			for ( i = 0; i < loadList.Num(); i++ ) {
+				f->Printf( "%s\n", loadList[i].c_str() );
+			}
+			CloseFile( f );
+		}
+	}
+
+	ClearPrefetch();
+	loadList.Clear();
+	loadListHash.Clear();
+	loadListName.Clear();
+}
+
+/*
+===========
+idFileSystemLocal::StopPrefetchThreads
+===========
+*/
+void idFileSystemLocal::StopPrefetchThreads( void ) {
+#ifndef NOMT
+	Sys_EnterCriticalSection( CRITICAL_SECTION_TWO );
+	prefetchExit = true;
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_TWO );
+
+	for ( int i = 0; i < numPrefetchThreads; i++ ) {
+		Sys_DestroyThread( prefetchThreads[i] );
+	}
+#endif
+	numPrefetchThreads = 0;
+}
+
+/*
+===========
+idFileSystemLocal::ClearPrefetch
+===========
+*/
+void idFileSystemLocal::ClearPrefetch( void ) {
+	StopPrefetchThreads();
+
+	for ( int i = 0; i < prefetchFiles.Num(); i++ ) {
+		if ( prefetchFiles[i].data ) {
+			Mem_Free( prefetchFiles[i].data );
+		}
+	}
+	prefetchFiles.Clear();
+	prefetchHash.Clear();
+	prefetchNext = 0;
+	prefetchBytes = 0;
+	prefetchWorkerUsec = 0;
+	prefetchHits = 0;
+	prefetchLate = 0;
+	prefetchMisses = 0;
+}
+
 /*
 ===========
 idFileSystemLocal::OpenFileWrite
@@ -3203,6 +4261,7 @@ idFile *idFileSystemLocal::OpenFileWrite( const char *relativePath, const char *
 	// if the dir we are writing to is in our current list, it will be outdated
 	// so just flush everything
 	ClearDirCache();
+	NotePathWritten( relativePath );
 
 	common->DPrintf( "writing to: %s\n", OSpath.c_str() );
 	CreateOSPath( OSpath );
@@ -3310,6 +4369,7 @@ idFile *idFileSystemLocal::OpenFileAppend( const char *relativePath, bool sync,
 
 	OSpath = BuildOSPath( path, gameFolder, relativePath );
 	CreateOSPath( OSpath );
+	NotePathWritten( relativePath );
 
 	if ( fs_debug.GetInteger() ) {
 		common->Printf( "idFileSystem::OpenFileAppend: %s\n", OSpath.c_str() );
@@ -179,6 +179,9 @@ public:
 							// The returned files include a full relative path.
 							// The extension must include a leading dot and may not contain wildcards.
 	virtual idFileList *	ListFilesTree( const char *relativePath, const char *extension, bool sort = false, const char* gamedir = NULL ) = 0;
+							// Lists the files with the given extension stored in a loaded pak, matched on its file name ( "pak000.pk4" ).
+							// The returned files include a full relative path. Returns NULL if no such pak is in the search path.
+	virtual idFileList *	ListPakFiles( const char *pakName, const char *extension, bool sort = false ) = 0;
 							// Frees the given file list.
 	virtual void			FreeFileList( idFileList *fileList ) = 0;
 							// Converts a relative path to a full OS path.
@@ -220,6 +223,11 @@ public:
 	virtual int				ReadFile( const char *relativePath, void **buffer, ID_TIME_T *timestamp = NULL ) = 0;
 							// Frees the memory allocated by ReadFile.
 	virtual void			FreeFile( void *buffer ) = 0;
+							// Like ReadFile, but files stored uncompressed in a memory mapped pak are returned
+							// as a pointer into the mapping without a copy. The data is read-only and is not
+							// guaranteed to be 0 terminated. Release it with FreeFileView.
+	virtual int				ReadFileView( const char *relativePath, const void **view, ID_TIME_T *timestamp = NULL ) = 0;
+	virtual void			FreeFileView( const void *view ) = 0;
 							// Writes a complete file, will create any needed subdirectories.
 							// Returns the length of the file, or -1 on failure.
 	virtual int				WriteFile( const char *relativePath, const void *buffer, int size, const char *basePath = "fs_savepath" ) = 0;
@@ -283,6 +291,13 @@ public:
 							// ignore case and seperator char distinctions
 	virtual bool			FilenameCompare( const char *s1, const char *s2 ) const = 0;
 
+							// Starts staging the pak files recorded during the previous load of this map,
+							// and records the files opened during this load for the next one.
+	virtual void			BeginLevelLoad( const char *mapName ) = 0;
+							// Reports how much of the load the prefetch covered, frees the unused staging
+							// and saves the recorded file list.
+	virtual void			EndLevelLoad( void ) = 0;
+
 #ifdef NOMT
 	virtual void 			RunThread() = 0;
 #endif
@@ -42,6 +42,7 @@ class idRenderModelManager;
 class idUserInterface;
 class idUserInterfaceManager;
 class idNetworkSystem;
+class idProfiler;
 
 /*
 ===============================================================================
@@ -324,7 +325,7 @@ extern idGameEdit *				gameEdit;
 ===============================================================================
 */
 
-const int GAME_API_VERSION		= 9;
+const int GAME_API_VERSION		= 10;
 
 typedef struct {
 
@@ -342,6 +343,7 @@ typedef struct {
 	idDeclManager *				declManager;			// declaration manager
 	idAASFileManager *			AASFileManager;			// AAS file manager
 	idCollisionModelManager *	collisionModelManager;	// collision model manager
+	idProfiler *				profiler;				// frame profiler
 
 } gameImport_t;
 
@@ -0,0 +1,467 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "sys/platform.h"
+#include "idlib/containers/HashIndex.h"
+#include "framework/CVarSystem.h"
+#include "framework/CmdSystem.h"
+#include "framework/FileSystem.h"
+#include "framework/Common.h"
+
+#include "framework/Profiler.h"
+
+#define MAX_PROFILE_DEPTH		32
+#define MAX_PROFILE_FRAMES		1024
+#define MAX_FRAME_ZONES			8192
+
+typedef struct profileZone_s {
+	const char *			name;
+	unsigned int			start;
+	unsigned int			end;
+	unsigned int			childTime;		// time spent in directly nested zones
+	int						depth;
+} profileZone_t;
+
+typedef struct profileFrame_s {
+	int						frameNumber;
+	unsigned int			start;
+	unsigned int			end;
+	int						droppedZones;
+	idList<profileZone_t>	zones;
+} profileFrame_t;
+
+class idProfilerLocal : public idProfiler {
+public:
+							idProfilerLocal( void );
+
+	virtual void			Init( void );
+	virtual void			Shutdown( void );
+	virtual void			Frame( void );
+	virtual bool			IsEnabled( void ) const { return recording; }
+	virtual void			BeginZone( const char *name );
+	virtual void			EndZone( void );
+
+	virtual void			Clear( void );
+
+	void					Dump( int numFrames ) const;
+	bool					WriteTrace( const char *fileName ) const;
+
+	static idCVar			com_profile;
+	static idCVar			com_profileFrames;
+
+private:
+	bool					recording;
+	profileFrame_t *		frames;
+	int						numFrames;			// size of the ring buffer, one more than com_profileFrames
+	int						numStored;			// completed frames in the ring buffer
+	int						current;			// frame being recorded
+	int						frameNumber;
+	int						stack[MAX_PROFILE_DEPTH];
+	int						stackDepth;
+
+	void					FinishFrame( void );
+	const profileFrame_t *	StoredFrame( int age ) const;
+};
+
+idCVar idProfilerLocal::com_profile( "com_profile", "0", CVAR_SYSTEM | CVAR_BOOL, "record profile zones of the most recent frames" );
+idCVar idProfilerLocal::com_profileFrames( "com_profileFrames", "120", CVAR_SYSTEM | CVAR_INTEGER, "number of frames kept by the profiler", 1, MAX_PROFILE_FRAMES );
+
+idProfilerLocal	profilerLocal;
+idProfiler *	profiler = &profilerLocal;
+
+/*
+================
+idProfilerLocal::idProfilerLocal
+================
+*/
+idProfilerLocal::idProfilerLocal( void ) {
+	recording = false;
+	frames = NULL;
+	numFrames = 0;
+	numStored = 0;
+	current = 0;
+	frameNumber = 0;
+	stackDepth = 0;
+}
+
+/*
+================
+Profile_Dump_f
+================
+*/
+static void Profile_Dump_f( const idCmdArgs &args ) {
+	profilerLocal.Dump( args.Argc() > 1 ? atoi( args.Argv( 1 ) ) : 0 );
+}
+
+/*
+================
+Profile_Trace_f
+================
+*/
+static void Profile_Trace_f( const idCmdArgs &args ) {
+	idStr fileName;
+
+	if ( args.Argc() > 1 ) {
+		fileName = args.Argv( 1 );
+	} else {
+		fileName = "profile";
+	}
+	fileName.DefaultFileExtension( ".json" );
+
+	profilerLocal.WriteTrace( fileName );
+}
+
+/*
+================
+Profile_Clear_f
+================
+*/
+static void Profile_Clear_f( const idCmdArgs &args ) {
+	profilerLocal.Clear();
+}
+
+/*
+================
+idProfilerLocal::Init
+================
+*/
+void idProfilerLocal::Init( void ) {
+	cmdSystem->AddCommand( "profileDump", Profile_Dump_f, CMD_FL_SYSTEM, "prints zone times of the recorded frames, usage: profileDump [frames]" );
+	cmdSystem->AddCommand( "profileTrace", Profile_Trace_f, CMD_FL_SYSTEM, "writes the recorded frames as a Chrome trace, usage: profileTrace [file]" );
+	cmdSystem->AddCommand( "profileClear", Profile_Clear_f, CMD_FL_SYSTEM, "clears the recorded frames" );
+}
+
+/*
+================
+idProfilerLocal::Shutdown
+================
+*/
+void idProfilerLocal::Shutdown( void ) {
+	recording = false;
+	delete[] frames;
+	frames = NULL;
+	numFrames = 0;
+	numStored = 0;
+	stackDepth = 0;
+}
+
+/*
+================
+idProfilerLocal::Clear
+================
+*/
+void idProfilerLocal::Clear( void ) {
+	for ( int i = 0; i < numFrames; i++ ) {
+		frames[i].zones.SetNum( 0, false );
+	}
+	numStored = 0;
+
+	// zones still open in the current frame are no longer recorded
+	for ( int i = 0; i < stackDepth; i++ ) {
+		stack[i] = -1;
+	}
+}
+
+/*
+================
+idProfilerLocal::FinishFrame
+
+Closes any zones left open and stores the frame in the ring buffer.
+================
+*/
+void idProfilerLocal::FinishFrame( void ) {
+	profileFrame_t &frame = frames[current];
+
+	frame.end = Sys_Microseconds();
+	while ( stackDepth > 0 ) {
+		// zones dropped on overflow or by Clear are on the stack as -1
+		int index = stack[--stackDepth];
+		if ( index >= 0 ) {
+			frame.zones[index].end = frame.end;
+		}
+	}
+
+	// the slot after the newest frame is reused for recording, so it never counts as stored
+	current = ( current + 1 ) % numFrames;
+	if ( numStored < numFrames - 1 ) {
+		numStored++;
+	}
+}
+
+/*
+================
+idProfilerLocal::StoredFrame
+
+Age 0 is the most recently completed frame.
+================
+*/
+const profileFrame_t *idProfilerLocal::StoredFrame( int age ) const {
+	if ( age < 0 || age >= numStored ) {
+		return NULL;
+	}
+	return &frames[( current - 1 - age + numFrames * 2 ) % numFrames];
+}
+
+/*
+================
+idProfilerLocal::Frame
+================
+*/
+void idProfilerLocal::Frame( void ) {
+	if ( recording ) {
+		FinishFrame();
+	}
+
+	frameNumber++;
+
+	recording = com_profile.GetBool();
+	if ( !recording ) {
+		return;
+	}
+
+	// resize the ring buffer, dropping what was recorded so far
+	if ( com_profileFrames.GetInteger() + 1 != numFrames ) {
+		delete[] frames;
+		numFrames = com_profileFrames.GetInteger() + 1;
+		frames = new profileFrame_t[numFrames];
+		for ( int i = 0; i < numFrames; i++ ) {
+			frames[i].zones.SetGranularity( 1024 );
+		}
+		numStored = 0;
+		current = 0;
+	}
+
+	profileFrame_t &frame = frames[current];
+	frame.frameNumber = frameNumber;
+	frame.start = Sys_Microseconds();
+	frame.end = frame.start;
+	frame.droppedZones = 0;
+	frame.zones.SetNum( 0, false );
+	stackDepth = 0;
+}
+
+/*
+================
+idProfilerLocal::BeginZone
+================
+*/
+void idProfilerLocal::BeginZone( const char *name ) {
+	profileFrame_t &frame = frames[current];
+
+	// zones that don't fit still keep their place on the stack, so EndZone stays balanced
+	if ( stackDepth >= MAX_PROFILE_DEPTH || frame.zones.Num() >= MAX_FRAME_ZONES ) {
+		frame.droppedZones++;
+		if ( stackDepth < MAX_PROFILE_DEPTH ) {
+			stack[stackDepth++] = -1;
+		}
+		return;
+	}
+
+	profileZone_t &zone = frame.zones.Alloc();
+	zone.name = name;
+	zone.start = Sys_Microseconds();
+	zone.end = zone.start;
+	zone.childTime = 0;
+	zone.depth = stackDepth;
+
+	stack[stackDepth++] = frame.zones.Num() - 1;
+}
+
+/*
+================
+idProfilerLocal::EndZone
+================
+*/
+void idProfilerLocal::EndZone( void ) {
+	if ( stackDepth <= 0 ) {
+		return;
+	}
+
+	profileFrame_t &frame = frames[current];
+
+	int index = stack[--stackDepth];
+	if ( index < 0 ) {
+		return;
+	}
+
+	profileZone_t &zone = frame.zones[index];
+	zone.end = Sys_Microseconds();
+
+	// charge the time to the parent so self time can be derived
+	for ( int i = stackDepth - 1; i >= 0; i-- ) {
+		if ( stack[i] >= 0 ) {
+			frame.zones[stack[i]].childTime += zone.end - zone.start;
+			break;
+		}
+	}
+}
+
+/*
+================
+idProfilerLocal::Dump
+
+Aggregates the zones of the most recent frames by name.  Entity think
+zones are named after the entity class, which gives the cost per type.
+================
+*/
+typedef struct profileStat_s {
+	const char *	name;
+	double			total;
+	double			self;
+	unsigned int	max;
+	int				calls;
+} profileStat_t;
+
+static int ProfileStatSort( const profileStat_t *a, const profileStat_t *b ) {
+	if ( a->total < b->total ) {
+		return 1;
+	}
+	if ( a->total > b->total ) {
+		return -1;
+	}
+	return 0;
+}
+
+void idProfilerLocal::Dump( int count ) const {
+	idList<profileStat_t>	stats;
+	idHashIndex				hash;
+	double					frameTime = 0.0;
+	int						dropped = 0;
+
+	if ( count <= 0 || count > numStored ) {
+		count = numStored;
+	}
+	if ( !count ) {
+		common->Printf( "no frames recorded, set com_profile 1\n" );
+		return;
+	}
+
+	stats.SetGranularity( 256 );
+
+	for ( int age = 0; age < count; age++ ) {
+		const profileFrame_t *frame = StoredFrame( age );
+
+		frameTime += frame->end - frame->start;
+		dropped += frame->droppedZones;
+
+		for ( int i = 0; i < frame->zones.Num(); i++ ) {
+			const profileZone_t &zone = frame->zones[i];
+			const unsigned int time = zone.end - zone.start;
+			const int key = hash.GenerateKey( zone.name );
+			int j;
+
+			for ( j = hash.First( key ); j != -1; j = hash.Next( j ) ) {
+				if ( stats[j].name == zone.name || idStr::Cmp( stats[j].name, zone.name ) == 0 ) {
+					break;
+				}
+			}
+			if ( j == -1 ) {
+				j = stats.Num();
+				profileStat_t &stat = stats.Alloc();
+				stat.name = zone.name;
+				stat.total = 0.0;
+				stat.self = 0.0;
+				stat.max = 0;
+				stat.calls = 0;
+				hash.Add( key, j );
+			}
+
+			profileStat_t &stat = stats[j];
+			stat.total += time;
+			stat.self += time - zone.childTime;
+			if ( time > stat.max ) {
+				stat.max = time;
+			}
+			stat.calls++;
+		}
+	}
+
+	stats.Sort( ProfileStatSort );
+
+	common->Printf( "%d frames, %.3f ms per frame\n", count, frameTime / ( count * 1000.0 ) );
+	common->Printf( "   total ms    self ms     max ms    calls  zone\n" );
+	for ( int i = 0; i < stats.Num(); i++ ) {
+		const profileStat_t &stat = stats[i];
+		common->Printf( "%11.3f %10.3f %10.3f %8.1f  %s\n", stat.total / ( count * 1000.0 ), stat.self / ( count * 1000.0 ),
+			stat.max / 1000.0, (float)stat.calls / count, stat.name );
+	}
+	if ( dropped ) {
+		common->Printf( "%d zones dropped\n", dropped );
+	}
+}
+
+/*
+================
+idProfilerLocal::WriteTrace
+
+Writes the recorded frames in the Chrome trace event format, as complete
+events with microsecond timestamps.
+================
+*/
+bool idProfilerLocal::WriteTrace( const char *fileName ) const {
+	if ( !numStored ) {
+		common->Printf( "no frames recorded, set com_profile 1\n" );
+		return false;
+	}
+
+	idFile *f = fileSystem->OpenFileWrite( fileName );
+	if ( !f ) {
+		common->Warning( "couldn't open %s", fileName );
+		return false;
+	}
+
+	const unsigned int base = StoredFrame( numStored - 1 )->start;
+	const char *separator = "";
+	int numEvents = 0;
+
+	f->Printf( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+	for ( int age = numStored - 1; age >= 0; age-- ) {
+		const profileFrame_t *frame = StoredFrame( age );
+
+		f->Printf( "%s{\"name\":\"frame %d\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%u,\"dur\":%u}",
+			separator, frame->frameNumber, frame->start - base, frame->end - frame->start );
+		separator = ",\n";
+		numEvents++;
+
+		for ( int i = 0; i < frame->zones.Num(); i++ ) {
+			const profileZone_t &zone = frame->zones[i];
+			idStr name = zone.name;
+			name.Replace( "\\", "\\\\" );
+			name.Replace( "\"", "\\\"" );
+			f->Printf( "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%u,\"dur\":%u}",
+				separator, name.c_str(), zone.start - base, zone.end - zone.start );
+			numEvents++;
+		}
+	}
+	f->Printf( "\n]}\n" );
+
+	fileSystem->CloseFile( f );
+
+	common->Printf( "wrote %d events of %d frames to %s\n", numEvents, numStored, fileName );
+	return true;
+}
@@ -0,0 +1,94 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+/*
+===============================================================================
+
+	Frame profiler.
+
+	Code is instrumented with nested, named zones, usually through an
+	idScopedProfileZone on the stack.  While com_profile is set, every zone
+	of the last com_profileFrames frames is kept in a ring buffer, from
+	where it can be summarized on the console or written out as a Chrome
+	trace (chrome://tracing, Perfetto).
+
+	Only the zone name pointer is stored, so names must be string literals
+	or otherwise live as long as the profiler, like idTypeInfo::classname.
+
+	Zones are only recorded from the main thread.
+
+===============================================================================
+*/
+
+class idProfiler {
+public:
+	virtual			~idProfiler( void ) {}
+
+	virtual void	Init( void ) = 0;
+	virtual void	Shutdown( void ) = 0;
+
+	// called once at the start of every common frame, closes the previous frame
+	virtual void	Frame( void ) = 0;
+
+	// true while the current frame is being recorded
+	virtual bool	IsEnabled( void ) const = 0;
+
+	virtual void	BeginZone( const char *name ) = 0;
+	virtual void	EndZone( void ) = 0;
+
+	// drops all recorded frames, needed before the zone names become invalid
+	virtual void	Clear( void ) = 0;
+};
+
+extern idProfiler *	profiler;	// statically initialized to an idProfilerLocal
+
+/*
+===============================================================================
+
+	Scoped profile zone, ends the zone when it goes out of scope.
+
+===============================================================================
+*/
+
+class idScopedProfileZone {
+public:
+					idScopedProfileZone( const char *name ) { active = profiler->IsEnabled(); if ( active ) { profiler->BeginZone( name ); } }
+					~idScopedProfileZone( void ) { if ( active ) { profiler->EndZone(); } }
+
+private:
+	bool			active;
+};
+
+#define PROFILE_ZONE_CONCAT2( a, b )	a##b
+#define PROFILE_ZONE_CONCAT( a, b )		PROFILE_ZONE_CONCAT2( a, b )
+#define PROFILE_SCOPE( name )			idScopedProfileZone PROFILE_ZONE_CONCAT( profileZone_, __LINE__ )( name )
+
+#endif /* !__PROFILER_H__ */
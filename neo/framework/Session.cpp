@@ -29,7 +29,9 @@ If you have questions concerning this license or the applicable additional terms
 #include "sys/platform.h"
 #include "idlib/hashing/CRC32.h"
 #include "idlib/LangDict.h"
+#include "idlib/Lexer.h"
 #include "framework/async/AsyncNetwork.h"
+#include "framework/Compressor.h"
 #include "framework/Console.h"
 #include "framework/Game.h"
 #include "framework/EventLoop.h"
@@ -52,6 +54,10 @@ idCVar  idSessionLocal::com_showDemo("com_showDemo", "0", CVAR_SYSTEM | CVAR_BOO
 idCVar  idSessionLocal::com_skipGameDraw("com_skipGameDraw", "0", CVAR_SYSTEM | CVAR_BOOL, "");
 idCVar  idSessionLocal::com_wipeSeconds("com_wipeSeconds", "1", CVAR_SYSTEM, "");
 idCVar  idSessionLocal::com_guid("com_guid", "", CVAR_SYSTEM | CVAR_ARCHIVE | CVAR_ROM, "");
+idCVar  idSessionLocal::com_compressSaveGames("com_compressSaveGames", "1", CVAR_SYSTEM | CVAR_BOOL,
+                                              "compress savegames, uncompressed savegames can still be loaded");
+idCVar  idSessionLocal::com_timeDemoWarmupFrames("com_timeDemoWarmupFrames", "30", CVAR_SYSTEM | CVAR_INTEGER,
+                                                 "frames at the start of a timedemo that are left out of the statistics", 0, 10000);
 
 idSessionLocal sessLocal;
 idSession* session = &sessLocal;
@@ -80,9 +86,9 @@ Session_RescanSI_f
 */
 void Session_RescanSI_f(const idCmdArgs& args) {
   sessLocal.mapSpawnData.serverInfo = *cvarSystem->MoveCVarsToDict(CVAR_SERVERINFO);
-  //if (game && idAsyncNetwork::server.IsActive()) {
-  //  game->SetServerInfo(sessLocal.mapSpawnData.serverInfo);
-  //}
+  if (game && idAsyncNetwork::server.IsActive()) {
+    game->SetServerInfo(sessLocal.mapSpawnData.serverInfo);
+  }
 }
 
 /*
@@ -346,6 +352,11 @@ void idSessionLocal::Clear() {
   menuSoundWorld = NULL;
   readDemo = NULL;
   writeDemo = NULL;
+  timeDemoFrameTime = 0;
+
+  benchmarkActive = false;
+  benchmarkQuit = false;
+  benchmarkDemoIndex = 0;
   renderdemoVersion = 0;
   cmdDemoFile = NULL;
 
@@ -389,6 +400,9 @@ idSessionLocal::idSessionLocal() {
 
   demoversion = false;
 
+  memset(&saveGameWrite, 0, sizeof(saveGameWrite));
+  memset(&saveGameWriteThread, 0, sizeof(saveGameWriteThread));
+
   Clear();
 }
 
@@ -417,7 +431,7 @@ void idSessionLocal::Stop() {
   idAsyncNetwork::client.DisconnectFromServer();
 
   // kill async server
-  //idAsyncNetwork::server.Kill();
+  idAsyncNetwork::server.Kill();
 
   if ( sw ) {
     sw->StopAllSounds();
@@ -438,6 +452,9 @@ idSessionLocal::Shutdown
 void idSessionLocal::Shutdown() {
   int i;
 
+  // make sure the last savegame is on disk
+  UpdateSaveGameWrite(true);
+
   if ( timeDemo == TD_YES ) {
     // else the game freezes when showing the timedemo results
     timeDemo = TD_YES_THEN_QUIT;
@@ -644,6 +661,19 @@ static void Session_CompressDemo_f(const idCmdArgs& args) {
   }
 }
 
+/*
+================
+Session_BenchmarkCompressors_f
+================
+*/
+static void Session_BenchmarkCompressors_f(const idCmdArgs& args) {
+  if ( args.Argc() != 2 ) {
+    common->Printf("use: benchmarkCompressors <file>\n");
+    return;
+  }
+  sessLocal.BenchmarkCompressors(args.Argv(1));
+}
+
 /*
 ================
 Session_StopRecordingDemo_f
@@ -664,6 +694,50 @@ static void Session_PlayDemo_f(const idCmdArgs& args) {
   }
 }
 
+/*
+================
+Session_DemoSeek_f
+================
+*/
+static void Session_DemoSeek_f(const idCmdArgs& args) {
+  if ( args.Argc() != 2 ) {
+    common->Printf("use: demoSeek <frame>\n");
+    return;
+  }
+  sessLocal.SeekRenderDemo(atoi(args.Argv(1)));
+}
+
+/*
+================
+Session_DemoIndex_f
+
+Lists the keyframes of a demo, so the frame ranges can be handed to separate jobs
+================
+*/
+static void Session_DemoIndex_f(const idCmdArgs& args) {
+  if ( args.Argc() != 2 ) {
+    common->Printf("use: demoIndex <file>\n");
+    return;
+  }
+
+  idStr demoName = va("demos/%s", args.Argv(1));
+  demoName.DefaultFileExtension(".demo");
+
+  idDemoFile demo;
+  if ( !demo.OpenForReading(demoName)) {
+    common->Printf("couldn't open %s\n", demoName.c_str());
+    return;
+  }
+
+  const idList<demoKeyframe_t>& keyframes = demo.GetKeyframes();
+  for ( int i = 0; i < keyframes.Num(); i++ ) {
+    common->Printf("%5i: frame %6i at offset %i\n", i, keyframes[i].frame, keyframes[i].offset);
+  }
+  common->Printf("%i keyframes in %s\n", keyframes.Num(), demoName.c_str());
+
+  demo.Close();
+}
+
 /*
 ================
 Session_TimeDemo_f
@@ -675,6 +749,58 @@ static void Session_TimeDemo_f(const idCmdArgs& args) {
   }
 }
 
+/*
+================
+Session_BenchmarkDemos
+
+Without demos on the command line the list is read from benchmarks/<name>.txt
+================
+*/
+static void Session_BenchmarkDemos(const idCmdArgs& args, bool quit) {
+  if ( args.Argc() < 2 ) {
+    common->Printf("use: %s <name> [demo ...]\n", args.Argv(0));
+    return;
+  }
+
+  idStrList demos;
+  for ( int i = 2; i < args.Argc(); i++ ) {
+    demos.Append(args.Argv(i));
+  }
+
+  if ( !demos.Num()) {
+    idLexer src(LEXFL_NOFATALERRORS | LEXFL_NOSTRINGCONCAT | LEXFL_ALLOWPATHNAMES);
+    idToken token;
+
+    if ( !src.LoadFile(va("benchmarks/%s.txt", args.Argv(1)))) {
+      common->Printf("couldn't load benchmarks/%s.txt\n", args.Argv(1));
+      return;
+    }
+    while ( src.ReadToken(&token)) {
+      demos.Append(token);
+    }
+  }
+
+  sessLocal.StartBenchmarkDemos(args.Argv(1), demos, quit);
+}
+
+/*
+================
+Session_BenchmarkDemos_f
+================
+*/
+static void Session_BenchmarkDemos_f(const idCmdArgs& args) {
+  Session_BenchmarkDemos(args, false);
+}
+
+/*
+================
+Session_BenchmarkDemosQuit_f
+================
+*/
+static void Session_BenchmarkDemosQuit_f(const idCmdArgs& args) {
+  Session_BenchmarkDemos(args, true);
+}
+
 /*
 ================
 Session_TimeDemoQuit_f
@@ -688,6 +814,32 @@ static void Session_TimeDemoQuit_f(const idCmdArgs& args) {
   }
 }
 
+/*
+================
+Session_RenderDemoAudio_f
+
+Times a demo while the sound system mixes its audio in software to a wave file
+================
+*/
+static void Session_RenderDemoAudio_f(const idCmdArgs& args) {
+  if ( args.Argc() < 2 ) {
+    common->Printf("usage: renderDemoAudio <demoName> [waveName]\n");
+    return;
+  }
+
+  idStr waveName = va("demos/%s", args.Argv(( args.Argc() > 2 ) ? 2 : 1));
+  waveName.SetFileExtension(".wav");
+
+  if ( !soundSystem->StartWritingWave(waveName)) {
+    return;
+  }
+
+  sessLocal.TimeRenderDemo(va("demos/%s", args.Argv(1)));
+  if ( !sessLocal.readDemo ) {
+    soundSystem->StopWritingWave();
+  }
+}
+
 /*
 ================
 Session_WriteCmdDemo_f
@@ -824,12 +976,16 @@ void idSessionLocal::StopPlayingRenderDemo() {
   // Record the stop time before doing anything that could be time consuming
   int timeDemoStopTime = Sys_Milliseconds();
 
+  idStr demoName = readDemo->GetName();
+
   readDemo->Close();
 
+  soundSystem->StopWritingWave();
+
   sw->StopAllSounds();
   soundSystem->SetPlayingSoundWorld(menuSoundWorld);
 
-  common->Printf("stopped playing %s.\n", readDemo->GetName());
+  common->Printf("stopped playing %s.\n", demoName.c_str());
   delete readDemo;
   readDemo = NULL;
 
@@ -840,7 +996,20 @@ void idSessionLocal::StopPlayingRenderDemo() {
     idStr message = va("%i frames rendered in %3.1f seconds = %3.1f fps\n", numDemoFrames, demoSeconds, demoFPS);
 
     common->Printf(message);
-    if ( timeDemo == TD_YES_THEN_QUIT ) {
+
+    timeDemoResult_t result;
+    GetTimeDemoResult(demoName, result);
+    common->Printf("%i frames measured: frame msec avg %.2f p50 %.2f p95 %.2f p99 %.2f worst %.2f\n", result.frames,
+                   result.msec.average, result.msec.p50, result.msec.p95, result.msec.p99, result.msec.worst);
+    common->Printf("frontend p50 %.0f p99 %.0f, backend p50 %.0f p99 %.0f, %.1f allocs %.1f KB per frame\n",
+                   result.frontendMsec.p50, result.frontendMsec.p99, result.backendMsec.p50, result.backendMsec.p99,
+                   result.allocsPerFrame, result.allocBytesPerFrame / 1024.0f);
+
+    if ( benchmarkActive ) {
+      // the next demo is started from Frame
+      benchmarkResults.Append(result);
+    }
+    else if ( timeDemo == TD_YES_THEN_QUIT ) {
       cmdSystem->BufferCommandText(CMD_EXEC_APPEND, "quit\n");
     }
     else {
@@ -852,6 +1021,45 @@ void idSessionLocal::StopPlayingRenderDemo() {
   }
 }
 
+/*
+================
+idSessionLocal::SeekRenderDemo
+
+Continues playback from the closest keyframe and plays forward to the frame without drawing
+================
+*/
+void idSessionLocal::SeekRenderDemo(int frame) {
+  if ( !readDemo ) {
+    common->Printf("not playing a demo\n");
+    return;
+  }
+
+  int startTime = Sys_Milliseconds();
+
+  // keyframes count the frames written before them, playback starts counting at 1
+  int keyframe = readDemo->SeekToKeyframe(frame - 1);
+  if ( keyframe < 0 ) {
+    common->Printf("%s has no keyframe index\n", readDemo->GetName());
+    return;
+  }
+
+  sw->StopAllSounds();
+
+  numDemoFrames = keyframe + 1;
+  // AdvanceRenderDemo keeps a single frame demo open at its end, so stop once no frame is read
+  while ( readDemo && numDemoFrames < frame ) {
+    int lastFrame = numDemoFrames;
+    AdvanceRenderDemo(true);
+    if ( numDemoFrames == lastFrame ) {
+      break;
+    }
+  }
+  lastDemoTic = -1;
+
+  common->Printf("seeked to frame %i from keyframe %i in %i ms\n", numDemoFrames, keyframe,
+                 Sys_Milliseconds() - startTime);
+}
+
 /*
 ================
 idSessionLocal::DemoShot
@@ -962,9 +1170,238 @@ void idSessionLocal::TimeRenderDemo(const char* demoName, bool twice) {
     return;
   }
 
+  timeDemoFrames.Clear();
+  timeDemoFrameTime = Sys_Microseconds();
+  time_gameFrame = 0;
+  time_gameDraw = 0;
+  Mem_ClearFrameStats();
+
   timeDemo = TD_YES;
 }
 
+/*
+================
+idSessionLocal::RecordTimeDemoFrame
+================
+*/
+void idSessionLocal::RecordTimeDemoFrame() {
+  timeDemoFrame_t frame;
+  memoryStats_t allocs, frees;
+
+  unsigned int now = Sys_Microseconds();
+  frame.msec = ( now - timeDemoFrameTime ) * 0.001f;
+  timeDemoFrameTime = now;
+
+  frame.frontendMsec = time_frontend;
+  frame.backendMsec = time_backend;
+
+  // com_speeds shows no game times while a timedemo runs
+  frame.gameMsec = time_gameFrame + time_gameDraw;
+  time_gameFrame = 0;
+  time_gameDraw = 0;
+
+  Mem_GetFrameStats(allocs, frees);
+  Mem_ClearFrameStats();
+  frame.allocs = allocs.num;
+  frame.allocBytes = allocs.totalSize;
+
+  timeDemoFrames.Append(frame);
+}
+
+/*
+================
+TimeDemoFloatCompare
+================
+*/
+static int TimeDemoFloatCompare(const float* a, const float* b) {
+  if ( *a < *b ) {
+    return -1;
+  }
+  return ( *a > *b ) ? 1 : 0;
+}
+
+/*
+================
+TimeDemoStat
+================
+*/
+static void TimeDemoStat(idList<float>& values, timeDemoStat_t& stat) {
+  memset(&stat, 0, sizeof(stat));
+
+  int num = values.Num();
+  if ( !num ) {
+    return;
+  }
+
+  values.Sort(TimeDemoFloatCompare);
+
+  for ( int i = 0; i < num; i++ ) {
+    stat.average += values[i];
+  }
+  stat.average /= num;
+
+  // nearest rank
+  stat.p50 = values[Max(0, idMath::FtoiFast(ceilf(0.50f * num)) - 1)];
+  stat.p95 = values[Max(0, idMath::FtoiFast(ceilf(0.95f * num)) - 1)];
+  stat.p99 = values[Max(0, idMath::FtoiFast(ceilf(0.99f * num)) - 1)];
+  stat.worst = values[num - 1];
+}
+
+/*
+================
+idSessionLocal::GetTimeDemoResult
+
+Summarizes the frames of the last timedemo, without the warm-up frames
+================
+*/
+void idSessionLocal::GetTimeDemoResult(const char* demoName, timeDemoResult_t& result) const {
+  idList<float> msec, frontendMsec, backendMsec, gameMsec;
+  float allocs = 0.0f, allocBytes = 0.0f;
+
+  // always keep the last frame
+  int first = Min(com_timeDemoWarmupFrames.GetInteger(), Max(timeDemoFrames.Num() - 1, 0));
+
+  result.demoName = demoName;
+  result.frames = timeDemoFrames.Num() - first;
+  result.seconds = 0.0f;
+
+  for ( int i = first; i < timeDemoFrames.Num(); i++ ) {
+    const timeDemoFrame_t& frame = timeDemoFrames[i];
+    msec.Append(frame.msec);
+    frontendMsec.Append(frame.frontendMsec);
+    backendMsec.Append(frame.backendMsec);
+    gameMsec.Append(frame.gameMsec);
+    allocs += frame.allocs;
+    allocBytes += frame.allocBytes;
+    result.seconds += frame.msec * 0.001f;
+  }
+
+  result.fps = result.seconds > 0.0f ? result.frames / result.seconds : 0.0f;
+  result.allocsPerFrame = result.frames ? allocs / result.frames : 0.0f;
+  result.allocBytesPerFrame = result.frames ? allocBytes / result.frames : 0.0f;
+
+  TimeDemoStat(msec, result.msec);
+  TimeDemoStat(frontendMsec, result.frontendMsec);
+  TimeDemoStat(backendMsec, result.backendMsec);
+  TimeDemoStat(gameMsec, result.gameMsec);
+}
+
+/*
+================
+idSessionLocal::StartBenchmarkDemos
+================
+*/
+void idSessionLocal::StartBenchmarkDemos(const char* name, const idStrList& demos, bool quit) {
+  if ( !demos.Num()) {
+    common->Printf("no demos to benchmark\n");
+    return;
+  }
+
+  benchmarkActive = true;
+  benchmarkQuit = quit;
+  benchmarkName = name;
+  benchmarkDemos = demos;
+  benchmarkDemoIndex = 0;
+  benchmarkResults.Clear();
+
+  NextBenchmarkDemo();
+}
+
+/*
+================
+idSessionLocal::NextBenchmarkDemo
+
+Starts the next timedemo of the benchmark, or writes the report after the last one
+================
+*/
+void idSessionLocal::NextBenchmarkDemo() {
+  if ( benchmarkDemoIndex >= benchmarkDemos.Num()) {
+    benchmarkActive = false;
+    WriteBenchmarkReport();
+    if ( benchmarkQuit ) {
+      cmdSystem->BufferCommandText(CMD_EXEC_APPEND, "quit\n");
+    }
+    else {
+      soundSystem->SetMute(false);
+    }
+    return;
+  }
+
+  const char* demo = benchmarkDemos[benchmarkDemoIndex++];
+  common->Printf("benchmark %s: %s (%i of %i)\n", benchmarkName.c_str(), demo, benchmarkDemoIndex, benchmarkDemos.Num());
+
+  TimeRenderDemo(va("demos/%s", demo));
+  if ( !readDemo ) {
+    common->Warning("benchmark %s: couldn't play %s", benchmarkName.c_str(), demo);
+  }
+}
+
+/*
+================
+WriteBenchmarkStat
+================
+*/
+static void WriteBenchmarkStat(idFile* f, const char* name, const timeDemoStat_t& stat, bool last) {
+  f->Printf("\t\t\t\"%s\": { \"avg\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"worst\": %.3f }%s\n", name,
+            stat.average, stat.p50, stat.p95, stat.p99, stat.worst, last ? "" : ",");
+}
+
+/*
+================
+idSessionLocal::WriteBenchmarkReport
+
+Writes benchmarks/<name>.csv and benchmarks/<name>.json
+================
+*/
+void idSessionLocal::WriteBenchmarkReport() {
+  int i;
+  idStr fileName = va("benchmarks/%s", benchmarkName.c_str());
+
+  fileName.SetFileExtension(".csv");
+  idFile* f = fileSystem->OpenFileWrite(fileName);
+  if ( !f ) {
+    common->Warning("couldn't write %s", fileName.c_str());
+    return;
+  }
+  f->Printf("demo,frames,seconds,fps,msec_avg,msec_p50,msec_p95,msec_p99,msec_worst,"
+            "frontend_p50,frontend_p99,frontend_worst,backend_p50,backend_p99,backend_worst,"
+            "game_p50,game_p99,game_worst,allocs_per_frame,alloc_bytes_per_frame\n");
+  for ( i = 0; i < benchmarkResults.Num(); i++ ) {
+    const timeDemoResult_t& r = benchmarkResults[i];
+    f->Printf("%s,%i,%.3f,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.1f,%.0f\n",
+              r.demoName.c_str(), r.frames, r.seconds, r.fps, r.msec.average, r.msec.p50, r.msec.p95, r.msec.p99,
+              r.msec.worst, r.frontendMsec.p50, r.frontendMsec.p99, r.frontendMsec.worst, r.backendMsec.p50,
+              r.backendMsec.p99, r.backendMsec.worst, r.gameMsec.p50, r.gameMsec.p99, r.gameMsec.worst,
+              r.allocsPerFrame, r.allocBytesPerFrame);
+  }
+  fileSystem->CloseFile(f);
+  common->Printf("wrote %s\n", fileName.c_str());
+
+  fileName.SetFileExtension(".json");
+  f = fileSystem->OpenFileWrite(fileName);
+  if ( !f ) {
+    common->Warning("couldn't write %s", fileName.c_str());
+    return;
+  }
+  f->Printf("{\n\t\"benchmark\": \"%s\",\n\t\"warmupFrames\": %i,\n\t\"headless\": %s,\n\t\"demos\": [\n",
+            benchmarkName.c_str(), com_timeDemoWarmupFrames.GetInteger(),
+            cvarSystem->GetCVarBool("r_headless") ? "true" : "false");
+  for ( i = 0; i < benchmarkResults.Num(); i++ ) {
+    const timeDemoResult_t& r = benchmarkResults[i];
+    f->Printf("\t\t{\n\t\t\t\"demo\": \"%s\",\n\t\t\t\"frames\": %i,\n\t\t\t\"seconds\": %.3f,\n\t\t\t\"fps\": %.2f,\n",
+              r.demoName.c_str(), r.frames, r.seconds, r.fps);
+    WriteBenchmarkStat(f, "msec", r.msec, false);
+    WriteBenchmarkStat(f, "frontendMsec", r.frontendMsec, false);
+    WriteBenchmarkStat(f, "backendMsec", r.backendMsec, false);
+    WriteBenchmarkStat(f, "gameMsec", r.gameMsec, false);
+    f->Printf("\t\t\t\"allocsPerFrame\": %.1f,\n\t\t\t\"allocBytesPerFrame\": %.0f\n\t\t}%s\n", r.allocsPerFrame,
+              r.allocBytesPerFrame, i < benchmarkResults.Num() - 1 ? "," : "");
+  }
+  f->Printf("\t]\n}\n");
+  fileSystem->CloseFile(f);
+  common->Printf("wrote %s\n", fileName.c_str());
+}
+
 
 
 /*
@@ -1019,6 +1456,98 @@ void idSessionLocal::CompressDemoFile(const char* scheme, const char* demoName)
 
 }
 
+/*
+================
+idSessionLocal::BenchmarkCompressors
+
+Compresses the uncompressed stream of a demo with every compressor and
+reports the ratio and the throughput in both directions.
+================
+*/
+void idSessionLocal::BenchmarkCompressors(const char* demoName) {
+  static const struct {
+    const char* name;
+    idCompressor* (* alloc)(void);
+  } compressors[] = {
+    { "None", idCompressor::AllocNoCompression },
+    { "RunLength", idCompressor::AllocRunLength },
+    { "Huffman", idCompressor::AllocHuffman },
+    { "Arithmetic", idCompressor::AllocArithmetic },
+    { "LZSS", idCompressor::AllocLZSS },
+    { "LZW", idCompressor::AllocLZW },
+    { "LZ", idCompressor::AllocLZ },
+  };
+
+  idStr fullDemoName = "demos/";
+  fullDemoName += demoName;
+  fullDemoName.DefaultFileExtension(".demo");
+
+  idDemoFile demoread;
+  if ( !demoread.OpenForReading(fullDemoName)) {
+    common->Printf("Could not open %s for reading\n", fullDemoName.c_str());
+    return;
+  }
+
+  idFile_Memory raw(fullDemoName);
+  raw.SetGranularity(1024 * 1024);
+
+  static const int bufferSize = 65536;
+  char buffer[bufferSize];
+  int bytesRead;
+  while ( 0 != ( bytesRead = demoread.Read(buffer, bufferSize))) {
+    raw.Write(buffer, bytesRead);
+  }
+  demoread.Close();
+
+  const int length = raw.Length();
+  if ( length <= 0 ) {
+    common->Printf("%s is empty\n", fullDemoName.c_str());
+    return;
+  }
+
+  common->SetRefreshOnPrint(true);
+  common->Printf("%s: %d KB uncompressed\n", fullDemoName.c_str(), length >> 10);
+  common->Printf("compressor    size     compress MB/s  decompress MB/s\n");
+
+  byte* check = (byte*) Mem_Alloc(length);
+
+  for ( int i = 0; i < int(sizeof(compressors) / sizeof(compressors[0])); i++ ) {
+    idFile_Memory packed(compressors[i].name);
+    packed.SetGranularity(1024 * 1024);
+
+    unsigned int startTime = Sys_Microseconds();
+
+    idCompressor* compressor = compressors[i].alloc();
+    compressor->Init(&packed, true, 8);
+    compressor->Write(raw.GetDataPtr(), length);
+    compressor->FinishCompress();
+    delete compressor;
+
+    unsigned int compressTime = Sys_Microseconds() - startTime;
+
+    idFile_Memory unpacked(compressors[i].name, (const char*) packed.GetDataPtr(), packed.Length());
+
+    startTime = Sys_Microseconds();
+
+    compressor = compressors[i].alloc();
+    compressor->Init(&unpacked, false, 8);
+    int read = compressor->Read(check, length);
+    delete compressor;
+
+    unsigned int decompressTime = Sys_Microseconds() - startTime;
+
+    bool ok = ( read == length && memcmp(check, raw.GetDataPtr(), length) == 0 );
+
+    common->Printf("%-12s %5.1f%%  %10.1f     %10.1f%s\n", compressors[i].name, packed.Length() * 100.0f / length,
+                   length / ( Max(compressTime, 1u) * 1.048576f ), length / ( Max(decompressTime, 1u) * 1.048576f ),
+                   ok ? "" : "  MISMATCH");
+  }
+
+  Mem_Free(check);
+
+  common->SetRefreshOnPrint(false);
+}
+
 
 /*
 ===============
@@ -1027,10 +1556,10 @@ idSess"ionLocal::StartNewGame
 */
 void idSessionLocal::StartNewGame(const char* mapName, bool devmap) {
 
-  //if (idAsyncNetwork::server.IsActive()) {
-  //  common->Printf("Server running, use si_map / serverMapRestart\n");
-  //  return;
-  //}
+  if (idAsyncNetwork::server.IsActive()) {
+    common->Printf("Server running, use si_map / serverMapRestart\n");
+    return;
+  }
   if ( idAsyncNetwork::client.IsActive()) {
     common->Printf("Client running, disconnect from server first\n");
     return;
@@ -1474,6 +2003,7 @@ void idSessionLocal::ExecuteMapChange(bool noFadeWipe) {
 
   // note which media we are going to need to load
   if ( !reloadingSameMap ) {
+    fileSystem->BeginLevelLoad(mapString.c_str());
     declManager->BeginLevelLoad();
     renderSystem->BeginLevelLoad();
     soundSystem->BeginLevelLoad();
@@ -1546,13 +2076,13 @@ void idSessionLocal::ExecuteMapChange(bool noFadeWipe) {
       savegameFile = NULL;
 
       game->SetServerInfo(mapSpawnData.serverInfo);
-      game->InitFromNewMap(fullMapName + ".map", rw, sw, /*idAsyncNetwork::server.IsActive()*/false,
+      game->InitFromNewMap(fullMapName + ".map", rw, sw, idAsyncNetwork::server.IsActive(),
                            idAsyncNetwork::client.IsActive(), Sys_Milliseconds());
     }
   }
   else {
     game->SetServerInfo(mapSpawnData.serverInfo);
-    game->InitFromNewMap(fullMapName + ".map", rw, sw, /*idAsyncNetwork::server.IsActive()*/ false,
+    game->InitFromNewMap(fullMapName + ".map", rw, sw, idAsyncNetwork::server.IsActive(),
                          idAsyncNetwork::client.IsActive(), Sys_Milliseconds());
   }
 
@@ -1571,6 +2101,7 @@ void idSessionLocal::ExecuteMapChange(bool noFadeWipe) {
     SetBytesNeededForMapLoad(mapString.c_str(), fileSystem->GetReadCount());
   }
   uiManager->EndLevelLoad();
+  fileSystem->EndLevelLoad();
 
   if ( !idAsyncNetwork::IsActive() && !loadingSaveGame ) {
     // run a few frames to allow everything to settle
@@ -1807,6 +2338,190 @@ void idSessionLocal::ScrubSaveGameFileName(idStr& saveFileName) const {
   }
 }
 
+#define SAVEGAME_COMPRESSED_ID    ( ( 'Z' << 24 ) | ( 'V' << 16 ) | ( 'A' << 8 ) | 'S' )    // LZW
+#define SAVEGAME_LZ_ID            ( ( 'L' << 24 ) | ( 'V' << 16 ) | ( 'A' << 8 ) | 'S' )
+#define SAVEGAME_GRANULARITY      ( 1024 * 1024 )
+#define SAVEGAME_WRITE_CHUNK      ( 256 * 1024 )    // written per frame without threads
+
+/*
+===============
+SaveGameWriteChunk
+
+Writes up to maxBytes of a pending savegame, returns true once all of it is on disk.
+===============
+*/
+static bool SaveGameWriteChunk(saveGameWrite_t* sw, int maxBytes) {
+  int length = sw->data->Length() - sw->offset;
+  if ( length > maxBytes ) {
+    length = maxBytes;
+  }
+  if ( length > 0 ) {
+    sw->file->Write(sw->data->GetDataPtr() + sw->offset, length);
+    sw->offset += length;
+  }
+
+  if ( sw->offset < sw->data->Length()) {
+    return false;
+  }
+
+  // make sure the savegame survives a crash right after saving
+  sw->file->Flush();
+
+  return true;
+}
+
+/*
+===============
+SaveGameWriteThread
+===============
+*/
+static int SaveGameWriteThread(void* parm) {
+  saveGameWrite_t* sw = (saveGameWrite_t*) parm;
+
+  SaveGameWriteChunk(sw, sw->data->Length());
+  sw->completed = true;
+
+  return 0;
+}
+
+/*
+===============
+idSessionLocal::StartSaveGameWrite
+
+Takes ownership of the open file and the data.  The data is written on a
+background thread, or spread over the next frames when there are no threads.
+===============
+*/
+void idSessionLocal::StartSaveGameWrite(idFile* file, idFile_Memory* data) {
+  UpdateSaveGameWrite(true);
+
+  saveGameWrite.file = file;
+  saveGameWrite.data = data;
+  saveGameWrite.offset = 0;
+  saveGameWrite.startTime = Sys_Milliseconds();
+  saveGameWrite.completed = false;
+
+#ifdef NOMT
+#else
+  Sys_CreateThread(SaveGameWriteThread, &saveGameWrite, saveGameWriteThread, "saveGameWrite");
+#endif
+}
+
+/*
+===============
+idSessionLocal::UpdateSaveGameWrite
+
+Closes the savegame file once it has been written, if finish is set
+this blocks until then.
+===============
+*/
+void idSessionLocal::UpdateSaveGameWrite(bool finish) {
+  if ( !saveGameWrite.file ) {
+    return;
+  }
+
+#ifdef NOMT
+  if ( !saveGameWrite.completed ) {
+    saveGameWrite.completed = SaveGameWriteChunk(&saveGameWrite,
+                                                 finish ? saveGameWrite.data->Length() : SAVEGAME_WRITE_CHUNK);
+  }
+#else
+  if ( !saveGameWrite.completed && !finish ) {
+    return;
+  }
+  Sys_DestroyThread(saveGameWriteThread);
+#endif
+
+  if ( !saveGameWrite.completed ) {
+    return;
+  }
+
+  common->Printf("wrote %s: %d KB in %d ms\n", saveGameWrite.data->GetName(), saveGameWrite.data->Length() >> 10,
+                 Sys_Milliseconds() - saveGameWrite.startTime);
+
+  fileSystem->CloseFile(saveGameWrite.file);
+  delete saveGameWrite.data;
+
+  saveGameWrite.file = NULL;
+  saveGameWrite.data = NULL;
+
+#ifdef __EMSCRIPTEN__
+  // only now is the whole savegame in the file, push it to IndexedDB
+  EM_ASM(
+      console.info('Syncing user home to IDBFS....');
+      FS.syncfs(false, function(err) {
+        console.info("Syncing done.");
+      });
+  );
+#endif
+}
+
+/*
+===============
+idSessionLocal::ReadSaveGameFile
+
+Reads a savegame into memory with a single read and decompresses it.  Returns
+NULL on failure, the file is closed either way.
+===============
+*/
+idFile* idSessionLocal::ReadSaveGameFile(idFile* file) {
+  idStr name = file->GetName();
+  int startTime = Sys_Milliseconds();
+
+  int length = file->Length();
+  if ( length <= 0 ) {
+    common->Warning("Empty savegame file %s", name.c_str());
+    fileSystem->CloseFile(file);
+    return NULL;
+  }
+
+  char* buffer = (char*) Mem_Alloc(length);
+  int read = file->Read(buffer, length);
+  fileSystem->CloseFile(file);
+
+  if ( read != length ) {
+    common->Warning("Couldn't read savegame file %s", name.c_str());
+    Mem_Free(buffer);
+    return NULL;
+  }
+
+  int readTime = Sys_Milliseconds();
+
+  idFile_Memory* data = new idFile_Memory(name);
+
+  int id = length >= 8 ? LittleInt(((int*) buffer)[0]) : 0;
+  if ( id == SAVEGAME_COMPRESSED_ID || id == SAVEGAME_LZ_ID ) {
+    int uncompressedLength = LittleInt(((int*) buffer)[1]);
+    char* uncompressed = (char*) Mem_Alloc(uncompressedLength > 0 ? uncompressedLength : 1);
+
+    idFile_Memory compressedFile(name, (const char*) buffer + 8, length - 8);
+    idCompressor* compressor = ( id == SAVEGAME_LZ_ID ) ? idCompressor::AllocLZ() : idCompressor::AllocLZW();
+    compressor->Init(&compressedFile, false, 8);
+    read = compressor->Read(uncompressed, uncompressedLength);
+    delete compressor;
+
+    Mem_Free(buffer);
+
+    if ( uncompressedLength <= 0 || read != uncompressedLength ) {
+      common->Warning("Truncated savegame file %s", name.c_str());
+      Mem_Free(uncompressed);
+      delete data;
+      return NULL;
+    }
+
+    data->TakeData(uncompressed, uncompressedLength);
+  }
+  else {
+    // savegame from before compression
+    data->TakeData(buffer, length);
+  }
+
+  common->Printf("read %s: %d KB (%d KB uncompressed), read in %d ms, decompressed in %d ms\n", name.c_str(),
+                 length >> 10, data->Length() >> 10, readTime - startTime, Sys_Milliseconds() - readTime);
+
+  return data;
+}
+
 /*
 ===============
 idSessionLocal::SaveGame
@@ -1859,6 +2574,9 @@ bool idSessionLocal::SaveGame(const char* saveName, bool autosave) {
   descriptionFile = gameFile;
   descriptionFile.SetFileExtension(".txt");
 
+  // a previous save to the same file must be complete before it is reopened
+  UpdateSaveGameWrite(true);
+
   // Open savegame file
   idFile* fileOut = fileSystem->OpenFileWrite(gameFile);
   if ( fileOut == NULL ) {
@@ -1870,31 +2588,59 @@ bool idSessionLocal::SaveGame(const char* saveName, bool autosave) {
     return false;
   }
 
+  // serialize everything to memory first, the many small writes would be slow on a real file
+  int startTime = Sys_Milliseconds();
+
+  idFile_Memory* saveData = new idFile_Memory(gameFile);
+  saveData->SetGranularity(SAVEGAME_GRANULARITY);
+
   // Write SaveGame Header:
   // Game Name / Version / Map Name / Persistant Player Info
 
   // game
   const char* gamename = GAME_NAME;
-  fileOut->WriteString(gamename);
+  saveData->WriteString(gamename);
 
   // version
-  fileOut->WriteInt(SAVEGAME_VERSION);
+  saveData->WriteInt(SAVEGAME_VERSION);
 
   // map
   mapName = mapSpawnData.serverInfo.GetString("si_map");
-  fileOut->WriteString(mapName);
+  saveData->WriteString(mapName);
 
   // persistent player info
   for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
     mapSpawnData.persistentPlayerInfo[i] = game->GetPersistentPlayerInfo(i);
-    mapSpawnData.persistentPlayerInfo[i].WriteToFileHandle(fileOut);
+    mapSpawnData.persistentPlayerInfo[i].WriteToFileHandle(saveData);
   }
 
   // let the game save its state
-  game->SaveGame(fileOut);
+  game->SaveGame(saveData);
+
+  int serializeTime = Sys_Milliseconds();
+  int saveLength = saveData->Length();
+
+  idFile_Memory* fileData = saveData;
+  if ( com_compressSaveGames.GetBool()) {
+    fileData = new idFile_Memory(gameFile);
+    fileData->SetGranularity(SAVEGAME_GRANULARITY);
+    fileData->WriteInt(SAVEGAME_LZ_ID);
+    fileData->WriteInt(saveLength);
+
+    idCompressor* compressor = idCompressor::AllocLZ();
+    compressor->Init(fileData, true, 8);
+    compressor->Write(saveData->GetDataPtr(), saveLength);
+    compressor->FinishCompress();
+    delete compressor;
+
+    delete saveData;
+  }
+
+  common->Printf("saved %s: %d KB (%d KB uncompressed), serialized in %d ms, compressed in %d ms\n", gameFile.c_str(),
+                 fileData->Length() >> 10, saveLength >> 10, serializeTime - startTime, Sys_Milliseconds() - serializeTime);
 
-  // close the sava game file
-  fileSystem->CloseFile(fileOut);
+  // the file is written and closed in the background
+  StartSaveGameWrite(fileOut, fileData);
 
   // Write screenshot
   if ( !autosave ) {
@@ -1976,6 +2722,9 @@ bool idSessionLocal::LoadGame(const char* saveName) {
   in = "savegames/";
   in += loadFile;
 
+  // the savegame may still be in the process of being written
+  UpdateSaveGameWrite(true);
+
   // Open savegame file
   // only allow loads from the game directory because we don't want a base game to load
   idStr game = cvarSystem->GetCVarString("fs_game");
@@ -1986,6 +2735,12 @@ bool idSessionLocal::LoadGame(const char* saveName) {
     return false;
   }
 
+  // read it with a single call, all the small reads of the restore then come from memory
+  savegameFile = ReadSaveGameFile(savegameFile);
+  if ( savegameFile == NULL ) {
+    return false;
+  }
+
   loadingSaveGame = true;
 
   // Read in save game header
@@ -2270,7 +3025,7 @@ void idSessionLocal::PacifierUpdate() {
   UpdateScreen();
 
   idAsyncNetwork::client.PacifierUpdate();
-  //idAsyncNetwork::server.PacifierUpdate();
+  idAsyncNetwork::server.PacifierUpdate();
 }
 
 /*
@@ -2395,13 +3150,26 @@ void idSessionLocal::UpdateScreen(bool outOfSequence) {
   // draw everything
   Draw();
 
-  if ( com_speeds.GetBool()) {
+  if ( com_speeds.GetBool() || timeDemo ) {
     renderSystem->EndFrame(&time_frontend, &time_backend);
   }
   else {
     renderSystem->EndFrame(NULL, NULL);
   }
 
+  if ( readDemo && timeDemo ) {
+    RecordTimeDemoFrame();
+  }
+
+  // indexed demos get the full render and sound world state every so often,
+  // but not from loading screens, where the world is still being built
+  if ( writeDemo && !outOfSequence && !insideExecuteMapChange && writeDemo->NeedsKeyframe()) {
+    writeDemo->BeginKeyframe();
+    sw->StartWritingDemo(writeDemo);
+    rw->WriteDemoKeyframe();
+    writeDemo->EndKeyframe();
+  }
+
   insideUpdateScreen = false;
 }
 
@@ -2581,6 +3349,14 @@ idSessionLocal::Frame
 // EMTERPRETIFY
 void idSessionLocal::Frame() {
 
+  // keep writing a savegame in the background
+  UpdateSaveGameWrite(false);
+
+  // the next demo of a benchmark starts once the last one has finished
+  if ( benchmarkActive && !readDemo ) {
+    NextBenchmarkDemo();
+  }
+
   if ( !emsessionframe_pre()) {
     return;
   }
@@ -2761,8 +3537,20 @@ void idSessionLocal::Init() {
                         idCmdSystem::ArgCompletion_DemoName);
   cmdSystem->AddCommand("timeDemoQuit", Session_TimeDemoQuit_f, CMD_FL_SYSTEM, "times a demo and quits",
                         idCmdSystem::ArgCompletion_DemoName);
+  cmdSystem->AddCommand("renderDemoAudio", Session_RenderDemoAudio_f, CMD_FL_SYSTEM, "writes the audio of a demo to a wave file",
+                        idCmdSystem::ArgCompletion_DemoName);
+  cmdSystem->AddCommand("benchmarkDemos", Session_BenchmarkDemos_f, CMD_FL_SYSTEM,
+                        "times a list of demos and writes benchmarks/<name>.csv and .json");
+  cmdSystem->AddCommand("benchmarkDemosQuit", Session_BenchmarkDemosQuit_f, CMD_FL_SYSTEM,
+                        "times a list of demos, writes the report and quits");
+  cmdSystem->AddCommand("demoSeek", Session_DemoSeek_f, CMD_FL_SYSTEM, "continues demo playback from a frame");
+  cmdSystem->AddCommand("demoIndex", Session_DemoIndex_f, CMD_FL_SYSTEM, "lists the keyframes of a demo",
+                        idCmdSystem::ArgCompletion_DemoName);
   cmdSystem->AddCommand("compressDemo", Session_CompressDemo_f, CMD_FL_SYSTEM, "compresses a demo file",
                         idCmdSystem::ArgCompletion_DemoName);
+  cmdSystem->AddCommand("benchmarkCompressors", Session_BenchmarkCompressors_f, CMD_FL_SYSTEM,
+                        "reports ratio and throughput of every compressor on a demo",
+                        idCmdSystem::ArgCompletion_DemoName);
 
   cmdSystem->AddCommand("disconnect", Session_Disconnect_f, CMD_FL_SYSTEM, "disconnects from a game");
 
@@ -2824,15 +3612,13 @@ idSessionLocal::GetLocalClientNum
 int idSessionLocal::GetLocalClientNum() {
   if ( idAsyncNetwork::client.IsActive()) {
     return idAsyncNetwork::client.GetLocalClientNum();
-  } /*else if (idAsyncNetwork::server.IsActive()) {
-    if (idAsyncNetwork::serverDedicated.GetInteger() == 0) {
-      return 0;
-    } else if (idAsyncNetwork::server.IsClientInGame(idAsyncNetwork::serverDrawClient.GetInteger())) {
+  } else if (idAsyncNetwork::server.IsActive()) {
+    if (idAsyncNetwork::server.IsClientInGame(idAsyncNetwork::serverDrawClient.GetInteger())) {
       return idAsyncNetwork::serverDrawClient.GetInteger();
     } else {
       return -1;
     }
-  }*/ else {
+  } else {
     return 0;
   }
 }
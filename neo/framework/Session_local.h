@@ -39,6 +39,8 @@ If you have questions concerning this license or the applicable additional terms
 #include "renderer/RenderWorld.h"
 #include "ui/ListGUI.h"
 
+class idFile_Memory;
+
 /*
 
 IsConnectedToServer();
@@ -90,6 +92,47 @@ const int USERCMD_PER_DEMO_FRAME	= 2;
 const int CONNECT_TRANSMIT_TIME		= 1000;
 const int MAX_LOGGED_USERCMDS		= 60*60*60;	// one hour of single player, 15 minutes of four player
 
+// timings of a single frame of a timedemo
+typedef struct {
+	float				msec;				// whole frame
+	int					frontendMsec;
+	int					backendMsec;
+	int					gameMsec;
+	int					allocs;
+	int					allocBytes;
+} timeDemoFrame_t;
+
+typedef struct {
+	float				average;
+	float				p50;
+	float				p95;
+	float				p99;
+	float				worst;
+} timeDemoStat_t;
+
+// summary of a timedemo with the warm-up frames left out
+typedef struct {
+	idStr				demoName;
+	int					frames;
+	float				seconds;
+	float				fps;
+	timeDemoStat_t		msec;
+	timeDemoStat_t		frontendMsec;
+	timeDemoStat_t		backendMsec;
+	timeDemoStat_t		gameMsec;
+	float				allocsPerFrame;
+	float				allocBytesPerFrame;
+} timeDemoResult_t;
+
+// a finished savegame that is written to disk after SaveGame returned
+typedef struct {
+	idFile *			file;				// opened and closed on the main thread
+	idFile_Memory *		data;				// contents of the savegame file
+	int					offset;				// bytes written so far
+	int					startTime;
+	volatile bool		completed;
+} saveGameWrite_t;
+
 class idSessionLocal : public idSession {
 public:
 
@@ -165,6 +208,11 @@ public:
 	bool				LoadGame(const char *saveName);
 	bool				SaveGame(const char *saveName, bool autosave = false);
 
+						// savegames are serialized to memory and written to disk afterwards
+	idFile *			ReadSaveGameFile( idFile *file );
+	void				StartSaveGameWrite( idFile *file, idFile_Memory *data );
+	void				UpdateSaveGameWrite( bool finish );
+
 	const char			*GetAuthMsg( void );
 
 	//=====================================
@@ -177,6 +225,8 @@ public:
 	static idCVar		com_skipGameDraw;
 	static idCVar		com_wipeSeconds;
 	static idCVar		com_guid;
+	static idCVar		com_compressSaveGames;
+	static idCVar		com_timeDemoWarmupFrames;
 
 	static idCVar		gui_configServerRate;
 
@@ -214,6 +264,9 @@ public:
 	idFile *			savegameFile;		// this is the savegame file to load from
 	int					savegameVersion;
 
+	saveGameWrite_t		saveGameWrite;		// savegame still being written to disk
+	xthreadInfo			saveGameWriteThread;
+
 	idFile *			cmdDemoFile;		// if non-zero, we are reading commands from a file
 
 	int					latchedTicNumber;	// set to com_ticNumber each frame
@@ -224,6 +277,16 @@ public:
 	timeDemo_t			timeDemo;
 	int					timeDemoStartTime;
 	int					numDemoFrames;		// for timeDemo and demoShot
+	idList<timeDemoFrame_t>	timeDemoFrames;
+	unsigned int		timeDemoFrameTime;
+
+	// benchmarkDemos runs a list of timedemos and writes a report
+	bool				benchmarkActive;
+	bool				benchmarkQuit;
+	idStr				benchmarkName;
+	idStrList			benchmarkDemos;
+	int					benchmarkDemoIndex;
+	idList<timeDemoResult_t>	benchmarkResults;
 	int					demoTimeOffset;
 	renderView_t		currentDemoRenderView;
 	// the next one will be read when
@@ -276,8 +339,15 @@ public:
 	void				StopRecordingRenderDemo();
 	void				StartPlayingRenderDemo( idStr name );
 	void				StopPlayingRenderDemo();
+	void				SeekRenderDemo( int frame );
 	void				CompressDemoFile( const char *scheme, const char *name );
+	void				BenchmarkCompressors( const char *name );
 	void				TimeRenderDemo( const char *name, bool twice = false );
+	void				RecordTimeDemoFrame();
+	void				GetTimeDemoResult( const char *demoName, timeDemoResult_t &result ) const;
+	void				StartBenchmarkDemos( const char *name, const idStrList &demos, bool quit );
+	void				NextBenchmarkDemo();
+	void				WriteBenchmarkReport();
 
 	void				AdvanceRenderDemo( bool singleFrameOnly );
 	bool				RunGameTic();
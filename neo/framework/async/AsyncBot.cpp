@@ -0,0 +1,519 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "sys/platform.h"
+#include "idlib/math/Angles.h"
+#include "idlib/LangDict.h"
+#include "framework/async/AsyncNetwork.h"
+#include "framework/DeclManager.h"
+
+#include "framework/async/AsyncBot.h"
+
+const int BOT_CONNECTION_RESEND_TIME	= 1000;
+const int BOT_EMPTY_RESEND_TIME			= 500;
+const int BOT_USERCMD_BACKUP			= 3;
+
+/*
+==================
+idAsyncBot::idAsyncBot
+==================
+*/
+idAsyncBot::idAsyncBot( void ) {
+	botNum = 0;
+	Clear();
+}
+
+/*
+==================
+idAsyncBot::Clear
+==================
+*/
+void idAsyncBot::Clear( void ) {
+	state = BS_DISCONNECTED;
+	clientId = 0;
+	clientNum = -1;
+	serverId = 0;
+	serverChallenge = 0;
+	serverMessageSequence = 0;
+	snapshotSequence = 0;
+	gameInitId = GAME_INIT_ID_INVALID;
+	gameFrame = 0;
+	gameTime = 0;
+	lastConnectTime = -9999;
+	lastEmptyTime = -9999;
+	memset( userCmds, 0, sizeof( userCmds ) );
+	sentUserInfo.Clear();
+}
+
+/*
+==================
+idAsyncBot::Time
+==================
+*/
+int idAsyncBot::Time( void ) const {
+	return Sys_Milliseconds();
+}
+
+/*
+==================
+idAsyncBot::Connect
+==================
+*/
+bool idAsyncBot::Connect( int num, const netadr_t adr ) {
+	if ( IsActive() ) {
+		return false;
+	}
+
+	if ( !port.GetPort() ) {
+		if ( !port.InitForPort( PORT_ANY ) ) {
+			common->Printf( "Couldn't open bot network port.\n" );
+			return false;
+		}
+	}
+
+	Clear();
+
+	serverAddress = adr;
+
+	botNum = num;
+
+	// pseudo random client id, spread out so bots added in the same millisecond differ
+	clientId = ( Sys_Milliseconds() + botNum * 4099 ) & CONNECTIONLESS_MESSAGE_ID_MASK;
+
+	userInfo = *cvarSystem->MoveCVarsToDict( CVAR_USERINFO );
+	userInfo.Set( "ui_name", va( "bot%d", botNum ) );
+	userInfo.Set( "ui_spectate", "Play" );
+	userInfo.Set( "ui_ready", "Ready" );
+
+	state = BS_CHALLENGING;
+	return true;
+}
+
+/*
+==================
+idAsyncBot::Disconnect
+==================
+*/
+void idAsyncBot::Disconnect( void ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	if ( state >= BS_CONNECTED ) {
+		msg.Init( msgBuf, sizeof( msgBuf ) );
+		msg.WriteByte( CLIENT_RELIABLE_MESSAGE_DISCONNECT );
+		msg.WriteString( "disconnect" );
+		channel.SendReliableMessage( msg );
+
+		// push the reliable message out, the server drops us on the first one it reads
+		for ( int i = 0; i < 3; i++ ) {
+			lastEmptyTime = -9999;
+			SendEmpty();
+		}
+	}
+
+	channel.Shutdown();
+	port.Close();
+	Clear();
+}
+
+/*
+==================
+idAsyncBot::BuildUsercmd
+
+Runs in a wide circle and fires a short burst every two seconds.
+==================
+*/
+void idAsyncBot::BuildUsercmd( usercmd_t &cmd ) {
+	memset( &cmd, 0, sizeof( cmd ) );
+	cmd.gameFrame = gameFrame;
+	cmd.gameTime = gameTime;
+	cmd.forwardmove = 127;
+	cmd.buttons = BUTTON_RUN;
+	if ( ( gameFrame + botNum * 17 ) % 120 < 10 ) {
+		cmd.buttons |= BUTTON_ATTACK;
+	}
+	cmd.angles[YAW] = ANGLE2SHORT( (float)( ( gameTime / 25 + botNum * 45 ) % 360 ) );
+}
+
+/*
+==================
+idAsyncBot::SendToServer
+==================
+*/
+void idAsyncBot::SendToServer( idBitMsg &msg ) {
+	channel.SendMessage( port, Time(), msg );
+	while( channel.UnsentFragmentsLeft() ) {
+		channel.SendNextFragment( port, Time() );
+	}
+}
+
+/*
+==================
+idAsyncBot::SendConnectionMessage
+==================
+*/
+void idAsyncBot::SendConnectionMessage( void ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	if ( Time() - lastConnectTime < BOT_CONNECTION_RESEND_TIME ) {
+		return;
+	}
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteShort( CONNECTIONLESS_MESSAGE_ID );
+	if ( state == BS_CHALLENGING ) {
+		msg.WriteString( "challenge" );
+		msg.WriteInt( clientId );
+	} else {
+		msg.WriteString( "connect" );
+		msg.WriteInt( ASYNC_PROTOCOL_VERSION );
+		msg.WriteInt( declManager->GetChecksum() );
+		msg.WriteInt( serverChallenge );
+		msg.WriteShort( clientId );
+		msg.WriteInt( cvarSystem->GetCVarInteger( "net_clientMaxRate" ) );
+		msg.WriteString( va( "bot%d", botNum ) );
+		msg.WriteString( cvarSystem->GetCVarString( "password" ), -1, false );
+		msg.WriteShort( 0 );
+	}
+	port.SendPacket( serverAddress, msg.GetData(), msg.GetSize() );
+
+	lastConnectTime = Time();
+}
+
+/*
+==================
+idAsyncBot::SendUserInfo
+==================
+*/
+void idAsyncBot::SendUserInfo( void ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteByte( CLIENT_RELIABLE_MESSAGE_CLIENTINFO );
+	msg.WriteDeltaDict( userInfo, &sentUserInfo );
+	if ( channel.SendReliableMessage( msg ) ) {
+		sentUserInfo = userInfo;
+	}
+}
+
+/*
+==================
+idAsyncBot::SendEmpty
+==================
+*/
+void idAsyncBot::SendEmpty( void ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	if ( Time() - lastEmptyTime < BOT_EMPTY_RESEND_TIME ) {
+		return;
+	}
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteInt( serverMessageSequence );
+	msg.WriteInt( gameInitId );
+	msg.WriteInt( snapshotSequence );
+	msg.WriteByte( CLIENT_UNRELIABLE_MESSAGE_EMPTY );
+	SendToServer( msg );
+
+	lastEmptyTime = Time();
+}
+
+/*
+==================
+idAsyncBot::SendPingResponse
+==================
+*/
+void idAsyncBot::SendPingResponse( int time ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteInt( serverMessageSequence );
+	msg.WriteInt( gameInitId );
+	msg.WriteInt( snapshotSequence );
+	msg.WriteByte( CLIENT_UNRELIABLE_MESSAGE_PINGRESPONSE );
+	msg.WriteInt( time );
+	SendToServer( msg );
+}
+
+/*
+==================
+idAsyncBot::SendUsercmds
+==================
+*/
+void idAsyncBot::SendUsercmds( void ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+	usercmd_t *	last;
+	int			i;
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteInt( serverMessageSequence );
+	msg.WriteInt( gameInitId );
+	msg.WriteInt( snapshotSequence );
+	msg.WriteByte( CLIENT_UNRELIABLE_MESSAGE_USERCMD );
+	msg.WriteShort( 0 );
+
+	msg.WriteInt( gameFrame );
+	msg.WriteByte( BOT_USERCMD_BACKUP );
+	for ( last = NULL, i = gameFrame - BOT_USERCMD_BACKUP + 1; i <= gameFrame; i++ ) {
+		usercmd_t &cmd = userCmds[i & ( MAX_USERCMD_BACKUP - 1 )];
+		idAsyncNetwork::WriteUserCmdDelta( msg, cmd, last );
+		last = &cmd;
+	}
+	SendToServer( msg );
+}
+
+/*
+==================
+idAsyncBot::ConnectionlessMessage
+==================
+*/
+void idAsyncBot::ConnectionlessMessage( const idBitMsg &msg ) {
+	char string[MAX_STRING_CHARS];
+
+	msg.ReadString( string, sizeof( string ) );
+
+	if ( idStr::Icmp( string, "challengeResponse" ) == 0 ) {
+		if ( state != BS_CHALLENGING ) {
+			return;
+		}
+		serverChallenge = msg.ReadInt();
+		serverId = msg.ReadShort();
+		state = BS_CONNECTING;
+		lastConnectTime = -9999;
+		return;
+	}
+
+	if ( idStr::Icmp( string, "connectResponse" ) == 0 ) {
+		if ( state != BS_CONNECTING ) {
+			return;
+		}
+		channel.Init( serverAddress, clientId );
+		clientNum = msg.ReadInt();
+		gameInitId = msg.ReadInt();
+		gameFrame = msg.ReadInt();
+		gameTime = msg.ReadInt();
+		state = BS_CONNECTED;
+		lastEmptyTime = -9999;
+		sentUserInfo.Clear();
+		if ( idAsyncNetwork::verbose.GetInteger() ) {
+			common->Printf( "bot%d connected as client %d\n", botNum, clientNum );
+		}
+		return;
+	}
+
+	if ( idStr::Icmp( string, "disconnect" ) == 0 ) {
+		common->Printf( "bot%d was disconnected by the server\n", botNum );
+		channel.Shutdown();
+		port.Close();
+		Clear();
+		return;
+	}
+
+	if ( idStr::Icmp( string, "print" ) == 0 ) {
+		if ( msg.ReadInt() == SERVER_PRINT_GAMEDENY ) {
+			msg.ReadInt();
+		}
+		msg.ReadString( string, sizeof( string ) );
+		common->Printf( "bot%d: %s\n", botNum, common->GetLanguageDict()->GetString( string ) );
+		return;
+	}
+}
+
+/*
+==================
+idAsyncBot::ProcessReliableServerMessages
+
+Everything but the enter game and disconnect notifications is meant for the
+game code, which a bot doesn't run.
+==================
+*/
+void idAsyncBot::ProcessReliableServerMessages( void ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+
+	while ( channel.GetReliableMessage( msg ) ) {
+		switch( msg.ReadByte() ) {
+			case SERVER_RELIABLE_MESSAGE_ENTERGAME: {
+				SendUserInfo();
+				break;
+			}
+			case SERVER_RELIABLE_MESSAGE_DISCONNECT: {
+				if ( msg.ReadInt() == clientNum ) {
+					common->Printf( "bot%d was dropped by the server\n", botNum );
+					channel.Shutdown();
+					port.Close();
+					Clear();
+					return;
+				}
+				break;
+			}
+			default: {
+				break;
+			}
+		}
+	}
+}
+
+/*
+==================
+idAsyncBot::ProcessUnreliableServerMessage
+==================
+*/
+void idAsyncBot::ProcessUnreliableServerMessage( const idBitMsg &msg ) {
+	int serverGameInitId, snapshotGameFrame, snapshotGameTime;
+
+	serverGameInitId = msg.ReadInt();
+
+	switch( msg.ReadByte() ) {
+		case SERVER_UNRELIABLE_MESSAGE_PING: {
+			SendPingResponse( msg.ReadInt() );
+			break;
+		}
+		case SERVER_UNRELIABLE_MESSAGE_GAMEINIT: {
+			gameInitId = serverGameInitId;
+			gameFrame = msg.ReadInt();
+			gameTime = msg.ReadInt();
+			memset( userCmds, 0, sizeof( userCmds ) );
+			sentUserInfo.Clear();
+			channel.ResetRate();
+			state = BS_CONNECTED;
+			lastEmptyTime = -9999;
+			break;
+		}
+		case SERVER_UNRELIABLE_MESSAGE_SNAPSHOT: {
+			if ( serverGameInitId != gameInitId ) {
+				break;
+			}
+			snapshotSequence = msg.ReadInt();
+			snapshotGameFrame = msg.ReadInt();
+			snapshotGameTime = msg.ReadInt();
+			if ( state == BS_CONNECTED ) {
+				state = BS_INGAME;
+			}
+			// never fall behind the server, the usercmds would only be duplicated
+			if ( gameFrame < snapshotGameFrame ) {
+				gameFrame = snapshotGameFrame;
+				gameTime = snapshotGameTime;
+			}
+			break;
+		}
+		default: {
+			break;
+		}
+	}
+}
+
+/*
+==================
+idAsyncBot::ProcessMessage
+==================
+*/
+void idAsyncBot::ProcessMessage( const netadr_t from, idBitMsg &msg ) {
+	int id;
+
+	if ( !Sys_CompareNetAdrBase( from, serverAddress ) || from.port != serverAddress.port ) {
+		return;
+	}
+
+	id = msg.ReadShort();
+	if ( id == CONNECTIONLESS_MESSAGE_ID ) {
+		ConnectionlessMessage( msg );
+		return;
+	}
+
+	if ( state < BS_CONNECTED || id != serverId || msg.GetRemaingData() < 4 ) {
+		return;
+	}
+
+	if ( !channel.Process( from, Time(), msg, serverMessageSequence ) ) {
+		return;
+	}
+
+	ProcessReliableServerMessages();
+	if ( state >= BS_CONNECTED ) {
+		ProcessUnreliableServerMessage( msg );
+	}
+}
+
+/*
+==================
+idAsyncBot::RunFrame
+==================
+*/
+void idAsyncBot::RunFrame( int numFrames ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+	netadr_t	from;
+	int			size;
+
+	if ( !IsActive() ) {
+		return;
+	}
+
+	while( IsActive() && port.GetPacket( from, msgBuf, size, sizeof( msgBuf ) ) ) {
+		msg.Init( msgBuf, sizeof( msgBuf ) );
+		msg.SetSize( size );
+		msg.BeginReading();
+		ProcessMessage( from, msg );
+	}
+
+	switch( state ) {
+		case BS_CHALLENGING:
+		case BS_CONNECTING: {
+			SendConnectionMessage();
+			break;
+		}
+		case BS_CONNECTED: {
+			SendEmpty();
+			break;
+		}
+		case BS_INGAME: {
+			for ( int i = 0; i < numFrames; i++ ) {
+				gameFrame++;
+				gameTime += USERCMD_MSEC;
+				BuildUsercmd( userCmds[gameFrame & ( MAX_USERCMD_BACKUP - 1 )] );
+			}
+			if ( numFrames > 0 ) {
+				SendUsercmds();
+			} else {
+				SendEmpty();
+			}
+			break;
+		}
+		default: {
+			break;
+		}
+	}
+}
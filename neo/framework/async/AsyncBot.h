@@ -0,0 +1,109 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#ifndef __ASYNCBOT_H__
+#define __ASYNCBOT_H__
+
+#include "idlib/Dict.h"
+#include "framework/async/MsgChannel.h"
+#include "framework/UsercmdGen.h"
+
+/*
+===============================================================================
+
+  Loopback bot for the dedicated server.
+
+  A bot opens its own UDP port and talks to the server through 127.0.0.1
+  with the same packets a real client sends: challenge, connect, usercmds
+  and snapshot acknowledges.  It never decodes the game snapshots, it only
+  reads the headers it needs to stay in sync, so it puts the full network
+  load of a player on the server without running a second game.
+
+===============================================================================
+*/
+
+typedef enum {
+	BS_DISCONNECTED,
+	BS_CHALLENGING,
+	BS_CONNECTING,
+	BS_CONNECTED,
+	BS_INGAME
+} botState_t;
+
+class idAsyncBot {
+public:
+						idAsyncBot();
+
+	bool				Connect( int botNum, const netadr_t adr );
+	void				Disconnect( void );
+	bool				IsActive( void ) const { return state != BS_DISCONNECTED; }
+	int					GetClientNum( void ) const { return clientNum; }
+
+						// process incoming packets and send usercmds for the game frames the server just ran
+	void				RunFrame( int numFrames );
+
+private:
+	botState_t			state;
+	int					botNum;
+	idPort				port;
+	netadr_t			serverAddress;
+	idMsgChannel		channel;
+
+	int					clientId;					// client identification
+	int					clientNum;					// client number on server
+	int					serverId;					// server identification
+	int					serverChallenge;			// challenge from server
+	int					serverMessageSequence;		// sequence number of last server message
+	int					snapshotSequence;			// sequence number of the last received snapshot
+
+	int					gameInitId;					// game initialization identification
+	int					gameFrame;					// game frame of the last generated usercmd
+	int					gameTime;					// game time of the last generated usercmd
+	int					lastConnectTime;			// last time a connect message was sent
+	int					lastEmptyTime;				// last time an empty message was sent
+
+	usercmd_t			userCmds[MAX_USERCMD_BACKUP];
+	idDict				userInfo;					// user info the bot plays with
+	idDict				sentUserInfo;				// user info the server knows about
+
+	int					Time( void ) const;
+	void				Clear( void );
+	void				BuildUsercmd( usercmd_t &cmd );
+	void				SendConnectionMessage( void );
+	void				SendUserInfo( void );
+	void				SendEmpty( void );
+	void				SendPingResponse( int time );
+	void				SendUsercmds( void );
+	void				SendToServer( idBitMsg &msg );
+	void				ConnectionlessMessage( const idBitMsg &msg );
+	void				ProcessReliableServerMessages( void );
+	void				ProcessUnreliableServerMessage( const idBitMsg &msg );
+	void				ProcessMessage( const netadr_t from, idBitMsg &msg );
+};
+
+#endif /* !__ASYNCBOT_H__ */
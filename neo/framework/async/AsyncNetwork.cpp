@@ -35,12 +35,12 @@ If you have questions concerning this license or the applicable additional terms
 
 #include "framework/async/AsyncNetwork.h"
 
-//idAsyncServer		idAsyncNetwork::server;
+idAsyncServer		idAsyncNetwork::server;
 idAsyncClient		idAsyncNetwork::client;
 
 idCVar				idAsyncNetwork::verbose( "net_verbose", "0", CVAR_SYSTEM | CVAR_INTEGER | CVAR_NOCHEAT, "1 = verbose output, 2 = even more verbose output", 0, 2, idCmdSystem::ArgCompletion_Integer<0,2> );
 idCVar				idAsyncNetwork::allowCheats( "net_allowCheats", "0", CVAR_SYSTEM | CVAR_BOOL | CVAR_NETWORKSYNC, "Allow cheats in network game" );
-//idCVar				idAsyncNetwork::serverDedicated( "net_serverDedicated", "0", CVAR_SERVERINFO | CVAR_SYSTEM | CVAR_INTEGER | CVAR_NOCHEAT, "1 = text console dedicated server, 2 = graphical dedicated server", 0, 2, idCmdSystem::ArgCompletion_Integer<0,2> );
+idCVar				idAsyncNetwork::serverDedicated( "net_serverDedicated", "0", CVAR_SERVERINFO | CVAR_SYSTEM | CVAR_INTEGER | CVAR_NOCHEAT, "1 = text console dedicated server, 2 = graphical dedicated server", 0, 2, idCmdSystem::ArgCompletion_Integer<0,2> );
 idCVar				idAsyncNetwork::serverSnapshotDelay( "net_serverSnapshotDelay", "50", CVAR_SYSTEM | CVAR_INTEGER | CVAR_NOCHEAT, "delay between snapshots in milliseconds" );
 idCVar				idAsyncNetwork::serverMaxClientRate( "net_serverMaxClientRate", "16000", CVAR_SYSTEM | CVAR_INTEGER | CVAR_ARCHIVE | CVAR_NOCHEAT, "maximum rate to a client in bytes/sec" );
 idCVar				idAsyncNetwork::clientMaxRate( "net_clientMaxRate", "16000", CVAR_SYSTEM | CVAR_INTEGER | CVAR_ARCHIVE | CVAR_NOCHEAT, "maximum rate requested by client from server in bytes/sec" );
@@ -63,6 +63,7 @@ idCVar				idAsyncNetwork::master4( "net_master4", "", CVAR_SYSTEM | CVAR_ARCHIVE
 idCVar				idAsyncNetwork::LANServer( "net_LANServer", "0", CVAR_SYSTEM | CVAR_BOOL | CVAR_NOCHEAT, "config LAN games only - affects clients and servers" );
 idCVar				idAsyncNetwork::serverReloadEngine( "net_serverReloadEngine", "0", CVAR_SYSTEM | CVAR_INTEGER | CVAR_NOCHEAT, "perform a full reload on next map restart (including flushing referenced pak files) - decreased if > 0" );
 idCVar				idAsyncNetwork::idleServer( "si_idleServer", "0", CVAR_SYSTEM | CVAR_BOOL | CVAR_INIT | CVAR_SERVERINFO, "game clients are idle" );
+idCVar				idAsyncNetwork::serverStats( "net_serverStats", "0", CVAR_SYSTEM | CVAR_INTEGER | CVAR_NOCHEAT, "print server tick and bandwidth statistics every this many seconds, 0 = off" );
 idCVar				idAsyncNetwork::clientDownload( "net_clientDownload", "1", CVAR_SYSTEM | CVAR_INTEGER | CVAR_ARCHIVE, "client pk4 downloads policy: 0 - never, 1 - ask, 2 - always (will still prompt for binary code)" );
 
 int					idAsyncNetwork::realTime;
@@ -92,8 +93,8 @@ void idAsyncNetwork::Init( void ) {
 	masters[3].var = &master3;
 	masters[4].var = &master4;
 
-	//cmdSystem->AddCommand( "spawnServer", SpawnServer_f, CMD_FL_SYSTEM, "spawns a server", idCmdSystem::ArgCompletion_MapName );
-	//cmdSystem->AddCommand( "nextMap", NextMap_f, CMD_FL_SYSTEM, "loads the next map on the server" );
+	cmdSystem->AddCommand( "spawnServer", SpawnServer_f, CMD_FL_SYSTEM, "spawns a server", idCmdSystem::ArgCompletion_MapName );
+	cmdSystem->AddCommand( "nextMap", NextMap_f, CMD_FL_SYSTEM, "loads the next map on the server" );
 	cmdSystem->AddCommand( "connect", Connect_f, CMD_FL_SYSTEM, "connects to a server" );
 	cmdSystem->AddCommand( "reconnect", Reconnect_f, CMD_FL_SYSTEM, "reconnect to the last server we tried to connect to" );
 	cmdSystem->AddCommand( "serverInfo", GetServerInfo_f, CMD_FL_SYSTEM, "shows server info" );
@@ -101,9 +102,12 @@ void idAsyncNetwork::Init( void ) {
 	cmdSystem->AddCommand( "listServers", ListServers_f, CMD_FL_SYSTEM, "lists scanned servers" );
 	cmdSystem->AddCommand( "rcon", RemoteConsole_f, CMD_FL_SYSTEM, "sends remote console command to server" );
 	//cmdSystem->AddCommand( "heartbeat", Heartbeat_f, CMD_FL_SYSTEM, "send a heartbeat to the the master servers" );
-	//cmdSystem->AddCommand( "kick", Kick_f, CMD_FL_SYSTEM, "kick a client by connection number" );
+	cmdSystem->AddCommand( "kick", Kick_f, CMD_FL_SYSTEM, "kick a client by connection number" );
 	cmdSystem->AddCommand( "checkNewVersion", CheckNewVersion_f, CMD_FL_SYSTEM, "check if a new version of the game is available" );
-	//cmdSystem->AddCommand( "updateUI", UpdateUI_f, CMD_FL_SYSTEM, "internal - cause a sync down of game-modified userinfo" );
+	cmdSystem->AddCommand( "updateUI", UpdateUI_f, CMD_FL_SYSTEM, "internal - cause a sync down of game-modified userinfo" );
+	cmdSystem->AddCommand( "addBot", AddBot_f, CMD_FL_SYSTEM, "connects a loopback bot to the running server" );
+	cmdSystem->AddCommand( "removeBots", RemoveBots_f, CMD_FL_SYSTEM, "disconnects all loopback bots" );
+	cmdSystem->AddCommand( "serverStats", ServerStats_f, CMD_FL_SYSTEM, "prints server tick and bandwidth statistics, 'serverStats reset' restarts them" );
 }
 
 /*
@@ -156,8 +160,8 @@ void idAsyncNetwork::Shutdown( void ) {
 	client.DisconnectFromServer();
 	client.ClearServers();
 	client.ClosePort();
-	//server.Kill();
-	//server.ClosePort();
+	server.Kill();
+	server.ClosePort();
 }
 
 /*
@@ -166,15 +170,17 @@ idAsyncNetwork::RunFrame
 ==================
 */
 void idAsyncNetwork::RunFrame( void ) {
-	if ( console->Active() ) {
-		Sys_GrabMouseCursor( false );
-		usercmdGen->InhibitUsercmd( INHIBIT_ASYNC, true );
-	} else {
-		Sys_GrabMouseCursor( true );
-		usercmdGen->InhibitUsercmd( INHIBIT_ASYNC, false );
+	if ( !server.IsActive() ) {
+		if ( console->Active() ) {
+			Sys_GrabMouseCursor( false );
+			usercmdGen->InhibitUsercmd( INHIBIT_ASYNC, true );
+		} else {
+			Sys_GrabMouseCursor( true );
+			usercmdGen->InhibitUsercmd( INHIBIT_ASYNC, false );
+		}
 	}
 	client.RunFrame();
-	//server.RunFrame();
+	server.RunFrame();
 }
 
 /*
@@ -289,7 +295,12 @@ bool idAsyncNetwork::UsercmdInputChanged( const usercmd_t &previousUserCmd, cons
 idAsyncNetwork::SpawnServer_f
 ==================
 */
-/*void idAsyncNetwork::SpawnServer_f( const idCmdArgs &args ) {
+void idAsyncNetwork::SpawnServer_f( const idCmdArgs &args ) {
+
+	if ( client.IsActive() ) {
+		common->Printf( "disconnect from the server first\n" );
+		return;
+	}
 
 	if(args.Argc() > 1) {
 		cvarSystem->SetCVarString("si_map", args.Argv(1));
@@ -303,6 +314,10 @@ idAsyncNetwork::SpawnServer_f
 	// make sure the current system state is compatible with net_serverDedicated
 	switch ( cvarSystem->GetCVarInteger( "net_serverDedicated" ) ) {
 		case 0:
+			// the server never owns a local player, so a listen server runs as a graphical dedicated one
+			common->Warning( "listen servers are not supported, using net_serverDedicated 2" );
+			cvarSystem->SetCVarInteger( "net_serverDedicated", 2 );
+			// fall through
 		case 2:
 			if ( !renderSystem->IsOpenGLRunning() ) {
 				common->Warning( "OpenGL is not running, net_serverDedicated == %d", cvarSystem->GetCVarInteger( "net_serverDedicated" ) );
@@ -318,21 +333,25 @@ idAsyncNetwork::SpawnServer_f
 			break;
 	}
 	// use serverMapRestart if we already have a running server
-	//if ( server.IsActive() ) {
-	//	cmdSystem->BufferCommandText( CMD_EXEC_NOW, "serverMapRestart" );
-	//} else {
-	//	server.Spawn();
-	//}
-}*/
+	if ( server.IsActive() ) {
+		cmdSystem->BufferCommandText( CMD_EXEC_NOW, "serverMapRestart" );
+	} else {
+		server.Spawn();
+	}
+}
 
 /*
 ==================
 idAsyncNetwork::NextMap_f
 ==================
 */
-//void idAsyncNetwork::NextMap_f( const idCmdArgs &args ) {
-	//server.ExecuteMapChange();
-//}
+void idAsyncNetwork::NextMap_f( const idCmdArgs &args ) {
+	if ( !server.IsActive() ) {
+		common->Printf( "server is not running\n" );
+		return;
+	}
+	server.ExecuteMapChange();
+}
 
 /*
 ==================
@@ -340,10 +359,10 @@ idAsyncNetwork::Connect_f
 ==================
 */
 void idAsyncNetwork::Connect_f( const idCmdArgs &args ) {
-	//if ( server.IsActive() ) {
-	//	common->Printf( "already running a server\n" );
-	//	return;
-	//}
+	if ( server.IsActive() ) {
+		common->Printf( "already running a server\n" );
+		return;
+	}
 	if ( args.Argc() != 2 ) {
 		common->Printf( "USAGE: connect <serverName>\n" );
 		return;
@@ -415,29 +434,29 @@ idAsyncNetwork::Heartbeat_f
 idAsyncNetwork::Kick_f
 ==================
 */
-//void idAsyncNetwork::Kick_f( const idCmdArgs &args ) {
-	//idStr clientId;
-	//int iclient;
+void idAsyncNetwork::Kick_f( const idCmdArgs &args ) {
+	idStr clientId;
+	int iclient;
 
-	//if ( !server.IsActive() ) {
-		//common->Printf( "server is not running\n" );
-		//return;
-	//}
+	if ( !server.IsActive() ) {
+		common->Printf( "server is not running\n" );
+		return;
+	}
 
-	/*clientId = args.Argv( 1 );
+	clientId = args.Argv( 1 );
 	if ( !clientId.IsNumeric() ) {
 		common->Printf( "usage: kick <client number>\n" );
 		return;
 	}
 	iclient = atoi( clientId );
 
-	if ( server.GetLocalClientNum() == iclient ) {
-		common->Printf( "can't kick the host\n" );
+	if ( iclient < 0 || iclient >= MAX_ASYNC_CLIENTS ) {
+		common->Printf( "usage: kick <client number>\n" );
 		return;
 	}
 
-	server.DropClient( iclient, "#str_07134" );*/
-//}
+	server.DropClient( iclient, "#str_07134" );
+}
 
 /*
 ==================
@@ -475,18 +494,54 @@ void idAsyncNetwork::ExecuteSessionCommand( const char *sessCmd ) {
 idAsyncNetwork::UpdateUI_f
 =================
 */
-//void idAsyncNetwork::UpdateUI_f( const idCmdArgs &args ) {
-	//if ( args.Argc() != 2 ) {
-		//common->Warning( "idAsyncNetwork::UpdateUI_f: wrong arguments\n" );
-		//return;
-	//}
-	//if ( !server.IsActive() ) {
-		//common->Warning( "idAsyncNetwork::UpdateUI_f: server is not active\n" );
-		//return;
-	//}
-	//int clientNum = atoi( args.Args( 1 ) );
-	//server.UpdateUI( clientNum );
-//}
+void idAsyncNetwork::UpdateUI_f( const idCmdArgs &args ) {
+	if ( args.Argc() != 2 ) {
+		common->Warning( "idAsyncNetwork::UpdateUI_f: wrong arguments\n" );
+		return;
+	}
+	if ( !server.IsActive() ) {
+		common->Warning( "idAsyncNetwork::UpdateUI_f: server is not active\n" );
+		return;
+	}
+	int clientNum = atoi( args.Args( 1 ) );
+	server.UpdateUI( clientNum );
+}
+
+/*
+=================
+idAsyncNetwork::AddBot_f
+=================
+*/
+void idAsyncNetwork::AddBot_f( const idCmdArgs &args ) {
+	int i, count;
+
+	count = ( args.Argc() > 1 ) ? atoi( args.Argv( 1 ) ) : 1;
+	for ( i = 0; i < count; i++ ) {
+		server.AddBot();
+	}
+}
+
+/*
+=================
+idAsyncNetwork::RemoveBots_f
+=================
+*/
+void idAsyncNetwork::RemoveBots_f( const idCmdArgs &args ) {
+	server.RemoveBots();
+}
+
+/*
+=================
+idAsyncNetwork::ServerStats_f
+=================
+*/
+void idAsyncNetwork::ServerStats_f( const idCmdArgs &args ) {
+	if ( !idStr::Icmp( args.Argv( 1 ), "reset" ) ) {
+		server.ResetStats();
+		return;
+	}
+	server.PrintStats();
+}
 
 /*
 ===============
@@ -32,7 +32,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "idlib/BitMsg.h"
 #include "framework/async/MsgChannel.h"
 #include "framework/async/AsyncClient.h"
-//#include "framework/async/AsyncServer.h"
+#include "framework/async/AsyncServer.h"
 #include "framework/Compressor.h"
 #include "framework/Licensee.h"
 #include "framework/CVarSystem.h"
@@ -118,7 +118,7 @@ public:
 
 	static void				Init( void );
 	static void				Shutdown( void );
-	static bool				IsActive( void ) { return ( /*server.IsActive() || */ client.IsActive() ); }
+	static bool				IsActive( void ) { return ( server.IsActive() || client.IsActive() ); }
 	static void				RunFrame( void );
 
 	static void				WriteUserCmdDelta( idBitMsg &msg, const usercmd_t &cmd, const usercmd_t *base );
@@ -136,12 +136,12 @@ public:
 
 	static void				ExecuteSessionCommand( const char *sessCmd );
 
-	//static idAsyncServer	server;
+	static idAsyncServer	server;
 	static idAsyncClient	client;
 
 	static idCVar			verbose;						// verbose output
 	static idCVar			allowCheats;					// allow cheats
-	//static idCVar			serverDedicated;				// if set run a dedicated server
+	static idCVar			serverDedicated;				// if set run a dedicated server
 	static idCVar			serverSnapshotDelay;			// number of milliseconds between snapshots
 	static idCVar			serverMaxClientRate;			// maximum outgoing rate to clients
 	static idCVar			clientMaxRate;					// maximum rate from server requested by client
@@ -166,6 +166,7 @@ public:
 	static idCVar			serverAllowServerMod;			// let a pure server start with a different game code than what is referenced in game code
 	static idCVar			idleServer;						// serverinfo reply, indicates all clients are idle
 	static idCVar			clientDownload;					// preferred download policy
+	static idCVar			serverStats;					// seconds between periodic server statistics, 0 = off
 
 	// same message used for offline check and network reply
 	static void				BuildInvalidKeyMsg( idStr &msg, bool valid[ 2 ] );
@@ -174,8 +175,8 @@ private:
 	static int				realTime;
 	static master_t			masters[ MAX_MASTER_SERVERS];	// master1 etc.
 
-	//static void				SpawnServer_f( const idCmdArgs &args );
-	//static void				NextMap_f( const idCmdArgs &args );
+	static void				SpawnServer_f( const idCmdArgs &args );
+	static void				NextMap_f( const idCmdArgs &args );
 	static void				Connect_f( const idCmdArgs &args );
 	static void				Reconnect_f( const idCmdArgs &args );
 	static void				GetServerInfo_f( const idCmdArgs &args );
@@ -183,9 +184,12 @@ private:
 	static void				ListServers_f( const idCmdArgs &args );
 	static void				RemoteConsole_f( const idCmdArgs &args );
 	//static void				Heartbeat_f( const idCmdArgs &args );
-	//static void				Kick_f( const idCmdArgs &args );
+	static void				Kick_f( const idCmdArgs &args );
 	static void				CheckNewVersion_f( const idCmdArgs &args );
-	//static void				UpdateUI_f( const idCmdArgs &args );
+	static void				UpdateUI_f( const idCmdArgs &args );
+	static void				AddBot_f( const idCmdArgs &args );
+	static void				RemoveBots_f( const idCmdArgs &args );
+	static void				ServerStats_f( const idCmdArgs &args );
 };
 
 #endif /* !__ASYNCNETWORK_H__ */
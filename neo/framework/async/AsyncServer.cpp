@@ -0,0 +1,1988 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "sys/platform.h"
+#include "idlib/LangDict.h"
+#include "framework/async/AsyncNetwork.h"
+#include "framework/Licensee.h"
+#include "framework/Game.h"
+#include "framework/DeclManager.h"
+#include "framework/Session_local.h"
+
+#include "framework/async/AsyncServer.h"
+
+const int MIN_RECONNECT_TIME			= 2000;
+const int EMPTY_RESEND_TIME				= 500;
+const int PING_RESEND_TIME				= 500;
+const int NOINPUT_IDLE_TIME				= 30000;
+
+/*
+==================
+idAsyncServer::idAsyncServer
+==================
+*/
+idAsyncServer::idAsyncServer( void ) {
+	int i;
+
+	active = false;
+	realTime = 0;
+	serverTime = 0;
+	serverId = 0;
+	serverDataChecksum = 0;
+	gameInitId = 0;
+	gameFrame = 0;
+	gameTime = 0;
+	gameTimeResidual = 0;
+	memset( challenges, 0, sizeof( challenges ) );
+	memset( userCmds, 0, sizeof( userCmds ) );
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		ClearClient( i );
+	}
+	ResetStats();
+}
+
+/*
+==================
+idAsyncServer::InitPort
+==================
+*/
+bool idAsyncServer::InitPort( void ) {
+	int lastPort;
+
+	// if this is the first time we have spawned a server, open the UDP port
+	if ( !serverPort.GetPort() ) {
+		if ( cvarSystem->GetCVarInteger( "net_port" ) != 0 ) {
+			if ( !serverPort.InitForPort( cvarSystem->GetCVarInteger( "net_port" ) ) ) {
+				common->Printf( "Unable to open server on port %d (net_port)\n", cvarSystem->GetCVarInteger( "net_port" ) );
+				return false;
+			}
+		} else {
+			// scan for multiple ports, in case other servers are running on this IP already
+			for ( lastPort = 0; lastPort < NUM_SERVER_PORTS; lastPort++ ) {
+				if ( serverPort.InitForPort( PORT_SERVER + lastPort ) ) {
+					break;
+				}
+			}
+			if ( lastPort >= NUM_SERVER_PORTS ) {
+				common->Printf( "Unable to open server network port.\n" );
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/*
+==================
+idAsyncServer::ClosePort
+==================
+*/
+void idAsyncServer::ClosePort( void ) {
+	int i;
+
+	RemoveBots();
+
+	serverPort.Close();
+	for ( i = 0; i < MAX_CHALLENGES; i++ ) {
+		challenges[i].connected = false;
+	}
+}
+
+/*
+==================
+idAsyncServer::ClearClient
+==================
+*/
+void idAsyncServer::ClearClient( int clientNum ) {
+	serverClient_t &client = clients[clientNum];
+	client.clientId = 0;
+	client.clientState = SCS_FREE;
+	client.clientPrediction = 0;
+	client.clientAheadTime = 0;
+	client.clientRate = 0;
+	client.clientPing = 0;
+	client.gameInitSequence = 0;
+	client.gameFrame = 0;
+	client.gameTime = 0;
+	client.channel.Shutdown();
+	client.lastConnectTime = 0;
+	client.lastEmptyTime = 0;
+	client.lastPingTime = 0;
+	client.lastSnapshotTime = 0;
+	client.lastPacketTime = 0;
+	client.lastInputTime = 0;
+	client.snapshotSequence = 0;
+	client.acknowledgeSnapshotSequence = 0;
+	client.numDuplicatedUsercmds = 0;
+	client.guid[0] = '\0';
+}
+
+/*
+==================
+idAsyncServer::Clear
+==================
+*/
+void idAsyncServer::Clear( void ) {
+	int i;
+
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		ClearClient( i );
+	}
+	serverId = 0;
+	serverDataChecksum = 0;
+	memset( challenges, 0, sizeof( challenges ) );
+	memset( userCmds, 0, sizeof( userCmds ) );
+}
+
+/*
+==================
+idAsyncServer::Spawn
+==================
+*/
+void idAsyncServer::Spawn( void ) {
+	int			size;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+	netadr_t	from;
+
+	// shutdown any current game
+	session->Stop();
+
+	if ( active ) {
+		return;
+	}
+
+	if ( !InitPort() ) {
+		return;
+	}
+
+	// trash any currently pending packets
+	while( serverPort.GetPacket( from, msgBuf, size, sizeof( msgBuf ) ) ) {
+	}
+
+	// reset cheats cvars
+	if ( !idAsyncNetwork::allowCheats.GetBool() ) {
+		cvarSystem->ResetFlaggedVariables( CVAR_CHEAT );
+	}
+
+	Clear();
+
+	common->Printf( "Server spawned on port %i.\n", serverPort.GetPort() );
+
+	// calculate a checksum on some of the essential data used
+	serverDataChecksum = declManager->GetChecksum();
+
+	// get a pseudo random server id, but don't use the id which is reserved for connectionless packets
+	serverId = Sys_Milliseconds() & CONNECTIONLESS_MESSAGE_ID_MASK;
+
+	active = true;
+
+	ExecuteMapChange();
+}
+
+/*
+==================
+idAsyncServer::Kill
+==================
+*/
+void idAsyncServer::Kill( void ) {
+	int i, j;
+
+	if ( !active ) {
+		return;
+	}
+
+	// the bots disconnect like any other client
+	RemoveBots();
+
+	// drop all clients
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		DropClient( i, "#str_07135" );
+	}
+
+	// send some empty messages to the zombie clients to make sure they disconnect
+	for ( j = 0; j < 4; j++ ) {
+		for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+			if ( clients[i].clientState == SCS_ZOMBIE ) {
+				if ( clients[i].channel.UnsentFragmentsLeft() ) {
+					clients[i].channel.SendNextFragment( serverPort, serverTime );
+				} else {
+					SendEmptyToClient( i, true );
+				}
+			}
+		}
+		Sys_Sleep( 10 );
+	}
+
+	active = false;
+
+	// shutdown any current game
+	session->Stop();
+}
+
+/*
+==================
+idAsyncServer::ExecuteMapChange
+==================
+*/
+void idAsyncServer::ExecuteMapChange( void ) {
+	int			i;
+	idStr		mapName;
+	char		bestGameType[ MAX_STRING_CHARS ];
+
+	assert( active );
+
+	// make sure the map/gametype combo is good
+	game->GetBestGameType( cvarSystem->GetCVarString( "si_map" ), cvarSystem->GetCVarString( "si_gametype" ), bestGameType );
+	cvarSystem->SetCVarString( "si_gametype", bestGameType );
+
+	// initialize map settings
+	cmdSystem->BufferCommandText( CMD_EXEC_NOW, "rescanSI" );
+
+	sprintf( mapName, "maps/%s", sessLocal.mapSpawnData.serverInfo.GetString( "si_map" ) );
+	mapName.SetFileExtension( ".map" );
+	if ( fileSystem->ReadFile( mapName, NULL, NULL ) == -1 ) {
+		common->Printf( "Can't find map %s\n", mapName.c_str() );
+		cmdSystem->BufferCommandText( CMD_EXEC_APPEND, "disconnect\n" );
+		return;
+	}
+
+	// new game init id, so clients still sending for the old map can be told apart
+	gameInitId ^= Sys_Milliseconds();
+	if ( gameInitId == GAME_INIT_ID_INVALID || gameInitId == GAME_INIT_ID_MAP_LOAD ) {
+		gameInitId = 0;
+	}
+
+	// the game starts over at frame zero
+	serverTime = 0;
+	realTime = Sys_Milliseconds();
+	gameFrame = 0;
+	gameTime = 0;
+	gameTimeResidual = 0;
+	memset( userCmds, 0, sizeof( userCmds ) );
+
+	// the server never has a local player
+	game->SetLocalClient( -1 );
+
+	// load map
+	sessLocal.ExecuteMapChange();
+
+	// re-initialize all connected clients for the new map
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		if ( clients[i].clientState >= SCS_CONNECTED ) {
+			InitClient( i, clients[i].clientId, clients[i].clientRate );
+			SendGameInitToClient( i );
+		}
+	}
+
+	// don't count the time spent loading
+	UpdateTime( 0 );
+
+	ResetStats();
+}
+
+/*
+==================
+idAsyncServer::GetPort
+==================
+*/
+int idAsyncServer::GetPort( void ) const {
+	return serverPort.GetPort();
+}
+
+/*
+===============
+idAsyncServer::GetBoundAdr
+===============
+*/
+netadr_t idAsyncServer::GetBoundAdr( void ) const {
+	return serverPort.GetAdr();
+}
+
+/*
+==================
+idAsyncServer::GetOutgoingRate
+==================
+*/
+int idAsyncServer::GetOutgoingRate( void ) const {
+	int i, rate;
+
+	rate = 0;
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		const serverClient_t &client = clients[i];
+
+		if ( client.clientState >= SCS_CONNECTED ) {
+			rate += client.channel.GetOutgoingRate();
+		}
+	}
+	return rate;
+}
+
+/*
+==================
+idAsyncServer::GetIncomingRate
+==================
+*/
+int idAsyncServer::GetIncomingRate( void ) const {
+	int i, rate;
+
+	rate = 0;
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		const serverClient_t &client = clients[i];
+
+		if ( client.clientState >= SCS_CONNECTED ) {
+			rate += client.channel.GetIncomingRate();
+		}
+	}
+	return rate;
+}
+
+/*
+==================
+idAsyncServer::IsClientInGame
+==================
+*/
+bool idAsyncServer::IsClientInGame( int clientNum ) const {
+	if ( clientNum < 0 || clientNum >= MAX_ASYNC_CLIENTS ) {
+		return false;
+	}
+	return ( clients[clientNum].clientState == SCS_INGAME );
+}
+
+/*
+==================
+idAsyncServer::GetClientPing
+==================
+*/
+int idAsyncServer::GetClientPing( int clientNum ) const {
+	const serverClient_t &client = clients[clientNum];
+
+	if ( client.clientState < SCS_CONNECTED ) {
+		return 99999;
+	} else {
+		return client.clientPing;
+	}
+}
+
+/*
+==================
+idAsyncServer::GetClientPrediction
+==================
+*/
+int idAsyncServer::GetClientPrediction( int clientNum ) const {
+	const serverClient_t &client = clients[clientNum];
+
+	if ( client.clientState < SCS_CONNECTED ) {
+		return 99999;
+	} else {
+		return client.clientPrediction;
+	}
+}
+
+/*
+==================
+idAsyncServer::GetClientTimeSinceLastPacket
+==================
+*/
+int idAsyncServer::GetClientTimeSinceLastPacket( int clientNum ) const {
+	const serverClient_t &client = clients[clientNum];
+
+	if ( client.clientState < SCS_CONNECTED ) {
+		return 99999;
+	} else {
+		return serverTime - client.lastPacketTime;
+	}
+}
+
+/*
+==================
+idAsyncServer::GetClientTimeSinceLastInput
+==================
+*/
+int idAsyncServer::GetClientTimeSinceLastInput( int clientNum ) const {
+	const serverClient_t &client = clients[clientNum];
+
+	if ( client.clientState < SCS_CONNECTED ) {
+		return 99999;
+	} else {
+		return serverTime - client.lastInputTime;
+	}
+}
+
+/*
+==================
+idAsyncServer::GetClientOutgoingRate
+==================
+*/
+int idAsyncServer::GetClientOutgoingRate( int clientNum ) const {
+	if ( clientNum < 0 || clientNum >= MAX_ASYNC_CLIENTS ) {
+		return -1;
+	}
+
+	const serverClient_t &client = clients[clientNum];
+
+	if ( client.clientState < SCS_CONNECTED ) {
+		return -1;
+	} else {
+		return client.channel.GetOutgoingRate();
+	}
+}
+
+/*
+==================
+idAsyncServer::GetClientIncomingRate
+==================
+*/
+int idAsyncServer::GetClientIncomingRate( int clientNum ) const {
+	if ( clientNum < 0 || clientNum >= MAX_ASYNC_CLIENTS ) {
+		return -1;
+	}
+
+	const serverClient_t &client = clients[clientNum];
+
+	if ( client.clientState < SCS_CONNECTED ) {
+		return -1;
+	} else {
+		return client.channel.GetIncomingRate();
+	}
+}
+
+/*
+==================
+idAsyncServer::GetClientOutgoingCompression
+==================
+*/
+float idAsyncServer::GetClientOutgoingCompression( int clientNum ) const {
+	if ( clientNum < 0 || clientNum >= MAX_ASYNC_CLIENTS ) {
+		return 0.0f;
+	}
+
+	const serverClient_t &client = clients[clientNum];
+
+	if ( client.clientState < SCS_CONNECTED ) {
+		return 0.0f;
+	} else {
+		return client.channel.GetOutgoingCompression();
+	}
+}
+
+/*
+==================
+idAsyncServer::GetClientIncomingCompression
+==================
+*/
+float idAsyncServer::GetClientIncomingCompression( int clientNum ) const {
+	if ( clientNum < 0 || clientNum >= MAX_ASYNC_CLIENTS ) {
+		return 0.0f;
+	}
+
+	const serverClient_t &client = clients[clientNum];
+
+	if ( client.clientState < SCS_CONNECTED ) {
+		return 0.0f;
+	} else {
+		return client.channel.GetIncomingCompression();
+	}
+}
+
+/*
+==================
+idAsyncServer::GetClientIncomingPacketLoss
+==================
+*/
+float idAsyncServer::GetClientIncomingPacketLoss( int clientNum ) const {
+	if ( clientNum < 0 || clientNum >= MAX_ASYNC_CLIENTS ) {
+		return 0.0f;
+	}
+
+	const serverClient_t &client = clients[clientNum];
+
+	if ( client.clientState < SCS_CONNECTED ) {
+		return 0.0f;
+	} else {
+		return client.channel.GetIncomingPacketLoss();
+	}
+}
+
+/*
+==================
+idAsyncServer::GetNumClients
+==================
+*/
+int idAsyncServer::GetNumClients( void ) const {
+	int ret = 0;
+	for ( int i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		if ( clients[i].clientState >= SCS_CONNECTED ) {
+			ret++;
+		}
+	}
+	return ret;
+}
+
+/*
+==================
+idAsyncServer::GetNumIdleClients
+==================
+*/
+int idAsyncServer::GetNumIdleClients( void ) const {
+	int ret = 0;
+	for ( int i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		if ( clients[i].clientState >= SCS_CONNECTED ) {
+			if ( serverTime - clients[i].lastInputTime > NOINPUT_IDLE_TIME ) {
+				ret++;
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+==================
+idAsyncServer::DuplicateUsercmds
+==================
+*/
+void idAsyncServer::DuplicateUsercmds( int frame, int time ) {
+	int i, previousIndex, currentIndex;
+
+	previousIndex = ( frame - 1 ) & ( MAX_USERCMD_BACKUP - 1 );
+	currentIndex = frame & ( MAX_USERCMD_BACKUP - 1 );
+
+	// duplicate previous user commands if no new commands are available for a client
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		if ( clients[i].clientState == SCS_FREE ) {
+			continue;
+		}
+
+		if ( idAsyncNetwork::DuplicateUsercmd( userCmds[previousIndex][i], userCmds[currentIndex][i], frame, time ) ) {
+			clients[i].numDuplicatedUsercmds++;
+		}
+	}
+}
+
+/*
+==================
+idAsyncServer::InitClient
+==================
+*/
+void idAsyncServer::InitClient( int clientNum, int clientId, int clientRate ) {
+	int i;
+
+	// clear the user info
+	sessLocal.mapSpawnData.userInfo[ clientNum ].Clear();	// always start with a clean base
+
+	// clear the server client
+	serverClient_t &client = clients[clientNum];
+	client.clientId = clientId;
+	client.clientState = SCS_CONNECTED;
+	client.clientPrediction = 0;
+	client.clientAheadTime = 0;
+	client.gameInitSequence = -1;
+	client.gameFrame = 0;
+	client.gameTime = 0;
+	client.channel.ResetRate();
+	client.clientRate = clientRate ? clientRate : idAsyncNetwork::serverMaxClientRate.GetInteger();
+	client.channel.SetMaxOutgoingRate( Min( idAsyncNetwork::serverMaxClientRate.GetInteger(), client.clientRate ) );
+	client.clientPing = 0;
+	client.lastConnectTime = serverTime;
+	client.lastEmptyTime = serverTime;
+	client.lastPingTime = serverTime;
+	client.lastSnapshotTime = serverTime;
+	client.lastPacketTime = serverTime;
+	client.lastInputTime = serverTime;
+	client.acknowledgeSnapshotSequence = 0;
+	client.numDuplicatedUsercmds = 0;
+
+	// clear the user commands
+	for ( i = 0; i < MAX_USERCMD_BACKUP; i++ ) {
+		memset( &userCmds[i][clientNum], 0, sizeof( userCmds[i][clientNum] ) );
+	}
+
+	// let the game know a player connected
+	game->ServerClientConnect( clientNum, client.guid );
+}
+
+/*
+==================
+idAsyncServer::DropClient
+==================
+*/
+void idAsyncServer::DropClient( int clientNum, const char *reason ) {
+	int			i;
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	serverClient_t &client = clients[clientNum];
+
+	if ( client.clientState <= SCS_ZOMBIE ) {
+		return;
+	}
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteByte( SERVER_RELIABLE_MESSAGE_DISCONNECT );
+	msg.WriteInt( clientNum );
+	msg.WriteString( reason );
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		// clientNum so SendReliableMessage can identify the right client
+		if ( i == clientNum || clients[i].clientState >= SCS_CONNECTED ) {
+			SendReliableMessage( i, msg );
+		}
+	}
+
+	reason = common->GetLanguageDict()->GetString( reason );
+	common->Printf( "client %d %s\n", clientNum, reason );
+
+	// remove the player from the game
+	game->ServerClientDisconnect( clientNum );
+
+	client.clientState = SCS_ZOMBIE;
+}
+
+/*
+==================
+idAsyncServer::SendReliableMessage
+==================
+*/
+void idAsyncServer::SendReliableMessage( int clientNum, const idBitMsg &msg ) {
+	if ( !clients[ clientNum ].channel.SendReliableMessage( msg ) ) {
+		clients[ clientNum ].channel.ClearReliableMessages();
+		DropClient( clientNum, "#str_07136" );
+	}
+}
+
+/*
+==================
+idAsyncServer::CheckClientTimeouts
+==================
+*/
+void idAsyncServer::CheckClientTimeouts( void ) {
+	int i, zombieTimeout, clientTimeout;
+
+	zombieTimeout = serverTime - idAsyncNetwork::serverZombieTimeout.GetInteger() * 1000;
+	clientTimeout = serverTime - idAsyncNetwork::serverClientTimeout.GetInteger() * 1000;
+
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		serverClient_t &client = clients[i];
+
+		if ( client.clientState == SCS_FREE ) {
+			continue;
+		}
+
+		if ( client.clientState == SCS_ZOMBIE && client.lastPacketTime < zombieTimeout ) {
+			client.channel.Shutdown();
+			client.clientState = SCS_FREE;
+			continue;
+		}
+
+		if ( client.clientState >= SCS_CONNECTED && client.lastPacketTime < clientTimeout ) {
+			DropClient( i, "#str_07137" );
+			continue;
+		}
+	}
+}
+
+/*
+==================
+idAsyncServer::SendPrintBroadcast
+==================
+*/
+void idAsyncServer::SendPrintBroadcast( const char *string ) {
+	int			i;
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteByte( SERVER_RELIABLE_MESSAGE_PRINT );
+	msg.WriteString( string );
+
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		if ( clients[i].clientState >= SCS_CONNECTED ) {
+			SendReliableMessage( i, msg );
+		}
+	}
+}
+
+/*
+==================
+idAsyncServer::SendPrintToClient
+==================
+*/
+void idAsyncServer::SendPrintToClient( int clientNum, const char *string ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	serverClient_t &client = clients[clientNum];
+
+	if ( client.clientState < SCS_CONNECTED ) {
+		return;
+	}
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteByte( SERVER_RELIABLE_MESSAGE_PRINT );
+	msg.WriteString( string );
+
+	SendReliableMessage( clientNum, msg );
+}
+
+/*
+==================
+idAsyncServer::SendUserInfoBroadcast
+==================
+*/
+void idAsyncServer::SendUserInfoBroadcast( int userInfoNum, const idDict &info, bool sendToAll ) {
+	idBitMsg		msg;
+	byte			msgBuf[MAX_MESSAGE_SIZE];
+	const idDict	*gameInfo;
+	bool			gameModifiedInfo;
+
+	gameInfo = game->SetUserInfo( userInfoNum, info, false, true );
+	if ( gameInfo ) {
+		gameModifiedInfo = true;
+	} else {
+		gameModifiedInfo = false;
+		gameInfo = &info;
+	}
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteByte( SERVER_RELIABLE_MESSAGE_CLIENTINFO );
+	msg.WriteByte( userInfoNum );
+	if ( gameModifiedInfo || sendToAll ) {
+		msg.WriteBits( 0, 1 );
+	} else {
+		msg.WriteBits( 1, 1 );
+	}
+
+#if ID_CLIENTINFO_TAGS
+	msg.WriteInt( sessLocal.mapSpawnData.userInfo[userInfoNum].Checksum() );
+#endif
+
+	if ( gameModifiedInfo || sendToAll ) {
+		msg.WriteDeltaDict( *gameInfo, NULL );
+	} else {
+		msg.WriteDeltaDict( *gameInfo, &sessLocal.mapSpawnData.userInfo[userInfoNum] );
+	}
+
+	for ( int i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		if ( clients[i].clientState >= SCS_CONNECTED && ( sendToAll || i != userInfoNum || gameModifiedInfo ) ) {
+			SendReliableMessage( i, msg );
+		}
+	}
+
+	sessLocal.mapSpawnData.userInfo[userInfoNum] = *gameInfo;
+}
+
+/*
+==================
+idAsyncServer::UpdateUI
+
+if the game modifies userInfo, it will call this through command system
+we then need to get the info from the game, and broadcast to clients
+( using DeltaDict and our current mapSpawnData as a base )
+==================
+*/
+void idAsyncServer::UpdateUI( int clientNum ) {
+	const idDict	*info = game->GetUserInfo( clientNum );
+
+	if ( !info ) {
+		common->Warning( "idAsyncServer::UpdateUI: no info from game\n" );
+		return;
+	}
+
+	SendUserInfoBroadcast( clientNum, *info, true );
+}
+
+/*
+==================
+idAsyncServer::SendUserInfoToClient
+==================
+*/
+void idAsyncServer::SendUserInfoToClient( int clientNum, int userInfoNum, const idDict &info ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	if ( clients[clientNum].clientState < SCS_CONNECTED ) {
+		return;
+	}
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteByte( SERVER_RELIABLE_MESSAGE_CLIENTINFO );
+	msg.WriteByte( userInfoNum );
+	msg.WriteBits( 0, 1 );
+
+#if ID_CLIENTINFO_TAGS
+	msg.WriteInt( 0 );
+#endif
+
+	msg.WriteDeltaDict( info, NULL );
+
+	SendReliableMessage( clientNum, msg );
+}
+
+/*
+==================
+idAsyncServer::SendSyncedCvarsBroadcast
+==================
+*/
+void idAsyncServer::SendSyncedCvarsBroadcast( const idDict &cvars ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+	int			i;
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteByte( SERVER_RELIABLE_MESSAGE_SYNCEDCVARS );
+	msg.WriteDeltaDict( cvars, &sessLocal.mapSpawnData.syncedCVars );
+
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		if ( clients[i].clientState >= SCS_CONNECTED ) {
+			SendReliableMessage( i, msg );
+		}
+	}
+
+	sessLocal.mapSpawnData.syncedCVars = cvars;
+}
+
+/*
+==================
+idAsyncServer::SendSyncedCvarsToClient
+==================
+*/
+void idAsyncServer::SendSyncedCvarsToClient( int clientNum, const idDict &cvars ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	if ( clients[clientNum].clientState < SCS_CONNECTED ) {
+		return;
+	}
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteByte( SERVER_RELIABLE_MESSAGE_SYNCEDCVARS );
+	msg.WriteDeltaDict( cvars, NULL );
+
+	SendReliableMessage( clientNum, msg );
+}
+
+/*
+==================
+idAsyncServer::SendApplySnapshotToClient
+==================
+*/
+void idAsyncServer::SendApplySnapshotToClient( int clientNum, int sequence ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteByte( SERVER_RELIABLE_MESSAGE_APPLYSNAPSHOT );
+	msg.WriteInt( sequence );
+
+	SendReliableMessage( clientNum, msg );
+}
+
+/*
+==================
+idAsyncServer::SendEnterGameToClient
+==================
+*/
+void idAsyncServer::SendEnterGameToClient( int clientNum ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteByte( SERVER_RELIABLE_MESSAGE_ENTERGAME );
+
+	SendReliableMessage( clientNum, msg );
+}
+
+/*
+==================
+idAsyncServer::SendReliableGameMessage
+==================
+*/
+void idAsyncServer::SendReliableGameMessage( int clientNum, const idBitMsg &msg ) {
+	int			i;
+	idBitMsg	outMsg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	outMsg.Init( msgBuf, sizeof( msgBuf ) );
+	outMsg.WriteByte( SERVER_RELIABLE_MESSAGE_GAME );
+	outMsg.WriteData( msg.GetData(), msg.GetSize() );
+
+	if ( clientNum >= 0 && clientNum < MAX_ASYNC_CLIENTS ) {
+		if ( clients[clientNum].clientState == SCS_INGAME ) {
+			SendReliableMessage( clientNum, outMsg );
+		}
+		return;
+	}
+
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		if ( clients[i].clientState != SCS_INGAME ) {
+			continue;
+		}
+		SendReliableMessage( i, outMsg );
+	}
+}
+
+/*
+==================
+idAsyncServer::SendReliableGameMessageExcluding
+==================
+*/
+void idAsyncServer::SendReliableGameMessageExcluding( int clientNum, const idBitMsg &msg ) {
+	int			i;
+	idBitMsg	outMsg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	assert( clientNum >= 0 && clientNum < MAX_ASYNC_CLIENTS );
+
+	outMsg.Init( msgBuf, sizeof( msgBuf ) );
+	outMsg.WriteByte( SERVER_RELIABLE_MESSAGE_GAME );
+	outMsg.WriteData( msg.GetData(), msg.GetSize() );
+
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		if ( i == clientNum ) {
+			continue;
+		}
+		if ( clients[i].clientState != SCS_INGAME ) {
+			continue;
+		}
+		SendReliableMessage( i, outMsg );
+	}
+}
+
+/*
+==================
+idAsyncServer::SendEmptyToClient
+==================
+*/
+void idAsyncServer::SendEmptyToClient( int clientNum, bool force ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	serverClient_t &client = clients[clientNum];
+
+	if ( client.lastEmptyTime > realTime ) {
+		client.lastEmptyTime = realTime;
+	}
+
+	if ( !force && ( realTime - client.lastEmptyTime < EMPTY_RESEND_TIME ) ) {
+		return;
+	}
+
+	if ( idAsyncNetwork::verbose.GetInteger() ) {
+		common->Printf( "sending empty to client %d: gameInitId = %d, gameFrame = %d, gameTime = %d\n", clientNum, gameInitId, gameFrame, gameTime );
+	}
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteInt( gameInitId );
+	msg.WriteByte( SERVER_UNRELIABLE_MESSAGE_EMPTY );
+
+	client.channel.SendMessage( serverPort, serverTime, msg );
+
+	client.lastEmptyTime = realTime;
+}
+
+/*
+==================
+idAsyncServer::SendPingToClient
+==================
+*/
+void idAsyncServer::SendPingToClient( int clientNum ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	serverClient_t &client = clients[clientNum];
+
+	if ( client.lastPingTime > realTime ) {
+		client.lastPingTime = realTime;
+	}
+
+	if ( realTime - client.lastPingTime < PING_RESEND_TIME ) {
+		return;
+	}
+
+	if ( idAsyncNetwork::verbose.GetInteger() == 2 ) {
+		common->Printf( "pinging client %d: gameInitId = %d, gameFrame = %d, gameTime = %d\n", clientNum, gameInitId, gameFrame, gameTime );
+	}
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteInt( gameInitId );
+	msg.WriteByte( SERVER_UNRELIABLE_MESSAGE_PING );
+	msg.WriteInt( realTime );
+
+	client.channel.SendMessage( serverPort, serverTime, msg );
+
+	client.lastPingTime = realTime;
+}
+
+/*
+==================
+idAsyncServer::SendGameInitToClient
+==================
+*/
+void idAsyncServer::SendGameInitToClient( int clientNum ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	if ( idAsyncNetwork::verbose.GetInteger() ) {
+		common->Printf( "sending gameinit to client %d: gameInitId = %d, gameFrame = %d, gameTime = %d\n", clientNum, gameInitId, gameFrame, gameTime );
+	}
+
+	serverClient_t &client = clients[clientNum];
+
+	// clear the unsent fragments. might flood winsock but that's ok
+	while( client.channel.UnsentFragmentsLeft() ) {
+		client.channel.SendNextFragment( serverPort, serverTime );
+	}
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteInt( gameInitId );
+	msg.WriteByte( SERVER_UNRELIABLE_MESSAGE_GAMEINIT );
+	msg.WriteInt( gameFrame );
+	msg.WriteInt( gameTime );
+	msg.WriteDeltaDict( sessLocal.mapSpawnData.serverInfo, NULL );
+	client.gameInitSequence = client.channel.SendMessage( serverPort, serverTime, msg );
+}
+
+/*
+==================
+idAsyncServer::SendSnapshotToClient
+==================
+*/
+bool idAsyncServer::SendSnapshotToClient( int clientNum ) {
+	int			i, j, index, numUsercmds, maxRelay, headerSize;
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+	usercmd_t *	last;
+	byte		clientInPVS[MAX_ASYNC_CLIENTS >> 3];
+
+	serverClient_t &client = clients[clientNum];
+
+	if ( serverTime - client.lastSnapshotTime < idAsyncNetwork::serverSnapshotDelay.GetInteger() ) {
+		return false;
+	}
+
+	if ( idAsyncNetwork::verbose.GetInteger() == 2 ) {
+		common->Printf( "sending snapshot to client %d: gameInitId = %d, gameFrame = %d, gameTime = %d\n", clientNum, gameInitId, gameFrame, gameTime );
+	}
+
+	// how far is the client ahead of the server minus the packet delay
+	client.clientAheadTime = client.gameTime - ( gameTime + gameTimeResidual );
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+	msg.WriteInt( gameInitId );
+	msg.WriteByte( SERVER_UNRELIABLE_MESSAGE_SNAPSHOT );
+
+	// write the snapshot
+	msg.WriteInt( client.snapshotSequence );
+	msg.WriteInt( gameFrame );
+	msg.WriteInt( gameTime );
+	msg.WriteByte( idMath::ClampChar( client.numDuplicatedUsercmds ) );
+	msg.WriteShort( idMath::ClampShort( client.clientAheadTime ) );
+
+	headerSize = msg.GetSize();
+
+	// write the game snapshot
+	game->ServerWriteSnapshot( clientNum, client.snapshotSequence, msg, clientInPVS, MAX_ASYNC_CLIENTS );
+
+	numSnapshots++;
+	snapshotBytes += msg.GetSize() - headerSize;
+
+	maxRelay = idMath::ClampInt( 1, MAX_USERCMD_RELAY, idAsyncNetwork::serverMaxUsercmdRelay.GetInteger() );
+
+	// write the latest user commands from the other clients in the PVS to the snapshot
+	for ( last = NULL, i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		serverClient_t &other = clients[i];
+
+		if ( other.clientState == SCS_FREE || i == clientNum ) {
+			continue;
+		}
+
+		// if the client is not in the PVS
+		if ( !( clientInPVS[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
+			continue;
+		}
+
+		// always send at least one usercmd, DuplicateUsercmds makes sure there is one available
+		numUsercmds = Max( 1, Min( other.gameFrame, gameFrame + maxRelay ) - gameFrame );
+		msg.WriteByte( i );
+		msg.WriteByte( numUsercmds );
+		for ( j = 0; j < numUsercmds; j++ ) {
+			index = ( gameFrame + j ) & ( MAX_USERCMD_BACKUP - 1 );
+			idAsyncNetwork::WriteUserCmdDelta( msg, userCmds[index][i], last );
+			last = &userCmds[index][i];
+		}
+	}
+	msg.WriteByte( MAX_ASYNC_CLIENTS );
+
+	client.channel.SendMessage( serverPort, serverTime, msg );
+
+	client.lastSnapshotTime = serverTime;
+	client.snapshotSequence++;
+	client.numDuplicatedUsercmds = 0;
+
+	return true;
+}
+
+/*
+==================
+idAsyncServer::ProcessUnreliableClientMessage
+==================
+*/
+void idAsyncServer::ProcessUnreliableClientMessage( int clientNum, const idBitMsg &msg ) {
+	int			i, id, acknowledgeSequence, acknowledgeSnapshotSequence, clientGameInitId, clientGameFrame, numUsercmds, index;
+	usercmd_t	*last;
+
+	serverClient_t &client = clients[clientNum];
+
+	if ( client.clientState == SCS_ZOMBIE ) {
+		return;
+	}
+
+	acknowledgeSequence = msg.ReadInt();
+	clientGameInitId = msg.ReadInt();
+
+	// while loading a map the client may send empty messages to keep the connection alive
+	if ( clientGameInitId == GAME_INIT_ID_MAP_LOAD ) {
+		if ( idAsyncNetwork::verbose.GetInteger() ) {
+			common->Printf( "ignore unreliable msg from client %d, gameInitId == ID_MAP_LOAD\n", clientNum );
+		}
+		return;
+	}
+
+	// check if the client is in the right game
+	if ( clientGameInitId != gameInitId ) {
+		if ( acknowledgeSequence > client.gameInitSequence ) {
+			// the client is connected but not in the right game
+			client.clientState = SCS_CONNECTED;
+
+			// send game init to client
+			SendGameInitToClient( clientNum );
+		}
+		return;
+	}
+
+	acknowledgeSnapshotSequence = msg.ReadInt();
+
+	if ( client.clientState == SCS_CONNECTED ) {
+
+		// the client is in the right game
+		client.clientState = SCS_INGAME;
+
+		// send the user info of other clients
+		for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+			if ( clients[i].clientState >= SCS_CONNECTED && i != clientNum ) {
+				SendUserInfoToClient( clientNum, i, sessLocal.mapSpawnData.userInfo[i] );
+			}
+		}
+
+		// send synchronized cvars to client
+		SendSyncedCvarsToClient( clientNum, sessLocal.mapSpawnData.syncedCVars );
+
+		SendEnterGameToClient( clientNum );
+
+		// get the client running in the game
+		game->ServerClientBegin( clientNum );
+
+		// write any reliable messages to initialize the client game state
+		game->ServerWriteInitialReliableMessages( clientNum );
+
+	} else if ( client.clientState == SCS_INGAME && acknowledgeSnapshotSequence > client.acknowledgeSnapshotSequence ) {
+
+		// the client ackowledged a snapshot it received
+		client.acknowledgeSnapshotSequence = acknowledgeSnapshotSequence;
+
+		// notify the game of the snapshot and tell the client to apply it as well
+		if ( game->ServerApplySnapshot( clientNum, client.acknowledgeSnapshotSequence ) ) {
+			SendApplySnapshotToClient( clientNum, client.acknowledgeSnapshotSequence );
+		}
+	}
+
+	// process the unreliable message
+	id = msg.ReadByte();
+	switch( id ) {
+		case CLIENT_UNRELIABLE_MESSAGE_EMPTY: {
+			if ( idAsyncNetwork::verbose.GetInteger() ) {
+				common->Printf( "received empty message for client %d\n", clientNum );
+			}
+			break;
+		}
+		case CLIENT_UNRELIABLE_MESSAGE_PINGRESPONSE: {
+			client.clientPing = realTime - msg.ReadInt();
+			break;
+		}
+		case CLIENT_UNRELIABLE_MESSAGE_USERCMD: {
+
+			client.clientPrediction = msg.ReadShort();
+
+			// read user commands
+			clientGameFrame = msg.ReadInt();
+			numUsercmds = msg.ReadByte();
+			for ( last = NULL, i = clientGameFrame - numUsercmds + 1; i <= clientGameFrame; i++ ) {
+				index = i & ( MAX_USERCMD_BACKUP - 1 );
+				idAsyncNetwork::ReadUserCmdDelta( msg, userCmds[index][clientNum], last );
+				userCmds[index][clientNum].gameFrame = i;
+				userCmds[index][clientNum].duplicateCount = 0;
+				if ( idAsyncNetwork::UsercmdInputChanged( userCmds[( i - 1 ) & ( MAX_USERCMD_BACKUP - 1 )][clientNum], userCmds[index][clientNum] ) ) {
+					client.lastInputTime = serverTime;
+				}
+				last = &userCmds[index][clientNum];
+			}
+
+			if ( last ) {
+				client.gameFrame = last->gameFrame;
+				client.gameTime = last->gameTime;
+			}
+
+			if ( idAsyncNetwork::verbose.GetInteger() == 2 ) {
+				common->Printf( "received user command for client %d, gameInitId = %d, gameFrame, %d gameTime %d\n", clientNum, clientGameInitId, client.gameFrame, client.gameTime );
+			}
+			break;
+		}
+		default: {
+			common->Printf( "unknown unreliable message %d from client %d\n", id, clientNum );
+			break;
+		}
+	}
+}
+
+/*
+==================
+idAsyncServer::ProcessReliableClientMessages
+==================
+*/
+void idAsyncServer::ProcessReliableClientMessages( int clientNum ) {
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+	byte		id;
+
+	serverClient_t &client = clients[clientNum];
+
+	msg.Init( msgBuf, sizeof( msgBuf ) );
+
+	while ( client.channel.GetReliableMessage( msg ) ) {
+		id = msg.ReadByte();
+		switch( id ) {
+			case CLIENT_RELIABLE_MESSAGE_CLIENTINFO: {
+				idDict info;
+				msg.ReadDeltaDict( info, &sessLocal.mapSpawnData.userInfo[clientNum] );
+				SendUserInfoBroadcast( clientNum, info );
+				break;
+			}
+			case CLIENT_RELIABLE_MESSAGE_PRINT: {
+				char string[MAX_STRING_CHARS];
+				msg.ReadString( string, sizeof( string ) );
+				common->Printf( "%s\n", string );
+				break;
+			}
+			case CLIENT_RELIABLE_MESSAGE_DISCONNECT: {
+				DropClient( clientNum, "#str_07138" );
+				break;
+			}
+			case CLIENT_RELIABLE_MESSAGE_PURE: {
+				// pure servers are not supported, clients only send this when asked to
+				break;
+			}
+			default: {
+				// pass reliable message on to game code
+				game->ServerProcessReliableMessage( clientNum, msg );
+				break;
+			}
+		}
+	}
+}
+
+/*
+==================
+idAsyncServer::PrintOOB
+==================
+*/
+void idAsyncServer::PrintOOB( const netadr_t to, int opcode, const char *string ) {
+	idBitMsg	outMsg;
+	byte		msgBuf[ MAX_MESSAGE_SIZE ];
+
+	outMsg.Init( msgBuf, sizeof( msgBuf ) );
+	outMsg.WriteShort( CONNECTIONLESS_MESSAGE_ID );
+	outMsg.WriteString( "print" );
+	outMsg.WriteInt( opcode );
+	outMsg.WriteString( string );
+	serverPort.SendPacket( to, outMsg.GetData(), outMsg.GetSize() );
+}
+
+/*
+==================
+idAsyncServer::ProcessChallengeMessage
+==================
+*/
+void idAsyncServer::ProcessChallengeMessage( const netadr_t from, const idBitMsg &msg ) {
+	int			i, clientId, oldest, oldestTime;
+	idBitMsg	outMsg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	clientId = msg.ReadInt();
+
+	oldest = 0;
+	oldestTime = 0x7fffffff;
+
+	// see if we already have a challenge for this ip
+	for ( i = 0; i < MAX_CHALLENGES; i++ ) {
+		if ( !challenges[i].connected && Sys_CompareNetAdrBase( from, challenges[i].address ) && from.port == challenges[i].address.port && clientId == challenges[i].clientId ) {
+			break;
+		}
+		if ( challenges[i].time < oldestTime ) {
+			oldestTime = challenges[i].time;
+			oldest = i;
+		}
+	}
+
+	if ( i >= MAX_CHALLENGES ) {
+		// this is the first time this client has asked for a challenge
+		i = oldest;
+		challenges[i].address = from;
+		challenges[i].clientId = clientId;
+		challenges[i].challenge = ( (rand() << 16) ^ rand() ) ^ serverTime;
+		challenges[i].time = serverTime;
+		challenges[i].connected = false;
+	}
+
+	common->DPrintf( "sending challenge 0x%x to %s\n", challenges[i].challenge, Sys_NetAdrToString( from ) );
+
+	outMsg.Init( msgBuf, sizeof( msgBuf ) );
+	outMsg.WriteShort( CONNECTIONLESS_MESSAGE_ID );
+	outMsg.WriteString( "challengeResponse" );
+	outMsg.WriteInt( challenges[i].challenge );
+	outMsg.WriteShort( serverId );
+	outMsg.WriteString( cvarSystem->GetCVarString( "fs_game_base" ) );
+	outMsg.WriteString( cvarSystem->GetCVarString( "fs_game" ) );
+
+	serverPort.SendPacket( from, outMsg.GetData(), outMsg.GetSize() );
+}
+
+/*
+==================
+idAsyncServer::ProcessConnectMessage
+==================
+*/
+void idAsyncServer::ProcessConnectMessage( const netadr_t from, const idBitMsg &msg ) {
+	int			clientNum, protocol, clientDataChecksum, challenge, clientId, clientRate, ichallenge;
+	idBitMsg	outMsg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+	char		guid[ 12 ];
+	char		password[ 17 ];
+	char		reason[ MAX_STRING_CHARS ];
+	allowReply_t	reply;
+
+	protocol = msg.ReadInt();
+
+	// check protocol id
+	if ( protocol != ASYNC_PROTOCOL_VERSION ) {
+		common->Printf( "NET: Connect from %s rejected - wrong protocol version %d.%d\n", Sys_NetAdrToString( from ), protocol >> 16, protocol & 0xffff );
+		PrintOOB( from, SERVER_PRINT_BADPROTOCOL, va( "server uses protocol %d.%d\n", ASYNC_PROTOCOL_MAJOR, ASYNC_PROTOCOL_MINOR ) );
+		return;
+	}
+
+	clientDataChecksum = msg.ReadInt();
+	challenge = msg.ReadInt();
+	clientId = msg.ReadShort();
+	clientRate = msg.ReadInt();
+
+	// check the client data
+	if ( clientDataChecksum != serverDataChecksum ) {
+		PrintOOB( from, SERVER_PRINT_MISC, "#str_04842" );
+		return;
+	}
+
+	// find the challenge
+	for ( ichallenge = 0; ichallenge < MAX_CHALLENGES; ichallenge++ ) {
+		if ( Sys_CompareNetAdrBase( from, challenges[ichallenge].address ) && from.port == challenges[ichallenge].address.port ) {
+			if ( clientId == challenges[ichallenge].clientId && challenge == challenges[ichallenge].challenge ) {
+				break;
+			}
+		}
+	}
+	if ( ichallenge >= MAX_CHALLENGES ) {
+		PrintOOB( from, SERVER_PRINT_BADCHALLENGE, "#str_04840" );
+		return;
+	}
+
+	msg.ReadString( guid, sizeof( guid ) );
+	msg.ReadString( password, sizeof( password ) );
+
+	// if there already is a connection from this address, use the same slot
+	for ( clientNum = 0; clientNum < MAX_ASYNC_CLIENTS; clientNum++ ) {
+		serverClient_t &client = clients[clientNum];
+
+		if ( client.clientState == SCS_FREE ) {
+			continue;
+		}
+
+		if ( Sys_CompareNetAdrBase( from, client.channel.GetRemoteAddress() ) && from.port == client.channel.GetRemoteAddress().port ) {
+			if ( serverTime - client.lastConnectTime < MIN_RECONNECT_TIME ) {
+				common->Printf( "%s: reconnect rejected : too soon\n", Sys_NetAdrToString( from ) );
+				return;
+			}
+			break;
+		}
+	}
+
+	// if the client is not reconnecting, let the game decide and find a free slot
+	if ( clientNum >= MAX_ASYNC_CLIENTS ) {
+		reason[0] = '\0';
+		reply = game->ServerAllowClient( GetNumClients(), Sys_NetAdrToString( from ), guid, password, reason );
+		if ( reply != ALLOW_YES ) {
+			common->DPrintf( "game denied connection for %s\n", Sys_NetAdrToString( from ) );
+
+			// SERVER_PRINT_GAMEDENY passes the game opcode through. Don't use PrintOOB
+			outMsg.Init( msgBuf, sizeof( msgBuf ) );
+			outMsg.WriteShort( CONNECTIONLESS_MESSAGE_ID );
+			outMsg.WriteString( "print" );
+			outMsg.WriteInt( SERVER_PRINT_GAMEDENY );
+			outMsg.WriteInt( reply );
+			outMsg.WriteString( reason );
+			serverPort.SendPacket( from, outMsg.GetData(), outMsg.GetSize() );
+			return;
+		}
+
+		for ( clientNum = 0; clientNum < MAX_ASYNC_CLIENTS; clientNum++ ) {
+			if ( clients[clientNum].clientState == SCS_FREE ) {
+				break;
+			}
+		}
+		if ( clientNum >= MAX_ASYNC_CLIENTS ) {
+			PrintOOB( from, SERVER_PRINT_MISC, "#str_04843" );
+			return;
+		}
+	}
+
+	challenges[ ichallenge ].connected = true;
+
+	common->Printf( "sending connect response to %s\n", Sys_NetAdrToString( from ) );
+
+	serverClient_t &client = clients[clientNum];
+
+	client.channel.Init( from, serverId );
+	idStr::Copynz( client.guid, guid, sizeof( client.guid ) );
+
+	InitClient( clientNum, clientId, clientRate );
+
+	// send response telling the client he's connected
+	outMsg.Init( msgBuf, sizeof( msgBuf ) );
+	outMsg.WriteShort( CONNECTIONLESS_MESSAGE_ID );
+	outMsg.WriteString( "connectResponse" );
+	outMsg.WriteInt( clientNum );
+	outMsg.WriteInt( gameInitId );
+	outMsg.WriteInt( gameFrame );
+	outMsg.WriteInt( gameTime );
+	outMsg.WriteDeltaDict( sessLocal.mapSpawnData.serverInfo, NULL );
+
+	serverPort.SendPacket( from, outMsg.GetData(), outMsg.GetSize() );
+}
+
+/*
+==================
+idAsyncServer::ConnectionlessMessage
+==================
+*/
+void idAsyncServer::ConnectionlessMessage( const netadr_t from, const idBitMsg &msg ) {
+	char		string[MAX_STRING_CHARS];
+	idBitMsg	outMsg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+	int			i;
+
+	msg.ReadString( string, sizeof( string ) );
+
+	// info request
+	if ( idStr::Icmp( string, "getInfo" ) == 0 ) {
+		outMsg.Init( msgBuf, sizeof( msgBuf ) );
+		outMsg.WriteShort( CONNECTIONLESS_MESSAGE_ID );
+		outMsg.WriteString( "infoResponse" );
+		outMsg.WriteInt( msg.ReadInt() );
+		outMsg.WriteInt( ASYNC_PROTOCOL_VERSION );
+		outMsg.WriteDeltaDict( sessLocal.mapSpawnData.serverInfo, NULL );
+		for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+			if ( clients[i].clientState >= SCS_CONNECTED ) {
+				outMsg.WriteByte( i );
+				outMsg.WriteShort( clients[i].clientPing );
+				outMsg.WriteInt( clients[i].channel.GetMaxOutgoingRate() );
+				outMsg.WriteString( sessLocal.mapSpawnData.userInfo[i].GetString( "ui_name", "Player" ), MAX_NICKLEN );
+			}
+		}
+		outMsg.WriteByte( MAX_ASYNC_CLIENTS );
+		serverPort.SendPacket( from, outMsg.GetData(), outMsg.GetSize() );
+		return;
+	}
+
+	// when the server is not active, only the info requests are answered
+	if ( !active ) {
+		return;
+	}
+
+	// challenge from a client
+	if ( idStr::Icmp( string, "challenge" ) == 0 ) {
+		ProcessChallengeMessage( from, msg );
+		return;
+	}
+
+	// connect from a client
+	if ( idStr::Icmp( string, "connect" ) == 0 ) {
+		ProcessConnectMessage( from, msg );
+		return;
+	}
+
+	common->DPrintf( "ignored message from %s: %s\n", Sys_NetAdrToString( from ), string );
+	return;
+}
+
+/*
+==================
+idAsyncServer::ProcessMessage
+==================
+*/
+void idAsyncServer::ProcessMessage( const netadr_t from, idBitMsg &msg ) {
+	int			i, id, sequence;
+	idBitMsg	outMsg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+
+	id = msg.ReadShort();
+
+	// check for a connectionless message
+	if ( id == CONNECTIONLESS_MESSAGE_ID ) {
+		ConnectionlessMessage( from, msg );
+		return;
+	}
+
+	if ( msg.GetRemaingData() < 4 ) {
+		common->DPrintf( "%s: tiny packet\n", Sys_NetAdrToString( from ) );
+		return;
+	}
+
+	// if the id does not match the id of a connected client, it is not a valid connection
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		serverClient_t &client = clients[i];
+
+		if ( client.clientState == SCS_FREE ) {
+			continue;
+		}
+
+		// if the message is from a different address or client
+		if ( !Sys_CompareNetAdrBase( from, client.channel.GetRemoteAddress() ) || id != client.clientId ) {
+			continue;
+		}
+
+		if ( !client.channel.Process( from, serverTime, msg, sequence ) ) {
+			return;		// out of order, duplicated, fragment, etc.
+		}
+
+		// zombie clients still need to do the channel processing to make sure they don't
+		// need to retransmit the final reliable message, but they don't do any other processing
+		if ( client.clientState == SCS_ZOMBIE ) {
+			return;
+		}
+
+		client.lastPacketTime = serverTime;
+
+		ProcessReliableClientMessages( i );
+		ProcessUnreliableClientMessage( i, msg );
+
+		return;
+	}
+
+	// if we received a sequenced packet from an address we don't recognize,
+	// send an out of band disconnect packet to it
+	outMsg.Init( msgBuf, sizeof( msgBuf ) );
+	outMsg.WriteShort( CONNECTIONLESS_MESSAGE_ID );
+	outMsg.WriteString( "disconnect" );
+	serverPort.SendPacket( from, outMsg.GetData(), outMsg.GetSize() );
+
+	return;
+}
+
+/*
+==================
+idAsyncServer::ProcessConnectionLessMessages
+==================
+*/
+void idAsyncServer::ProcessConnectionLessMessages( void ) {
+	int			size, id;
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+	netadr_t	from;
+
+	if ( !serverPort.GetPort() ) {
+		return;
+	}
+
+	while( serverPort.GetPacket( from, msgBuf, size, sizeof( msgBuf ) ) ) {
+		msg.Init( msgBuf, sizeof( msgBuf ) );
+		msg.SetSize( size );
+		msg.BeginReading();
+		id = msg.ReadShort();
+		if ( id == CONNECTIONLESS_MESSAGE_ID ) {
+			ConnectionlessMessage( from, msg );
+		}
+	}
+}
+
+/*
+==================
+idAsyncServer::UpdateTime
+==================
+*/
+int idAsyncServer::UpdateTime( int clamp ) {
+	int time, msec;
+
+	time = Sys_Milliseconds();
+	msec = idMath::ClampInt( 0, clamp, time - realTime );
+	realTime = time;
+	serverTime += msec;
+	return msec;
+}
+
+/*
+==================
+idAsyncServer::RunFrame
+==================
+*/
+void idAsyncServer::RunFrame( void ) {
+	int			i, msec, size, numFrames, start;
+	bool		newPacket;
+	idBitMsg	msg;
+	byte		msgBuf[MAX_MESSAGE_SIZE];
+	netadr_t	from;
+
+	msec = UpdateTime( 100 );
+
+	if ( !serverPort.GetPort() ) {
+		return;
+	}
+
+	if ( !active ) {
+		ProcessConnectionLessMessages();
+		return;
+	}
+
+	gameTimeResidual += msec;
+
+	// spin in place processing incoming packets until enough time lapsed to run a new game frame
+	do {
+
+		do {
+
+			// blocking read with game time residual timeout
+			newPacket = serverPort.GetPacketBlocking( from, msgBuf, size, sizeof( msgBuf ), USERCMD_MSEC - gameTimeResidual - 1 );
+			if ( newPacket ) {
+				msg.Init( msgBuf, sizeof( msgBuf ) );
+				msg.SetSize( size );
+				msg.BeginReading();
+				ProcessMessage( from, msg );
+			}
+
+			msec = UpdateTime( 100 );
+			gameTimeResidual += msec;
+
+		} while( newPacket );
+
+	} while( gameTimeResidual < USERCMD_MSEC );
+
+	// the server may have been killed while processing messages
+	if ( !active ) {
+		return;
+	}
+
+	// check for clients that timed out
+	CheckClientTimeouts();
+
+	if ( idAsyncNetwork::idleServer.GetBool() == ( !GetNumClients() || GetNumIdleClients() != GetNumClients() ) ) {
+		idAsyncNetwork::idleServer.SetBool( !idAsyncNetwork::idleServer.GetBool() );
+		// the need to propagate right away, only this
+		sessLocal.mapSpawnData.serverInfo.Set( "si_idleServer", idAsyncNetwork::idleServer.GetString() );
+		game->SetServerInfo( sessLocal.mapSpawnData.serverInfo );
+	}
+
+	// make sure the time doesn't wrap
+	if ( serverTime > 0x70000000 ) {
+		ExecuteMapChange();
+		return;
+	}
+
+	// check for synchronized cvar changes
+	if ( cvarSystem->GetModifiedFlags() & CVAR_NETWORKSYNC ) {
+		SendSyncedCvarsBroadcast( *cvarSystem->MoveCVarsToDict( CVAR_NETWORKSYNC ) );
+		cvarSystem->ClearModifiedFlags( CVAR_NETWORKSYNC );
+	}
+
+	// advance the server game at a fixed tick
+	for ( numFrames = 0; gameTimeResidual >= USERCMD_MSEC; numFrames++ ) {
+
+		// duplicate usercmds for clients if no new ones are available
+		DuplicateUsercmds( gameFrame, gameTime );
+
+		// advance game
+		start = Sys_Microseconds();
+		gameReturn_t ret = game->RunFrame( userCmds[gameFrame & ( MAX_USERCMD_BACKUP - 1 ) ] );
+		RecordTick( Sys_Microseconds() - start );
+
+		idAsyncNetwork::ExecuteSessionCommand( ret.sessionCommand );
+
+		// update time
+		gameFrame++;
+		gameTime += USERCMD_MSEC;
+		gameTimeResidual -= USERCMD_MSEC;
+	}
+
+	// duplicate usercmds so there is always at least one available to send with snapshots
+	DuplicateUsercmds( gameFrame, gameTime );
+
+	// send snapshots to connected clients
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		serverClient_t &client = clients[i];
+
+		if ( client.clientState == SCS_FREE ) {
+			continue;
+		}
+
+		// modify maximum rate if necesary
+		if ( idAsyncNetwork::serverMaxClientRate.IsModified() ) {
+			client.channel.SetMaxOutgoingRate( Min( client.clientRate, idAsyncNetwork::serverMaxClientRate.GetInteger() ) );
+		}
+
+		// if the channel is not yet ready to send new data
+		if ( !client.channel.ReadyToSend( serverTime ) ) {
+			continue;
+		}
+
+		// send additional message fragments if the last message was too large to send at once
+		if ( client.channel.UnsentFragmentsLeft() ) {
+			client.channel.SendNextFragment( serverPort, serverTime );
+			continue;
+		}
+
+		if ( client.clientState == SCS_INGAME ) {
+			if ( !SendSnapshotToClient( i ) ) {
+				SendPingToClient( i );
+			}
+		} else {
+			SendEmptyToClient( i );
+		}
+	}
+
+	idAsyncNetwork::serverMaxClientRate.ClearModified();
+
+	// let the loopback bots read what was sent and answer for the frames that were run
+	for ( i = 0; i < MAX_ASYNC_BOTS; i++ ) {
+		bots[i].RunFrame( numFrames );
+	}
+
+	// periodic statistics
+	if ( idAsyncNetwork::serverStats.GetInteger() > 0 && serverTime - statsLastPrintTime >= idAsyncNetwork::serverStats.GetInteger() * 1000 ) {
+		PrintStats();
+		statsLastPrintTime = serverTime;
+	}
+}
+
+/*
+==================
+idAsyncServer::PacifierUpdate
+
+Keeps the connections alive while a map is loading.
+==================
+*/
+void idAsyncServer::PacifierUpdate( void ) {
+	int i;
+
+	if ( !IsActive() ) {
+		return;
+	}
+	realTime = Sys_Milliseconds();
+	ProcessConnectionLessMessages();
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		if ( clients[i].clientState >= SCS_CONNECTED ) {
+			if ( clients[i].channel.UnsentFragmentsLeft() ) {
+				clients[i].channel.SendNextFragment( serverPort, serverTime );
+			} else {
+				SendEmptyToClient( i );
+			}
+		}
+	}
+}
+
+/*
+==================
+idAsyncServer::AddBot
+==================
+*/
+void idAsyncServer::AddBot( void ) {
+	int			i;
+	netadr_t	adr;
+
+	if ( !active ) {
+		common->Printf( "server is not running\n" );
+		return;
+	}
+
+	for ( i = 0; i < MAX_ASYNC_BOTS; i++ ) {
+		if ( !bots[i].IsActive() ) {
+			break;
+		}
+	}
+	if ( i >= MAX_ASYNC_BOTS ) {
+		common->Printf( "all %d bots are already connected\n", MAX_ASYNC_BOTS );
+		return;
+	}
+
+	// talk to the address the server is bound to, or loopback when it listens on all interfaces
+	adr = serverPort.GetAdr();
+	if ( adr.ip[0] == 0 && adr.ip[1] == 0 && adr.ip[2] == 0 && adr.ip[3] == 0 ) {
+		Sys_StringToNetAdr( "127.0.0.1", &adr, false );
+		adr.port = serverPort.GetPort();
+	}
+
+	if ( bots[i].Connect( i, adr ) ) {
+		common->Printf( "bot%d connecting to %s\n", i, Sys_NetAdrToString( adr ) );
+	}
+}
+
+/*
+==================
+idAsyncServer::RemoveBots
+==================
+*/
+void idAsyncServer::RemoveBots( void ) {
+	for ( int i = 0; i < MAX_ASYNC_BOTS; i++ ) {
+		if ( bots[i].IsActive() ) {
+			bots[i].Disconnect();
+		}
+	}
+}
+
+/*
+==================
+idAsyncServer::RecordTick
+==================
+*/
+void idAsyncServer::RecordTick( int usec ) {
+	tickTimes[numTicks & ( SERVER_TICK_STATS - 1 )] = usec;
+	tickTimeTotal += usec;
+	if ( usec > tickTimeMax ) {
+		tickTimeMax = usec;
+	}
+	numTicks++;
+}
+
+/*
+==================
+idAsyncServer::ResetStats
+==================
+*/
+void idAsyncServer::ResetStats( void ) {
+	statsStartTime = serverTime;
+	statsLastPrintTime = serverTime;
+	numTicks = 0;
+	memset( tickTimes, 0, sizeof( tickTimes ) );
+	tickTimeTotal = 0;
+	tickTimeMax = 0;
+	numSnapshots = 0;
+	snapshotBytes = 0;
+	basePacketsRead = serverPort.packetsRead;
+	baseBytesRead = serverPort.bytesRead;
+	basePacketsWritten = serverPort.packetsWritten;
+	baseBytesWritten = serverPort.bytesWritten;
+}
+
+/*
+==================
+idAsyncServer::PrintStats
+==================
+*/
+void idAsyncServer::PrintStats( void ) const {
+	int				i, numWindow, numBots;
+	float			seconds;
+	idList<int>		window;
+
+	if ( !active ) {
+		common->Printf( "server is not running\n" );
+		return;
+	}
+
+	seconds = Max( 1, serverTime - statsStartTime ) * 0.001f;
+
+	numBots = 0;
+	for ( i = 0; i < MAX_ASYNC_BOTS; i++ ) {
+		if ( bots[i].IsActive() ) {
+			numBots++;
+		}
+	}
+
+	common->Printf( "server: %d clients (%d bots), %d ticks in %.1f seconds, %.1f ticks/s\n",
+		GetNumClients(), numBots, numTicks, seconds, numTicks / seconds );
+
+	if ( numTicks ) {
+		numWindow = Min( numTicks, SERVER_TICK_STATS );
+		window.SetNum( numWindow );
+		for ( i = 0; i < numWindow; i++ ) {
+			window[i] = tickTimes[i];
+		}
+		window.Sort();
+		common->Printf( "tick time: avg %.3f ms, max %.3f ms, last %d ticks p50 %.3f ms p95 %.3f ms (budget %d ms)\n",
+			tickTimeTotal * 0.001f / numTicks, tickTimeMax * 0.001f, numWindow,
+			window[numWindow / 2] * 0.001f, window[( numWindow * 95 ) / 100] * 0.001f, USERCMD_MSEC );
+	}
+
+	if ( numSnapshots ) {
+		common->Printf( "snapshots: %d sent, avg %d bytes of game state\n", numSnapshots, (int)( snapshotBytes / numSnapshots ) );
+	}
+
+	common->Printf( "bandwidth: out %.2f KB/s in %d packets/s, in %.2f KB/s in %d packets/s\n",
+		( serverPort.bytesWritten - baseBytesWritten ) / ( 1024.0f * seconds ), (int)( ( serverPort.packetsWritten - basePacketsWritten ) / seconds ),
+		( serverPort.bytesRead - baseBytesRead ) / ( 1024.0f * seconds ), (int)( ( serverPort.packetsRead - basePacketsRead ) / seconds ) );
+
+	for ( i = 0; i < MAX_ASYNC_CLIENTS; i++ ) {
+		const serverClient_t &client = clients[i];
+
+		if ( client.clientState < SCS_CONNECTED ) {
+			continue;
+		}
+
+		common->Printf( "client %2d: %-16s ping %4d, out %5d B/s (%4.1f%%), in %5d B/s (%4.1f%%), loss %4.1f%%\n", i,
+			sessLocal.mapSpawnData.userInfo[i].GetString( "ui_name" ), client.clientPing,
+			client.channel.GetOutgoingRate(), client.channel.GetOutgoingCompression(),
+			client.channel.GetIncomingRate(), client.channel.GetIncomingCompression(),
+			client.channel.GetIncomingPacketLoss() );
+	}
+}
+
+/*
+==================
+idAsyncServer::GetAsyncStatsAvgMsg
+==================
+*/
+void idAsyncServer::GetAsyncStatsAvgMsg( idStr &msg ) const {
+	if ( !numTicks ) {
+		msg = "no server ticks yet";
+		return;
+	}
+	sprintf( msg, "avg tick %.2f ms, max tick %.2f ms, avg snapshot %d bytes",
+		tickTimeTotal * 0.001f / numTicks, tickTimeMax * 0.001f, numSnapshots ? (int)( snapshotBytes / numSnapshots ) : 0 );
+}
@@ -0,0 +1,209 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#ifndef __ASYNCSERVER_H__
+#define __ASYNCSERVER_H__
+
+#include "framework/async/MsgChannel.h"
+#include "framework/async/AsyncBot.h"
+#include "framework/UsercmdGen.h"
+
+/*
+===============================================================================
+
+  Network Server for asynchronous networking.
+
+  Only dedicated servers are supported: the server never owns a local
+  player, all clients connect over the network.  There is no pure server
+  checking, pak downloading, master server heartbeat or key authorization.
+
+===============================================================================
+*/
+
+// MAX_CHALLENGES is made large to prevent a denial of service attack that could cycle
+// all of them out before legitimate users connected
+const int MAX_CHALLENGES				= 1024;
+
+// number of loopback bots that can be added with addBot
+const int MAX_ASYNC_BOTS				= 8;
+
+// number of ticks in the tick time statistics window
+const int SERVER_TICK_STATS				= 256;
+
+typedef enum {
+	SCS_FREE,			// can be reused for a new connection
+	SCS_ZOMBIE,			// client has been disconnected, but don't reuse connection for a couple seconds
+	SCS_CONNECTED,		// client is connected
+	SCS_INGAME			// client is in the game
+} serverClientState_t;
+
+typedef struct challenge_s {
+	netadr_t			address;		// client address
+	int					clientId;		// client identification
+	int					challenge;		// challenge code
+	int					time;			// time the challenge was created
+	bool				connected;		// true if the client is connected
+} challenge_t;
+
+typedef struct serverClient_s {
+	int					clientId;
+	serverClientState_t	clientState;
+	int					clientPrediction;
+	int					clientAheadTime;
+	int					clientRate;
+	int					clientPing;
+
+	int					gameInitSequence;
+	int					gameFrame;
+	int					gameTime;
+
+	idMsgChannel		channel;
+	int					lastConnectTime;
+	int					lastEmptyTime;
+	int					lastPingTime;
+	int					lastSnapshotTime;
+	int					lastPacketTime;
+	int					lastInputTime;
+	int					snapshotSequence;
+	int					acknowledgeSnapshotSequence;
+	int					numDuplicatedUsercmds;
+
+	char				guid[12];		// Even Balance - M. Quinn
+} serverClient_t;
+
+class idAsyncServer {
+public:
+						idAsyncServer();
+
+	bool				InitPort( void );
+	void				ClosePort( void );
+	void				Spawn( void );
+	void				Kill( void );
+	void				ExecuteMapChange( void );
+
+	int					GetPort( void ) const;
+	netadr_t			GetBoundAdr( void ) const;
+	bool				IsActive( void ) const { return active; }
+	int					GetDelay( void ) const { return gameTimeResidual; }
+	int					GetOutgoingRate( void ) const;
+	int					GetIncomingRate( void ) const;
+	bool				IsClientInGame( int clientNum ) const;
+	int					GetClientPing( int clientNum ) const;
+	int					GetClientPrediction( int clientNum ) const;
+	int					GetClientTimeSinceLastPacket( int clientNum ) const;
+	int					GetClientTimeSinceLastInput( int clientNum ) const;
+	int					GetClientOutgoingRate( int clientNum ) const;
+	int					GetClientIncomingRate( int clientNum ) const;
+	float				GetClientOutgoingCompression( int clientNum ) const;
+	float				GetClientIncomingCompression( int clientNum ) const;
+	float				GetClientIncomingPacketLoss( int clientNum ) const;
+	int					GetNumClients( void ) const;
+	int					GetNumIdleClients( void ) const;
+	int					GetLocalClientNum( void ) const { return -1; }
+
+	void				RunFrame( void );
+	void				DropClient( int clientNum, const char *reason );
+	void				PacifierUpdate( void );
+
+	void				SendReliableGameMessage( int clientNum, const idBitMsg &msg );
+	void				SendReliableGameMessageExcluding( int clientNum, const idBitMsg &msg );
+
+	void				UpdateUI( int clientNum );
+
+	void				AddBot( void );
+	void				RemoveBots( void );
+
+	void				PrintStats( void ) const;
+	void				ResetStats( void );
+	void				GetAsyncStatsAvgMsg( idStr &msg ) const;
+
+private:
+	bool				active;						// true if server is active
+	int					realTime;					// absolute time
+
+	int					serverTime;					// local server time
+	idPort				serverPort;					// UDP port
+	int					serverId;					// server identification
+	int					serverDataChecksum;			// checksum of the data used by the server
+
+	challenge_t			challenges[MAX_CHALLENGES];	// to prevent invalid IPs from connecting
+	serverClient_t		clients[MAX_ASYNC_CLIENTS];	// clients
+	usercmd_t			userCmds[MAX_USERCMD_BACKUP][MAX_ASYNC_CLIENTS];
+
+	int					gameInitId;					// game initialization identification
+	int					gameFrame;					// local game frame
+	int					gameTime;					// local game time
+	int					gameTimeResidual;			// left over time from previous frame
+
+	idAsyncBot			bots[MAX_ASYNC_BOTS];		// loopback clients
+
+	// statistics
+	int					statsStartTime;				// server time the statistics were reset
+	int					statsLastPrintTime;			// server time of the last periodic print
+	int					numTicks;					// game frames run since the reset
+	int					tickTimes[SERVER_TICK_STATS];	// microseconds spent in game->RunFrame, ring buffer
+	double				tickTimeTotal;				// sum over all ticks, in microseconds, an int wraps after half an hour
+	int					tickTimeMax;				// slowest tick, in microseconds
+	int					numSnapshots;				// snapshots sent since the reset
+	double				snapshotBytes;				// snapshot payload bytes since the reset
+	int					basePacketsRead;			// port counters at the time of the reset
+	int					baseBytesRead;
+	int					basePacketsWritten;
+	int					baseBytesWritten;
+
+	void				Clear( void );
+	void				DuplicateUsercmds( int frame, int time );
+	void				ClearClient( int clientNum );
+	void				InitClient( int clientNum, int clientId, int clientRate );
+	void				SendReliableMessage( int clientNum, const idBitMsg &msg );
+	void				SendGameInitToClient( int clientNum );
+	bool				SendSnapshotToClient( int clientNum );
+	void				SendPingToClient( int clientNum );
+	void				SendEmptyToClient( int clientNum, bool force = false );
+	void				SendUserInfoBroadcast( int userInfoNum, const idDict &info, bool sendToAll = false );
+	void				SendUserInfoToClient( int clientNum, int userInfoNum, const idDict &info );
+	void				SendSyncedCvarsBroadcast( const idDict &cvars );
+	void				SendSyncedCvarsToClient( int clientNum, const idDict &cvars );
+	void				SendPrintBroadcast( const char *string );
+	void				SendPrintToClient( int clientNum, const char *string );
+	void				SendEnterGameToClient( int clientNum );
+	void				SendApplySnapshotToClient( int clientNum, int sequence );
+	void				CheckClientTimeouts( void );
+	void				PrintOOB( const netadr_t to, int opcode, const char *string );
+	void				ProcessUnreliableClientMessage( int clientNum, const idBitMsg &msg );
+	void				ProcessReliableClientMessages( int clientNum );
+	void				ProcessChallengeMessage( const netadr_t from, const idBitMsg &msg );
+	void				ProcessConnectMessage( const netadr_t from, const idBitMsg &msg );
+	void				ConnectionlessMessage( const netadr_t from, const idBitMsg &msg );
+	void				ProcessMessage( const netadr_t from, idBitMsg &msg );
+	void				ProcessConnectionLessMessages( void );
+	void				RecordTick( int usec );
+	int					UpdateTime( int clamp );
+};
+
+#endif /* !__ASYNCSERVER_H__ */
@@ -2193,3 +2193,20 @@ extern unzFile unzReOpen (const char* path, unzFile file)
 
 	return (unzFile)s;
 }
+
+// the following function was added for d3wasm to read entries from memory mapped paks
+
+extern int unzGetCurrentFileLocalHeader64( unzFile file, ZPOS64_T *pos )
+{
+	unz64_s* s;
+
+	if( file == NULL || pos == NULL )
+		return UNZ_PARAMERROR;
+
+	s = (unz64_s*)file;
+	if( !s->current_file_ok )
+		return UNZ_PARAMERROR;
+
+	*pos = s->cur_file_info_internal.offset_curfile + s->byte_before_the_zipfile;
+	return UNZ_OK;
+}
@@ -447,6 +447,14 @@ extern unzFile unzReOpen( const char* path, unzFile file );
 	   of this unzip package.
 */
 
+extern int unzGetCurrentFileLocalHeader64( unzFile file, ZPOS64_T *pos );
+
+/*
+  Get the offset of the local header of the current file, from the start
+  of the zip file on disk.  Used to read entries directly from a memory
+  mapped pak.  Returns UNZ_OK, or UNZ_PARAMERROR if there is no current file.
+*/
+
 #ifdef __cplusplus
 }
 #endif
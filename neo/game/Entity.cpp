@@ -411,6 +411,7 @@ idEntity::idEntity() {
 
 	thinkFlags		= 0;
 	dormantStart	= 0;
+	thinkSkippedFrames = 0;
 	cinematic		= false;
 	renderView		= NULL;
 	cameraTarget	= NULL;
@@ -451,6 +452,21 @@ void idEntity::FixupLocalizedStrings() {
 	}
 }
 
+// spawnArgs every entity reads in Spawn
+static const idDictKey	KEY_NAME( "name" );
+static const idDictKey	KEY_CLASSNAME( "classname" );
+static const idDictKey	KEY_CAMERATARGET( "cameraTarget" );
+static const idDictKey	KEY_SOLIDFORTEAM( "solidForTeam" );
+static const idDictKey	KEY_NEVERDORMANT( "neverDormant" );
+static const idDictKey	KEY_HIDE( "hide" );
+static const idDictKey	KEY_CINEMATIC( "cinematic" );
+static const idDictKey	KEY_THINKTIERS( "thinkTiers" );
+static const idDictKey	KEY_NETWORKSYNC( "networkSync" );
+static const idDictKey	KEY_HEALTH( "health" );
+static const idDictKey	KEY_MODEL( "model" );
+static const idDictKey	KEY_BIND( "bind" );
+static const idDictKey	KEY_SCRIPTOBJECT( "scriptobject" );
+
 /*
 ================
 idEntity::Spawn
@@ -467,7 +483,7 @@ void idEntity::Spawn( void ) {
 
 	gameLocal.RegisterEntity( this );
 
-	spawnArgs.GetString( "classname", NULL, &classname );
+	spawnArgs.GetString( KEY_CLASSNAME, NULL, &classname );
 	const idDeclEntityDef *def = gameLocal.FindEntityDef( classname, false );
 	if ( def ) {
 		entityDefNumber = def->Index();
@@ -494,7 +510,7 @@ void idEntity::Spawn( void ) {
 	refSound.listenerId = entityNumber + 1;
 
 	cameraTarget = NULL;
-	temp = spawnArgs.GetString( "cameraTarget" );
+	temp = spawnArgs.GetString( KEY_CAMERATARGET );
 	if ( temp && temp[0] ) {
 		// update the camera taget
 		PostEventMS( &EV_UpdateCameraTarget, 0 );
@@ -504,16 +520,17 @@ void idEntity::Spawn( void ) {
 		UpdateGuiParms( renderEntity.gui[ i ], &spawnArgs );
 	}
 
-	fl.solidForTeam = spawnArgs.GetBool( "solidForTeam", "0" );
-	fl.neverDormant = spawnArgs.GetBool( "neverDormant", "0" );
-	fl.hidden = spawnArgs.GetBool( "hide", "0" );
+	fl.solidForTeam = spawnArgs.GetBool( KEY_SOLIDFORTEAM, "0" );
+	fl.neverDormant = spawnArgs.GetBool( KEY_NEVERDORMANT, "0" );
+	fl.hidden = spawnArgs.GetBool( KEY_HIDE, "0" );
 	if ( fl.hidden ) {
 		// make sure we're hidden, since a spawn function might not set it up right
 		PostEventMS( &EV_Hide, 0 );
 	}
-	cinematic = spawnArgs.GetBool( "cinematic", "0" );
+	cinematic = spawnArgs.GetBool( KEY_CINEMATIC, "0" );
+	fl.thinkTiers = spawnArgs.GetBool( KEY_THINKTIERS, "0" );
 
-	networkSync = spawnArgs.FindKey( "networkSync" );
+	networkSync = spawnArgs.FindKey( KEY_NETWORKSYNC );
 	if ( networkSync ) {
 		fl.networkSync = ( atoi( networkSync->GetValue() ) != 0 );
 	}
@@ -521,14 +538,14 @@ void idEntity::Spawn( void ) {
 #if 0
 	if ( !gameLocal.isClient ) {
 		// common->DPrintf( "NET: DBG %s - %s is synced: %s\n", spawnArgs.GetString( "classname", "" ), GetType()->classname, fl.networkSync ? "true" : "false" );
-		if ( spawnArgs.GetString( "classname", "" )[ 0 ] == '\0' && !fl.networkSync ) {
+		if ( spawnArgs.GetString( KEY_CLASSNAME, "" )[ 0 ] == '\0' && !fl.networkSync ) {
 			common->DPrintf( "NET: WRN %s entity, no classname, and no networkSync?\n", GetType()->classname );
 		}
 	}
 #endif
 
 	// every object will have a unique name
-	temp = spawnArgs.GetString( "name", va( "%s_%s_%d", GetClassname(), spawnArgs.GetString( "classname" ), entityNumber ) );
+	temp = spawnArgs.GetString( KEY_NAME, va( "%s_%s_%d", GetClassname(), spawnArgs.GetString( KEY_CLASSNAME ), entityNumber ) );
 	SetName( temp );
 
 	// if we have targets, wait until all entities are spawned to get them
@@ -541,19 +558,19 @@ void idEntity::Spawn( void ) {
 		}
 	}
 
-	health = spawnArgs.GetInt( "health" );
+	health = spawnArgs.GetInt( KEY_HEALTH );
 
 	InitDefaultPhysics( origin, axis );
 
 	SetOrigin( origin );
 	SetAxis( axis );
 
-	temp = spawnArgs.GetString( "model" );
+	temp = spawnArgs.GetString( KEY_MODEL );
 	if ( temp && *temp ) {
 		SetModel( temp );
 	}
 
-	if ( spawnArgs.GetString( "bind", "", &temp ) ) {
+	if ( spawnArgs.GetString( KEY_BIND, "", &temp ) ) {
 		PostEventMS( &EV_SpawnBind, 0 );
 	}
 
@@ -563,7 +580,7 @@ void idEntity::Spawn( void ) {
 	}
 
 	// setup script object
-	if ( ShouldConstructScriptObjectAtSpawn() && spawnArgs.GetString( "scriptobject", NULL, &scriptObjectName ) ) {
+	if ( ShouldConstructScriptObjectAtSpawn() && spawnArgs.GetString( KEY_SCRIPTOBJECT, NULL, &scriptObjectName ) ) {
 		if ( !scriptObject.SetType( scriptObjectName ) ) {
 			gameLocal.Error( "Script object '%s' not found on entity '%s'.", scriptObjectName, name.c_str() );
 		}
@@ -647,6 +664,7 @@ void idEntity::Save( idSaveGame *savefile ) const {
 	savefile->WriteInt( thinkFlags );
 	savefile->WriteInt( dormantStart );
 	savefile->WriteBool( cinematic );
+	savefile->WriteInt( thinkSkippedFrames );
 
 	savefile->WriteObject( cameraTarget );
 
@@ -721,6 +739,12 @@ void idEntity::Restore( idRestoreGame *savefile ) {
 	savefile->ReadInt( thinkFlags );
 	savefile->ReadInt( dormantStart );
 	savefile->ReadBool( cinematic );
+	if ( savefile->GetBuildNumber() >= THINK_TIERS_BUILD_NUMBER ) {
+		savefile->ReadInt( thinkSkippedFrames );
+	} else {
+		// not saved before the think tiers
+		thinkSkippedFrames = 0;
+	}
 
 	savefile->ReadObject( reinterpret_cast<idClass *&>( cameraTarget ) );
 
@@ -954,6 +978,7 @@ void idEntity::BecomeActive( int flags ) {
 	thinkFlags |= flags;
 	if ( thinkFlags ) {
 		if ( !IsActive() ) {
+			thinkSkippedFrames = 0;
 			activeNode.AddToEnd( gameLocal.activeEntities );
 		} else if ( !oldFlags ) {
 			// we became inactive this frame, so we have to decrease the count of entities to deactivate
@@ -134,6 +134,7 @@ public:
 
 	int						thinkFlags;				// TH_? flags
 	int						dormantStart;			// time that the entity was first closed off from player
+	int						thinkSkippedFrames;		// frames skipped by the think tier scheduler since the last think
 	bool					cinematic;				// during cinematics, entity will only think if cinematic is set
 
 	renderView_t *			renderView;				// for camera views from this entity
@@ -156,6 +157,7 @@ public:
 		bool				isDormant			:1;	// if true the entity is dormant
 		bool				hasAwakened			:1;	// before a monster has been awakened the first time, use full PVS for dormant instead of area-connected
 		bool				networkSync			:1; // if true the entity is synchronized over the network
+		bool				thinkTiers			:1;	// if true the entity thinks at reduced rates when far from the players
 	} fl;
 
 public:
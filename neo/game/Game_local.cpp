@@ -33,6 +33,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "framework/BuildVersion.h"
 #include "framework/DeclEntityDef.h"
 #include "framework/FileSystem.h"
+#include "framework/Profiler.h"
 #include "renderer/ModelManager.h"
 
 #include "gamesys/SysCvar.h"
@@ -58,6 +59,12 @@ const float	DEFAULT_GRAVITY			= 1066.0f;
 const idVec3	DEFAULT_GRAVITY_VEC3( 0, 0, -DEFAULT_GRAVITY );
 const int	CINEMATIC_SKIP_DELAY	= SEC2MS( 2.0f );
 
+// spawnArgs looked up for every spawned entity
+static const idDictKey	KEY_NAME( "name" );
+static const idDictKey	KEY_CLASSNAME( "classname" );
+static const idDictKey	KEY_SPAWNCLASS( "spawnclass" );
+static const idDictKey	KEY_SPAWNFUNC( "spawnfunc" );
+
 #ifdef GAME_DLL
 
 idSys *						sys = NULL;
@@ -73,6 +80,7 @@ idUserInterfaceManager *	uiManager = NULL;
 idDeclManager *				declManager = NULL;
 idAASFileManager *			AASFileManager = NULL;
 idCollisionModelManager *	collisionModelManager = NULL;
+idProfiler *				profiler = NULL;
 idCVar *					idCVar::staticVars = NULL;
 
 idCVar com_forceGenericSIMD( "com_forceGenericSIMD", "0", CVAR_BOOL|CVAR_SYSTEM, "force generic platform independent SIMD" );
@@ -120,6 +128,7 @@ extern "C" ID_GAME_API gameExport_t *GetGameAPI( gameImport_t *import ) {
 		declManager					= import->declManager;
 		AASFileManager				= import->AASFileManager;
 		collisionModelManager		= import->collisionModelManager;
+		profiler					= import->profiler;
 	}
 
 	// set interface pointers used by idLib
@@ -158,6 +167,7 @@ void TestGameAPI( void ) {
 	testImport.declManager				= ::declManager;
 	testImport.AASFileManager			= ::AASFileManager;
 	testImport.collisionModelManager	= ::collisionModelManager;
+	testImport.profiler					= ::profiler;
 
 	testExport = *GetGameAPI( &testImport );
 }
@@ -193,6 +203,9 @@ void idGameLocal::Clear( void ) {
 	spawnedEntities.Clear();
 	activeEntities.Clear();
 	numEntitiesToDeactivate = 0;
+	numThinkTierOrigins = 0;
+	memset( thinkTierCounts, 0, sizeof( thinkTierCounts ) );
+	thinkTierSkipped = 0;
 	sortPushers = false;
 	sortTeamMasters = false;
 	persistentLevelInfo.Clear();
@@ -602,14 +615,7 @@ void idGameLocal::SaveGame( idFile *f ) {
 
 	savegame.Close();
 
-#ifdef __EMSCRIPTEN__
-	EM_ASM(
-			console.info('Syncing user home to IDBFS....');
-			FS.syncfs(false, function(err) {
-				console.info("Syncing done.");
-			});
-		);
-#endif
+	// the session writes the file out and syncs it to IDBFS on the web build
 }
 
 /*
@@ -1911,6 +1917,106 @@ void idGameLocal::FreePlayerPVS( void ) {
 	}
 }
 
+/*
+================
+idGameLocal::SetupThinkTiers
+================
+*/
+void idGameLocal::SetupThinkTiers( void ) {
+	numThinkTierOrigins = 0;
+	for ( int i = 0; i < numClients; i++ ) {
+		idEntity *ent = entities[i];
+		if ( !ent || !ent->IsType( idPlayer::Type ) ) {
+			continue;
+		}
+		thinkTierOrigins[numThinkTierOrigins++] = ent->GetPhysics()->GetOrigin();
+	}
+
+	memset( thinkTierCounts, 0, sizeof( thinkTierCounts ) );
+	thinkTierSkipped = 0;
+}
+
+/*
+================
+idGameLocal::GetThinkTier
+
+Entities have to opt in with the thinkTiers spawnArg, the rest always think every frame.
+================
+*/
+thinkTier_t idGameLocal::GetThinkTier( idEntity *ent ) const {
+	if ( !ent->fl.thinkTiers || !g_thinkTiers.GetBool() || !numThinkTierOrigins || playerPVS.i == -1 ) {
+		return THINK_TIER_FULL;
+	}
+	if ( inCinematic && ent->cinematic ) {
+		return THINK_TIER_FULL;
+	}
+
+	const idVec3 &origin = ent->GetPhysics()->GetOrigin();
+	float distSqr = idMath::INFINITY;
+	for ( int i = 0; i < numThinkTierOrigins; i++ ) {
+		float d = ( thinkTierOrigins[i] - origin ).LengthSqr();
+		if ( d < distSqr ) {
+			distSqr = d;
+		}
+	}
+
+	if ( InPlayerPVS( ent ) ) {
+		if ( distSqr > Square( g_thinkTierNear.GetFloat() ) ) {
+			return THINK_TIER_REDUCED;
+		}
+		return THINK_TIER_FULL;
+	}
+	if ( distSqr > Square( g_thinkTierFar.GetFloat() ) ) {
+		return THINK_TIER_FAR;
+	}
+	return THINK_TIER_REDUCED;
+}
+
+/*
+================
+idGameLocal::ThinkEntity
+
+Returns false if the think tier scheduler skipped the entity this frame.
+Entities on the same tier are staggered by entity number to spread the load
+over the frames.  When a skipping entity thinks again, the skipped frames are
+added to its physics step so it catches up instead of falling behind.
+================
+*/
+bool idGameLocal::ThinkEntity( idEntity *ent, bool profile ) {
+	const thinkTier_t tier = GetThinkTier( ent );
+	int interval;
+
+	thinkTierCounts[tier]++;
+
+	switch( tier ) {
+		case THINK_TIER_REDUCED:	interval = g_thinkTierReducedFrames.GetInteger(); break;
+		case THINK_TIER_FAR:		interval = g_thinkTierFarFrames.GetInteger(); break;
+		default:					interval = 1; break;
+	}
+
+	if ( interval > 1 && ( framenum + ent->entityNumber ) % interval != 0 ) {
+		ent->thinkSkippedFrames++;
+		thinkTierSkipped++;
+		return false;
+	}
+
+	const int framePreviousTime = previousTime;
+	previousTime -= ent->thinkSkippedFrames * msec;
+	ent->thinkSkippedFrames = 0;
+
+	if ( profile ) {
+		profiler->BeginZone( ent->GetType()->classname );
+	}
+	ent->Think();
+	if ( profile ) {
+		profiler->EndZone();
+	}
+
+	previousTime = framePreviousTime;
+
+	return true;
+}
+
 /*
 ================
 idGameLocal::InPlayerPVS
@@ -2121,12 +2227,21 @@ gameReturn_t idGameLocal::RunFrame( const usercmd_t *clientCmds ) {
 		// create a merged pvs for all players
 		SetupPlayerPVS();
 
+		// gather the player positions for the think tiers
+		SetupThinkTiers();
+
 		// sort the active entity list
 		SortActiveEntityList();
 
 		timer_think.Clear();
 		timer_think.Start();
 
+		// each entity think is profiled under its class name, which gives the think cost per type
+		const bool profileThink = profiler->IsEnabled();
+		if ( profileThink ) {
+			profiler->BeginZone( "Game_Think" );
+		}
+
 		// let entities think
 		if ( g_timeentities.GetFloat() ) {
 			num = 0;
@@ -2137,7 +2252,9 @@ gameReturn_t idGameLocal::RunFrame( const usercmd_t *clientCmds ) {
 				}
 				timer_singlethink.Clear();
 				timer_singlethink.Start();
-				ent->Think();
+				if ( !ThinkEntity( ent, profileThink ) ) {
+					continue;
+				}
 				timer_singlethink.Stop();
 				ms = timer_singlethink.Milliseconds();
 				if ( ms >= g_timeentities.GetFloat() ) {
@@ -2153,13 +2270,17 @@ gameReturn_t idGameLocal::RunFrame( const usercmd_t *clientCmds ) {
 						ent->GetPhysics()->UpdateTime( time );
 						continue;
 					}
-					ent->Think();
+					if ( !ThinkEntity( ent, profileThink ) ) {
+						continue;
+					}
 					num++;
 				}
 			} else {
 				num = 0;
 				for( ent = activeEntities.Next(); ent != NULL; ent = ent->activeNode.Next() ) {
-					ent->Think();
+					if ( !ThinkEntity( ent, profileThink ) ) {
+						continue;
+					}
 					num++;
 				}
 			}
@@ -2180,12 +2301,19 @@ gameReturn_t idGameLocal::RunFrame( const usercmd_t *clientCmds ) {
 			numEntitiesToDeactivate = 0;
 		}
 
+		if ( profileThink ) {
+			profiler->EndZone();
+		}
+
 		timer_think.Stop();
 		timer_events.Clear();
 		timer_events.Start();
 
 		// service any pending events
-		idEvent::ServiceEvents();
+		{
+			PROFILE_SCOPE( "Game_Events" );
+			idEvent::ServiceEvents();
+		}
 
 		timer_events.Stop();
 
@@ -2204,6 +2332,12 @@ gameReturn_t idGameLocal::RunFrame( const usercmd_t *clientCmds ) {
 				timer_think.Milliseconds(), timer_events.Milliseconds(), num );
 		}
 
+		if ( g_thinkTierStats.GetBool() ) {
+			Printf( "think tiers %d: full:%d reduced:%d far:%d skipped:%d\n", time,
+				thinkTierCounts[THINK_TIER_FULL], thinkTierCounts[THINK_TIER_REDUCED],
+				thinkTierCounts[THINK_TIER_FAR], thinkTierSkipped );
+		}
+
 		// build the return value
 		ret.consistencyHash = 0;
 		ret.sessionCommand[0] = 0;
@@ -2925,11 +3059,11 @@ bool idGameLocal::SpawnEntityDef( const idDict &args, idEntity **ent, bool setDe
 
 	spawnArgs = args;
 
-	if ( spawnArgs.GetString( "name", "", &name ) ) {
+	if ( spawnArgs.GetString( KEY_NAME, "", &name ) ) {
 		sprintf( error, " on '%s'", name);
 	}
 
-	spawnArgs.GetString( "classname", NULL, &classname );
+	spawnArgs.GetString( KEY_CLASSNAME, NULL, &classname );
 
 	const idDeclEntityDef *def = FindEntityDef( classname, false );
 
@@ -2941,7 +3075,7 @@ bool idGameLocal::SpawnEntityDef( const idDict &args, idEntity **ent, bool setDe
 	spawnArgs.SetDefaults( &def->dict );
 
 	// check if we should spawn a class object
-	spawnArgs.GetString( "spawnclass", NULL, &spawn );
+	spawnArgs.GetString( KEY_SPAWNCLASS, NULL, &spawn );
 	if ( spawn ) {
 
 		cls = idClass::GetClass( spawn );
@@ -2966,7 +3100,7 @@ bool idGameLocal::SpawnEntityDef( const idDict &args, idEntity **ent, bool setDe
 	}
 
 	// check if we should call a script function to spawn
-	spawnArgs.GetString( "spawnfunc", NULL, &spawn );
+	spawnArgs.GetString( KEY_SPAWNFUNC, NULL, &spawn );
 	if ( spawn ) {
 		const function_t *func = program.FindFunction( spawn );
 		if ( !func ) {
@@ -3091,6 +3225,7 @@ void idGameLocal::SpawnMapEntities( void ) {
 	idMapEntity	*mapEnt;
 	int			numEntities;
 	idDict		args;
+	idTimer		timer;
 
 	Printf( "Spawning entities\n" );
 
@@ -3101,6 +3236,8 @@ void idGameLocal::SpawnMapEntities( void ) {
 
 	SetSkill( g_skill.GetInteger() );
 
+	timer.Start();
+
 	numEntities = mapFile->GetNumEntities();
 	if ( numEntities == 0 ) {
 		Error( "...no entities" );
@@ -3142,7 +3279,9 @@ void idGameLocal::SpawnMapEntities( void ) {
 		}
 	}
 
-	Printf( "...%i entities spawned, %i inhibited\n\n", num, inhibit );
+	timer.Stop();
+
+	Printf( "...%i entities spawned, %i inhibited in %u ms\n\n", num, inhibit, timer.Milliseconds() );
 }
 
 /*
@@ -157,6 +157,13 @@ typedef enum {
 	GAMESTATE_SHUTDOWN				// inside MapShutdown().  clearing memory.
 } gameState_t;
 
+typedef enum {
+	THINK_TIER_FULL,				// thinks every frame
+	THINK_TIER_REDUCED,				// in the player PVS but distant, or outside it but close
+	THINK_TIER_FAR,					// outside the player PVS and far away
+	NUM_THINK_TIERS
+} thinkTier_t;
+
 typedef struct {
 	idEntity	*ent;
 	int			dist;
@@ -472,6 +479,11 @@ private:
 	pvsHandle_t				playerPVS;				// merged pvs of all players
 	pvsHandle_t				playerConnectedAreas;	// all areas connected to any player area
 
+	idVec3					thinkTierOrigins[MAX_CLIENTS];	// player positions the think tiers are measured from
+	int						numThinkTierOrigins;
+	int						thinkTierCounts[NUM_THINK_TIERS];	// entities on each think tier in the current frame
+	int						thinkTierSkipped;		// thinks skipped by the tier scheduler in the current frame
+
 	idVec3					gravity;				// global gravity vector
 	gameState_t				gamestate;				// keeps track of whether we're spawning, shutting down, or normal gameplay
 	bool					influenceActive;		// true when a phantasm is happening
@@ -512,6 +524,9 @@ private:
 	void					FreePlayerPVS( void );
 	void					UpdateGravity( void );
 	void					SortActiveEntityList( void );
+	void					SetupThinkTiers( void );
+	thinkTier_t				GetThinkTier( idEntity *ent ) const;
+	bool					ThinkEntity( idEntity *ent, bool profile );
 	void					ShowTargets( void );
 	void					RunDebugInfo( void );
 
@@ -28,6 +28,7 @@ If you have questions concerning this license or the applicable additional terms
 
 #include "sys/platform.h"
 #include "renderer/ModelManager.h"
+#include "gamesys/SysCvar.h"
 #include "Game_local.h"
 
 #include "SmokeParticles.h"
@@ -43,10 +44,21 @@ idSmokeParticles::idSmokeParticles( void ) {
 	initialized = false;
 	memset( &renderEntity, 0, sizeof( renderEntity ) );
 	renderEntityHandle = -1;
-	memset( smokes, 0, sizeof( smokes ) );
-	freeSmokes = NULL;
 	numActiveSmokes = 0;
 	currentParticleTime = -1;
+	currentViewOrigin.Zero();
+	currentViewAxis.Identity();
+	memset( &stats, 0, sizeof( stats ) );
+}
+
+/*
+================
+idSmokeParticles::~idSmokeParticles
+================
+*/
+idSmokeParticles::~idSmokeParticles( void ) {
+	activeStages.DeleteContents( true );
+	freeStages.DeleteContents( true );
 }
 
 /*
@@ -59,16 +71,11 @@ void idSmokeParticles::Init( void ) {
 		Shutdown();
 	}
 
-	// set up the free list
-	for ( int i = 0; i < MAX_SMOKE_PARTICLES-1; i++ ) {
-		smokes[i].next = &smokes[i+1];
-	}
-	smokes[MAX_SMOKE_PARTICLES-1].next = NULL;
-	freeSmokes = &smokes[0];
+	// release the pools of the previous map
+	activeStages.DeleteContents( true );
+	freeStages.DeleteContents( true );
 	numActiveSmokes = 0;
 
-	activeStages.Clear();
-
 	memset( &renderEntity, 0, sizeof( renderEntity ) );
 
 	renderEntity.bounds.Clear();
@@ -115,6 +122,45 @@ void idSmokeParticles::Shutdown( void ) {
 	initialized = false;
 }
 
+/*
+================
+idSmokeParticles::AllocStage
+
+Takes an emptied pool from the free list if there is one, so a busy
+stage does not grow its pool again every time it comes back.
+================
+*/
+activeSmokeStage_t *idSmokeParticles::AllocStage( const idParticleStage *stage ) {
+	activeSmokeStage_t *active;
+
+	if ( freeStages.Num() ) {
+		active = freeStages[freeStages.Num() - 1];
+		freeStages.RemoveIndex( freeStages.Num() - 1 );
+	} else {
+		active = new activeSmokeStage_t;
+		active->smokes.SetGranularity( SMOKE_POOL_GRANULARITY );
+	}
+	active->stage = stage;
+	active->smokes.SetNum( 0, false );
+	activeStages.Append( active );
+
+	return active;
+}
+
+/*
+================
+idSmokeParticles::FreeStage
+================
+*/
+void idSmokeParticles::FreeStage( int activeStageNum ) {
+	activeSmokeStage_t *active = activeStages[activeStageNum];
+
+	active->stage = NULL;
+	active->smokes.SetNum( 0, false );
+	freeStages.Append( active );
+	activeStages.RemoveIndex( activeStageNum );
+}
+
 /*
 ================
 idSmokeParticles::FreeSmokes
@@ -122,40 +168,43 @@ idSmokeParticles::FreeSmokes
 */
 void idSmokeParticles::FreeSmokes( void ) {
 	for ( int activeStageNum = 0; activeStageNum < activeStages.Num(); activeStageNum++ ) {
-		singleSmoke_t *smoke, *next, *last;
-
-		activeSmokeStage_t *active = &activeStages[activeStageNum];
+		activeSmokeStage_t *active = activeStages[activeStageNum];
 		const idParticleStage *stage = active->stage;
 
-		for ( last = NULL, smoke = active->smokes; smoke; smoke = next ) {
-			next = smoke->next;
+		// compact the pool over the dead smokes, keeping the emission order
+		int numSmokes = 0;
+		for ( int i = 0; i < active->smokes.Num(); i++ ) {
+			const singleSmoke_t &smoke = active->smokes[i];
 
-			float frac = (float)( gameLocal.time - smoke->privateStartTime ) / ( stage->particleLife * 1000 );
+			float frac = (float)( gameLocal.time - smoke.privateStartTime ) / ( stage->particleLife * 1000 );
 			if ( frac >= 1.0f ) {
-				// remove the particle from the stage list
-				if ( last != NULL ) {
-					last->next = smoke->next;
-				} else {
-					active->smokes = smoke->next;
-				}
-				// put the particle on the free list
-				smoke->next = freeSmokes;
-				freeSmokes = smoke;
-				numActiveSmokes--;
 				continue;
 			}
-
-			last = smoke;
+			if ( numSmokes != i ) {
+				active->smokes[numSmokes] = smoke;
+			}
+			numSmokes++;
 		}
+		numActiveSmokes -= active->smokes.Num() - numSmokes;
+		active->smokes.SetNum( numSmokes, false );
 
-		if ( !active->smokes ) {
+		if ( !numSmokes ) {
 			// remove this from the activeStages list
-			activeStages.RemoveIndex( activeStageNum );
+			FreeStage( activeStageNum );
 			activeStageNum--;
 		}
 	}
 }
 
+/*
+================
+idSmokeParticles::ClearStats
+================
+*/
+void idSmokeParticles::ClearStats( void ) {
+	memset( &stats, 0, sizeof( stats ) );
+}
+
 /*
 ================
 idSmokeParticles::EmitSmoke
@@ -241,38 +290,31 @@ bool idSmokeParticles::EmitSmoke( const idDeclParticle *smoke, const int systemS
 		activeSmokeStage_t	*active = NULL;
 		int i;
 		for ( i = 0 ; i < activeStages.Num() ; i++ ) {
-			active = &activeStages[i];
-			if ( active->stage == stage ) {
+			if ( activeStages[i]->stage == stage ) {
+				active = activeStages[i];
 				break;
 			}
 		}
-		if ( i == activeStages.Num() ) {
+		if ( !active ) {
 			// add a new one
-			activeSmokeStage_t	newActive;
-
-			newActive.smokes = NULL;
-			newActive.stage = stage;
-			i = activeStages.Append( newActive );
-			active = &activeStages[i];
+			active = AllocStage( stage );
 		}
 
-		// add all the required particles
+		// add all the required particles, the pools grow in blocks up to the soft limit
+		const int maxSmokes = g_maxSmokeParticles.GetInteger();
 		for ( prevCount++ ; prevCount <= nowCount ; prevCount++ ) {
-			if ( !freeSmokes ) {
-				gameLocal.Printf( "idSmokeParticles::EmitSmoke: no free smokes with %d active stages\n", activeStages.Num() );
+			if ( numActiveSmokes >= maxSmokes ) {
+				gameLocal.Printf( "idSmokeParticles::EmitSmoke: %d smokes with %d active stages hit g_maxSmokeParticles\n", numActiveSmokes, activeStages.Num() );
 				return true;
 			}
-			singleSmoke_t	*newSmoke = freeSmokes;
-			freeSmokes = freeSmokes->next;
+			singleSmoke_t &newSmoke = active->smokes.Alloc();
 			numActiveSmokes++;
 
-			newSmoke->index = prevCount;
-			newSmoke->axis = axis;
-			newSmoke->origin = origin;
-			newSmoke->random = steppingRandom;
-			newSmoke->privateStartTime = systemStartTime + prevCount * finalParticleTime / stage->totalParticles;
-			newSmoke->next = active->smokes;
-			active->smokes = newSmoke;
+			newSmoke.index = prevCount;
+			newSmoke.axis = axis;
+			newSmoke.origin = origin;
+			newSmoke.random = steppingRandom;
+			newSmoke.privateStartTime = systemStartTime + prevCount * finalParticleTime / stage->totalParticles;
 
 			steppingRandom.RandomInt();	// advance the random
 		}
@@ -288,20 +330,64 @@ idSmokeParticles::UpdateRenderEntity
 */
 bool idSmokeParticles::UpdateRenderEntity( renderEntity_s *renderEntity, const renderView_t *renderView ) {
 
-	// FIXME: re-use model surfaces
-	renderEntity->hModel->InitEmpty( smokeParticle_SnapshotName );
-
 	// this may be triggered by a model trace or other non-view related source,
 	// to which we should look like an empty model
 	if ( !renderView ) {
+		renderEntity->hModel->InitEmpty( smokeParticle_SnapshotName );
+		currentParticleTime = -1;
 		return false;
 	}
 
-	// don't regenerate it if it is current
+	const int cullSmokes = g_cullSmokeParticles.GetInteger();
+
+	// don't regenerate it if it is current, with culling it is only current for the same view
 	if ( renderView->time == currentParticleTime && !renderView->forceUpdate ) {
-		return false;
+		if ( !cullSmokes || ( renderView->vieworg == currentViewOrigin && renderView->viewaxis == currentViewAxis ) ) {
+			return false;
+		}
 	}
 	currentParticleTime = renderView->time;
+	currentViewOrigin = renderView->vieworg;
+	currentViewAxis = renderView->viewaxis;
+
+	// FIXME: re-use model surfaces
+	renderEntity->hModel->InitEmpty( smokeParticle_SnapshotName );
+
+	// clients never free smokes from the game frame, and the pools
+	// must not hold dead smokes when the vertex count is allocated
+	FreeSmokes();
+
+	// set up the view frustum and PVS the smoke groups are culled against
+	idFrustum viewFrustum;
+	bool useFrustum = false;
+	pvsHandle_t pvsHandle;
+	pvsHandle.i = -1;
+	pvsHandle.h = 0;
+
+	if ( cullSmokes > 0 ) {
+		if ( renderView->fov_x > 0.0f && renderView->fov_x < 180.0f && renderView->fov_y > 0.0f && renderView->fov_y < 180.0f ) {
+			const float dFar = MAX_WORLD_SIZE;
+			viewFrustum.SetOrigin( renderView->vieworg );
+			viewFrustum.SetAxis( renderView->viewaxis );
+			viewFrustum.SetSize( 0.0f, dFar, dFar * idMath::Tan( DEG2RAD( renderView->fov_x * 0.5f ) ), dFar * idMath::Tan( DEG2RAD( renderView->fov_y * 0.5f ) ) );
+			useFrustum = true;
+		}
+		if ( cullSmokes > 1 && renderView->viewID != 0 ) {
+			// subviews clear the viewID, the renderer finds their areas from the origin of the
+			// view they are seen in, not from a mirrored origin, so they are only frustum culled
+			int viewArea = gameRenderWorld->PointInArea( renderView->vieworg );
+			if ( viewArea >= 0 ) {
+				pvsHandle = gameLocal.pvs.SetupCurrentPVS( viewArea );
+			}
+		}
+	}
+
+	stats.numActiveSmokes = numActiveSmokes;
+	stats.numGroups = 0;
+	stats.numCulledGroups = 0;
+	stats.numCulledSmokes = 0;
+	stats.numQuads = 0;
+	stats.numCulledQuads = 0;
 
 	particleGen_t g;
 
@@ -309,21 +395,60 @@ bool idSmokeParticles::UpdateRenderEntity( renderEntity_s *renderEntity, const r
 	g.renderView = renderView;
 
 	for ( int activeStageNum = 0; activeStageNum < activeStages.Num(); activeStageNum++ ) {
-		singleSmoke_t *smoke, *next, *last;
-
-		activeSmokeStage_t *active = &activeStages[activeStageNum];
+		const activeSmokeStage_t *active = activeStages[activeStageNum];
 		const idParticleStage *stage = active->stage;
 
 		if ( !stage->material ) {
 			continue;
 		}
 
-		// allocate a srfTriangles that can hold all the particles
+		const int numSmokes = active->smokes.Num();
+		const int quadsPerParticle = stage->NumQuadsPerParticle();
+
+		// a stage without derived bounds can't be culled
+		const bool cullGroups = ( useFrustum || pvsHandle.i != -1 ) && !stage->bounds.IsCleared();
+		const float particleRadius = cullGroups ? stage->bounds.GetRadius() : 0.0f;
+
+		// test each group of consecutive smokes against the view
+		visibleGroups.SetNum( ( numSmokes + SMOKE_GROUP_SIZE - 1 ) / SMOKE_GROUP_SIZE, false );
 		int count = 0;
-		for ( smoke = active->smokes; smoke; smoke = smoke->next ) {
-			count++;
+		for ( int group = 0; group < visibleGroups.Num(); group++ ) {
+			const int first = group * SMOKE_GROUP_SIZE;
+			const int last = Min( first + SMOKE_GROUP_SIZE, numSmokes );
+			bool visible = true;
+
+			if ( cullGroups ) {
+				idBounds groupBounds;
+				groupBounds.Clear();
+				for ( int i = first; i < last; i++ ) {
+					groupBounds.AddPoint( active->smokes[i].origin );
+				}
+				groupBounds.ExpandSelf( particleRadius );
+
+				if ( useFrustum && viewFrustum.CullBounds( groupBounds ) ) {
+					visible = false;
+				} else if ( pvsHandle.i != -1 && !gameLocal.pvs.InCurrentPVS( pvsHandle, groupBounds ) ) {
+					visible = false;
+				}
+			}
+
+			visibleGroups[group] = visible;
+			stats.numGroups++;
+			if ( visible ) {
+				count += last - first;
+			} else {
+				stats.numCulledGroups++;
+				stats.numCulledSmokes += last - first;
+				stats.numCulledQuads += ( last - first ) * quadsPerParticle;
+			}
 		}
-		int	quads = count * stage->NumQuadsPerParticle();
+
+		if ( !count ) {
+			continue;
+		}
+
+		// allocate a srfTriangles that can hold all the visible particles
+		int	quads = count * quadsPerParticle;
 		srfTriangles_t *tri = renderEntity->hModel->AllocSurfaceTriangles( quads * 4, quads * 6 );
 		tri->numIndexes = quads * 6;
 		tri->numVerts = quads * 4;
@@ -336,52 +461,35 @@ bool idSmokeParticles::UpdateRenderEntity( renderEntity_s *renderEntity, const r
 		tri->bounds[1][1] =
 		tri->bounds[1][2] = 99999;
 
+		// newest smokes first, the order the old linked lists were drawn in
 		tri->numVerts = 0;
-		for ( last = NULL, smoke = active->smokes; smoke; smoke = next ) {
-			next = smoke->next;
-
-			g.frac = (float)( gameLocal.time - smoke->privateStartTime ) / ( stage->particleLife * 1000 );
-			if ( g.frac >= 1.0f ) {
-				// remove the particle from the stage list
-				if ( last != NULL ) {
-					last->next = smoke->next;
-				} else {
-					active->smokes = smoke->next;
-				}
-				// put the particle on the free list
-				smoke->next = freeSmokes;
-				freeSmokes = smoke;
-				numActiveSmokes--;
+		for ( int group = visibleGroups.Num() - 1; group >= 0; group-- ) {
+			if ( !visibleGroups[group] ) {
 				continue;
 			}
+			const int first = group * SMOKE_GROUP_SIZE;
+			for ( int i = Min( first + SMOKE_GROUP_SIZE, numSmokes ) - 1; i >= first; i-- ) {
+				const singleSmoke_t &smoke = active->smokes[i];
 
-			g.index = smoke->index;
-			g.random = smoke->random;
+				g.frac = (float)( gameLocal.time - smoke.privateStartTime ) / ( stage->particleLife * 1000 );
+				g.index = smoke.index;
+				g.random = smoke.random;
 
-			g.origin = smoke->origin;
-			g.axis = smoke->axis;
+				g.origin = smoke.origin;
+				g.axis = smoke.axis;
 
-			g.originalRandom = g.random;
-			g.age = g.frac * stage->particleLife;
+				g.originalRandom = g.random;
+				g.age = g.frac * stage->particleLife;
 
-			tri->numVerts += stage->CreateParticle( &g, tri->verts + tri->numVerts );
-
-			last = smoke;
+				tri->numVerts += stage->CreateParticle( &g, tri->verts + tri->numVerts );
+			}
 		}
 		if ( tri->numVerts > quads * 4 ) {
 			gameLocal.Error( "idSmokeParticles::UpdateRenderEntity: miscounted verts" );
 		}
 
 		if ( tri->numVerts == 0 ) {
-
-			// they were all removed
 			renderEntity->hModel->FreeSurfaceTriangles( tri );
-
-			if ( !active->smokes ) {
-				// remove this from the activeStages list
-				activeStages.RemoveIndex( activeStageNum );
-				activeStageNum--;
-			}
 		} else {
 			// build the index list
 			int	indexes = 0;
@@ -395,6 +503,7 @@ bool idSmokeParticles::UpdateRenderEntity( renderEntity_s *renderEntity, const r
 				indexes += 6;
 			}
 			tri->numIndexes = indexes;
+			stats.numQuads += tri->numVerts / 4;
 
 			modelSurface_t	surf;
 			surf.geometry = tri;
@@ -404,6 +513,14 @@ bool idSmokeParticles::UpdateRenderEntity( renderEntity_s *renderEntity, const r
 			renderEntity->hModel->AddSurface( surf );
 		}
 	}
+
+	if ( pvsHandle.i != -1 ) {
+		gameLocal.pvs.FreeCurrentPVS( pvsHandle );
+	}
+
+	stats.peakActiveSmokes = Max( stats.peakActiveSmokes, stats.numActiveSmokes );
+	stats.peakQuads = Max( stats.peakQuads, stats.numQuads );
+
 	return true;
 }
 
@@ -29,6 +29,7 @@ If you have questions concerning this license or the applicable additional terms
 #ifndef __SMOKEPARTICLES_H__
 #define __SMOKEPARTICLES_H__
 
+#include "idlib/containers/List.h"
 #include "idlib/math/Random.h"
 #include "idlib/math/Vector.h"
 #include "idlib/math/Matrix.h"
@@ -48,6 +49,10 @@ If you have questions concerning this license or the applicable additional terms
 	particle systems are completely parametric, and have no performance
 	overhead when not in view.
 
+	Each stage keeps its smokes in one contiguous pool.  The pool is walked
+	in groups of consecutive smokes, and a group is only turned into quads
+	when its bounds are inside the view frustum and the PVS of the view.
+
 	All smoke systems share the same shaderparms, so any coloration must be
 	done in the particle definition.
 
@@ -58,7 +63,6 @@ If you have questions concerning this license or the applicable additional terms
 */
 
 typedef struct singleSmoke_s {
-	struct singleSmoke_s	 *	next;
 	int							privateStartTime;	// start time for this particular particle
 	int							index;				// particle index in system, 0 <= index < stage->totalParticles
 	idRandom					random;
@@ -68,13 +72,24 @@ typedef struct singleSmoke_s {
 
 typedef struct {
 	const idParticleStage *		stage;
-	singleSmoke_t *				smokes;
+	idList<singleSmoke_t>		smokes;				// contiguous pool in emission order, oldest first
 } activeSmokeStage_t;
 
+typedef struct {
+	int							numActiveSmokes;	// smokes alive in all pools
+	int							numGroups;			// smoke groups tested against the view
+	int							numCulledGroups;	// groups outside the view frustum or PVS
+	int							numCulledSmokes;	// smokes skipped with the culled groups
+	int							numQuads;			// quads generated for the last view
+	int							numCulledQuads;		// quads skipped with the culled groups
+	int							peakActiveSmokes;
+	int							peakQuads;
+} smokeStats_t;
 
 class idSmokeParticles {
 public:
 								idSmokeParticles( void );
+								~idSmokeParticles( void );
 
 	// creats an entity covering the entire world that will call back each rendering
 	void						Init( void );
@@ -87,20 +102,30 @@ public:
 	// free old smokes
 	void						FreeSmokes( void );
 
+	// counters of the last generated view, for the smokeStats command
+	const smokeStats_t &		GetStats( void ) const { return stats; }
+	void						ClearStats( void );
+
 private:
 	bool						initialized;
 
 	renderEntity_t				renderEntity;			// used to present a model to the renderer
 	int							renderEntityHandle;		// handle to static renderer model
 
-	static const int			MAX_SMOKE_PARTICLES = 10000;
-	singleSmoke_t				smokes[MAX_SMOKE_PARTICLES];
+	static const int			SMOKE_POOL_GRANULARITY = 256;
+	static const int			SMOKE_GROUP_SIZE = 32;	// consecutive smokes culled as one group
 
-	idList<activeSmokeStage_t>	activeStages;
-	singleSmoke_t *				freeSmokes;
+	idList<activeSmokeStage_t *> activeStages;
+	idList<activeSmokeStage_t *> freeStages;		// emptied stage pools kept for reuse
 	int							numActiveSmokes;
 	int							currentParticleTime;	// don't need to recalculate if == view time
+	idVec3						currentViewOrigin;		// culling depends on the view, so regenerate if it moves
+	idMat3						currentViewAxis;
+	smokeStats_t				stats;
+	idList<bool>				visibleGroups;			// culling result of the stage being generated
 
+	activeSmokeStage_t *		AllocStage( const idParticleStage *stage );
+	void						FreeStage( int activeStageNum );
 	bool						UpdateRenderEntity( renderEntity_s *renderEntity, const renderView_t *renderView );
 	static bool					ModelCallback( renderEntity_s *renderEntity, const renderView_t *renderView );
 };
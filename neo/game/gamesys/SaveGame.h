@@ -43,6 +43,7 @@ Save game related helper classes.
 */
 
 const int INITIAL_RELEASE_BUILD_NUMBER = 1262;
+const int THINK_TIERS_BUILD_NUMBER = 19041;		// first build that saves idEntity::thinkSkippedFrames
 
 class idSaveGame {
 public:
@@ -40,6 +40,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "WorldSpawn.h"
 #include "Fx.h"
 #include "Misc.h"
+#include "SmokeParticles.h"
 
 #include "SysCmds.h"
 
@@ -1440,6 +1441,29 @@ static void Cmd_AASStats_f( const idCmdArgs &args ) {
 	}
 }
 
+/*
+==================
+Cmd_SmokeStats_f
+==================
+*/
+static void Cmd_SmokeStats_f( const idCmdArgs &args ) {
+	if ( !gameLocal.smokeParticles ) {
+		return;
+	}
+
+	if ( args.Argc() > 1 && !idStr::Icmp( args.Argv( 1 ), "clear" ) ) {
+		gameLocal.smokeParticles->ClearStats();
+		return;
+	}
+
+	const smokeStats_t &stats = gameLocal.smokeParticles->GetStats();
+	gameLocal.Printf( "%6d active smokes (peak %d)\n", stats.numActiveSmokes, stats.peakActiveSmokes );
+	gameLocal.Printf( "%6d groups, %d culled\n", stats.numGroups, stats.numCulledGroups );
+	gameLocal.Printf( "%6d culled smokes\n", stats.numCulledSmokes );
+	gameLocal.Printf( "%6d generated quads (peak %d)\n", stats.numQuads, stats.peakQuads );
+	gameLocal.Printf( "%6d culled quads\n", stats.numCulledQuads );
+}
+
 /*
 ==================
 Cmd_TestDamage_f
@@ -2321,6 +2345,7 @@ void idGameLocal::InitConsoleCommands( void ) {
 	cmdSystem->AddCommand( "reloadanims",			Cmd_ReloadAnims_f,			CMD_FL_GAME|CMD_FL_CHEAT,	"reloads animations" );
 	cmdSystem->AddCommand( "listAnims",				Cmd_ListAnims_f,			CMD_FL_GAME,				"lists all animations" );
 	cmdSystem->AddCommand( "aasStats",				Cmd_AASStats_f,				CMD_FL_GAME,				"shows AAS stats" );
+	cmdSystem->AddCommand( "smokeStats",			Cmd_SmokeStats_f,			CMD_FL_GAME,				"shows smoke particle counters of the last view, \"clear\" resets the peaks" );
 	//cmdSystem->AddCommand( "testDamage",			Cmd_TestDamage_f,			CMD_FL_GAME|CMD_FL_CHEAT,	"tests a damage def", idCmdSystem::ArgCompletion_Decl<DECL_ENTITYDEF> );
 	cmdSystem->AddCommand( "weaponSplat",			Cmd_WeaponSplat_f,			CMD_FL_GAME|CMD_FL_CHEAT,	"projects a blood splat on the player weapon" );
 	cmdSystem->AddCommand( "saveSelected",			Cmd_SaveSelected_f,			CMD_FL_GAME|CMD_FL_CHEAT,	"saves the selected entity to the .map file" );
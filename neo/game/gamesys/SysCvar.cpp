@@ -110,8 +110,11 @@ idCVar g_nightmare(					"g_nightmare",				"0",			CVAR_GAME | CVAR_ARCHIVE | CVAR
 idCVar g_gravity(					"g_gravity",		DEFAULT_GRAVITY_STRING, CVAR_GAME | CVAR_FLOAT, "" );
 idCVar g_skipFX(					"g_skipFX",					"0",			CVAR_GAME | CVAR_BOOL, "" );
 idCVar g_skipParticles(				"g_skipParticles",			"0",			CVAR_GAME | CVAR_BOOL, "" );
+idCVar g_maxSmokeParticles(			"g_maxSmokeParticles",		"20000",		CVAR_GAME | CVAR_INTEGER, "maximum number of smoke particles alive at once", 0, 1000000 );
+idCVar g_cullSmokeParticles(		"g_cullSmokeParticles",		"2",			CVAR_GAME | CVAR_INTEGER, "cull smoke particle groups before building their quads: 0 = off, 1 = view frustum, 2 = view frustum and PVS of player views", 0, 2 );
 
 idCVar g_disasm(					"g_disasm",					"0",			CVAR_GAME | CVAR_BOOL, "disassemble script into base/script/disasm.txt on the local drive when script is compiled" );
+idCVar g_scriptCache(				"g_scriptCache",			"1",			CVAR_GAME | CVAR_BOOL, "load the compiled game scripts from scriptcache/ when none of their sources changed" );
 idCVar g_debugBounds(				"g_debugBounds",			"0",			CVAR_GAME | CVAR_BOOL, "checks for models with bounds > 2048" );
 idCVar g_debugAnim(					"g_debugAnim",				"-1",			CVAR_GAME | CVAR_INTEGER, "displays information on which animations are playing on the specified entity number.  set to -1 to disable." );
 idCVar g_debugMove(					"g_debugMove",				"0",			CVAR_GAME | CVAR_BOOL, "" );
@@ -149,6 +152,13 @@ idCVar g_showEnemies(				"g_showEnemies",			"0",			CVAR_GAME | CVAR_BOOL, "draws
 idCVar g_frametime(					"g_frametime",				"0",			CVAR_GAME | CVAR_BOOL, "displays timing information for each game frame" );
 idCVar g_timeentities(				"g_timeEntities",			"0",			CVAR_GAME | CVAR_FLOAT, "when non-zero, shows entities whose think functions exceeded the # of milliseconds specified" );
 
+idCVar g_thinkTiers(				"g_thinkTiers",				"1",			CVAR_GAME | CVAR_BOOL, "lets entities with the thinkTiers spawnArg think at reduced rates when far from the players" );
+idCVar g_thinkTierNear(				"g_thinkTierNear",			"1024",			CVAR_GAME | CVAR_FLOAT, "entities in the player PVS beyond this distance think at the reduced rate" );
+idCVar g_thinkTierFar(				"g_thinkTierFar",			"2048",			CVAR_GAME | CVAR_FLOAT, "entities outside the player PVS beyond this distance think at the far rate, closer ones at the reduced rate" );
+idCVar g_thinkTierReducedFrames(	"g_thinkTierReducedFrames",	"2",			CVAR_GAME | CVAR_INTEGER, "entities on the reduced tier think every # frames", 1, 16, idCmdSystem::ArgCompletion_Integer<1,16> );
+idCVar g_thinkTierFarFrames(		"g_thinkTierFarFrames",		"4",			CVAR_GAME | CVAR_INTEGER, "entities on the far tier think every # frames", 1, 16, idCmdSystem::ArgCompletion_Integer<1,16> );
+idCVar g_thinkTierStats(			"g_thinkTierStats",			"0",			CVAR_GAME | CVAR_BOOL, "displays the number of entities on each think tier for each game frame" );
+
 idCVar ai_debugScript(				"ai_debugScript",			"-1",			CVAR_GAME | CVAR_INTEGER, "displays script calls for the specified monster entity number" );
 idCVar ai_debugMove(				"ai_debugMove",				"0",			CVAR_GAME | CVAR_BOOL, "draws movement information for monsters" );
 idCVar ai_debugTrajectory(			"ai_debugTrajectory",		"0",			CVAR_GAME | CVAR_BOOL, "draws trajectory tests for monsters" );
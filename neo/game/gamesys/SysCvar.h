@@ -45,12 +45,15 @@ extern idCVar	g_skill;
 extern idCVar	g_gravity;
 extern idCVar	g_skipFX;
 extern idCVar	g_skipParticles;
+extern idCVar	g_maxSmokeParticles;
+extern idCVar	g_cullSmokeParticles;
 extern idCVar	g_bloodEffects;
 extern idCVar	g_projectileLights;
 extern idCVar	g_doubleVision;
 extern idCVar	g_muzzleFlash;
 
 extern idCVar	g_disasm;
+extern idCVar	g_scriptCache;
 extern idCVar	g_debugBounds;
 extern idCVar	g_debugAnim;
 extern idCVar	g_debugMove;
@@ -86,6 +89,13 @@ extern idCVar	g_showEnemies;
 extern idCVar	g_frametime;
 extern idCVar	g_timeentities;
 
+extern idCVar	g_thinkTiers;
+extern idCVar	g_thinkTierNear;
+extern idCVar	g_thinkTierFar;
+extern idCVar	g_thinkTierReducedFrames;
+extern idCVar	g_thinkTierFarFrames;
+extern idCVar	g_thinkTierStats;
+
 extern idCVar	ai_debugScript;
 extern idCVar	ai_debugMove;
 extern idCVar	ai_debugTrajectory;
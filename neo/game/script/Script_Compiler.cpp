@@ -28,6 +28,9 @@ If you have questions concerning this license or the applicable additional terms
 
 #include "sys/platform.h"
 #include "idlib/Timer.h"
+#include "idlib/hashing/MD4.h"
+#include "framework/Licensee.h"
+#include "framework/BuildVersion.h"
 
 #include "script/Script_Thread.h"
 #include "Game_local.h"
@@ -204,6 +207,26 @@ const opcode_t idCompiler::opcodes[] = {
 	{ NULL }
 };
 
+/*
+================
+idCompiler::Checksum
+
+Identifies the compiler that emits the code: the build it is part of and the
+opcode table.  Compiled programs from any other compiler can't be trusted.
+================
+*/
+int idCompiler::Checksum( void ) {
+	idStr		key;
+	const opcode_t	*op;
+
+	key = va( "%s.%d %s %s;", ENGINE_VERSION, BUILD_NUMBER, __DATE__, __TIME__ );
+	for( op = opcodes; op->name; op++ ) {
+		key += va( "%s %s %d %d %s %s %s;", op->name, op->opname, op->priority, op->rightAssociative,
+			op->type_a->TypeDef()->Name(), op->type_b->TypeDef()->Name(), op->type_c->TypeDef()->Name() );
+	}
+	return MD4_BlockChecksum( key.c_str(), key.Length() );
+}
+
 /*
 ================
 idCompiler::idCompiler()
@@ -2571,7 +2594,7 @@ idCompiler::CompileFile
 compiles the 0 terminated text, adding definitions to the program structure
 ============
 */
-void idCompiler::CompileFile( const char *text, const char *filename, bool toConsole ) {
+void idCompiler::CompileFile( const char *text, const char *filename, bool toConsole, idStrList *includes ) {
 	idTimer compile_time;
 	bool error;
 
@@ -2590,6 +2613,7 @@ void idCompiler::CompileFile( const char *text, const char *filename, bool toCon
 	memset( &immediate, 0, sizeof( immediate ) );
 
 	parser.SetFlags( LEXFL_ALLOWMULTICHARLITERALS );
+	parser.SetIncludeList( includes );
 	parser.LoadMemory( text, strlen( text ), filename );
 	parserPtr = &parser;
 
@@ -275,8 +275,10 @@ private:
 public :
 	static const opcode_t	opcodes[];
 
+	static int		Checksum( void );
+
 					idCompiler();
-	void			CompileFile( const char *text, const char *filename, bool console );
+	void			CompileFile( const char *text, const char *filename, bool console, idStrList *includes = NULL );
 };
 
 #endif /* !__SCRIPT_COMPILER_H__ */
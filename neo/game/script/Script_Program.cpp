@@ -27,6 +27,7 @@ If you have questions concerning this license or the applicable additional terms
 */
 
 #include "sys/platform.h"
+#include "idlib/Timer.h"
 #include "idlib/hashing/MD4.h"
 #include "framework/FileSystem.h"
 
@@ -1840,7 +1841,7 @@ bool idProgram::CompileText( const char *source, const char *text, bool console
 #if !defined(__EMSCRIPTEN__)
   try {
 #endif
-		compiler.CompileFile( text, filename, console );
+		compiler.CompileFile( text, filename, console, recordSources ? &sourceFiles : NULL );
 
 		// check to make sure all functions prototyped have code
 		for( i = 0; i < varDefs.Num(); i++ ) {
@@ -1959,9 +1960,634 @@ void idProgram::FreeData( void ) {
 	top_defs		= 0;
 	top_files		= 0;
 
+	sourceFiles.Clear();
+	recordSources = false;
+
 	filename = "";
 }
 
+/***********************************************************************
+
+  Compiled program cache
+
+  The program state after compiling the default script is written to
+  fs_savepath under scriptcache/.  Pointers are stored as indices: types
+  and defs as their position in the program lists or as one of the
+  built-in types and defs, def values as offsets in the global variables
+  or function numbers.  The header lists every source file that was read,
+  includes too, with its length and timestamp.  Files in paks have no
+  timestamp, so their contents are checksummed instead.  The compiler
+  checksum ties the cache to the build that wrote it.  The program and
+  tables checksums are stored as well and checked after reading, so
+  savegames see the same program as after a compile.
+
+***********************************************************************/
+
+#define SCRIPT_CACHE_ID				"SCRCACHE"
+#define SCRIPT_CACHE_VERSION		2
+#define SCRIPT_CACHE_DIR			"scriptcache"
+#define SCRIPT_CACHE_EXTENSION		".scache"
+
+#define SCRIPT_CACHE_NULL			-1
+#define SCRIPT_CACHE_BUILTIN		-2				// built-in n is stored as SCRIPT_CACHE_BUILTIN - n
+
+typedef enum {
+	SCV_INT,										// offsets and other plain values
+	SCV_VARIABLE,									// pointer into the global variables
+	SCV_FUNCTION									// pointer to a function
+} scriptCacheValue_t;
+
+static idTypeDef *scriptCacheTypes[] = {
+	&type_void, &type_scriptevent, &type_namespace, &type_string, &type_float, &type_vector, &type_entity, &type_field,
+	&type_function, &type_virtualfunction, &type_pointer, &type_object, &type_jumpoffset, &type_argsize, &type_boolean
+};
+
+static idVarDef *scriptCacheDefs[] = {
+	&def_void, &def_scriptevent, &def_namespace, &def_string, &def_float, &def_vector, &def_entity, &def_field,
+	&def_function, &def_virtualfunction, &def_pointer, &def_object, &def_jumpoffset, &def_argsize, &def_boolean
+};
+
+static const int NUM_SCRIPT_CACHE_BUILTINS = sizeof( scriptCacheTypes ) / sizeof( scriptCacheTypes[ 0 ] );
+
+/*
+================
+ScriptCacheFileName
+================
+*/
+static idStr ScriptCacheFileName( const char *defaultScript ) {
+	idStr name = SCRIPT_CACHE_DIR "/";
+
+	name += defaultScript;
+	name.SetFileExtension( SCRIPT_CACHE_EXTENSION );
+	return name;
+}
+
+/*
+================
+ScriptEventsChecksum
+
+The compiled code depends on the script events the game code defines.
+================
+*/
+static int ScriptEventsChecksum( void ) {
+	idStr events;
+
+	for( int i = 0; i < idEventDef::NumEventCommands(); i++ ) {
+		const idEventDef *ev = idEventDef::GetEventCommand( i );
+		events += va( "%s(%s)%d;", ev->GetName(), ev->GetArgFormat(), ev->GetReturnType() );
+	}
+	return MD4_BlockChecksum( events.c_str(), events.Length() );
+}
+
+/*
+================
+ScriptSourceKey
+================
+*/
+static bool ScriptSourceKey( const char *name, int &length, int &timestamp, int &checksum ) {
+	ID_TIME_T	time;
+	const void	*view;
+
+	length = fileSystem->ReadFile( name, NULL, &time );
+	if ( length < 0 ) {
+		return false;
+	}
+	timestamp = ( int )time;
+	checksum = 0;
+	if ( time == 0 ) {
+		if ( fileSystem->ReadFileView( name, &view ) != length ) {
+			return false;
+		}
+		checksum = MD4_BlockChecksum( view, length );
+		fileSystem->FreeFileView( view );
+	}
+	return true;
+}
+
+/*
+================
+ScriptCacheValueType
+
+What the value of a def holds, following idProgram::AllocDef.
+================
+*/
+static scriptCacheValue_t ScriptCacheValueType( const idVarDef *def ) {
+	if ( def->initialized == idVarDef::stackVariable ) {
+		return SCV_INT;
+	}
+	switch( def->Type() ) {
+	case ev_jumpoffset :
+	case ev_argsize :
+	case ev_virtualfunction :
+		return SCV_INT;
+	case ev_function :
+		return SCV_FUNCTION;
+	default :
+		break;
+	}
+	if ( def->scope && def->scope->TypeDef()->Inherits( &type_object ) ) {
+		// position in the object
+		return SCV_INT;
+	}
+	return SCV_VARIABLE;
+}
+
+/*
+================
+ScriptCacheTypeIndex
+================
+*/
+static int ScriptCacheTypeIndex( const idTypeDef *type, const idList<idTypeDef *> &types, const idHashIndex &typeHash ) {
+	int i;
+
+	if ( !type ) {
+		return SCRIPT_CACHE_NULL;
+	}
+	for( i = typeHash.First( typeHash.GenerateKey( ( int )( ( uintptr_t )type >> 4 ), 0 ) ); i >= 0; i = typeHash.Next( i ) ) {
+		if ( types[ i ] == type ) {
+			return i;
+		}
+	}
+	for( i = 0; i < NUM_SCRIPT_CACHE_BUILTINS; i++ ) {
+		if ( scriptCacheTypes[ i ] == type ) {
+			return SCRIPT_CACHE_BUILTIN - i;
+		}
+	}
+	// not a type the reader can resolve
+	return SCRIPT_CACHE_BUILTIN - NUM_SCRIPT_CACHE_BUILTINS;
+}
+
+/*
+================
+ScriptCacheDefIndex
+================
+*/
+static int ScriptCacheDefIndex( const idVarDef *def, const idList<idVarDef *> &varDefs ) {
+	if ( !def ) {
+		return SCRIPT_CACHE_NULL;
+	}
+	if ( def->num >= 0 && def->num < varDefs.Num() && varDefs[ def->num ] == def ) {
+		return def->num;
+	}
+	for( int i = 0; i < NUM_SCRIPT_CACHE_BUILTINS; i++ ) {
+		if ( scriptCacheDefs[ i ] == def ) {
+			return SCRIPT_CACHE_BUILTIN - i;
+		}
+	}
+	return SCRIPT_CACHE_BUILTIN - NUM_SCRIPT_CACHE_BUILTINS;
+}
+
+/*
+================
+ScriptCacheType
+================
+*/
+static idTypeDef *ScriptCacheType( int index, const idList<idTypeDef *> &types, bool &error ) {
+	if ( index == SCRIPT_CACHE_NULL ) {
+		return NULL;
+	}
+	if ( index >= 0 && index < types.Num() ) {
+		return types[ index ];
+	}
+	if ( index <= SCRIPT_CACHE_BUILTIN && SCRIPT_CACHE_BUILTIN - index < NUM_SCRIPT_CACHE_BUILTINS ) {
+		return scriptCacheTypes[ SCRIPT_CACHE_BUILTIN - index ];
+	}
+	error = true;
+	return NULL;
+}
+
+/*
+================
+ScriptCacheDef
+================
+*/
+static idVarDef *ScriptCacheDef( int index, const idList<idVarDef *> &varDefs, bool &error ) {
+	if ( index == SCRIPT_CACHE_NULL ) {
+		return NULL;
+	}
+	if ( index >= 0 && index < varDefs.Num() ) {
+		return varDefs[ index ];
+	}
+	if ( index <= SCRIPT_CACHE_BUILTIN && SCRIPT_CACHE_BUILTIN - index < NUM_SCRIPT_CACHE_BUILTINS ) {
+		return scriptCacheDefs[ SCRIPT_CACHE_BUILTIN - index ];
+	}
+	error = true;
+	return NULL;
+}
+
+/*
+================
+idProgram::TablesChecksum
+
+CalculateChecksum only covers the statements, this covers the types, defs,
+functions and global variables the statements refer to.
+================
+*/
+int idProgram::TablesChecksum( void ) const {
+	idStr	key;
+	int		i, j, value;
+
+	for( i = 0; i < types.Num(); i++ ) {
+		const idTypeDef *type = types[ i ];
+
+		key += va( "%d %s %d %s %d %d", type->type, type->name.c_str(), type->size,
+			type->auxType ? type->auxType->name.c_str() : "", type->def ? type->def->num : -1, type->functions.Num() );
+		for( j = 0; j < type->parmTypes.Num(); j++ ) {
+			key += va( " %s %s", type->parmTypes[ j ]->name.c_str(), type->parmNames[ j ].c_str() );
+		}
+		key += ";";
+	}
+
+	for( i = 0; i < varDefs.Num(); i++ ) {
+		const idVarDef *def = varDefs[ i ];
+
+		switch( ScriptCacheValueType( def ) ) {
+		case SCV_VARIABLE :
+			value = def->value.bytePtr ? def->value.bytePtr - variables : -1;
+			break;
+		case SCV_FUNCTION :
+			value = def->value.functionPtr ? def->value.functionPtr - &functions[ 0 ] : -1;
+			break;
+		default :
+			value = def->value.argSize;
+			break;
+		}
+		key += va( "%s %s %d %d %d %d;", def->Name(), def->TypeDef()->Name(), def->scope ? def->scope->num : -1,
+			def->numUsers, def->initialized, value );
+	}
+
+	for( i = 0; i < functions.Num(); i++ ) {
+		const function_t &func = functions[ i ];
+
+		key += va( "%s %s %d %d %d %d %d %d", func.Name(), func.eventdef ? func.eventdef->GetName() : "",
+			func.def ? func.def->num : -1, func.firstStatement, func.numStatements, func.parmTotal, func.locals, func.filenum );
+		for( j = 0; j < func.parmSize.Num(); j++ ) {
+			key += va( " %d", func.parmSize[ j ] );
+		}
+		key += ";";
+	}
+
+	key += va( "%d %u", numVariables, MD4_BlockChecksum( variables, numVariables ) );
+
+	return MD4_BlockChecksum( key.c_str(), key.Length() );
+}
+
+/*
+================
+idProgram::WriteCompiledProgram
+================
+*/
+void idProgram::WriteCompiledProgram( const char *defaultScript ) {
+	idHashIndex		typeHash;
+	idFile_Memory	*f;
+	int				i, j, length, timestamp, checksum, value;
+
+	if ( !g_scriptCache.GetBool() || g_disasm.GetBool() || !sourceFiles.Num() ) {
+		return;
+	}
+
+	typeHash.Clear( 1024, types.Num() );
+	for( i = 0; i < types.Num(); i++ ) {
+		typeHash.Add( typeHash.GenerateKey( ( int )( ( uintptr_t )types[ i ] >> 4 ), 0 ), i );
+	}
+
+	f = new idFile_Memory( SCRIPT_CACHE_DIR );
+
+	f->WriteString( SCRIPT_CACHE_ID );
+	f->WriteInt( SCRIPT_CACHE_VERSION );
+	f->WriteInt( sizeof( intptr_t ) );
+	f->WriteInt( idCompiler::Checksum() );
+	f->WriteInt( ScriptEventsChecksum() );
+
+	f->WriteInt( sourceFiles.Num() );
+	for( i = 0; i < sourceFiles.Num(); i++ ) {
+		if ( !ScriptSourceKey( sourceFiles[ i ], length, timestamp, checksum ) ) {
+			delete f;
+			return;
+		}
+		f->WriteString( sourceFiles[ i ] );
+		f->WriteInt( length );
+		f->WriteInt( timestamp );
+		f->WriteInt( checksum );
+	}
+	f->WriteInt( CalculateChecksum() );
+	f->WriteInt( TablesChecksum() );
+
+	f->WriteInt( fileList.Num() );
+	for( i = 0; i < fileList.Num(); i++ ) {
+		f->WriteString( fileList[ i ] );
+	}
+
+	// counts first, the references go in every direction
+	f->WriteInt( types.Num() );
+	f->WriteInt( varDefs.Num() );
+	f->WriteInt( functions.Num() );
+	f->WriteInt( statements.Num() );
+	f->WriteInt( numVariables );
+
+	for( i = 0; i < types.Num(); i++ ) {
+		const idTypeDef *type = types[ i ];
+
+		f->WriteInt( type->type );
+		f->WriteString( type->name );
+		f->WriteInt( type->size );
+		f->WriteInt( ScriptCacheTypeIndex( type->auxType, types, typeHash ) );
+		f->WriteInt( ScriptCacheDefIndex( type->def, varDefs ) );
+		f->WriteInt( type->parmTypes.Num() );
+		for( j = 0; j < type->parmTypes.Num(); j++ ) {
+			f->WriteInt( ScriptCacheTypeIndex( type->parmTypes[ j ], types, typeHash ) );
+			f->WriteString( type->parmNames[ j ] );
+		}
+		f->WriteInt( type->functions.Num() );
+		for( j = 0; j < type->functions.Num(); j++ ) {
+			f->WriteInt( type->functions[ j ] - &functions[ 0 ] );
+		}
+	}
+
+	for( i = 0; i < varDefs.Num(); i++ ) {
+		const idVarDef *def = varDefs[ i ];
+		scriptCacheValue_t valueType = ScriptCacheValueType( def );
+
+		switch( valueType ) {
+		case SCV_VARIABLE :
+			value = def->value.bytePtr ? def->value.bytePtr - variables : SCRIPT_CACHE_NULL;
+			if ( value != SCRIPT_CACHE_NULL && ( value < 0 || value > numVariables ) ) {
+				gameLocal.Warning( "script cache: '%s' is not a global variable, not writing the cache", def->GlobalName() );
+				delete f;
+				return;
+			}
+			break;
+		case SCV_FUNCTION :
+			value = def->value.functionPtr ? def->value.functionPtr - &functions[ 0 ] : SCRIPT_CACHE_NULL;
+			break;
+		default :
+			value = def->value.argSize;
+			break;
+		}
+
+		f->WriteInt( ScriptCacheTypeIndex( def->TypeDef(), types, typeHash ) );
+		f->WriteString( def->Name() );
+		f->WriteInt( ScriptCacheDefIndex( def->scope, varDefs ) );
+		f->WriteInt( def->numUsers );
+		f->WriteInt( def->initialized );
+		f->WriteInt( valueType );
+		f->WriteInt( value );
+	}
+
+	for( i = 0; i < functions.Num(); i++ ) {
+		const function_t &func = functions[ i ];
+
+		f->WriteString( func.Name() );
+		f->WriteString( func.eventdef ? func.eventdef->GetName() : "" );
+		f->WriteInt( ScriptCacheDefIndex( func.def, varDefs ) );
+		f->WriteInt( ScriptCacheTypeIndex( func.type, types, typeHash ) );
+		f->WriteInt( func.firstStatement );
+		f->WriteInt( func.numStatements );
+		f->WriteInt( func.parmTotal );
+		f->WriteInt( func.locals );
+		f->WriteInt( func.filenum );
+		f->WriteInt( func.parmSize.Num() );
+		for( j = 0; j < func.parmSize.Num(); j++ ) {
+			f->WriteInt( func.parmSize[ j ] );
+		}
+	}
+
+	for( i = 0; i < statements.Num(); i++ ) {
+		const statement_t &statement = statements[ i ];
+
+		f->WriteUnsignedShort( statement.op );
+		f->WriteInt( ScriptCacheDefIndex( statement.a, varDefs ) );
+		f->WriteInt( ScriptCacheDefIndex( statement.b, varDefs ) );
+		f->WriteInt( ScriptCacheDefIndex( statement.c, varDefs ) );
+		f->WriteUnsignedShort( statement.linenumber );
+		f->WriteUnsignedShort( statement.file );
+	}
+
+	f->Write( variables, numVariables );
+
+	f->WriteInt( ScriptCacheDefIndex( returnDef, varDefs ) );
+	f->WriteInt( ScriptCacheDefIndex( returnStringDef, varDefs ) );
+	f->WriteInt( ScriptCacheDefIndex( sysDef, varDefs ) );
+	f->WriteString( SCRIPT_CACHE_ID );
+
+	fileSystem->WriteFile( ScriptCacheFileName( defaultScript ), f->GetDataPtr(), f->Length() );
+	delete f;
+}
+
+/*
+================
+idProgram::ReadCompiledProgram
+
+Returns false if there is no cache or any of its sources changed.
+================
+*/
+bool idProgram::ReadCompiledProgram( const char *defaultScript ) {
+	idTimer		readTime;
+	idStr		id, name, eventName;
+	bool		error;
+	int			i, j, num, version, value, length, timestamp, checksum, programChecksum, tablesChecksum;
+	int			numTypes, numDefs, numFunctions, numStatements;
+
+	if ( !g_scriptCache.GetBool() || g_disasm.GetBool() ) {
+		return false;
+	}
+
+	idFile *f = fileSystem->OpenFileRead( ScriptCacheFileName( defaultScript ) );
+	if ( !f ) {
+		return false;
+	}
+
+	readTime.Start();
+
+	f->ReadString( id );
+	f->ReadInt( version );
+	f->ReadInt( value );
+	f->ReadInt( num );
+	f->ReadInt( checksum );
+	if ( id != SCRIPT_CACHE_ID || version != SCRIPT_CACHE_VERSION || value != sizeof( intptr_t ) || num != idCompiler::Checksum() || checksum != ScriptEventsChecksum() ) {
+		fileSystem->CloseFile( f );
+		return false;
+	}
+
+	f->ReadInt( num );
+	for( i = 0; i < num; i++ ) {
+		int cachedLength, cachedTimestamp, cachedChecksum;
+
+		f->ReadString( name );
+		f->ReadInt( cachedLength );
+		f->ReadInt( cachedTimestamp );
+		f->ReadInt( cachedChecksum );
+		if ( !ScriptSourceKey( name, length, timestamp, checksum ) || length != cachedLength || timestamp != cachedTimestamp || checksum != cachedChecksum ) {
+			gameLocal.Printf( "script cache: %s changed\n", name.c_str() );
+			fileSystem->CloseFile( f );
+			return false;
+		}
+	}
+	f->ReadInt( programChecksum );
+	f->ReadInt( tablesChecksum );
+
+	FreeData();
+
+	f->ReadInt( num );
+	for( i = 0; i < num; i++ ) {
+		f->ReadString( name );
+		fileList.Append( name );
+	}
+
+	f->ReadInt( numTypes );
+	f->ReadInt( numDefs );
+	f->ReadInt( numFunctions );
+	f->ReadInt( numStatements );
+	f->ReadInt( numVariables );
+
+	error = ( numTypes < 0 || numDefs < 0 || numFunctions < 0 || numFunctions > functions.Max()
+		|| numStatements <= 0 || numStatements > statements.Max() || numVariables < 0 || numVariables > MAX_GLOBALS );
+	if ( error ) {
+		numVariables = 0;
+		FreeData();
+		fileSystem->CloseFile( f );
+		return false;
+	}
+
+	for( i = 0; i < numTypes; i++ ) {
+		AllocType( ev_void, NULL, "", 0, NULL );
+	}
+	for( i = 0; i < numDefs; i++ ) {
+		idVarDef *def = new idVarDef();
+		def->num = varDefs.Append( def );
+	}
+	functions.SetNum( numFunctions );
+	statements.SetNum( numStatements );
+
+	for( i = 0; i < numTypes && !error; i++ ) {
+		idTypeDef *type = types[ i ];
+
+		f->ReadInt( value );
+		type->type = ( etype_t )value;
+		f->ReadString( type->name );
+		f->ReadInt( type->size );
+		f->ReadInt( value );
+		type->auxType = ScriptCacheType( value, types, error );
+		f->ReadInt( value );
+		type->def = ScriptCacheDef( value, varDefs, error );
+		f->ReadInt( num );
+		for( j = 0; j < num && !error; j++ ) {
+			f->ReadInt( value );
+			type->parmTypes.Append( ScriptCacheType( value, types, error ) );
+			f->ReadString( name );
+			type->parmNames.Append( name );
+		}
+		f->ReadInt( num );
+		for( j = 0; j < num && !error; j++ ) {
+			f->ReadInt( value );
+			error = ( value < 0 || value >= numFunctions );
+			type->functions.Append( error ? NULL : &functions[ value ] );
+		}
+	}
+
+	for( i = 0; i < numDefs && !error; i++ ) {
+		idVarDef *def = varDefs[ i ];
+		int valueType;
+
+		f->ReadInt( value );
+		def->SetTypeDef( ScriptCacheType( value, types, error ) );
+		f->ReadString( name );
+		AddDefToNameList( def, name );
+		f->ReadInt( value );
+		def->scope = ScriptCacheDef( value, varDefs, error );
+		f->ReadInt( def->numUsers );
+		f->ReadInt( value );
+		def->initialized = ( idVarDef::initialized_t )value;
+		f->ReadInt( valueType );
+		f->ReadInt( value );
+		switch( valueType ) {
+		case SCV_VARIABLE :
+			error |= ( value != SCRIPT_CACHE_NULL && ( value < 0 || value > numVariables ) );
+			def->value.bytePtr = ( value == SCRIPT_CACHE_NULL || error ) ? NULL : &variables[ value ];
+			break;
+		case SCV_FUNCTION :
+			error |= ( value != SCRIPT_CACHE_NULL && ( value < 0 || value >= numFunctions ) );
+			def->value.functionPtr = ( value == SCRIPT_CACHE_NULL || error ) ? NULL : &functions[ value ];
+			break;
+		case SCV_INT :
+			def->value.argSize = value;
+			break;
+		default :
+			error = true;
+			break;
+		}
+	}
+
+	for( i = 0; i < numFunctions && !error; i++ ) {
+		function_t &func = functions[ i ];
+
+		func.Clear();
+		f->ReadString( name );
+		func.SetName( name );
+		f->ReadString( eventName );
+		if ( eventName.Length() ) {
+			func.eventdef = idEventDef::FindEvent( eventName );
+			error |= ( func.eventdef == NULL );
+		}
+		f->ReadInt( value );
+		func.def = ScriptCacheDef( value, varDefs, error );
+		f->ReadInt( value );
+		func.type = ScriptCacheType( value, types, error );
+		f->ReadInt( func.firstStatement );
+		f->ReadInt( func.numStatements );
+		f->ReadInt( func.parmTotal );
+		f->ReadInt( func.locals );
+		f->ReadInt( func.filenum );
+		func.parmSize.SetGranularity( 1 );
+		f->ReadInt( num );
+		for( j = 0; j < num; j++ ) {
+			f->ReadInt( value );
+			func.parmSize.Append( value );
+		}
+		error |= ( func.firstStatement < 0 || func.firstStatement + func.numStatements > numStatements );
+	}
+
+	for( i = 0; i < numStatements && !error; i++ ) {
+		statement_t &statement = statements[ i ];
+
+		f->ReadUnsignedShort( statement.op );
+		f->ReadInt( value );
+		statement.a = ScriptCacheDef( value, varDefs, error );
+		f->ReadInt( value );
+		statement.b = ScriptCacheDef( value, varDefs, error );
+		f->ReadInt( value );
+		statement.c = ScriptCacheDef( value, varDefs, error );
+		f->ReadUnsignedShort( statement.linenumber );
+		f->ReadUnsignedShort( statement.file );
+		error |= ( statement.op >= NUM_OPCODES || statement.file >= fileList.Num() );
+	}
+
+	if ( !error ) {
+		error = ( f->Read( variables, numVariables ) != numVariables );
+		f->ReadInt( value );
+		returnDef = ScriptCacheDef( value, varDefs, error );
+		f->ReadInt( value );
+		returnStringDef = ScriptCacheDef( value, varDefs, error );
+		f->ReadInt( value );
+		sysDef = ScriptCacheDef( value, varDefs, error );
+		f->ReadString( id );
+		error |= ( id != SCRIPT_CACHE_ID || !returnDef || !returnStringDef || !sysDef );
+	}
+
+	fileSystem->CloseFile( f );
+
+	if ( error || CalculateChecksum() != programChecksum || TablesChecksum() != tablesChecksum ) {
+		gameLocal.Warning( "script cache: %s is damaged, recompiling", ScriptCacheFileName( defaultScript ).c_str() );
+		FreeData();
+		return false;
+	}
+
+	readTime.Stop();
+	gameLocal.Printf( "Loaded compiled scripts from %s in %u ms\n", ScriptCacheFileName( defaultScript ).c_str(), readTime.Milliseconds() );
+
+	return true;
+}
+
 /*
 ================
 idProgram::Startup
@@ -1973,15 +2599,28 @@ void idProgram::Startup( const char *defaultScript ) {
 	// make sure all data is freed up
 	idThread::Restart();
 
+	// a warm start reads the compiled program back instead of compiling it
+	if ( defaultScript && *defaultScript && ReadCompiledProgram( defaultScript ) ) {
+		FinishCompilation();
+		return;
+	}
+
 	// get ready for loading scripts
 	BeginCompilation();
 
 	// load the default script
 	if ( defaultScript && *defaultScript ) {
+		sourceFiles.Append( defaultScript );
+		recordSources = true;
 		CompileFile( defaultScript );
+		recordSources = false;
 	}
 
 	FinishCompilation();
+
+	if ( defaultScript && *defaultScript ) {
+		WriteCompiledProgram( defaultScript );
+	}
 }
 
 /*
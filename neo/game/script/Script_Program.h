@@ -94,6 +94,8 @@ Contains type information for variables and functions.
 ***********************************************************************/
 
 class idTypeDef {
+	friend class idProgram;
+
 private:
 	etype_t						type;
 	idStr						name;
@@ -460,7 +462,13 @@ private:
 	int											top_defs;
 	int											top_files;
 
+	idStrList									sourceFiles;		// every file the startup scripts were compiled from
+	bool										recordSources;
+
 	void										CompileStats( void );
+	bool										ReadCompiledProgram( const char *defaultScript );
+	void										WriteCompiledProgram( const char *defaultScript );
+	int											TablesChecksum( void ) const;
 	byte										*ReserveMem(int size);
 	idVarDef									*AllocVarDef(idTypeDef *type, const char *name, idVarDef *scope);
 
@@ -35,6 +35,7 @@ If you have questions concerning this license or the applicable additional terms
 
 idStrPool		idDict::globalKeys;
 idStrPool		idDict::globalValues;
+int				idDict::keyGeneration = 1;
 
 /*
 ================
@@ -185,6 +186,10 @@ void idDict::SetDefaults( const idDict *dict ) {
 	const idKeyValue *kv, *def;
 	idKeyValue newkv;
 
+	if ( SetDefaultsShared( dict ) ) {
+		return;
+	}
+
 	n = dict->args.Num();
 	for( i = 0; i < n; i++ ) {
 		def = &dict->args[i];
@@ -197,6 +202,74 @@ void idDict::SetDefaults( const idDict *dict ) {
 	}
 }
 
+/*
+================
+idDict::SetDefaultsShared
+
+  Bulk version of SetDefaults used for entityDef inheritance and spawning.
+  When both dicts use the same key pool and hash size, a key lands in the same
+  hash bucket in both, so the buckets of the defaults can be walked directly and
+  keys compared by pool pointer without hashing any strings.  The inherited
+  keys and values are shared with the defaults through the pool reference
+  counts, a later Set only replaces the pointer in this dict.
+================
+*/
+bool idDict::SetDefaultsShared( const idDict *dict ) {
+	int i, j, b, n, hashSize;
+
+	n = dict->args.Num();
+	if ( n == 0 || this == dict ) {
+		return n == 0;
+	}
+
+	hashSize = argHash.GetHashSize();
+	if ( dict->argHash.GetHashSize() != hashSize ) {
+		return false;
+	}
+	// a dict filled from both sides of a DLL boundary can mix pools
+	for ( j = 0; j < n; j++ ) {
+		if ( dict->args[j].key->GetPool() != &globalKeys ) {
+			return false;
+		}
+	}
+	for ( i = 0; i < args.Num(); i++ ) {
+		if ( args[i].key->GetPool() != &globalKeys ) {
+			return false;
+		}
+	}
+
+	// bucket of each default key, or -1 if this dict already has it
+	int *buckets = (int *) _alloca16( n * sizeof( int ) );
+	for ( i = 0; i < n; i++ ) {
+		buckets[i] = -1;
+	}
+
+	for ( b = 0; b < hashSize; b++ ) {
+		for ( j = dict->argHash.First( b ); j != -1; j = dict->argHash.Next( j ) ) {
+			buckets[j] = b;
+			for ( i = argHash.First( b ); i != -1; i = argHash.Next( i ) ) {
+				if ( args[i].key == dict->args[j].key ) {
+					buckets[j] = -1;
+					break;
+				}
+			}
+		}
+	}
+
+	// append in the order of the defaults so prefix iteration doesn't change
+	for ( j = 0; j < n; j++ ) {
+		if ( buckets[j] == -1 ) {
+			continue;
+		}
+		idKeyValue newkv;
+		newkv.key = globalKeys.CopyString( dict->args[j].key );
+		newkv.value = globalValues.CopyString( dict->args[j].value );
+		argHash.Add( buckets[j], args.Append( newkv ) );
+	}
+
+	return true;
+}
+
 /*
 ================
 idDict::Clear
@@ -377,6 +450,25 @@ bool idDict::GetVector( const char *key, const char *defaultString, idVec3 &out
 	return found;
 }
 
+/*
+================
+idDict::GetVector
+================
+*/
+bool idDict::GetVector( const idDictKey &key, const char *defaultString, idVec3 &out ) const {
+	bool		found;
+	const char	*s;
+
+	if ( !defaultString ) {
+		defaultString = "0 0 0";
+	}
+
+	found = GetString( key, defaultString, &s );
+	out.Zero();
+	sscanf( s, "%f %f %f", &out.x, &out.y, &out.z );
+	return found;
+}
+
 /*
 ================
 idDict::GetVec2
@@ -470,6 +562,49 @@ const idKeyValue *idDict::FindKey( const char *key ) const {
 	return NULL;
 }
 
+/*
+================
+idDict::InternKey
+
+  returns the pool string of a key handle, interning it the first time
+================
+*/
+const idPoolStr *idDict::InternKey( const idDictKey &key ) {
+	if ( key.generation != keyGeneration ) {
+		// the reference is kept until the pool is cleared
+		key.poolStr = globalKeys.AllocString( key.name );
+		key.generation = keyGeneration;
+	}
+	return key.poolStr;
+}
+
+/*
+================
+idDict::FindKey
+
+  Keys from this module's pool are unique case-insensitive, so they only match
+  by pointer.  Keys allocated from another module's pool fall back to a string
+  compare.
+================
+*/
+const idKeyValue *idDict::FindKey( const idDictKey &key ) const {
+	int i;
+
+	assert( idStr::IHash( key.name ) == key.hash );
+
+	const idPoolStr *poolStr = InternKey( key );
+	for ( i = argHash.First( key.hash ); i != -1; i = argHash.Next( i ) ) {
+		if ( args[i].key == poolStr ) {
+			return &args[i];
+		}
+		if ( args[i].key->GetPool() != &globalKeys && args[i].GetKey().Icmp( key.name ) == 0 ) {
+			return &args[i];
+		}
+	}
+
+	return NULL;
+}
+
 /*
 ================
 idDict::FindKeyIndex
@@ -631,6 +766,7 @@ idDict::Init
 void idDict::Init( void ) {
 	globalKeys.SetCaseSensitive( false );
 	globalValues.SetCaseSensitive( true );
+	keyGeneration++;
 }
 
 /*
@@ -641,6 +777,7 @@ idDict::Shutdown
 void idDict::Shutdown( void ) {
 	globalKeys.Clear();
 	globalValues.Clear();
+	keyGeneration++;
 }
 
 /*
@@ -48,9 +48,40 @@ Keys are compared case-insensitive.
 
 Does not allocate memory until the first key/value pair is added.
 
+Keys are pooled case-insensitive, so within one module two keys match if and
+only if they are the same pool string.  An idDictKey is a key name with its
+hash computed at compile time, which is interned on first use.  Lookups
+through a key handle skip hashing and compare pool pointers instead of
+strings:
+
+	static const idDictKey KEY_ORIGIN( "origin" );
+	idVec3 origin = spawnArgs.GetVector( KEY_ORIGIN );
+
+Key handles must have static storage duration.
+
 ===============================================================================
 */
 
+class idDictKey {
+	friend class idDict;
+
+public:
+	explicit constexpr	idDictKey( const char *name ) : name( name ), hash( IHash( name, 0 ) ), poolStr( NULL ), generation( 0 ) {}
+
+	const char *		GetName( void ) const { return name; }
+	int					GetHash( void ) const { return hash; }
+
+private:
+	const char *		name;
+	int					hash;			// same as idStr::IHash( name )
+	mutable const idPoolStr *poolStr;	// interned key, valid while generation matches idDict::keyGeneration
+	mutable int			generation;
+
+						// compile time version of idStr::IHash
+	static constexpr char	ToLower( char c ) { return ( c <= 'Z' && c >= 'A' ) ? ( c + ( 'a' - 'A' ) ) : c; }
+	static constexpr int	IHash( const char *string, int i ) { return *string ? ToLower( *string ) * ( i + 119 ) + IHash( string + 1, i + 1 ) : 0; }
+};
+
 class idKeyValue {
 	friend class idDict;
 
@@ -128,11 +159,22 @@ public:
 	bool				GetAngles( const char *key, const char *defaultString, idAngles &out ) const;
 	bool				GetMatrix( const char *key, const char *defaultString, idMat3 &out ) const;
 
+						// lookups with interned key handles
+	const char *		GetString( const idDictKey &key, const char *defaultString = "" ) const;
+	float				GetFloat( const idDictKey &key, const char *defaultString = "0" ) const;
+	int					GetInt( const idDictKey &key, const char *defaultString = "0" ) const;
+	bool				GetBool( const idDictKey &key, const char *defaultString = "0" ) const;
+	idVec3				GetVector( const idDictKey &key, const char *defaultString = NULL ) const;
+	bool				GetString( const idDictKey &key, const char *defaultString, const char **out ) const;
+	bool				GetVector( const idDictKey &key, const char *defaultString, idVec3 &out ) const;
+
 	int					GetNumKeyVals( void ) const;
 	const idKeyValue *	GetKeyVal( int index ) const;
 						// returns the key/value pair with the given key
 						// returns NULL if the key/value pair does not exist
 	const idKeyValue *	FindKey( const char *key ) const;
+						// same as above with an interned key handle
+	const idKeyValue *	FindKey( const idDictKey &key ) const;
 						// returns the index to the key/value pair with the given key
 						// returns -1 if the key/value pair does not exist
 	int					FindKeyIndex( const char *key ) const;
@@ -163,6 +205,10 @@ private:
 
 	static idStrPool	globalKeys;
 	static idStrPool	globalValues;
+	static int			keyGeneration;	// changes whenever globalKeys is cleared
+
+	static const idPoolStr *InternKey( const idDictKey &key );
+	bool				SetDefaultsShared( const idDict *dict );
 };
 
 
@@ -251,6 +297,42 @@ ID_INLINE const char *idDict::GetString( const char *key, const char *defaultStr
 	return defaultString;
 }
 
+ID_INLINE bool idDict::GetString( const idDictKey &key, const char *defaultString, const char **out ) const {
+	const idKeyValue *kv = FindKey( key );
+	if ( kv ) {
+		*out = kv->GetValue();
+		return true;
+	}
+	*out = defaultString;
+	return false;
+}
+
+ID_INLINE const char *idDict::GetString( const idDictKey &key, const char *defaultString ) const {
+	const idKeyValue *kv = FindKey( key );
+	if ( kv ) {
+		return kv->GetValue();
+	}
+	return defaultString;
+}
+
+ID_INLINE float idDict::GetFloat( const idDictKey &key, const char *defaultString ) const {
+	return atof( GetString( key, defaultString ) );
+}
+
+ID_INLINE int idDict::GetInt( const idDictKey &key, const char *defaultString ) const {
+	return atoi( GetString( key, defaultString ) );
+}
+
+ID_INLINE bool idDict::GetBool( const idDictKey &key, const char *defaultString ) const {
+	return ( atoi( GetString( key, defaultString ) ) != 0 );
+}
+
+ID_INLINE idVec3 idDict::GetVector( const idDictKey &key, const char *defaultString ) const {
+	idVec3 out;
+	GetVector( key, defaultString, out );
+	return out;
+}
+
 ID_INLINE float idDict::GetFloat( const char *key, const char *defaultString ) const {
 	return atof( GetString( key, defaultString ) );
 }
@@ -404,6 +404,9 @@ void idParser::PushScript( idLexer *script ) {
 			return;
 		}
 	}
+	if ( idParser::includeList ) {
+		idParser::includeList->AddUnique( script->GetFileName() );
+	}
 	//push the script on the script stack
 	script->next = idParser::scriptstack;
 	idParser::scriptstack = script;
@@ -3184,6 +3187,7 @@ idParser::idParser() {
 	this->defines = NULL;
 	this->tokens = NULL;
 	this->marker_p = NULL;
+	this->includeList = NULL;
 }
 
 /*
@@ -3202,6 +3206,7 @@ idParser::idParser( int flags ) {
 	this->defines = NULL;
 	this->tokens = NULL;
 	this->marker_p = NULL;
+	this->includeList = NULL;
 }
 
 /*
@@ -3220,6 +3225,7 @@ idParser::idParser( const char *filename, int flags, bool OSPath ) {
 	this->defines = NULL;
 	this->tokens = NULL;
 	this->marker_p = NULL;
+	this->includeList = NULL;
 	LoadFile( filename, OSPath );
 }
 
@@ -3239,6 +3245,7 @@ idParser::idParser( const char *ptr, int length, const char *name, int flags ) {
 	this->defines = NULL;
 	this->tokens = NULL;
 	this->marker_p = NULL;
+	this->includeList = NULL;
 	LoadMemory( ptr, length, name );
 }
 
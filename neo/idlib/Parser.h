@@ -30,6 +30,7 @@ If you have questions concerning this license or the applicable additional terms
 #define __PARSER_H__
 
 #include "idlib/Token.h"
+#include "idlib/containers/StrList.h"
 #include "idlib/Lexer.h"
 
 /*
@@ -180,6 +181,8 @@ public:
 	static void		RemoveAllGlobalDefines( void );
 					// set the base folder to load files from
 	static void		SetBaseFolder( const char *path );
+					// adds the name of every file included from now on to the list
+	void			SetIncludeList( idStrList *list ) { includeList = list; }
 
 private:
 	int				loaded;						// set when a source file is loaded from file or memory
@@ -195,6 +198,7 @@ private:
 	indent_t *		indentstack;				// stack with indents
 	int				skip;						// > 0 if skipping conditional code
 	const char*		marker_p;
+	idStrList *		includeList;				// optional list of included files
 
 	static define_t *globaldefines;				// list with global defines added to every source loaded
 
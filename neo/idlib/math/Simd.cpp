@@ -3931,6 +3931,327 @@ void TestNegate( void ) {
 	PrintClocks( va( "   simd->Negate16( float[] ) %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
 }
 
+/*
+============
+TestMipMap
+============
+*/
+#define MIPMAP_SIZE		64
+
+void TestMipMap( void ) {
+	int i;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	ALIGN16( byte src[MIPMAP_SIZE*MIPMAP_SIZE*4] );
+	ALIGN16( byte dst1[MIPMAP_SIZE*MIPMAP_SIZE] );
+	ALIGN16( byte dst2[MIPMAP_SIZE*MIPMAP_SIZE] );
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < MIPMAP_SIZE*MIPMAP_SIZE*4; i++ ) {
+		src[i] = srnd.RandomInt( 256 );
+	}
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->MipMapRGBA( dst1, src, MIPMAP_SIZE, MIPMAP_SIZE );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->MipMapRGBA()", MIPMAP_SIZE*MIPMAP_SIZE, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->MipMapRGBA( dst2, src, MIPMAP_SIZE, MIPMAP_SIZE );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < MIPMAP_SIZE*MIPMAP_SIZE; i++ ) {
+		if ( dst1[i] != dst2[i] ) {
+			break;
+		}
+	}
+	result = ( i >= MIPMAP_SIZE*MIPMAP_SIZE ) ? "ok" :  S_COLOR_RED "X";
+	PrintClocks( va( "   simd->MipMapRGBA() %s", result ), MIPMAP_SIZE*MIPMAP_SIZE, bestClocksSIMD, bestClocksGeneric );
+}
+
+/*
+============
+TestHeightmapToNormalMap
+============
+*/
+void TestHeightmapToNormalMap( void ) {
+	int i;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	ALIGN16( byte heights[MIPMAP_SIZE*MIPMAP_SIZE] );
+	ALIGN16( byte dst1[MIPMAP_SIZE*MIPMAP_SIZE*4] );
+	ALIGN16( byte dst2[MIPMAP_SIZE*MIPMAP_SIZE*4] );
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < MIPMAP_SIZE*MIPMAP_SIZE; i++ ) {
+		heights[i] = srnd.RandomInt( 256 );
+	}
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->HeightmapToNormalMap( dst1, heights, MIPMAP_SIZE, MIPMAP_SIZE, 4.0f / 256.0f );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->HeightmapToNormalMap()", MIPMAP_SIZE*MIPMAP_SIZE, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->HeightmapToNormalMap( dst2, heights, MIPMAP_SIZE, MIPMAP_SIZE, 4.0f / 256.0f );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < MIPMAP_SIZE*MIPMAP_SIZE*4; i++ ) {
+		if ( dst1[i] != dst2[i] ) {
+			break;
+		}
+	}
+	result = ( i >= MIPMAP_SIZE*MIPMAP_SIZE*4 ) ? "ok" :  S_COLOR_RED "X";
+	PrintClocks( va( "   simd->HeightmapToNormalMap() %s", result ), MIPMAP_SIZE*MIPMAP_SIZE, bestClocksSIMD, bestClocksGeneric );
+}
+
+/*
+============
+TestSmoothNormalMap
+============
+*/
+void TestSmoothNormalMap( void ) {
+	int i;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	ALIGN16( byte src[MIPMAP_SIZE*MIPMAP_SIZE*4] );
+	ALIGN16( byte dst1[MIPMAP_SIZE*MIPMAP_SIZE*4] );
+	ALIGN16( byte dst2[MIPMAP_SIZE*MIPMAP_SIZE*4] );
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < MIPMAP_SIZE*MIPMAP_SIZE*4; i++ ) {
+		src[i] = srnd.RandomInt( 256 );
+	}
+	// include some of the 0,0,0 and 128,128,128 normals that are ignored
+	for ( i = 0; i < MIPMAP_SIZE*MIPMAP_SIZE; i += 7 ) {
+		memset( src + i * 4, ( i & 1 ) ? 128 : 0, 3 );
+	}
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->SmoothNormalMap( dst1, src, MIPMAP_SIZE, MIPMAP_SIZE );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->SmoothNormalMap()", MIPMAP_SIZE*MIPMAP_SIZE, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->SmoothNormalMap( dst2, src, MIPMAP_SIZE, MIPMAP_SIZE );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	// the normalize is allowed to round differently
+	for ( i = 0; i < MIPMAP_SIZE*MIPMAP_SIZE*4; i++ ) {
+		if ( idMath::Abs( dst1[i] - dst2[i] ) > 1 ) {
+			break;
+		}
+	}
+	result = ( i >= MIPMAP_SIZE*MIPMAP_SIZE*4 ) ? "ok" :  S_COLOR_RED "X";
+	PrintClocks( va( "   simd->SmoothNormalMap() %s", result ), MIPMAP_SIZE*MIPMAP_SIZE, bestClocksSIMD, bestClocksGeneric );
+}
+
+/*
+============
+TestAddNormalMaps
+============
+*/
+void TestAddNormalMaps( void ) {
+	int i;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	const int count = MIPMAP_SIZE*MIPMAP_SIZE - 1;		// not a multiple of four so the scalar tail is tested too
+	ALIGN16( byte src[MIPMAP_SIZE*MIPMAP_SIZE*4] );
+	ALIGN16( byte add[MIPMAP_SIZE*MIPMAP_SIZE*4] );
+	ALIGN16( byte dst1[MIPMAP_SIZE*MIPMAP_SIZE*4] );
+	ALIGN16( byte dst2[MIPMAP_SIZE*MIPMAP_SIZE*4] );
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < MIPMAP_SIZE*MIPMAP_SIZE*4; i++ ) {
+		src[i] = srnd.RandomInt( 256 );
+		add[i] = srnd.RandomInt( 256 );
+	}
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		memcpy( dst1, src, sizeof( dst1 ) );
+		StartRecordTime( start );
+		p_generic->AddNormalMaps( dst1, add, count );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->AddNormalMaps()", count, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		memcpy( dst2, src, sizeof( dst2 ) );
+		StartRecordTime( start );
+		p_simd->AddNormalMaps( dst2, add, count );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	// the normalize is allowed to round differently
+	for ( i = 0; i < MIPMAP_SIZE*MIPMAP_SIZE*4; i++ ) {
+		if ( idMath::Abs( dst1[i] - dst2[i] ) > 1 ) {
+			break;
+		}
+	}
+	result = ( i >= MIPMAP_SIZE*MIPMAP_SIZE*4 ) ? "ok" :  S_COLOR_RED "X";
+	PrintClocks( va( "   simd->AddNormalMaps() %s", result ), count, bestClocksSIMD, bestClocksGeneric );
+}
+
+/*
+============
+TestResampleRowRGBA
+============
+*/
+void TestResampleRowRGBA( void ) {
+	int i;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	const int count = MIPMAP_SIZE - 3;		// not a multiple of four so the scalar tail is tested too
+	ALIGN16( byte src[MIPMAP_SIZE*2*4] );
+	ALIGN16( byte dst1[MIPMAP_SIZE*4] );
+	ALIGN16( byte dst2[MIPMAP_SIZE*4] );
+	unsigned int offsets0[MIPMAP_SIZE];
+	unsigned int offsets1[MIPMAP_SIZE];
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < MIPMAP_SIZE*2*4; i++ ) {
+		src[i] = srnd.RandomInt( 256 );
+	}
+	for ( i = 0; i < MIPMAP_SIZE; i++ ) {
+		offsets0[i] = srnd.RandomInt( MIPMAP_SIZE ) * 4;
+		offsets1[i] = srnd.RandomInt( MIPMAP_SIZE ) * 4;
+	}
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->ResampleRowRGBA( dst1, src, src + MIPMAP_SIZE * 4, offsets0, offsets1, count );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->ResampleRowRGBA()", count, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->ResampleRowRGBA( dst2, src, src + MIPMAP_SIZE * 4, offsets0, offsets1, count );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < count * 4; i++ ) {
+		if ( dst1[i] != dst2[i] ) {
+			break;
+		}
+	}
+	result = ( i >= count * 4 ) ? "ok" :  S_COLOR_RED "X";
+	PrintClocks( va( "   simd->ResampleRowRGBA() %s", result ), count, bestClocksSIMD, bestClocksGeneric );
+}
+
+/*
+============
+TestCreateParticleQuads
+============
+*/
+void TestCreateParticleQuads( void ) {
+	int i, j;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	const int numQuads = COUNT / 4 - 1;		// not a multiple of four so the scalar tail is tested too
+	ALIGN16( float data[9][COUNT/4] );
+	ALIGN16( dword colors[COUNT/4] );
+	ALIGN16( idDrawVert verts1[COUNT] );
+	ALIGN16( idDrawVert verts2[COUNT] );
+	particleQuads_t quads;
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < COUNT/4; i++ ) {
+		float angle = srnd.RandomFloat() * idMath::TWO_PI;
+		data[0][i] = srnd.CRandomFloat() * 100.0f;
+		data[1][i] = srnd.CRandomFloat() * 100.0f;
+		data[2][i] = srnd.CRandomFloat() * 100.0f;
+		data[3][i] = idMath::Cos( angle );
+		data[4][i] = idMath::Sin( angle );
+		data[5][i] = srnd.RandomFloat() * 10.0f;
+		data[6][i] = srnd.RandomFloat() * 10.0f;
+		data[7][i] = srnd.RandomInt( 4 ) * 0.25f;
+		data[8][i] = 0.25f;
+		colors[i] = srnd.RandomInt();
+	}
+	quads.originX = data[0];
+	quads.originY = data[1];
+	quads.originZ = data[2];
+	quads.cosAngle = data[3];
+	quads.sinAngle = data[4];
+	quads.width = data[5];
+	quads.height = data[6];
+	quads.s = data[7];
+	quads.sWidth = data[8];
+	quads.color = colors;
+
+	idVec3 left( 0.0f, 1.0f, 0.0f );
+	idVec3 up( 0.0f, 0.0f, 1.0f );
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->CreateParticleQuads( verts1, left, up, quads, numQuads );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->CreateParticleQuads()", numQuads, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->CreateParticleQuads( verts2, left, up, quads, numQuads );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < numQuads * 4; i++ ) {
+		for ( j = 0; j < 5; j++ ) {
+			if ( verts1[i][j] != verts2[i][j] ) {
+				break;
+			}
+		}
+		if ( j < 5 || verts1[i].GetColor() != verts2[i].GetColor() || verts2[i].normal != vec3_origin ) {
+			break;
+		}
+	}
+	result = ( i >= numQuads * 4 ) ? "ok" :  S_COLOR_RED "X";
+	PrintClocks( va( "   simd->CreateParticleQuads() %s", result ), numQuads, bestClocksSIMD, bestClocksGeneric );
+}
+
 #ifdef __EMSCRIPTEN__
 // SIMD code not supported on emscripten for now
 #else
@@ -4035,6 +4356,15 @@ void idSIMD::Test_f( const idCmdArgs &args ) {
 	TestSoundUpSampling();
 	TestSoundMixing();
 
+	idLib::common->Printf("====================================\n" );
+
+	TestMipMap();
+	TestHeightmapToNormalMap();
+	TestSmoothNormalMap();
+	TestAddNormalMaps();
+	TestResampleRowRGBA();
+	TestCreateParticleQuads();
+
 	idLib::common->SetRefreshOnPrint( false );
 
 	if ( p_simd != processor ) {
@@ -85,6 +85,20 @@ struct dominantTri_s;
 
 const int MIXBUFFER_SAMPLES = 4096;
 
+// particle quads in structure of arrays form, one entry per quad
+typedef struct particleQuads_s {
+	float *							originX;
+	float *							originY;
+	float *							originZ;
+	float *							cosAngle;		// rotation of the quad around its origin
+	float *							sinAngle;
+	float *							width;			// half extents along the left and up axis
+	float *							height;
+	float *							s;				// texture s of the left edge
+	float *							sWidth;			// texture s of the right edge is s + sWidth
+	dword *							color;
+} particleQuads_t;
+
 typedef enum {
 	SPEAKER_LEFT = 0,
 	SPEAKER_RIGHT,
@@ -202,6 +216,16 @@ public:
 	virtual void VPCALL MixSoundSixSpeakerMono( float *mixBuffer, const float *samples, const int numSamples, const float lastV[6], const float currentV[6] ) = 0;
 	virtual void VPCALL MixSoundSixSpeakerStereo( float *mixBuffer, const float *samples, const int numSamples, const float lastV[6], const float currentV[6] ) = 0;
 	virtual void VPCALL MixedSoundToSamples( short *samples, const float *mixBuffer, const int numSamples ) = 0;
+
+	// image processing, width and height are powers of two
+	virtual void VPCALL MipMapRGBA( byte *dst, const byte *src, const int width, const int height ) = 0;
+	virtual void VPCALL HeightmapToNormalMap( byte *dst, const byte *heights, const int width, const int height, const float scale ) = 0;
+	virtual void VPCALL SmoothNormalMap( byte *dst, const byte *src, const int width, const int height ) = 0;
+	virtual void VPCALL AddNormalMaps( byte *dst, const byte *src, const int count ) = 0;
+	virtual void VPCALL ResampleRowRGBA( byte *dst, const byte *row0, const byte *row1, const unsigned int *offsets0, const unsigned int *offsets1, const int count ) = 0;
+
+	// particles, writes four verts per quad
+	virtual void VPCALL CreateParticleQuads( idDrawVert *verts, const idVec3 &left, const idVec3 &up, const particleQuads_t &quads, const int numQuads ) = 0;
 };
 
 // pointer to SIMD processor
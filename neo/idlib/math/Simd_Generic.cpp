@@ -3264,3 +3264,214 @@ void VPCALL idSIMD_Generic::MixedSoundToSamples( short *samples, const float *mi
 		}
 	}
 }
+
+/*
+============
+idSIMD_Generic::MipMapRGBA
+
+  box filters a width x height RGBA image down to ( width >> 1 ) x ( height >> 1 )
+  width and height must both be at least 2
+============
+*/
+void VPCALL idSIMD_Generic::MipMapRGBA( byte *dst, const byte *src, const int width, const int height ) {
+	int row = width * 4;
+
+	for ( int i = 0; i < ( height >> 1 ); i++, src += row ) {
+		for ( int j = 0; j < ( width >> 1 ); j++, dst += 4, src += 8 ) {
+			dst[0] = ( src[0] + src[4] + src[row+0] + src[row+4] ) >> 2;
+			dst[1] = ( src[1] + src[5] + src[row+1] + src[row+5] ) >> 2;
+			dst[2] = ( src[2] + src[6] + src[row+2] + src[row+6] ) >> 2;
+			dst[3] = ( src[3] + src[7] + src[row+3] + src[row+7] ) >> 2;
+		}
+	}
+}
+
+/*
+============
+idSIMD_Generic::HeightmapToNormalMap
+
+  converts a single channel heightmap to an RGBA normal map, the gradient
+  is estimated from the neighbouring texels with wrap around addressing
+============
+*/
+void VPCALL idSIMD_Generic::HeightmapToNormalMap( byte *dst, const byte *heights, const int width, const int height, const float scale ) {
+	idVec3 dir, dir2;
+
+	for ( int i = 0; i < height; i++ ) {
+		for ( int j = 0; j < width; j++ ) {
+			int d1, d2, d3, d4;
+			int a1, a3, a4;
+
+			// look at three points to estimate the gradient
+			a1 = d1 = heights[ ( i * width + j ) ];
+			d2 = heights[ ( i * width + ( ( j + 1 ) & ( width - 1 ) ) ) ];
+			a3 = d3 = heights[ ( ( ( i + 1 ) & ( height - 1 ) ) * width + j ) ];
+			a4 = d4 = heights[ ( ( ( i + 1 ) & ( height - 1 ) ) * width + ( ( j + 1 ) & ( width - 1 ) ) ) ];
+
+			d2 -= d1;
+			d3 -= d1;
+
+			dir[0] = -d2 * scale;
+			dir[1] = -d3 * scale;
+			dir[2] = 1;
+			dir.NormalizeFast();
+
+			a1 -= a3;
+			a4 -= a3;
+
+			dir2[0] = -a4 * scale;
+			dir2[1] = a1 * scale;
+			dir2[2] = 1;
+			dir2.NormalizeFast();
+
+			dir += dir2;
+			dir.NormalizeFast();
+
+			a1 = ( i * width + j ) * 4;
+			dst[ a1 + 0 ] = (byte)(dir[0] * 127 + 128);
+			dst[ a1 + 1 ] = (byte)(dir[1] * 127 + 128);
+			dst[ a1 + 2 ] = (byte)(dir[2] * 127 + 128);
+			dst[ a1 + 3 ] = 255;
+		}
+	}
+}
+
+/*
+============
+idSIMD_Generic::SmoothNormalMap
+
+  box filters the normals of src over 3x3 texels with wrap around addressing,
+  texels with a 0,0,0 or 128,128,128 normal are ignored, the alpha is copied
+============
+*/
+void VPCALL idSIMD_Generic::SmoothNormalMap( byte *dst, const byte *src, const int width, const int height ) {
+	idVec3 normal;
+
+	for ( int i = 0; i < height; i++ ) {
+		for ( int j = 0; j < width; j++ ) {
+			normal = vec3_origin;
+			for ( int k = -1; k < 2; k++ ) {
+				for ( int l = -1; l < 2; l++ ) {
+					const byte *in = src + ( ( ( i + k ) & ( height - 1 ) ) * width + ( ( j + l ) & ( width - 1 ) ) ) * 4;
+
+					if ( in[0] == 0 && in[1] == 0 && in[2] == 0 ) {
+						continue;
+					}
+					if ( in[0] == 128 && in[1] == 128 && in[2] == 128 ) {
+						continue;
+					}
+
+					normal[0] += in[0] - 128;
+					normal[1] += in[1] - 128;
+					normal[2] += in[2] - 128;
+				}
+			}
+			normal.Normalize();
+
+			byte *out = dst + ( i * width + j ) * 4;
+			out[0] = (byte)(128 + 127 * normal[0]);
+			out[1] = (byte)(128 + 127 * normal[1]);
+			out[2] = (byte)(128 + 127 * normal[2]);
+			out[3] = src[ ( i * width + j ) * 4 + 3 ];
+		}
+	}
+}
+
+/*
+============
+idSIMD_Generic::AddNormalMaps
+
+  adds the x and y change of the src normals to the dst normals and renormalizes,
+  dst normals that are shorter than one are first faded towards 0,0,1, the square
+  root is clamped because idMath::Sqrt is garbage for the slightly negative values
+  that the LengthFast approximation lets through
+============
+*/
+void VPCALL idSIMD_Generic::AddNormalMaps( byte *dst, const byte *src, const int count ) {
+	idVec3 n;
+
+	for ( int i = 0; i < count; i++, dst += 4, src += 4 ) {
+		n[0] = ( dst[0] - 128 ) / 127.0f;
+		n[1] = ( dst[1] - 128 ) / 127.0f;
+		n[2] = ( dst[2] - 128 ) / 127.0f;
+
+		// There are some normal maps that blend to 0,0,0 at the edges
+		// this screws up compression, so we try to correct that here by instead fading it to 0,0,1
+		if ( n.LengthFast() < 1.0f ) {
+			n[2] = idMath::Sqrt( Max( 1.0f - ( n[0] * n[0] ) - ( n[1] * n[1] ), 0.0f ) );
+		}
+
+		n[0] += ( src[0] - 128 ) / 127.0f;
+		n[1] += ( src[1] - 128 ) / 127.0f;
+		n.Normalize();
+
+		dst[0] = (byte)(n[0] * 127 + 128);
+		dst[1] = (byte)(n[1] * 127 + 128);
+		dst[2] = (byte)(n[2] * 127 + 128);
+		dst[3] = 255;
+	}
+}
+
+/*
+============
+idSIMD_Generic::ResampleRowRGBA
+
+  every destination texel is the average of the texels at offsets0[i] and
+  offsets1[i] in both source rows, the offsets are in bytes
+============
+*/
+void VPCALL idSIMD_Generic::ResampleRowRGBA( byte *dst, const byte *row0, const byte *row1, const unsigned int *offsets0, const unsigned int *offsets1, const int count ) {
+	for ( int i = 0; i < count; i++, dst += 4 ) {
+		const byte *pix1 = row0 + offsets0[i];
+		const byte *pix2 = row0 + offsets1[i];
+		const byte *pix3 = row1 + offsets0[i];
+		const byte *pix4 = row1 + offsets1[i];
+		dst[0] = ( pix1[0] + pix2[0] + pix3[0] + pix4[0] ) >> 2;
+		dst[1] = ( pix1[1] + pix2[1] + pix3[1] + pix4[1] ) >> 2;
+		dst[2] = ( pix1[2] + pix2[2] + pix3[2] + pix4[2] ) >> 2;
+		dst[3] = ( pix1[3] + pix2[3] + pix3[3] + pix4[3] ) >> 2;
+	}
+}
+
+/*
+============
+idSIMD_Generic::CreateParticleQuads
+
+  each quad is rotated in the plane of left and up, vertex order is
+
+  0 1
+  2 3
+============
+*/
+void VPCALL idSIMD_Generic::CreateParticleQuads( idDrawVert *verts, const idVec3 &left, const idVec3 &up, const particleQuads_t &quads, const int numQuads ) {
+	for ( int i = 0; i < numQuads; i++, verts += 4 ) {
+		const float c = quads.cosAngle[i];
+		const float s = quads.sinAngle[i];
+		const idVec3 origin( quads.originX[i], quads.originY[i], quads.originZ[i] );
+
+		idVec3 l = left * c + up * s;
+		idVec3 u = up * c - left * s;
+		l *= quads.width[i];
+		u *= quads.height[i];
+
+		verts[0].xyz = origin - l + u;
+		verts[1].xyz = origin + l + u;
+		verts[2].xyz = origin - l - u;
+		verts[3].xyz = origin + l - u;
+
+		const float s0 = quads.s[i];
+		const float s1 = quads.s[i] + quads.sWidth[i];
+
+		verts[0].st.Set( s0, 0.0f );
+		verts[1].st.Set( s1, 0.0f );
+		verts[2].st.Set( s0, 1.0f );
+		verts[3].st.Set( s1, 1.0f );
+
+		for ( int j = 0; j < 4; j++ ) {
+			verts[j].normal.Zero();
+			verts[j].tangents[0].Zero();
+			verts[j].tangents[1].Zero();
+			verts[j].SetColor( quads.color[i] );
+		}
+	}
+}
@@ -137,6 +137,14 @@ public:
 	virtual void VPCALL MixSoundSixSpeakerMono( float *mixBuffer, const float *samples, const int numSamples, const float lastV[6], const float currentV[6] );
 	virtual void VPCALL MixSoundSixSpeakerStereo( float *mixBuffer, const float *samples, const int numSamples, const float lastV[6], const float currentV[6] );
 	virtual void VPCALL MixedSoundToSamples( short *samples, const float *mixBuffer, const int numSamples );
+
+	virtual void VPCALL MipMapRGBA( byte *dst, const byte *src, const int width, const int height );
+	virtual void VPCALL HeightmapToNormalMap( byte *dst, const byte *heights, const int width, const int height, const float scale );
+	virtual void VPCALL SmoothNormalMap( byte *dst, const byte *src, const int width, const int height );
+	virtual void VPCALL AddNormalMaps( byte *dst, const byte *src, const int count );
+	virtual void VPCALL ResampleRowRGBA( byte *dst, const byte *row0, const byte *row1, const unsigned int *offsets0, const unsigned int *offsets1, const int count );
+
+	virtual void VPCALL CreateParticleQuads( idDrawVert *verts, const idVec3 &left, const idVec3 &up, const particleQuads_t &quads, const int numQuads );
 };
 
 #endif /* !__MATH_SIMD_GENERIC_H__ */
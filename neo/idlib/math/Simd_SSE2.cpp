@@ -28,6 +28,9 @@ If you have questions concerning this license or the applicable additional terms
 
 #include "sys/platform.h"
 
+#include "idlib/math/Vector.h"
+#include "idlib/geometry/DrawVert.h"
+
 #include "idlib/math/Simd_SSE2.h"
 
 //===============================================================
@@ -238,4 +241,557 @@ void VPCALL idSIMD_SSE2::CmpLT( byte *dst, const byte bitNum, const float *src0,
 		dst[i] |= ( src0[i] < c ) << bitNum;
 	}
 }
+
+/*
+============
+idSIMD_SSE2::MipMapRGBA
+
+  box filters a width x height RGBA image down to ( width >> 1 ) x ( height >> 1 )
+  four destination texels are produced per iteration, the results are bit exact
+  with the generic version
+============
+*/
+void VPCALL idSIMD_SSE2::MipMapRGBA( byte *dst, const byte *src, const int width, const int height ) {
+	const int row = width * 4;
+	const int outWidth = width >> 1;
+	const int outHeight = height >> 1;
+	const __m128i zero = _mm_setzero_si128();
+
+	for ( int i = 0; i < outHeight; i++ ) {
+		const byte *src0 = src + i * 2 * row;
+		const byte *src1 = src0 + row;
+		int j = 0;
+
+		for ( ; j + 4 <= outWidth; j += 4, src0 += 32, src1 += 32, dst += 16 ) {
+			__m128i r0a = _mm_loadu_si128( (const __m128i *)( src0 + 0 ) );
+			__m128i r0b = _mm_loadu_si128( (const __m128i *)( src0 + 16 ) );
+			__m128i r1a = _mm_loadu_si128( (const __m128i *)( src1 + 0 ) );
+			__m128i r1b = _mm_loadu_si128( (const __m128i *)( src1 + 16 ) );
+
+			// vertical sums of source texel pairs 0-1, 2-3, 4-5 and 6-7 widened to 16 bits
+			__m128i s01 = _mm_add_epi16( _mm_unpacklo_epi8( r0a, zero ), _mm_unpacklo_epi8( r1a, zero ) );
+			__m128i s23 = _mm_add_epi16( _mm_unpackhi_epi8( r0a, zero ), _mm_unpackhi_epi8( r1a, zero ) );
+			__m128i s45 = _mm_add_epi16( _mm_unpacklo_epi8( r0b, zero ), _mm_unpacklo_epi8( r1b, zero ) );
+			__m128i s67 = _mm_add_epi16( _mm_unpackhi_epi8( r0b, zero ), _mm_unpackhi_epi8( r1b, zero ) );
+
+			// add the horizontal neighbours
+			__m128i o01 = _mm_add_epi16( _mm_unpacklo_epi64( s01, s23 ), _mm_unpackhi_epi64( s01, s23 ) );
+			__m128i o23 = _mm_add_epi16( _mm_unpacklo_epi64( s45, s67 ), _mm_unpackhi_epi64( s45, s67 ) );
+
+			o01 = _mm_srli_epi16( o01, 2 );
+			o23 = _mm_srli_epi16( o23, 2 );
+
+			_mm_storeu_si128( (__m128i *)dst, _mm_packus_epi16( o01, o23 ) );
+		}
+
+		for ( ; j < outWidth; j++, src0 += 8, src1 += 8, dst += 4 ) {
+			dst[0] = ( src0[0] + src0[4] + src1[0] + src1[4] ) >> 2;
+			dst[1] = ( src0[1] + src0[5] + src1[1] + src1[5] ) >> 2;
+			dst[2] = ( src0[2] + src0[6] + src1[2] + src1[6] ) >> 2;
+			dst[3] = ( src0[3] + src0[7] + src1[3] + src1[7] ) >> 2;
+		}
+	}
+}
+
+/*
+============
+LoadHeights4
+
+  loads four consecutive heights as 32 bit integers
+============
+*/
+static ID_INLINE __m128i LoadHeights4( const byte *heights ) {
+	int packed;
+	memcpy( &packed, heights, 4 );
+	__m128i h = _mm_cvtsi32_si128( packed );
+	h = _mm_unpacklo_epi8( h, _mm_setzero_si128() );
+	return _mm_unpacklo_epi16( h, _mm_setzero_si128() );
+}
+
+/*
+============
+RSqrt4
+
+  same math as idMath::RSqrt so the results match the generic version
+============
+*/
+static ID_INLINE __m128 RSqrt4( __m128 x ) {
+	__m128 half = _mm_mul_ps( x, _mm_set1_ps( 0.5f ) );
+	__m128i bits = _mm_sub_epi32( _mm_set1_epi32( 0x5f3759df ), _mm_srai_epi32( _mm_castps_si128( x ), 1 ) );
+	__m128 r = _mm_castsi128_ps( bits );
+	return _mm_mul_ps( r, _mm_sub_ps( _mm_set1_ps( 1.5f ), _mm_mul_ps( _mm_mul_ps( r, r ), half ) ) );
+}
+
+/*
+============
+NormalizeFast4
+
+  same math as idVec3::NormalizeFast so the results match the generic version
+============
+*/
+static ID_INLINE void NormalizeFast4( __m128 &x, __m128 &y, __m128 &z ) {
+	__m128 sqrLength = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+	__m128 r = RSqrt4( sqrLength );
+	x = _mm_mul_ps( x, r );
+	y = _mm_mul_ps( y, r );
+	z = _mm_mul_ps( z, r );
+}
+
+/*
+============
+Normalize4
+
+  full precision normalize, a zero vector stays zero like it does with idVec3::Normalize,
+  the results can be one bit off from idMath::InvSqrt
+============
+*/
+static ID_INLINE void Normalize4( __m128 &x, __m128 &y, __m128 &z ) {
+	__m128 sqrLength = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+	sqrLength = _mm_max_ps( sqrLength, _mm_set1_ps( 1e-30f ) );
+	__m128 r = _mm_div_ps( _mm_set1_ps( 1.0f ), _mm_sqrt_ps( sqrLength ) );
+	x = _mm_mul_ps( x, r );
+	y = _mm_mul_ps( y, r );
+	z = _mm_mul_ps( z, r );
+}
+
+/*
+============
+UnpackTexels4
+
+  sign extends the eight 16 bit channels of lo and hi and transposes them
+  to one vector per channel
+============
+*/
+static ID_INLINE void UnpackTexels4( __m128 &x, __m128 &y, __m128 &z, __m128 &w, const __m128i lo, const __m128i hi ) {
+	x = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( lo, lo ), 16 ) );
+	y = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( lo, lo ), 16 ) );
+	z = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( hi, hi ), 16 ) );
+	w = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( hi, hi ), 16 ) );
+	_MM_TRANSPOSE4_PS( x, y, z, w );
+}
+
+/*
+============
+PackNormals4
+
+  converts normals in the [-1, 1] range to RGB bytes and merges in the alpha
+============
+*/
+static ID_INLINE __m128i PackNormals4( const __m128 x, const __m128 y, const __m128 z, const __m128i alpha ) {
+	const __m128 c127 = _mm_set1_ps( 127.0f );
+	const __m128 c128 = _mm_set1_ps( 128.0f );
+
+	__m128i r = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( x, c127 ), c128 ) );
+	__m128i g = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( y, c127 ), c128 ) );
+	__m128i b = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( z, c127 ), c128 ) );
+
+	return _mm_or_si128( _mm_or_si128( r, _mm_slli_epi32( g, 8 ) ), _mm_or_si128( _mm_slli_epi32( b, 16 ), alpha ) );
+}
+
+/*
+============
+idSIMD_SSE2::HeightmapToNormalMap
+
+  four texels are processed per iteration, the last texels of each row
+  wrap around and are handled by the scalar path
+============
+*/
+void VPCALL idSIMD_SSE2::HeightmapToNormalMap( byte *dst, const byte *heights, const int width, const int height, const float scale ) {
+	const __m128 s = _mm_set1_ps( scale );
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128i alpha = _mm_set1_epi32( (int)0xFF000000 );
+	idVec3 dir, dir2;
+
+	for ( int i = 0; i < height; i++ ) {
+		const byte *row0 = heights + i * width;
+		const byte *row1 = heights + ( ( i + 1 ) & ( height - 1 ) ) * width;
+		byte *out = dst + i * width * 4;
+		int j = 0;
+
+		for ( ; j + 4 < width; j += 4, out += 16 ) {
+			__m128i d1 = LoadHeights4( row0 + j );
+			__m128i d2 = LoadHeights4( row0 + j + 1 );
+			__m128i d3 = LoadHeights4( row1 + j );
+			__m128i d4 = LoadHeights4( row1 + j + 1 );
+
+			__m128 x0 = _mm_mul_ps( _mm_cvtepi32_ps( _mm_sub_epi32( d1, d2 ) ), s );
+			__m128 y0 = _mm_mul_ps( _mm_cvtepi32_ps( _mm_sub_epi32( d1, d3 ) ), s );
+			__m128 z0 = one;
+			NormalizeFast4( x0, y0, z0 );
+
+			__m128 x1 = _mm_mul_ps( _mm_cvtepi32_ps( _mm_sub_epi32( d3, d4 ) ), s );
+			__m128 y1 = _mm_mul_ps( _mm_cvtepi32_ps( _mm_sub_epi32( d1, d3 ) ), s );
+			__m128 z1 = one;
+			NormalizeFast4( x1, y1, z1 );
+
+			x0 = _mm_add_ps( x0, x1 );
+			y0 = _mm_add_ps( y0, y1 );
+			z0 = _mm_add_ps( z0, z1 );
+			NormalizeFast4( x0, y0, z0 );
+
+			_mm_storeu_si128( (__m128i *)out, PackNormals4( x0, y0, z0, alpha ) );
+		}
+
+		for ( ; j < width; j++, out += 4 ) {
+			int d1, d2, d3, d4;
+			int a1, a3, a4;
+
+			a1 = d1 = row0[ j ];
+			d2 = row0[ ( j + 1 ) & ( width - 1 ) ];
+			a3 = d3 = row1[ j ];
+			a4 = d4 = row1[ ( j + 1 ) & ( width - 1 ) ];
+
+			d2 -= d1;
+			d3 -= d1;
+
+			dir[0] = -d2 * scale;
+			dir[1] = -d3 * scale;
+			dir[2] = 1;
+			dir.NormalizeFast();
+
+			a1 -= a3;
+			a4 -= a3;
+
+			dir2[0] = -a4 * scale;
+			dir2[1] = a1 * scale;
+			dir2[2] = 1;
+			dir2.NormalizeFast();
+
+			dir += dir2;
+			dir.NormalizeFast();
+
+			out[0] = (byte)(dir[0] * 127 + 128);
+			out[1] = (byte)(dir[1] * 127 + 128);
+			out[2] = (byte)(dir[2] * 127 + 128);
+			out[3] = 255;
+		}
+	}
+}
+
+/*
+============
+IgnoreFlatNormals
+
+  replaces texels with a 0,0,0 or 128,128,128 normal by 128,128,128 so they
+  add nothing to the sum of the normals
+============
+*/
+static ID_INLINE __m128i IgnoreFlatNormals( const __m128i v ) {
+	const __m128i rgb = _mm_set1_epi32( 0x00FFFFFF );
+	const __m128i half = _mm_set1_epi8( (char)0x80 );
+
+	__m128i isZero = _mm_cmpeq_epi32( _mm_and_si128( _mm_cmpeq_epi8( v, _mm_setzero_si128() ), rgb ), rgb );
+	__m128i isHalf = _mm_cmpeq_epi32( _mm_and_si128( _mm_cmpeq_epi8( v, half ), rgb ), rgb );
+	__m128i ignore = _mm_or_si128( isZero, isHalf );
+
+	return _mm_or_si128( _mm_and_si128( ignore, half ), _mm_andnot_si128( ignore, v ) );
+}
+
+/*
+============
+SmoothNormalTexel
+============
+*/
+static void SmoothNormalTexel( byte *dst, const byte *src, const int width, const int height, const int i, const int j ) {
+	idVec3 normal;
+
+	normal = vec3_origin;
+	for ( int k = -1; k < 2; k++ ) {
+		for ( int l = -1; l < 2; l++ ) {
+			const byte *in = src + ( ( ( i + k ) & ( height - 1 ) ) * width + ( ( j + l ) & ( width - 1 ) ) ) * 4;
+
+			if ( in[0] == 0 && in[1] == 0 && in[2] == 0 ) {
+				continue;
+			}
+			if ( in[0] == 128 && in[1] == 128 && in[2] == 128 ) {
+				continue;
+			}
+
+			normal[0] += in[0] - 128;
+			normal[1] += in[1] - 128;
+			normal[2] += in[2] - 128;
+		}
+	}
+	normal.Normalize();
+
+	byte *out = dst + ( i * width + j ) * 4;
+	out[0] = (byte)(128 + 127 * normal[0]);
+	out[1] = (byte)(128 + 127 * normal[1]);
+	out[2] = (byte)(128 + 127 * normal[2]);
+	out[3] = src[ ( i * width + j ) * 4 + 3 ];
+}
+
+/*
+============
+idSIMD_SSE2::SmoothNormalMap
+
+  four texels are processed per iteration, the sums of the normals are exact
+  in 16 bits, the first and last texels of each row wrap around and are handled
+  by the scalar path
+============
+*/
+void VPCALL idSIMD_SSE2::SmoothNormalMap( byte *dst, const byte *src, const int width, const int height ) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16( 9 * 128 );
+	const __m128i alpha = _mm_set1_epi32( (int)0xFF000000 );
+	const byte *rows[3];
+
+	for ( int i = 0; i < height; i++ ) {
+		rows[0] = src + ( ( i - 1 ) & ( height - 1 ) ) * width * 4;
+		rows[1] = src + i * width * 4;
+		rows[2] = src + ( ( i + 1 ) & ( height - 1 ) ) * width * 4;
+		byte *out = dst + i * width * 4;
+
+		SmoothNormalTexel( dst, src, width, height, i, 0 );
+
+		int j = 1;
+		for ( ; j + 4 < width; j += 4 ) {
+			__m128i lo = zero;
+			__m128i hi = zero;
+
+			for ( int k = 0; k < 3; k++ ) {
+				for ( int l = -1; l < 2; l++ ) {
+					__m128i v = IgnoreFlatNormals( _mm_loadu_si128( (const __m128i *)( rows[k] + ( j + l ) * 4 ) ) );
+					lo = _mm_add_epi16( lo, _mm_unpacklo_epi8( v, zero ) );
+					hi = _mm_add_epi16( hi, _mm_unpackhi_epi8( v, zero ) );
+				}
+			}
+
+			__m128 x, y, z, w;
+			UnpackTexels4( x, y, z, w, _mm_sub_epi16( lo, bias ), _mm_sub_epi16( hi, bias ) );
+			Normalize4( x, y, z );
+
+			__m128i a = _mm_and_si128( _mm_loadu_si128( (const __m128i *)( rows[1] + j * 4 ) ), alpha );
+			_mm_storeu_si128( (__m128i *)( out + j * 4 ), PackNormals4( x, y, z, a ) );
+		}
+
+		for ( ; j < width; j++ ) {
+			SmoothNormalTexel( dst, src, width, height, i, j );
+		}
+	}
+}
+
+/*
+============
+idSIMD_SSE2::AddNormalMaps
+
+  four texels are processed per iteration, the length test reproduces
+  idVec3::LengthFast so the same normals are faded as in the generic version
+============
+*/
+void VPCALL idSIMD_SSE2::AddNormalMaps( byte *dst, const byte *src, const int count ) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16( 128 );
+	const __m128i alpha = _mm_set1_epi32( (int)0xFF000000 );
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 c127 = _mm_set1_ps( 127.0f );
+	idVec3 n;
+	int i = 0;
+
+	for ( ; i + 4 <= count; i += 4, dst += 16, src += 16 ) {
+		__m128i d = _mm_loadu_si128( (const __m128i *)dst );
+		__m128i s = _mm_loadu_si128( (const __m128i *)src );
+		__m128 x, y, z, w;
+		__m128 sx, sy, sz, sw;
+
+		UnpackTexels4( x, y, z, w, _mm_sub_epi16( _mm_unpacklo_epi8( d, zero ), bias ), _mm_sub_epi16( _mm_unpackhi_epi8( d, zero ), bias ) );
+		UnpackTexels4( sx, sy, sz, sw, _mm_sub_epi16( _mm_unpacklo_epi8( s, zero ), bias ), _mm_sub_epi16( _mm_unpackhi_epi8( s, zero ), bias ) );
+
+		x = _mm_div_ps( x, c127 );
+		y = _mm_div_ps( y, c127 );
+		z = _mm_div_ps( z, c127 );
+
+		// fade normals shorter than one towards 0,0,1
+		__m128 sqrLength = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+		__m128 shorter = _mm_cmplt_ps( _mm_mul_ps( sqrLength, RSqrt4( sqrLength ) ), one );
+		__m128 f = _mm_sqrt_ps( _mm_max_ps( _mm_sub_ps( _mm_sub_ps( one, _mm_mul_ps( x, x ) ), _mm_mul_ps( y, y ) ), _mm_setzero_ps() ) );
+		z = _mm_or_ps( _mm_and_ps( shorter, f ), _mm_andnot_ps( shorter, z ) );
+
+		x = _mm_add_ps( x, _mm_div_ps( sx, c127 ) );
+		y = _mm_add_ps( y, _mm_div_ps( sy, c127 ) );
+		Normalize4( x, y, z );
+
+		_mm_storeu_si128( (__m128i *)dst, PackNormals4( x, y, z, alpha ) );
+	}
+
+	for ( ; i < count; i++, dst += 4, src += 4 ) {
+		n[0] = ( dst[0] - 128 ) / 127.0f;
+		n[1] = ( dst[1] - 128 ) / 127.0f;
+		n[2] = ( dst[2] - 128 ) / 127.0f;
+
+		if ( n.LengthFast() < 1.0f ) {
+			n[2] = idMath::Sqrt( Max( 1.0f - ( n[0] * n[0] ) - ( n[1] * n[1] ), 0.0f ) );
+		}
+
+		n[0] += ( src[0] - 128 ) / 127.0f;
+		n[1] += ( src[1] - 128 ) / 127.0f;
+		n.Normalize();
+
+		dst[0] = (byte)(n[0] * 127 + 128);
+		dst[1] = (byte)(n[1] * 127 + 128);
+		dst[2] = (byte)(n[2] * 127 + 128);
+		dst[3] = 255;
+	}
+}
+
+/*
+============
+LoadTexel
+============
+*/
+static ID_INLINE int LoadTexel( const byte *texel ) {
+	int packed;
+	memcpy( &packed, texel, 4 );
+	return packed;
+}
+
+/*
+============
+idSIMD_SSE2::ResampleRowRGBA
+
+  four destination texels are produced per iteration, the results are bit exact
+  with the generic version
+============
+*/
+void VPCALL idSIMD_SSE2::ResampleRowRGBA( byte *dst, const byte *row0, const byte *row1, const unsigned int *offsets0, const unsigned int *offsets1, const int count ) {
+	const __m128i zero = _mm_setzero_si128();
+	int i = 0;
+
+	for ( ; i + 4 <= count; i += 4, dst += 16 ) {
+		__m128i p1 = _mm_set_epi32( LoadTexel( row0 + offsets0[i+3] ), LoadTexel( row0 + offsets0[i+2] ), LoadTexel( row0 + offsets0[i+1] ), LoadTexel( row0 + offsets0[i+0] ) );
+		__m128i p2 = _mm_set_epi32( LoadTexel( row0 + offsets1[i+3] ), LoadTexel( row0 + offsets1[i+2] ), LoadTexel( row0 + offsets1[i+1] ), LoadTexel( row0 + offsets1[i+0] ) );
+		__m128i p3 = _mm_set_epi32( LoadTexel( row1 + offsets0[i+3] ), LoadTexel( row1 + offsets0[i+2] ), LoadTexel( row1 + offsets0[i+1] ), LoadTexel( row1 + offsets0[i+0] ) );
+		__m128i p4 = _mm_set_epi32( LoadTexel( row1 + offsets1[i+3] ), LoadTexel( row1 + offsets1[i+2] ), LoadTexel( row1 + offsets1[i+1] ), LoadTexel( row1 + offsets1[i+0] ) );
+
+		__m128i lo = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( p1, zero ), _mm_unpacklo_epi8( p2, zero ) ), _mm_add_epi16( _mm_unpacklo_epi8( p3, zero ), _mm_unpacklo_epi8( p4, zero ) ) );
+		__m128i hi = _mm_add_epi16( _mm_add_epi16( _mm_unpackhi_epi8( p1, zero ), _mm_unpackhi_epi8( p2, zero ) ), _mm_add_epi16( _mm_unpackhi_epi8( p3, zero ), _mm_unpackhi_epi8( p4, zero ) ) );
+
+		_mm_storeu_si128( (__m128i *)dst, _mm_packus_epi16( _mm_srli_epi16( lo, 2 ), _mm_srli_epi16( hi, 2 ) ) );
+	}
+
+	for ( ; i < count; i++, dst += 4 ) {
+		const byte *pix1 = row0 + offsets0[i];
+		const byte *pix2 = row0 + offsets1[i];
+		const byte *pix3 = row1 + offsets0[i];
+		const byte *pix4 = row1 + offsets1[i];
+		dst[0] = ( pix1[0] + pix2[0] + pix3[0] + pix4[0] ) >> 2;
+		dst[1] = ( pix1[1] + pix2[1] + pix3[1] + pix4[1] ) >> 2;
+		dst[2] = ( pix1[2] + pix2[2] + pix3[2] + pix4[2] ) >> 2;
+		dst[3] = ( pix1[3] + pix2[3] + pix3[3] + pix4[3] ) >> 2;
+	}
+}
+
+/*
+============
+idSIMD_SSE2::CreateParticleQuads
+
+  the corners of four quads are calculated per iteration, the results are
+  bit exact with the generic version
+============
+*/
+void VPCALL idSIMD_SSE2::CreateParticleQuads( idDrawVert *verts, const idVec3 &left, const idVec3 &up, const particleQuads_t &quads, const int numQuads ) {
+	const __m128 lx = _mm_set1_ps( left.x );
+	const __m128 ly = _mm_set1_ps( left.y );
+	const __m128 lz = _mm_set1_ps( left.z );
+	const __m128 ux = _mm_set1_ps( up.x );
+	const __m128 uy = _mm_set1_ps( up.y );
+	const __m128 uz = _mm_set1_ps( up.z );
+	const __m128 zero = _mm_setzero_ps();
+	float s0[4];
+	float s1[4];
+	int i = 0;
+
+	assert( sizeof( idDrawVert ) == 60 );
+	assert( (ptrdiff_t)&verts->st - (ptrdiff_t)&verts->xyz == 12 );
+
+	for ( ; i + 4 <= numQuads; i += 4, verts += 16 ) {
+		const __m128 c = _mm_loadu_ps( quads.cosAngle + i );
+		const __m128 s = _mm_loadu_ps( quads.sinAngle + i );
+		const __m128 w = _mm_loadu_ps( quads.width + i );
+		const __m128 h = _mm_loadu_ps( quads.height + i );
+		const __m128 ox = _mm_loadu_ps( quads.originX + i );
+		const __m128 oy = _mm_loadu_ps( quads.originY + i );
+		const __m128 oz = _mm_loadu_ps( quads.originZ + i );
+
+		// rotated left and up of the four quads
+		__m128 qlx = _mm_mul_ps( _mm_add_ps( _mm_mul_ps( lx, c ), _mm_mul_ps( ux, s ) ), w );
+		__m128 qly = _mm_mul_ps( _mm_add_ps( _mm_mul_ps( ly, c ), _mm_mul_ps( uy, s ) ), w );
+		__m128 qlz = _mm_mul_ps( _mm_add_ps( _mm_mul_ps( lz, c ), _mm_mul_ps( uz, s ) ), w );
+		__m128 qux = _mm_mul_ps( _mm_sub_ps( _mm_mul_ps( ux, c ), _mm_mul_ps( lx, s ) ), h );
+		__m128 quy = _mm_mul_ps( _mm_sub_ps( _mm_mul_ps( uy, c ), _mm_mul_ps( ly, s ) ), h );
+		__m128 quz = _mm_mul_ps( _mm_sub_ps( _mm_mul_ps( uz, c ), _mm_mul_ps( lz, s ) ), h );
+
+		__m128 mx = _mm_sub_ps( ox, qlx );
+		__m128 my = _mm_sub_ps( oy, qly );
+		__m128 mz = _mm_sub_ps( oz, qlz );
+		__m128 px = _mm_add_ps( ox, qlx );
+		__m128 py = _mm_add_ps( oy, qly );
+		__m128 pz = _mm_add_ps( oz, qlz );
+
+		// corner k of the four quads, transposed to one xyz per quad
+		__m128 corners[4][4];
+		corners[0][0] = _mm_add_ps( mx, qux ); corners[0][1] = _mm_add_ps( my, quy ); corners[0][2] = _mm_add_ps( mz, quz ); corners[0][3] = zero;
+		corners[1][0] = _mm_add_ps( px, qux ); corners[1][1] = _mm_add_ps( py, quy ); corners[1][2] = _mm_add_ps( pz, quz ); corners[1][3] = zero;
+		corners[2][0] = _mm_sub_ps( mx, qux ); corners[2][1] = _mm_sub_ps( my, quy ); corners[2][2] = _mm_sub_ps( mz, quz ); corners[2][3] = zero;
+		corners[3][0] = _mm_sub_ps( px, qux ); corners[3][1] = _mm_sub_ps( py, quy ); corners[3][2] = _mm_sub_ps( pz, quz ); corners[3][3] = zero;
+		for ( int k = 0; k < 4; k++ ) {
+			_MM_TRANSPOSE4_PS( corners[k][0], corners[k][1], corners[k][2], corners[k][3] );
+		}
+
+		const __m128 st = _mm_loadu_ps( quads.s + i );
+		_mm_storeu_ps( s0, st );
+		_mm_storeu_ps( s1, _mm_add_ps( st, _mm_loadu_ps( quads.sWidth + i ) ) );
+
+		for ( int j = 0; j < 4; j++ ) {
+			idDrawVert *v = verts + j * 4;
+			const dword color = quads.color[i+j];
+
+			// the fourth float of each store lands on st[0], which is written right after
+			for ( int k = 0; k < 4; k++ ) {
+				_mm_storeu_ps( v[k].xyz.ToFloatPtr(), corners[k][j] );
+			}
+
+			v[0].st.Set( s0[j], 0.0f );
+			v[1].st.Set( s1[j], 0.0f );
+			v[2].st.Set( s0[j], 1.0f );
+			v[3].st.Set( s1[j], 1.0f );
+
+			for ( int k = 0; k < 4; k++ ) {
+				v[k].normal.Zero();
+				v[k].tangents[0].Zero();
+				v[k].tangents[1].Zero();
+				v[k].SetColor( color );
+			}
+		}
+	}
+
+	for ( ; i < numQuads; i++, verts += 4 ) {
+		const float c = quads.cosAngle[i];
+		const float s = quads.sinAngle[i];
+		const idVec3 origin( quads.originX[i], quads.originY[i], quads.originZ[i] );
+
+		idVec3 l = left * c + up * s;
+		idVec3 u = up * c - left * s;
+		l *= quads.width[i];
+		u *= quads.height[i];
+
+		verts[0].xyz = origin - l + u;
+		verts[1].xyz = origin + l + u;
+		verts[2].xyz = origin - l - u;
+		verts[3].xyz = origin + l - u;
+
+		verts[0].st.Set( quads.s[i], 0.0f );
+		verts[1].st.Set( quads.s[i] + quads.sWidth[i], 0.0f );
+		verts[2].st.Set( quads.s[i], 1.0f );
+		verts[3].st.Set( quads.s[i] + quads.sWidth[i], 1.0f );
+
+		for ( int k = 0; k < 4; k++ ) {
+			verts[k].normal.Zero();
+			verts[k].tangents[0].Zero();
+			verts[k].tangents[1].Zero();
+			verts[k].SetColor( quads.color[i] );
+		}
+	}
+}
+
 #endif
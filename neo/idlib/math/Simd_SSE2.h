@@ -46,6 +46,14 @@ public:
 
 	virtual const char * VPCALL GetName( void ) const;
 	virtual void VPCALL CmpLT( byte *dst,			const byte bitNum,		const float *src0,		const float constant,	const int count );
+
+	virtual void VPCALL MipMapRGBA( byte *dst, const byte *src, const int width, const int height );
+	virtual void VPCALL HeightmapToNormalMap( byte *dst, const byte *heights, const int width, const int height, const float scale );
+	virtual void VPCALL SmoothNormalMap( byte *dst, const byte *src, const int width, const int height );
+	virtual void VPCALL AddNormalMaps( byte *dst, const byte *src, const int count );
+	virtual void VPCALL ResampleRowRGBA( byte *dst, const byte *row0, const byte *row1, const unsigned int *offsets0, const unsigned int *offsets1, const int count );
+
+	virtual void VPCALL CreateParticleQuads( idDrawVert *verts, const idVec3 &left, const idVec3 &up, const particleQuads_t &quads, const int numQuads );
 #endif
 };
 
@@ -0,0 +1,557 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "sys/platform.h"
+#include "renderer/tr_local.h"
+#include "renderer/RenderWorld_local.h"
+
+#include "renderer/DecalQueue.h"
+
+idDecalQueue	decalQueue;
+
+/*
+==================
+idDecalQueue::idDecalQueue
+==================
+*/
+idDecalQueue::idDecalQueue( void ) {
+	frameCount = -1;
+	memset( &clip, 0, sizeof( clip ) );
+	workerRunning = false;
+	memset( &workerThread, 0, sizeof( workerThread ) );
+	memset( &stats, 0, sizeof( stats ) );
+}
+
+/*
+==================
+idDecalQueue::Shutdown
+==================
+*/
+void idDecalQueue::Shutdown( void ) {
+	WaitForWorker();
+
+	requests.Clear();
+	jobs.Clear();
+	clipFacePlanes.Clear();
+	clipPoints.Clear();
+	clipWindingPoints.Clear();
+	clipCullBits.Clear();
+	memset( &clip, 0, sizeof( clip ) );
+	frameCount = -1;
+}
+
+/*
+==================
+idDecalQueue::Coalesce
+
+Returns true if a queued projection already covers the new one.
+==================
+*/
+bool idDecalQueue::Coalesce( const decalRequest_t &request ) const {
+	const float dist = r_decalCoalesceDistance.GetFloat();
+
+	if ( dist <= 0.0f ) {
+		return false;
+	}
+
+	for ( int i = requests.Num() - 1; i >= 0; i-- ) {
+		const decalRequest_t &queued = requests[i];
+
+		if ( queued.type != request.type || queued.world != request.world ||
+				queued.entityHandle != request.entityHandle || queued.material != request.material ) {
+			continue;
+		}
+
+		if ( request.type == DQ_OVERLAY ) {
+			// the texture axes are in texture units, not world units
+			if ( queued.localTextureAxis[0].Compare( request.localTextureAxis[0], 0.01f ) &&
+					queued.localTextureAxis[1].Compare( request.localTextureAxis[1], 0.01f ) ) {
+				return true;
+			}
+			continue;
+		}
+
+		if ( queued.info.parallel != request.info.parallel ) {
+			continue;
+		}
+		if ( !queued.info.projectionOrigin.Compare( request.info.projectionOrigin, dist ) ) {
+			continue;
+		}
+		if ( !queued.info.projectionBounds[0].Compare( request.info.projectionBounds[0], dist ) ||
+				!queued.info.projectionBounds[1].Compare( request.info.projectionBounds[1], dist ) ) {
+			continue;
+		}
+		return true;
+	}
+
+	return false;
+}
+
+/*
+==================
+idDecalQueue::Enqueue
+==================
+*/
+bool idDecalQueue::Enqueue( const decalRequest_t &request ) {
+	if ( Coalesce( request ) ) {
+		stats.numCoalesced++;
+		return true;
+	}
+
+	// over budget for this many frames, the marks are not worth a spike
+	if ( requests.Num() >= MAX_QUEUED_DECALS ) {
+		stats.numDropped++;
+		return true;
+	}
+
+	requests.Append( request );
+	stats.numQueued++;
+	stats.peakQueued = Max( stats.peakQueued, requests.Num() );
+
+	return true;
+}
+
+/*
+==================
+idDecalQueue::QueueDecal
+
+The entity is picked by the caller and the projection is moved into
+its model space now, the way a synchronous decal would be.
+==================
+*/
+bool idDecalQueue::QueueDecal( idRenderWorldLocal *world, const idRenderEntityLocal *def, const decalProjectionInfo_t &info ) {
+	// nothing would ever take it off the queue without a renderer
+	if ( !r_asyncDecals.GetBool() || !glConfig.isInitialized ) {
+		return false;
+	}
+
+	decalRequest_t request;
+
+	request.type = DQ_DECAL;
+	request.world = world;
+	request.entityHandle = def->index;
+	request.def = def;
+	request.model = def->parms.hModel;
+	request.info = info;
+
+	// transform the bounding planes, fade planes and texture axis into local space
+	idRenderModelDecal::GlobalProjectionInfoToLocal( request.localInfo, info, def->parms.origin, def->parms.axis );
+	request.localInfo.force = ( def->parms.customShader != NULL );
+
+	request.localTextureAxis[0].Zero();
+	request.localTextureAxis[1].Zero();
+	request.material = info.material;
+	request.queueTime = Sys_Milliseconds();
+	request.queueFrame = tr.frameCount;
+
+	return Enqueue( request );
+}
+
+/*
+==================
+idDecalQueue::QueueOverlay
+==================
+*/
+bool idDecalQueue::QueueOverlay( idRenderWorldLocal *world, qhandle_t entityHandle, const idPlane localTextureAxis[2], const idMaterial *material ) {
+	if ( !r_asyncDecals.GetBool() || !glConfig.isInitialized ) {
+		return false;
+	}
+
+	decalRequest_t request;
+
+	memset( &request.info, 0, sizeof( request.info ) );
+	memset( &request.localInfo, 0, sizeof( request.localInfo ) );
+	request.type = DQ_OVERLAY;
+	request.world = world;
+	request.entityHandle = entityHandle;
+	request.def = NULL;
+	request.model = NULL;
+	request.localTextureAxis[0] = localTextureAxis[0];
+	request.localTextureAxis[1] = localTextureAxis[1];
+	request.material = material;
+	request.queueTime = Sys_Milliseconds();
+	request.queueFrame = tr.frameCount;
+
+	return Enqueue( request );
+}
+
+/*
+==================
+idDecalQueue::AddJob
+==================
+*/
+void idDecalQueue::AddJob( const decalRequest_t &request ) {
+	const idRenderModel *model = request.model;
+	decalJob_t &job = jobs.Alloc();
+
+	job.world = request.world;
+	job.entityHandle = request.entityHandle;
+	job.def = request.def;
+	job.model = model;
+	job.localInfo = request.localInfo;
+	job.queueTime = request.queueTime;
+	job.queueFrame = request.queueFrame;
+	job.clipped = false;
+	job.removed = false;
+	job.firstPoint = 0;
+	job.firstWinding = 0;
+	job.numWindings = 0;
+	job.firstFacePlanes = clipFacePlanes.Num();
+
+	for ( int i = 0; i < model->NumSurfaces(); i++ ) {
+		const srfTriangles_t *stri = model->Surface( i )->geometry;
+
+		// the main thread may derive face planes while the worker runs,
+		// so the worker only uses the ones that are already there
+		clipFacePlanes.Append( ( stri != NULL && stri->facePlanesCalculated ) ? stri->facePlanes : NULL );
+
+		// the worker can't allocate, so the cull bits must hold the largest surface now
+		if ( stri != NULL && stri->numVerts > clipCullBits.Num() ) {
+			clipCullBits.SetNum( stri->numVerts, false );
+		}
+	}
+}
+
+/*
+==================
+idDecalQueue::ProcessRequest
+
+Turns a queued projection into a job, if the entity still has the model.
+==================
+*/
+void idDecalQueue::ProcessRequest( const decalRequest_t &request ) {
+	idRenderWorldLocal *world = request.world;
+
+	stats.numProcessed++;
+
+	switch( request.type ) {
+		case DQ_DECAL: {
+			if ( request.entityHandle >= world->entityDefs.Num() || world->entityDefs[request.entityHandle] != request.def ||
+					request.def->parms.hModel != request.model ) {
+				stats.numStale++;
+				break;
+			}
+			AddJob( request );
+			break;
+		}
+		case DQ_OVERLAY: {
+			world->CreateEntityOverlay( request.entityHandle, request.localTextureAxis, request.material );
+			break;
+		}
+	}
+}
+
+/*
+==================
+idDecalQueue::ClipJobs
+==================
+*/
+void idDecalQueue::ClipJobs( void ) {
+	for ( int i = 0; i < jobs.Num(); i++ ) {
+		decalJob_t &job = jobs[i];
+
+		job.firstPoint = clip.numPoints;
+		job.firstWinding = clip.numWindings;
+		job.clipped = idRenderModelDecal::ClipDecal( job.model, clipFacePlanes.Ptr() + job.firstFacePlanes, job.localInfo, clip );
+		job.numWindings = clip.numWindings - job.firstWinding;
+	}
+}
+
+/*
+==================
+idDecalQueue::ClipThread
+==================
+*/
+int idDecalQueue::ClipThread( void *parm ) {
+	static_cast<idDecalQueue *>( parm )->ClipJobs();
+	return 0;
+}
+
+/*
+==================
+idDecalQueue::WaitForWorker
+==================
+*/
+void idDecalQueue::WaitForWorker( void ) {
+#ifndef NOMT
+	if ( workerRunning ) {
+		Sys_DestroyThread( workerThread );
+		workerRunning = false;
+	}
+#endif
+}
+
+/*
+==================
+idDecalQueue::StartJobs
+==================
+*/
+void idDecalQueue::StartJobs( void ) {
+	const int numRequests = Min( requests.Num(), Max( 1, r_decalBudget.GetInteger() ) );
+
+	jobs.SetNum( 0, false );
+	clipFacePlanes.SetNum( 0, false );
+	for ( int i = 0; i < numRequests; i++ ) {
+		ProcessRequest( requests[i] );
+	}
+
+	// keep the rest in order for the next frames
+	for ( int i = numRequests; i < requests.Num(); i++ ) {
+		requests[i - numRequests] = requests[i];
+	}
+	requests.SetNum( requests.Num() - numRequests, false );
+
+	if ( !jobs.Num() ) {
+		return;
+	}
+	stats.numJobs += jobs.Num();
+
+	if ( clipPoints.Num() < MAX_CLIP_POINTS ) {
+		clipPoints.SetNum( MAX_CLIP_POINTS );
+		clipWindingPoints.SetNum( MAX_CLIP_WINDINGS );
+	}
+	clip.points = clipPoints.Ptr();
+	clip.maxPoints = clipPoints.Num();
+	clip.numPoints = 0;
+	clip.windingPoints = clipWindingPoints.Ptr();
+	clip.maxWindings = clipWindingPoints.Num();
+	clip.numWindings = 0;
+	clip.cullBits = clipCullBits.Ptr();
+	clip.maxCullBits = clipCullBits.Num();
+
+#ifndef NOMT
+	workerRunning = true;
+	Sys_CreateThread( idDecalQueue::ClipThread, this, workerThread, "decals" );
+#else
+	ClipJobs();
+	PublishJobs();
+#endif
+}
+
+/*
+==================
+idDecalQueue::PublishJobs
+==================
+*/
+void idDecalQueue::PublishJobs( void ) {
+	const int time = Sys_Milliseconds();
+
+	for ( int i = 0; i < jobs.Num(); i++ ) {
+		const decalJob_t &job = jobs[i];
+
+		if ( job.removed ) {
+			continue;
+		}
+
+		// the entity may have been freed or given another model since the job was started,
+		// moving is fine because the projection was moved into model space when it was queued
+		idRenderWorldLocal *world = job.world;
+		if ( job.entityHandle >= world->entityDefs.Num() || world->entityDefs[job.entityHandle] != job.def ) {
+			stats.numStale++;
+			continue;
+		}
+		idRenderEntityLocal *def = world->entityDefs[job.entityHandle];
+		if ( def->parms.hModel != job.model ) {
+			stats.numStale++;
+			continue;
+		}
+
+		if ( !job.clipped ) {
+			// the clip buffers were full
+			if ( def->decals == NULL ) {
+				def->decals = idRenderModelDecal::Alloc();
+			}
+			def->decals->CreateDecal( job.model, job.localInfo );
+			stats.numOverflows++;
+		} else if ( job.numWindings ) {
+			if ( def->decals == NULL ) {
+				def->decals = idRenderModelDecal::Alloc();
+			}
+			def->decals->AddClippedDecal( clip, job.firstPoint, job.firstWinding, job.numWindings, job.localInfo );
+		}
+
+		const int latencyMsec = time - job.queueTime;
+		const int latencyFrames = tr.frameCount - job.queueFrame;
+		stats.numPublished++;
+		stats.totalLatencyMsec += latencyMsec;
+		stats.maxLatencyMsec = Max( stats.maxLatencyMsec, latencyMsec );
+		stats.totalLatencyFrames += latencyFrames;
+		stats.maxLatencyFrames = Max( stats.maxLatencyFrames, latencyFrames );
+	}
+
+	jobs.SetNum( 0, false );
+}
+
+/*
+==================
+idDecalQueue::RunFrame
+==================
+*/
+void idDecalQueue::RunFrame( void ) {
+	if ( frameCount == tr.frameCount ) {
+		return;
+	}
+	frameCount = tr.frameCount;
+
+	WaitForWorker();
+	PublishJobs();
+
+	if ( requests.Num() ) {
+		StartJobs();
+	}
+}
+
+/*
+==================
+idDecalQueue::RemoveDecals
+==================
+*/
+void idDecalQueue::RemoveDecals( const idRenderWorldLocal *world, qhandle_t entityHandle ) {
+	int num = 0;
+
+	for ( int i = 0; i < requests.Num(); i++ ) {
+		if ( requests[i].world == world && requests[i].entityHandle == entityHandle ) {
+			continue;
+		}
+		requests[num++] = requests[i];
+	}
+	requests.SetNum( num, false );
+
+	// the worker doesn't look at the flag, so it can be set while it runs
+	for ( int i = 0; i < jobs.Num(); i++ ) {
+		if ( jobs[i].world == world && jobs[i].entityHandle == entityHandle ) {
+			jobs[i].removed = true;
+		}
+	}
+}
+
+/*
+==================
+idDecalQueue::FreeModel
+==================
+*/
+void idDecalQueue::FreeModel( const idRenderModel *model ) {
+	WaitForWorker();
+
+	int num = 0;
+	for ( int i = 0; i < requests.Num(); i++ ) {
+		if ( requests[i].type == DQ_DECAL && ( model == NULL || requests[i].model == model ) ) {
+			continue;
+		}
+		requests[num++] = requests[i];
+	}
+	requests.SetNum( num, false );
+
+	for ( int i = 0; i < jobs.Num(); i++ ) {
+		if ( model == NULL || jobs[i].model == model ) {
+			jobs[i].removed = true;
+		}
+	}
+}
+
+/*
+==================
+idDecalQueue::FreeWorld
+==================
+*/
+void idDecalQueue::FreeWorld( const idRenderWorldLocal *world ) {
+	WaitForWorker();
+
+	int num = 0;
+	for ( int i = 0; i < requests.Num(); i++ ) {
+		if ( requests[i].world != world ) {
+			requests[num++] = requests[i];
+		}
+	}
+	requests.SetNum( num, false );
+
+	for ( int i = 0; i < jobs.Num(); i++ ) {
+		if ( jobs[i].world == world ) {
+			jobs[i].removed = true;
+		}
+	}
+}
+
+/*
+==================
+idDecalQueue::IsClipping
+
+Only used by asserts, the worker clips every job, removed or not.
+==================
+*/
+bool idDecalQueue::IsClipping( const srfTriangles_t *tri ) const {
+	if ( !workerRunning || tri == NULL ) {
+		return false;
+	}
+	for ( int i = 0; i < jobs.Num(); i++ ) {
+		const idRenderModel *model = jobs[i].model;
+		for ( int j = 0; j < model->NumSurfaces(); j++ ) {
+			if ( model->Surface( j )->geometry == tri ) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/*
+==================
+idDecalQueue::ClearStats
+==================
+*/
+void idDecalQueue::ClearStats( void ) {
+	memset( &stats, 0, sizeof( stats ) );
+	stats.peakQueued = requests.Num();
+}
+
+/*
+===============
+R_DecalQueueStats_f
+
+Prints the decal queue counters, "decalQueueStats clear" starts over.
+===============
+*/
+void R_DecalQueueStats_f( const idCmdArgs &args ) {
+	const decalQueueStats_t &s = decalQueue.GetStats();
+
+	if ( args.Argc() > 1 && !idStr::Icmp( args.Argv( 1 ), "clear" ) ) {
+		decalQueue.ClearStats();
+		return;
+	}
+
+	if ( !r_asyncDecals.GetBool() ) {
+		common->Printf( "r_asyncDecals is off\n" );
+	}
+
+	common->Printf( "projections: %i queued, %i coalesced, %i dropped, %i processed, peak queue %i\n", s.numQueued, s.numCoalesced, s.numDropped, s.numProcessed, s.peakQueued );
+	common->Printf( "jobs: %i clipped, %i published, %i stale, %i clipped again on the main thread\n", s.numJobs, s.numPublished, s.numStale, s.numOverflows );
+	if ( s.numPublished ) {
+		common->Printf( "latency: %.1f msec, %.2f frames average, %i msec, %i frames max\n",
+			(float)s.totalLatencyMsec / s.numPublished, (float)s.totalLatencyFrames / s.numPublished, s.maxLatencyMsec, s.maxLatencyFrames );
+	}
+}
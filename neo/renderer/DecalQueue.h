@@ -0,0 +1,179 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#ifndef __DECALQUEUE_H__
+#define __DECALQUEUE_H__
+
+#include "idlib/containers/List.h"
+#include "sys/sys_public.h"
+#include "renderer/tr_local.h"
+
+/*
+===============================================================================
+
+	Decal projection queue.
+
+	With r_asyncDecals set, ProjectDecalOntoWorld, ProjectDecal and
+	ProjectOverlay only queue the projection.  A decal is queued once for
+	every static entity it touches, already moved into the model space of
+	the entity, so it ends up where a synchronous decal would even if the
+	entity moves before it is clipped.  A projection that lands on a
+	queued one of the same material is merged into it.
+
+	The first scene rendered in a frame takes up to r_decalBudget queued
+	projections and turns them into jobs.  The jobs are clipped on a
+	worker thread against the verts, indexes and face planes of the model
+	surfaces themselves, not copies.  Static surfaces are not changed until
+	the model is freed, so freeing a model or a world waits for the
+	worker, and the trisurf functions that change or free the geometry
+	assert that the worker isn't clipping the surface.  The next frame adds the clipped windings to the entity
+	decals, after checking that the entity still has the same model.
+	Builds without threads clip the jobs right away.
+
+	Overlays follow the animated model of the entity, so they are created
+	on the main thread when they are taken off the queue.
+
+===============================================================================
+*/
+
+typedef enum {
+	DQ_DECAL,
+	DQ_OVERLAY
+} decalRequestType_t;
+
+typedef struct {
+	decalRequestType_t			type;
+	idRenderWorldLocal *		world;
+	qhandle_t					entityHandle;
+	const idRenderEntityLocal *	def;				// decals only, must still be the entity when processed
+	const idRenderModel *		model;				// decals only, the model the decal was projected on
+	decalProjectionInfo_t		info;				// global projection of decals, for merging
+	decalProjectionInfo_t		localInfo;			// the same projection in model space
+	idPlane						localTextureAxis[2];	// overlays only
+	const idMaterial *			material;
+	int							queueTime;			// Sys_Milliseconds when queued
+	int							queueFrame;
+} decalRequest_t;
+
+typedef struct {
+	idRenderWorldLocal *		world;
+	qhandle_t					entityHandle;
+	const idRenderEntityLocal *	def;				// must still be the entity when published
+	const idRenderModel *		model;				// surfaces the job is clipped against
+	decalProjectionInfo_t		localInfo;
+	int							queueTime;
+	int							queueFrame;
+	bool						clipped;			// false if the windings didn't fit the clip buffers
+	bool						removed;			// entity decals were removed or the model freed
+	int							firstFacePlanes;	// in clipFacePlanes, one for each model surface
+	int							firstPoint;
+	int							firstWinding;
+	int							numWindings;
+} decalJob_t;
+
+typedef struct {
+	int							numQueued;			// projections that went into the queue
+	int							numCoalesced;		// projections merged into a queued one
+	int							numDropped;			// projections that found the queue full
+	int							numProcessed;		// projections taken off the queue
+	int							numJobs;			// models clipped
+	int							numPublished;		// jobs added to entity decals
+	int							numStale;			// decals whose entity changed before publishing
+	int							numOverflows;		// jobs clipped again on the main thread
+	int							peakQueued;
+	int							totalLatencyMsec;	// from queueing to publishing, summed over the jobs
+	int							maxLatencyMsec;
+	int							totalLatencyFrames;
+	int							maxLatencyFrames;
+} decalQueueStats_t;
+
+class idDecalQueue {
+public:
+								idDecalQueue( void );
+
+	void						Shutdown( void );
+
+								// Returns false if the projection must be done right away.
+	bool						QueueDecal( idRenderWorldLocal *world, const idRenderEntityLocal *def, const decalProjectionInfo_t &info );
+	bool						QueueOverlay( idRenderWorldLocal *world, qhandle_t entityHandle, const idPlane localTextureAxis[2], const idMaterial *material );
+
+								// Publishes the jobs of the last frame and starts the next ones.
+								// Only the first call of a frame does anything.
+	void						RunFrame( void );
+
+								// Drops the queued projections and jobs of an entity.
+	void						RemoveDecals( const idRenderWorldLocal *world, qhandle_t entityHandle );
+
+								// Waits for the worker and drops everything that references the model
+								// or world.  A NULL model drops the decals of all models.
+	void						FreeModel( const idRenderModel *model );
+	void						FreeWorld( const idRenderWorldLocal *world );
+
+								// True while the worker may read the geometry of the surface.
+	bool						IsClipping( const srfTriangles_t *tri ) const;
+
+	const decalQueueStats_t &	GetStats( void ) const { return stats; }
+	void						ClearStats( void );
+
+private:
+	static const int			MAX_QUEUED_DECALS = 512;
+	static const int			MAX_CLIP_POINTS = 1 << 14;
+	static const int			MAX_CLIP_WINDINGS = 1 << 12;
+
+	idList<decalRequest_t>		requests;
+	idList<decalJob_t>			jobs;				// jobs started last frame
+	int							frameCount;			// tr.frameCount of the last RunFrame
+
+	decalClip_t					clip;				// shared by all the jobs of a frame
+	idList<const idPlane *>		clipFacePlanes;		// face planes of the surfaces at AddJob time
+	idList<idVec5>				clipPoints;
+	idList<int>					clipWindingPoints;
+	idList<byte>				clipCullBits;
+
+	bool						workerRunning;
+	xthreadInfo					workerThread;
+
+	decalQueueStats_t			stats;
+
+	bool						Enqueue( const decalRequest_t &request );
+	bool						Coalesce( const decalRequest_t &request ) const;
+	void						AddJob( const decalRequest_t &request );
+	void						ProcessRequest( const decalRequest_t &request );
+	void						WaitForWorker( void );
+	void						PublishJobs( void );
+	void						StartJobs( void );
+
+	static int					ClipThread( void *parm );
+	void						ClipJobs( void );
+};
+
+extern idDecalQueue				decalQueue;
+
+void R_DecalQueueStats_f( const idCmdArgs &args );
+
+#endif /* !__DECALQUEUE_H__ */
@@ -150,6 +150,10 @@ typedef enum {
 
 #define	MAX_IMAGE_NAME	256
 
+#ifndef NOMT
+const int MAX_IMAGE_LOAD_THREADS = 8;
+#endif
+
 class idImage {
 public:
 				idImage();
@@ -219,6 +223,7 @@ public:
 	bool				backgroundLoadInProgress;	// true if another thread is reading the complete d3t file
 	backgroundDownload_t	bgl;
 	idImage *			bglNext;				// linked from tr.backgroundImageLoads
+	bool				prefetchQueued;			// in globalImages->prefetchQueue
 
 	// parameters that define this image
 	idStr				imgName;				// game path, including extension (except for cube maps), may be an image program
@@ -227,6 +232,7 @@ public:
 	textureFilter_t		filter;
 	textureRepeat_t		repeat;
 	textureDepth_t		depth;
+	textureDepth_t		cacheDepth;				// depth before the image program changed it, keys the image cache
 	cubeFiles_t			cubeFiles;				// determines the naming and flipping conventions for the six images
 
 	bool				referencedOutsideLevelLoad;
@@ -258,12 +264,14 @@ ID_INLINE idImage::idImage() {
 	bgl.opcode = DLTYPE_FILE;
 	bgl.f = NULL;
 	bglNext = NULL;
+	prefetchQueued = false;
 	imgName[0] = '\0';
 	generatorFunction = NULL;
 	allowDownSize = false;
 	filter = TF_DEFAULT;
 	repeat = TR_REPEAT;
 	depth = TD_DEFAULT;
+	cacheDepth = TD_DEFAULT;
 	cubeFiles = CF_2D;
 	referencedOutsideLevelLoad = false;
 	levelLoadReferenced = false;
@@ -343,6 +351,20 @@ public:
 
 	void				PrintMemInfo( MemInfo_t *mi );
 
+	// residency management, see Image_residency.cpp
+	// file based images are kept in cacheLRU while they are loaded
+	void				AddResidentImage( idImage *image, bool stall );
+	void				RemoveResidentImage( idImage *image );
+	void				TouchResidentImage( idImage *image );
+
+	// queued images are streamed in by UpdateResidency and are never evicted
+	void				ClearPrefetchQueue();
+	void				PrefetchImage( idImage *image );
+
+	// called once a frame to stream in queued images and evict
+	// the least recently bound ones when over image_residencyBudget
+	void				UpdateResidency();
+
 	// cvars
 	static idCVar		image_roundDown;			// round bad sizes down to nearest power of two
 	static idCVar		image_colorMipLevels;		// development aid to see texture mip usage
@@ -353,6 +375,7 @@ public:
 	static idCVar		image_writeNormalTGAPalletized;		// debug tool to write out palletized versions of the final normal maps
 	static idCVar		image_writeTGA;				// debug tool to write out .tgas of the non normal maps
 	static idCVar		image_preload;				// if 0, dynamically load all images
+	static idCVar		image_useCache;				// store processed mip chains in fs_savepath
 	static idCVar		image_showBackgroundLoads;	// 1 = print number of outstanding background loads
 	static idCVar		image_forceDownSize;		// allows the ability to force a downsize
 	static idCVar		image_downSizeSpecular;		// downsize specular
@@ -360,6 +383,13 @@ public:
 	static idCVar		image_downSizeBump;			// downsize bump maps
 	static idCVar		image_downSizeBumpLimit;	// downsize bump limit
 	static idCVar		image_downSizeLimit;		// downsize diffuse limit
+	static idCVar		image_residencyBudget;		// megs of file based images to keep loaded, 0 = unlimited
+	static idCVar		image_prefetchDepth;		// portal steps from the view area to prefetch images for
+	static idCVar		image_prefetchMsec;			// time spent each frame loading prefetched images
+	static idCVar		image_showResidency;		// print per frame streaming statistics
+#ifndef NOMT
+	static idCVar		image_loadThreads;			// worker threads that build mip chains at level load
+#endif
 
 	// built-in images
 	idImage *			defaultImage;
@@ -413,12 +443,25 @@ public:
 
 	int	numActiveBackgroundImageLoads;
 	const static int MAX_BACKGROUND_IMAGE_LOADS = 8;
+
+	idList<idImage*>	prefetchQueue;				// nearest areas first
+	int					prefetchNext;				// first entry that may still need loading
+
+	// per frame residency statistics
+	int					residencyStalls;			// images loaded on demand by the back end
+	int					residencyPrefetches;
+	int					residencyEvictions;
+	int					residencyBytesStreamed;
 };
 
 extern idImageManager	*globalImages;		// pointer to global list for the rest of the system
 
 int MakePowerOfTwo( int num );
 
+// loads file based images like ActuallyLoadImage, building the
+// mip chains on image_loadThreads worker threads unless NOMT
+void R_LoadImageList( idImage * const *images, int numImages );
+
 /*
 ====================================================================
 
@@ -434,6 +477,7 @@ byte *R_ResampleTexture( const byte *in, int inwidth, int inheight,
 							int outwidth, int outheight );
 byte *R_MipMapWithAlphaSpecularity( const byte *in, int width, int height );
 byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder );
+void R_MipMapInto( byte *out, const byte *in, int width, int height, bool preserveBorder );
 byte *R_MipMap3D( const byte *in, int width, int height, int depth, bool preserveBorder );
 
 // these operate in-place on the provided pixels
@@ -467,4 +511,26 @@ IMAGEPROGRAM
 void R_LoadImageProgram( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp, textureDepth_t *depth = NULL );
 const char *R_ParsePastImageProgram( idLexer &src );
 
+/*
+====================================================================
+
+IMAGECACHE
+
+====================================================================
+*/
+
+// uploads the image from the processed image cache, returns false on a miss
+bool	R_LoadCachedImage( idImage *image );
+// collects the mip levels passed to qglTexImage2D, returns NULL if the image isn't cached
+idFile *R_BeginCachedImage( const idImage *image );
+void	R_WriteCachedImageLevel( idFile *f, const byte *data, int width, int height );
+void	R_FinishCachedImage( const idImage *image, idFile *f );
+// writes a mip chain that is already in the cache layout
+void	R_StoreCachedImage( const idImage *image, const byte *levels, int length );
+// uploads a mip chain in the cache layout as the new texture of the image
+void	R_UploadImageLevels( idImage *image, const byte *levels, int numLevels );
+void	R_PrintImageCacheStats( void );
+void	R_ImageCacheStats_f( const idCmdArgs &args );
+void	R_PurgeImageCache_f( const idCmdArgs &args );
+
 #endif
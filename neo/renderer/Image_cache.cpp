@@ -0,0 +1,385 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "sys/platform.h"
+#include "idlib/hashing/MD5.h"
+#include "framework/Compressor.h"
+#include "renderer/tr_local.h"
+
+#include "renderer/Image.h"
+
+/*
+
+The image cache stores the final mip chain of file based images, exactly as
+it is handed to qglTexImage2D, so a later load can skip decoding, image programs,
+downsampling and mip map generation.
+
+Entries live in fs_savepath under imagecache/.  The file name is a hash of the
+image program string together with everything that changes the processing
+(repeat mode, requested depth, downsize settings, maximum texture size).  The
+header repeats the full key and the newest source timestamp, so hash collisions
+and stale entries are detected and simply count as a miss.  Image programs like
+heightmap turn the image into a bump map, so the header also keeps the depth
+the image ended up with.
+
+*/
+
+#define IMAGE_CACHE_ID			"IMGCACHE"
+#define IMAGE_CACHE_VERSION		3
+#define IMAGE_CACHE_DIR			"imagecache"
+#define IMAGE_CACHE_EXTENSION	".icache"
+
+static int		imageCacheHits;
+static int		imageCacheMisses;
+static int		imageCacheWrites;
+static double	imageCacheBytesRead;
+static double	imageCacheBytesWritten;
+
+/*
+================
+R_ImageCacheEnabled
+
+The debug cvars that write or tint the generated images bypass the cache.
+================
+*/
+static bool R_ImageCacheEnabled( void ) {
+	if ( !glConfig.isInitialized || !globalImages->image_useCache.GetBool() ) {
+		return false;
+	}
+	if ( globalImages->image_colorMipLevels.GetBool() || globalImages->image_writeTGA.GetBool()
+		|| globalImages->image_writeNormalTGA.GetBool() || globalImages->image_writeNormalTGAPalletized.GetBool() ) {
+		return false;
+	}
+	return true;
+}
+
+/*
+================
+R_ImageCacheKey
+================
+*/
+static void R_ImageCacheKey( const idImage *image, idStr &key ) {
+	sprintf( key, "%s repeat %i depth %i allowDownSize %i downSize %i %i %i %i %i %i %i round %i max %i",
+		image->imgName.c_str(), image->repeat, image->cacheDepth, image->allowDownSize,
+		globalImages->image_downSize.GetInteger(), globalImages->image_forceDownSize.GetInteger(),
+		globalImages->image_downSizeLimit.GetInteger(),
+		globalImages->image_downSizeSpecular.GetInteger(), globalImages->image_downSizeSpecularLimit.GetInteger(),
+		globalImages->image_downSizeBump.GetInteger(), globalImages->image_downSizeBumpLimit.GetInteger(),
+		globalImages->image_roundDown.GetInteger(), glConfig.maxTextureSize );
+}
+
+/*
+================
+R_ImageCacheFileName
+================
+*/
+static const char *R_ImageCacheFileName( const idStr &key ) {
+	return va( IMAGE_CACHE_DIR "/%08x" IMAGE_CACHE_EXTENSION, MD5_BlockChecksum( key.c_str(), key.Length() ) );
+}
+
+/*
+================
+R_LoadCachedImage
+
+Returns false on a miss, in which case the image is untouched.
+================
+*/
+bool R_LoadCachedImage( idImage *image ) {
+	ID_TIME_T	current;
+	idStr		key, storedKey, id;
+	int			version, timestamp, depth, imageHash, payloadLength;
+
+	if ( !R_ImageCacheEnabled() ) {
+		return false;
+	}
+
+	R_LoadImageProgram( image->imgName, NULL, NULL, NULL, &current );
+	if ( current == 0 || current == FILE_NOT_FOUND_TIMESTAMP ) {
+		imageCacheMisses++;
+		return false;
+	}
+
+	R_ImageCacheKey( image, key );
+
+	idFile *f = fileSystem->OpenFileRead( R_ImageCacheFileName( key ) );
+	if ( !f ) {
+		imageCacheMisses++;
+		return false;
+	}
+
+	f->ReadString( id );
+	f->ReadInt( version );
+	f->ReadInt( timestamp );
+	f->ReadString( storedKey );
+	f->ReadInt( depth );
+	f->ReadInt( imageHash );
+	f->ReadInt( payloadLength );
+
+	if ( id != IMAGE_CACHE_ID || version != IMAGE_CACHE_VERSION || timestamp != (int)current || storedKey != key || payloadLength <= 0 ) {
+		fileSystem->CloseFile( f );
+		imageCacheMisses++;
+		return false;
+	}
+
+	// read the whole mip chain before touching the texture, so a truncated
+	// file doesn't leave a half uploaded image behind
+	byte *payload = (byte *)R_StaticAlloc( payloadLength );
+
+	idCompressor *compressor = idCompressor::AllocLZW();
+	compressor->Init( f, false, 8 );
+	int read = compressor->Read( payload, payloadLength );
+	delete compressor;
+	fileSystem->CloseFile( f );
+
+	if ( read != payloadLength ) {
+		R_StaticFree( payload );
+		imageCacheMisses++;
+		return false;
+	}
+
+	// validate the level layout
+	int numLevels = 0;
+	for ( int offset = 0; offset < payloadLength; numLevels++ ) {
+		const int *dims = (const int *)( payload + offset );
+		int width = LittleInt( dims[0] );
+		int height = LittleInt( dims[1] );
+		if ( width < 1 || height < 1 || offset + 8 + width * height * 4 > payloadLength ) {
+			numLevels = 0;
+			break;
+		}
+		offset += 8 + width * height * 4;
+	}
+
+	if ( !numLevels ) {
+		common->Warning( "R_LoadCachedImage: bad cache entry for %s", image->imgName.c_str() );
+		R_StaticFree( payload );
+		imageCacheMisses++;
+		return false;
+	}
+
+	image->depth = (textureDepth_t)depth;
+	R_UploadImageLevels( image, payload, numLevels );
+
+	R_StaticFree( payload );
+
+	image->timestamp = current;
+	image->imageHash = imageHash;
+
+	imageCacheHits++;
+	imageCacheBytesRead += payloadLength;
+
+	return true;
+}
+
+/*
+================
+R_UploadImageLevels
+
+Uploads a mip chain in the cache layout, one [ width, height, texels ]
+block per level, as the new 2D texture of the image.
+================
+*/
+void R_UploadImageLevels( idImage *image, const byte *levels, int numLevels ) {
+	image->PurgeImage();
+
+	qglGenTextures( 1, &image->texnum );
+	image->internalFormat = GL_RGBA;
+	image->type = TT_2D;
+	image->Bind();
+
+	for ( int level = 0, offset = 0; level < numLevels; level++ ) {
+		const int *dims = (const int *)( levels + offset );
+		int width = LittleInt( dims[0] );
+		int height = LittleInt( dims[1] );
+
+		if ( level == 0 ) {
+			image->uploadWidth = width;
+			image->uploadHeight = height;
+		}
+
+		qglTexImage2D( GL_TEXTURE_2D, level, image->internalFormat, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, levels + offset + 8 );
+
+		offset += 8 + width * height * 4;
+	}
+
+	image->SetImageFilterAndRepeat();
+
+	GL_CheckErrors();
+}
+
+/*
+================
+R_ImageCacheWanted
+================
+*/
+static bool R_ImageCacheWanted( const idImage *image ) {
+	if ( image->generatorFunction || image->cubeFiles != CF_2D || !R_ImageCacheEnabled() ) {
+		return false;
+	}
+	if ( image->timestamp == 0 || image->timestamp == FILE_NOT_FOUND_TIMESTAMP ) {
+		return false;
+	}
+	return true;
+}
+
+/*
+================
+R_BeginCachedImage
+
+Returns a memory file that collects the mip levels, or NULL if the
+image shouldn't be cached.
+================
+*/
+idFile *R_BeginCachedImage( const idImage *image ) {
+	if ( !R_ImageCacheWanted( image ) ) {
+		return NULL;
+	}
+
+	idFile_Memory *f = new idFile_Memory( image->imgName );
+	f->SetGranularity( 256 * 1024 );
+	return f;
+}
+
+/*
+================
+R_WriteCachedImageLevel
+================
+*/
+void R_WriteCachedImageLevel( idFile *f, const byte *data, int width, int height ) {
+	if ( !f ) {
+		return;
+	}
+	f->WriteInt( width );
+	f->WriteInt( height );
+	f->Write( data, width * height * 4 );
+}
+
+/*
+================
+R_FinishCachedImage
+
+Stores the collected mip chain and frees the memory file.
+================
+*/
+void R_FinishCachedImage( const idImage *image, idFile *f ) {
+	if ( !f ) {
+		return;
+	}
+
+	idFile_Memory *payload = static_cast<idFile_Memory *>( f );
+	R_StoreCachedImage( image, (const byte *)payload->GetDataPtr(), payload->Length() );
+	delete payload;
+}
+
+/*
+================
+R_StoreCachedImage
+
+Compresses a mip chain in the cache layout to fs_savepath.
+================
+*/
+void R_StoreCachedImage( const idImage *image, const byte *levels, int length ) {
+	idStr key;
+
+	if ( !R_ImageCacheWanted( image ) ) {
+		return;
+	}
+
+	R_ImageCacheKey( image, key );
+
+	idFile *out = fileSystem->OpenFileWrite( R_ImageCacheFileName( key ) );
+	if ( !out ) {
+		common->Warning( "R_StoreCachedImage: couldn't write cache entry for %s", image->imgName.c_str() );
+		return;
+	}
+
+	out->WriteString( IMAGE_CACHE_ID );
+	out->WriteInt( IMAGE_CACHE_VERSION );
+	out->WriteInt( (int)image->timestamp );
+	out->WriteString( key );
+	out->WriteInt( image->depth );
+	out->WriteInt( image->imageHash );
+	out->WriteInt( length );
+
+	idCompressor *compressor = idCompressor::AllocLZW();
+	compressor->Init( out, true, 8 );
+	compressor->Write( levels, length );
+	compressor->FinishCompress();
+	delete compressor;
+
+	imageCacheWrites++;
+	imageCacheBytesWritten += out->Length();
+
+	fileSystem->CloseFile( out );
+}
+
+/*
+================
+R_PrintImageCacheStats
+================
+*/
+void R_PrintImageCacheStats( void ) {
+	if ( !globalImages->image_useCache.GetBool() ) {
+		return;
+	}
+	common->Printf( "%5i image cache hits, %i misses, %i written\n", imageCacheHits, imageCacheMisses, imageCacheWrites );
+}
+
+/*
+================
+R_ImageCacheStats_f
+================
+*/
+void R_ImageCacheStats_f( const idCmdArgs &args ) {
+	common->Printf( "image cache is %s\n", globalImages->image_useCache.GetBool() ? "enabled" : "disabled" );
+	common->Printf( "%5i hits, %6.1f MB read\n", imageCacheHits, imageCacheBytesRead / ( 1024 * 1024 ) );
+	common->Printf( "%5i misses\n", imageCacheMisses );
+	common->Printf( "%5i writes, %6.1f MB written\n", imageCacheWrites, imageCacheBytesWritten / ( 1024 * 1024 ) );
+}
+
+/*
+================
+R_PurgeImageCache_f
+================
+*/
+void R_PurgeImageCache_f( const idCmdArgs &args ) {
+	idFileList *files = fileSystem->ListFiles( IMAGE_CACHE_DIR, IMAGE_CACHE_EXTENSION, false, true );
+
+	for ( int i = 0; i < files->GetNumFiles(); i++ ) {
+		fileSystem->RemoveFile( files->GetFile( i ) );
+	}
+	common->Printf( "removed %i image cache entries\n", files->GetNumFiles() );
+
+	fileSystem->FreeFileList( files );
+
+	imageCacheHits = 0;
+	imageCacheMisses = 0;
+	imageCacheWrites = 0;
+	imageCacheBytesRead = 0;
+	imageCacheBytesWritten = 0;
+}
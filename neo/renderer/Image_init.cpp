@@ -35,10 +35,6 @@ If you have questions concerning this license or the applicable additional terms
 
 #include "framework/GameCallbacks_local.h"
 
-#ifdef __EMSCRIPTEN__
-#include "emscripten.h"
-#endif
-
 const char *imageFilter[] = {
 	"GL_LINEAR_MIPMAP_NEAREST",
 	"GL_LINEAR_MIPMAP_LINEAR",
@@ -53,7 +49,15 @@ idCVar idImageManager::image_filter( "image_filter", imageFilter[1], CVAR_RENDER
 idCVar idImageManager::image_anisotropy( "image_anisotropy", "1", CVAR_RENDERER | CVAR_ARCHIVE, "set the maximum texture anisotropy if available" );
 idCVar idImageManager::image_colorMipLevels( "image_colorMipLevels", "0", CVAR_RENDERER | CVAR_BOOL, "development aid to see texture mip usage" );
 idCVar idImageManager::image_preload( "image_preload", "1", CVAR_RENDERER | CVAR_BOOL | CVAR_ARCHIVE, "if 0, dynamically load all images" );
+idCVar idImageManager::image_useCache( "image_useCache", "0", CVAR_RENDERER | CVAR_BOOL | CVAR_ARCHIVE, "store fully processed images in fs_savepath and load them from there while the sources are unchanged" );
 idCVar idImageManager::image_showBackgroundLoads( "image_showBackgroundLoads", "0", CVAR_RENDERER | CVAR_BOOL, "1 = print number of outstanding background loads" );
+idCVar idImageManager::image_residencyBudget( "image_residencyBudget", "0", CVAR_RENDERER | CVAR_INTEGER | CVAR_ARCHIVE, "megs of file based images to keep loaded, the least recently bound ones are purged above it, 0 = unlimited" );
+idCVar idImageManager::image_prefetchDepth( "image_prefetchDepth", "2", CVAR_RENDERER | CVAR_INTEGER | CVAR_ARCHIVE, "queue images for areas up to this many portals away from the view, -1 = disable" );
+idCVar idImageManager::image_prefetchMsec( "image_prefetchMsec", "4", CVAR_RENDERER | CVAR_INTEGER | CVAR_ARCHIVE, "milliseconds spent each frame loading queued images" );
+idCVar idImageManager::image_showResidency( "image_showResidency", "0", CVAR_RENDERER | CVAR_BOOL, "print image stalls, prefetches, evictions and bytes streamed each frame" );
+#ifndef NOMT
+idCVar idImageManager::image_loadThreads( "image_loadThreads", "2", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_INTEGER, "number of worker threads that build mip chains at level load, 0 builds them on the main thread", 0, MAX_IMAGE_LOAD_THREADS );
+#endif
 #if 1
 idCVar idImageManager::image_downSize( "image_downSize", "0", CVAR_RENDERER | CVAR_ROM, "controls texture downsampling" );
 idCVar idImageManager::image_forceDownSize( "image_forceDownSize", "0", CVAR_RENDERER | CVAR_ROM | CVAR_BOOL, "" );
@@ -1684,6 +1688,105 @@ void R_CombineCubeImages_f( const idCmdArgs &args ) {
 	common->SetRefreshOnPrint( false );
 }
 
+/*
+===============
+R_BenchmarkImages_f
+
+Decodes every image in a pk4 (or under a directory, including the ones
+inside pk4s), then decodes them again and builds the full mip chain, and
+reports the throughput of both stages.  Images of a pk4 that are overridden
+by a later search path are read from there.  No rendering context is needed.
+===============
+*/
+void R_BenchmarkImages_f( const idCmdArgs &args ) {
+	static const char *extensions[] = { ".tga", ".jpg", ".pcx", ".bmp" };
+	const char	*dir;
+	idStrList	files;
+	int			msec[2];
+	int			loaded = 0;
+	int			failed = 0;
+	double		decodedBytes = 0;
+	double		mipBytes = 0;
+
+	if ( args.Argc() > 2 ) {
+		common->Printf( "usage: benchmarkImages [pk4 or directory]\n" );
+		return;
+	}
+	dir = ( args.Argc() == 2 ) ? args.Argv( 1 ) : "textures";
+
+	bool pak = idStr::CheckExtension( dir, ".pk4" );
+
+	for ( int i = 0 ; i < (int)( sizeof( extensions ) / sizeof( extensions[0] ) ) ; i++ ) {
+		idFileList *list = pak ? fileSystem->ListPakFiles( dir, extensions[i] ) : fileSystem->ListFilesTree( dir, extensions[i] );
+		if ( !list ) {
+			common->Printf( "%s is not in the search path\n", dir );
+			return;
+		}
+		for ( int j = 0 ; j < list->GetNumFiles() ; j++ ) {
+			files.Append( list->GetFile( j ) );
+		}
+		fileSystem->FreeFileList( list );
+	}
+
+	if ( !files.Num() ) {
+		common->Printf( "no images found in %s\n", dir );
+		return;
+	}
+
+	common->Printf( "benchmarking %i images from %s using %s\n", files.Num(), dir, SIMDProcessor->GetName() );
+
+	// the first pass only decodes, the second one also builds the mip chain
+	for ( int pass = 0 ; pass < 2 ; pass++ ) {
+		int start = Sys_Milliseconds();
+
+		for ( int i = 0 ; i < files.Num() ; i++ ) {
+			byte	*pic;
+			int		width, height;
+
+			R_LoadImage( files[i], &pic, &width, &height, NULL, true );
+			if ( !pic ) {
+				if ( pass == 0 ) {
+					failed++;
+				}
+				continue;
+			}
+
+			if ( pass == 0 ) {
+				loaded++;
+				decodedBytes += width * height * 4;
+			} else {
+				while ( width > 1 || height > 1 ) {
+					byte *shrunk = R_MipMap( pic, width, height, false );
+					R_StaticFree( pic );
+					pic = shrunk;
+
+					mipBytes += width * height * 4;
+
+					width >>= 1;
+					height >>= 1;
+					if ( width < 1 ) {
+						width = 1;
+					}
+					if ( height < 1 ) {
+						height = 1;
+					}
+				}
+			}
+
+			R_StaticFree( pic );
+		}
+
+		msec[pass] = Sys_Milliseconds() - start;
+	}
+
+	int decodeMsec = Max( msec[0], 1 );
+	int mipMsec = Max( msec[1] - msec[0], 1 );
+
+	common->Printf( "%5i images loaded, %i failed\n", loaded, failed );
+	common->Printf( "decode: %6.1f MB in %5i msec, %6.1f MB/s\n", decodedBytes / ( 1024 * 1024 ), decodeMsec, decodedBytes * 1000.0 / ( 1024 * 1024 * decodeMsec ) );
+	common->Printf( "mipmap: %6.1f MB in %5i msec, %6.1f MB/s\n", mipBytes / ( 1024 * 1024 ), mipMsec, mipBytes * 1000.0 / ( 1024 * 1024 * mipMsec ) );
+}
+
 /*
 ===============
 CheckCvars
@@ -1742,6 +1845,13 @@ void idImageManager::Init() {
 	// clear the cached LRU
 	cacheLRU.cacheUsageNext = &cacheLRU;
 	cacheLRU.cacheUsagePrev = &cacheLRU;
+	totalCachedImageSize = 0;
+
+	prefetchNext = 0;
+	residencyStalls = 0;
+	residencyPrefetches = 0;
+	residencyEvictions = 0;
+	residencyBytesStreamed = 0;
 
 	// set default texture filter modes
 	ChangeTextureFilter();
@@ -1776,6 +1886,9 @@ void idImageManager::Init() {
 	cmdSystem->AddCommand( "reloadImages", R_ReloadImages_f, CMD_FL_RENDERER, "reloads images" );
 	cmdSystem->AddCommand( "listImages", R_ListImages_f, CMD_FL_RENDERER, "lists images" );
 	cmdSystem->AddCommand( "combineCubeImages", R_CombineCubeImages_f, CMD_FL_RENDERER, "combines six images for roq compression" );
+	cmdSystem->AddCommand( "imageCacheStats", R_ImageCacheStats_f, CMD_FL_RENDERER, "prints processed image cache statistics" );
+	cmdSystem->AddCommand( "purgeImageCache", R_PurgeImageCache_f, CMD_FL_RENDERER, "removes all processed image cache entries" );
+	cmdSystem->AddCommand( "benchmarkImages", R_BenchmarkImages_f, CMD_FL_RENDERER, "decodes and mipmaps every image in a pk4 or directory and reports throughput" );
 
 	// should forceLoadImages be here?
 }
@@ -1786,6 +1899,7 @@ Shutdown
 ===============
 */
 void idImageManager::Shutdown() {
+	ClearPrefetchQueue();
 	images.DeleteContents( true );
 }
 
@@ -1802,6 +1916,9 @@ loading the actual data.
 void idImageManager::BeginLevelLoad() {
 	insideLevelLoad = true;
 
+	// the queue refers to the previous level's areas
+	ClearPrefetchQueue();
+
 	for ( int i = 0 ; i < images.Num() ; i++ ) {
 		idImage	*image = images[ i ];
 
@@ -1864,6 +1981,7 @@ void idImageManager::EndLevelLoad() {
 	}
 
 	// load the ones we do need, if we are preloading
+	idList<idImage *> loadList;
 	for ( int i = 0 ; i < images.Num() ; i++ ) {
 		idImage	*image = images[ i ];
 		if ( image->generatorFunction ) {
@@ -1872,22 +1990,17 @@ void idImageManager::EndLevelLoad() {
 
 		if ( image->levelLoadReferenced && image->texnum == idImage::TEXTURE_NOT_LOADED ) {
 //			common->Printf( "Loading %s\n", image->imgName.c_str() );
-			loadCount++;
-			image->ActuallyLoadImage( false );
-
-			if ( ( loadCount & 15 ) == 0 ) {
-				session->PacifierUpdate();
-#ifdef __EMSCRIPTEN__
-        emscripten_sleep(1);
-#endif
-			}
+			loadList.Append( image );
 		}
 	}
+	loadCount = loadList.Num();
+	R_LoadImageList( loadList.Ptr(), loadList.Num() );
 
 	int	end = Sys_Milliseconds();
 	common->Printf( "%5i purged from previous\n", purgeCount );
 	common->Printf( "%5i kept from previous\n", keepCount );
 	common->Printf( "%5i new loaded\n", loadCount );
+	R_PrintImageCacheStats();
 	common->Printf( "all images loaded in %5.1f seconds\n", (end-start) * 0.001 );
 }
 
@@ -28,10 +28,15 @@ If you have questions concerning this license or the applicable additional terms
 
 #include "sys/platform.h"
 #include "idlib/hashing/MD4.h"
+#include "framework/Session.h"
 #include "renderer/tr_local.h"
 
 #include "renderer/Image.h"
 
+#ifdef __EMSCRIPTEN__
+#include "emscripten.h"
+#endif
+
 
 int MakePowerOfTwo( int num ) {
 	int		pot;
@@ -438,11 +443,15 @@ void idImage::GenerateImage( const byte *pic, int width, int height,
 			scaledBuffer[ i ] = 0;
 		}
 	}
+	// collect the levels for the processed image cache
+	idFile *cacheFile = R_BeginCachedImage( this );
+
 	// upload the main image level
 	Bind();
 
 
 	qglTexImage2D( GL_TEXTURE_2D, 0, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer );
+	R_WriteCachedImageLevel( cacheFile, scaledBuffer, scaled_width, scaled_height );
 
 	// create and upload the mip map levels, which we do in all cases, even if we don't think they are needed
 	int		miplevel;
@@ -475,8 +484,11 @@ void idImage::GenerateImage( const byte *pic, int width, int height,
 		// upload the mip map
 			qglTexImage2D( GL_TEXTURE_2D, miplevel, internalFormat, scaled_width, scaled_height,
 				0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer );
+		R_WriteCachedImageLevel( cacheFile, scaledBuffer, scaled_width, scaled_height );
 	}
 
+	R_FinishCachedImage( this, cacheFile );
+
 	if ( scaledBuffer != 0 ) {
 		R_StaticFree( scaledBuffer );
 	}
@@ -698,8 +710,13 @@ void	idImage::ActuallyLoadImage( bool fromBackEnd ) {
 			}
 		}
 	} else {
-		// see if we have a pre-generated image file that is
-		// already image processed and compressed
+		// see if we have a processed copy of the
+		// image in the cache, ready to upload
+		cacheDepth = depth;
+		if ( R_LoadCachedImage( this ) ) {
+			globalImages->AddResidentImage( this, fromBackEnd );
+			return;
+		}
 
 		R_LoadImageProgram( imgName, &pic, &width, &height, &timestamp, &depth );
 
@@ -719,6 +736,336 @@ void	idImage::ActuallyLoadImage( bool fromBackEnd ) {
 
 		R_StaticFree( pic );
 	}
+
+	globalImages->AddResidentImage( this, fromBackEnd );
+}
+
+/*
+===============================================================================
+
+	Level load batches
+
+	R_LoadImageList loads the file based 2D images of a level in batches.  The
+	heap and the file system aren't thread safe, so the main thread decodes
+	each image, runs its image program and allocates the buffers, then
+	image_loadThreads worker threads downsize the images, build the mip chains
+	in the image cache layout and hash them, and the main thread uploads the
+	levels and writes the image cache entries.  NOMT builds have no worker
+	threads and build the levels on the main thread.
+
+===============================================================================
+*/
+
+// a batch is started once this much memory is waiting for the workers
+const int IMAGE_LOAD_BATCH_BYTES = 64 << 20;
+
+typedef struct {
+	idImage *			image;
+	byte *				pic;				// from R_LoadImageProgram
+	int					width;
+	int					height;
+	int					numDownsizes;		// mip steps from pic down to the first uploaded level
+	byte *				scratch;			// levels between pic and the first uploaded one, NULL if none
+	byte *				levels;				// uploaded mip chain, [ width, height, texels ] per level
+	int					levelsLength;
+	int					numLevels;
+	int					imageHash;
+} imageLoadJob_t;
+
+// an image load that errored out leaves its batch here, the next one frees it
+static idList<imageLoadJob_t>	imageLoadBatch;
+static int						nextImageLoadJob;
+
+#ifndef NOMT
+// set while R_RunImageLoadBatch runs on worker threads
+static bool						imageLoadThreaded;
+#endif
+
+/*
+===============
+R_FreeImageLoadBatch
+===============
+*/
+static void R_FreeImageLoadBatch( void ) {
+	for ( int i = 0; i < imageLoadBatch.Num(); i++ ) {
+		R_StaticFree( imageLoadBatch[i].pic );
+		if ( imageLoadBatch[i].scratch ) {
+			R_StaticFree( imageLoadBatch[i].scratch );
+		}
+		R_StaticFree( imageLoadBatch[i].levels );
+	}
+	imageLoadBatch.Clear();
+}
+
+/*
+===============
+R_WriteImageLevelSize
+===============
+*/
+static byte *R_WriteImageLevelSize( byte *level, int width, int height ) {
+	int *dims = (int *)level;
+	dims[0] = LittleInt( width );
+	dims[1] = LittleInt( height );
+	return level + 8;
+}
+
+/*
+===============
+R_BuildImageLevels
+
+Does what GenerateImage does before the upload.  It doesn't allocate,
+print or touch GL, so it can run on the worker threads.
+===============
+*/
+static void R_BuildImageLevels( imageLoadJob_t &job ) {
+	const idImage *image = job.image;
+	bool preserveBorder = ( image->repeat == TR_CLAMP_TO_ZERO );
+	int width = job.width;
+	int height = job.height;
+	const byte *src = job.pic;
+	byte *scratch = job.scratch;
+	byte *level = job.levels;
+	byte *data;
+
+	// downsize to the first uploaded level
+	for ( int i = 0; i < job.numDownsizes; i++ ) {
+		int newWidth = Max( width >> 1, 1 );
+		int newHeight = Max( height >> 1, 1 );
+		byte *dst = ( i == job.numDownsizes - 1 ) ? level + 8 : scratch;
+
+		R_MipMapInto( dst, src, width, height, preserveBorder );
+
+		src = dst;
+		scratch += newWidth * newHeight * 4;
+		width = newWidth;
+		height = newHeight;
+	}
+	data = R_WriteImageLevelSize( level, width, height );
+	if ( !job.numDownsizes ) {
+		memcpy( data, src, width * height * 4 );
+	}
+
+	// zero the border if desired, allowing clamped projection textures
+	// even after picmip resampling or careless artists.
+	if ( image->repeat == TR_CLAMP_TO_ZERO ) {
+		byte	rgba[4];
+
+		rgba[0] = rgba[1] = rgba[2] = 0;
+		rgba[3] = 255;
+		R_SetBorderTexels( data, width, height, rgba );
+	}
+	if ( image->repeat == TR_CLAMP_TO_ZERO_ALPHA ) {
+		byte	rgba[4];
+
+		rgba[0] = rgba[1] = rgba[2] = 255;
+		rgba[3] = 0;
+		R_SetBorderTexels( data, width, height, rgba );
+	}
+
+	// swap the red and alpha for rxgb support
+	if ( image->depth == TD_BUMP ) {
+		for ( int i = 0; i < width * height * 4; i += 4 ) {
+			data[ i + 3 ] = data[ i ];
+			data[ i ] = 0;
+		}
+	}
+
+	while ( width > 1 || height > 1 ) {
+		int newWidth = Max( width >> 1, 1 );
+		int newHeight = Max( height >> 1, 1 );
+		byte *next = data + width * height * 4;
+		byte *nextData = R_WriteImageLevelSize( next, newWidth, newHeight );
+
+		R_MipMapInto( nextData, data, width, height, preserveBorder );
+
+		data = nextData;
+		width = newWidth;
+		height = newHeight;
+	}
+
+	job.imageHash = MD4_BlockChecksum( job.pic, job.width * job.height * 4 );
+}
+
+/*
+===============
+R_RunImageLoadJobs
+
+Claims the images of the batch one at a time until none are left.
+===============
+*/
+static void R_RunImageLoadJobs( void ) {
+	while ( 1 ) {
+#ifndef NOMT
+		if ( imageLoadThreaded ) {
+			Sys_EnterCriticalSection( CRITICAL_SECTION_FIVE );
+		}
+#endif
+		int job = ( nextImageLoadJob < imageLoadBatch.Num() ) ? nextImageLoadJob++ : -1;
+#ifndef NOMT
+		if ( imageLoadThreaded ) {
+			Sys_LeaveCriticalSection( CRITICAL_SECTION_FIVE );
+		}
+#endif
+
+		if ( job < 0 ) {
+			break;
+		}
+
+		R_BuildImageLevels( imageLoadBatch[job] );
+	}
+}
+
+#ifndef NOMT
+/*
+===============
+R_ImageLoadThread
+===============
+*/
+static int R_ImageLoadThread( void *parm ) {
+	R_RunImageLoadJobs();
+	return 0;
+}
+#endif
+
+/*
+===============
+R_RunImageLoadBatch
+
+Builds the levels of the batch on the worker threads and the calling
+thread, then uploads them and frees the batch.
+===============
+*/
+static void R_RunImageLoadBatch( void ) {
+	nextImageLoadJob = 0;
+
+#ifdef NOMT
+	R_RunImageLoadJobs();
+#else
+	int numThreads = Min( idMath::ClampInt( 0, MAX_IMAGE_LOAD_THREADS, globalImages->image_loadThreads.GetInteger() ), imageLoadBatch.Num() - 1 );
+
+	if ( numThreads <= 0 ) {
+		R_RunImageLoadJobs();
+	} else {
+		xthreadInfo threads[MAX_IMAGE_LOAD_THREADS];
+
+		imageLoadThreaded = true;
+		for ( int i = 0; i < numThreads; i++ ) {
+			Sys_CreateThread( R_ImageLoadThread, NULL, threads[i], "imageload" );
+		}
+		R_RunImageLoadJobs();
+		for ( int i = 0; i < numThreads; i++ ) {
+			Sys_DestroyThread( threads[i] );
+		}
+		imageLoadThreaded = false;
+	}
+#endif
+
+	for ( int i = 0; i < imageLoadBatch.Num(); i++ ) {
+		const imageLoadJob_t &job = imageLoadBatch[i];
+		idImage *image = job.image;
+
+		image->imageHash = job.imageHash;
+		R_UploadImageLevels( image, job.levels, job.numLevels );
+		R_StoreCachedImage( image, job.levels, job.levelsLength );
+
+		globalImages->AddResidentImage( image, false );
+	}
+
+	R_FreeImageLoadBatch();
+}
+
+/*
+===============
+R_LoadImageList
+
+Loads the images the same way ActuallyLoadImage does.  Cube maps and the
+debug cvars that write or tint the generated images take the normal path.
+===============
+*/
+void R_LoadImageList( idImage * const *images, int numImages ) {
+	int batchBytes = 0;
+
+	R_FreeImageLoadBatch();
+
+	bool batched = glConfig.isInitialized && !globalImages->image_colorMipLevels.GetBool() && !globalImages->image_writeTGA.GetBool() && !globalImages->image_writeNormalTGA.GetBool();
+
+	for ( int i = 0; i < numImages; i++ ) {
+		idImage *image = images[i];
+
+		if ( ( ( i + 1 ) & 15 ) == 0 ) {
+			session->PacifierUpdate();
+#ifdef __EMSCRIPTEN__
+			emscripten_sleep( 1 );
+#endif
+		}
+
+		if ( !batched || image->generatorFunction || image->cubeFiles != CF_2D ) {
+			image->ActuallyLoadImage( false );
+			continue;
+		}
+
+		image->cacheDepth = image->depth;
+		if ( R_LoadCachedImage( image ) ) {
+			globalImages->AddResidentImage( image, false );
+			continue;
+		}
+
+		imageLoadJob_t job;
+		memset( &job, 0, sizeof( job ) );
+		job.image = image;
+
+		R_LoadImageProgram( image->imgName, &job.pic, &job.width, &job.height, &image->timestamp, &image->depth );
+		if ( job.pic == NULL ) {
+			common->Warning( "Couldn't load image: %s", image->imgName.c_str() );
+			image->MakeDefault();
+			continue;
+		}
+
+		if ( MakePowerOfTwo( job.width ) != job.width || MakePowerOfTwo( job.height ) != job.height ) {
+			R_StaticFree( job.pic );
+			common->Error( "R_CreateImage: not a power of 2 image" );
+		}
+
+		// the same downsizing as GenerateImage, which might shrink below the target size
+		int width = job.width;
+		int height = job.height;
+		int scaledWidth = width;
+		int scaledHeight = height;
+		int scratchLength = 0;
+
+		image->GetDownsize( scaledWidth, scaledHeight );
+		if ( scaledWidth != width || scaledHeight != height ) {
+			do {
+				if ( job.numDownsizes++ ) {
+					scratchLength += width * height * 4;
+				}
+				width = Max( width >> 1, 1 );
+				height = Max( height >> 1, 1 );
+			} while ( width > scaledWidth || height > scaledHeight );
+		}
+
+		while ( 1 ) {
+			job.levelsLength += 8 + width * height * 4;
+			job.numLevels++;
+			if ( width == 1 && height == 1 ) {
+				break;
+			}
+			width = Max( width >> 1, 1 );
+			height = Max( height >> 1, 1 );
+		}
+
+		job.scratch = scratchLength ? (byte *)R_StaticAlloc( scratchLength ) : NULL;
+		job.levels = (byte *)R_StaticAlloc( job.levelsLength );
+		imageLoadBatch.Append( job );
+
+		batchBytes += job.width * job.height * 4 + scratchLength + job.levelsLength;
+		if ( batchBytes >= IMAGE_LOAD_BATCH_BYTES ) {
+			R_RunImageLoadBatch();
+			batchBytes = 0;
+		}
+	}
+
+	R_RunImageLoadBatch();
 }
 
 //=========================================================================================================
@@ -730,6 +1077,7 @@ PurgeImage
 */
 void idImage::PurgeImage() {
 	if ( texnum != TEXTURE_NOT_LOADED ) {
+		globalImages->RemoveResidentImage( this );
 		qglDeleteTextures( 1, &texnum );	// this should be the ONLY place it is ever called!
 		texnum = TEXTURE_NOT_LOADED;
 	}
@@ -752,6 +1100,9 @@ void idImage::Bind() {
 
 
 	// bump our statistic counters
+	if ( frameUsed != backEnd.frameCount ) {
+		globalImages->TouchResidentImage( this );
+	}
 	frameUsed = backEnd.frameCount;
 	bindCount++;
 
@@ -781,6 +1132,9 @@ void idImage::BindFragment() {
 
 
 	// bump our statistic counters
+	if ( frameUsed != backEnd.frameCount ) {
+		globalImages->TouchResidentImage( this );
+	}
 	frameUsed = backEnd.frameCount;
 	bindCount++;
 
@@ -47,11 +47,10 @@ after resampling to the next lower power of two.
 #define	MAX_DIMENSION	4096
 byte *R_ResampleTexture( const byte *in, int inwidth, int inheight,
 							int outwidth, int outheight ) {
-	int		i, j;
+	int		i;
 	const byte	*inrow, *inrow2;
 	unsigned int	frac, fracstep;
 	unsigned int	p1[MAX_DIMENSION], p2[MAX_DIMENSION];
-	const byte		*pix1, *pix2, *pix3, *pix4;
 	byte		*out, *out_p;
 
 	if ( outwidth > MAX_DIMENSION ) {
@@ -80,17 +79,7 @@ byte *R_ResampleTexture( const byte *in, int inwidth, int inheight,
 	for (i=0 ; i<outheight ; i++, out_p += outwidth*4 ) {
 		inrow = in + 4 * inwidth * (int)( ( i + 0.25f ) * inheight / outheight );
 		inrow2 = in + 4 * inwidth * (int)( ( i + 0.75f ) * inheight / outheight );
-		frac = fracstep >> 1;
-		for (j=0 ; j<outwidth ; j++) {
-			pix1 = inrow + p1[j];
-			pix2 = inrow + p2[j];
-			pix3 = inrow2 + p1[j];
-			pix4 = inrow2 + p2[j];
-			out_p[j*4+0] = (pix1[0] + pix2[0] + pix3[0] + pix4[0])>>2;
-			out_p[j*4+1] = (pix1[1] + pix2[1] + pix3[1] + pix4[1])>>2;
-			out_p[j*4+2] = (pix1[2] + pix2[2] + pix3[2] + pix4[2])>>2;
-			out_p[j*4+3] = (pix1[3] + pix2[3] + pix3[3] + pix4[3])>>2;
-		}
+		SIMDProcessor->ResampleRowRGBA( out_p, inrow, inrow2, p1, p2, outwidth );
 	}
 
 	return out;
@@ -380,9 +369,10 @@ byte *R_MipMapWithAlphaSpecularity( const byte *in, int width, int height ) {
 
 /*
 ================
-R_MipMap
+R_MipMapInto
 
-Returns a new copy of the texture, quartered in size and filtered.
+Quarters the texture into out, which must hold the smaller level.  It doesn't
+allocate, so it can run on the image load worker threads.
 
 If a texture is intended to be used in GL_CLAMP or GL_CLAMP_TO_EDGE mode with
 a completely transparent border, we must prevent any blurring into the outer
@@ -391,38 +381,26 @@ will result in a slight shrinking of the texture as it mips, but better than
 smeared clamps...
 ================
 */
-byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder ) {
-	int		i, j;
+void R_MipMapInto( byte *out, const byte *in, int width, int height, bool preserveBorder ) {
+	int		i;
 	const byte	*in_p;
-	byte	*out, *out_p;
-	int		row;
+	byte	*out_p;
 	byte	border[4];
-	int		newWidth, newHeight;
+	int		inWidth, inHeight;
 
-	if ( width < 1 || height < 1 || ( width + height == 2 ) ) {
-		common->FatalError( "R_MipMap called with size %i,%i", width, height );
-	}
+	assert( width >= 1 && height >= 1 && width + height > 2 );
 
 	border[0] = in[0];
 	border[1] = in[1];
 	border[2] = in[2];
 	border[3] = in[3];
 
-	row = width * 4;
-
-	newWidth = width >> 1;
-	newHeight = height >> 1;
-	if ( !newWidth ) {
-		newWidth = 1;
-	}
-	if ( !newHeight ) {
-		newHeight = 1;
-	}
-	out = (byte *)R_StaticAlloc( newWidth * newHeight * 4 );
 	out_p = out;
 
 	in_p = in;
 
+	inWidth = width;
+	inHeight = height;
 	width >>= 1;
 	height >>= 1;
 
@@ -443,22 +421,43 @@ byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder ) {
 				out_p[3] = ( in_p[3] + in_p[7] )>>1;
 			}
 		}
-		return out;
+		return;
 	}
 
-	for (i=0 ; i<height ; i++, in_p+=row) {
-		for (j=0 ; j<width ; j++, out_p+=4, in_p+=8) {
-			out_p[0] = (in_p[0] + in_p[4] + in_p[row+0] + in_p[row+4])>>2;
-			out_p[1] = (in_p[1] + in_p[5] + in_p[row+1] + in_p[row+5])>>2;
-			out_p[2] = (in_p[2] + in_p[6] + in_p[row+2] + in_p[row+6])>>2;
-			out_p[3] = (in_p[3] + in_p[7] + in_p[row+3] + in_p[row+7])>>2;
-		}
-	}
+	SIMDProcessor->MipMapRGBA( out, in, inWidth, inHeight );
 
 	// copy the old border texel back around if desired
 	if ( preserveBorder ) {
 		R_SetBorderTexels( out, width, height, border );
 	}
+}
+
+/*
+================
+R_MipMap
+
+Returns a new copy of the texture, quartered in size and filtered.
+================
+*/
+byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder ) {
+	byte	*out;
+	int		newWidth, newHeight;
+
+	if ( width < 1 || height < 1 || ( width + height == 2 ) ) {
+		common->FatalError( "R_MipMap called with size %i,%i", width, height );
+	}
+
+	newWidth = width >> 1;
+	newHeight = height >> 1;
+	if ( !newWidth ) {
+		newWidth = 1;
+	}
+	if ( !newHeight ) {
+		newHeight = 1;
+	}
+	out = (byte *)R_StaticAlloc( newWidth * newHeight * 4 );
+
+	R_MipMapInto( out, in, width, height, preserveBorder );
 
 	return out;
 }
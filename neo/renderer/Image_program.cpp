@@ -83,47 +83,7 @@ static void R_HeightmapToNormalMap( byte *data, int width, int height, float sca
 		depth[i] = ( data[i*4] + data[i*4+1] + data[i*4+2] ) / 3;
 	}
 
-	idVec3	dir, dir2;
-	for ( i = 0 ; i < height ; i++ ) {
-		for ( j = 0 ; j < width ; j++ ) {
-			int		d1, d2, d3, d4;
-			int		a1, a3, a4;
-
-			// FIXME: look at five points?
-
-			// look at three points to estimate the gradient
-			a1 = d1 = depth[ ( i * width + j ) ];
-			d2 = depth[ ( i * width + ( ( j + 1 ) & ( width - 1 ) ) ) ];
-			a3 = d3 = depth[ ( ( ( i + 1 ) & ( height - 1 ) ) * width + j ) ];
-			a4 = d4 = depth[ ( ( ( i + 1 ) & ( height - 1 ) ) * width + ( ( j + 1 ) & ( width - 1 ) ) ) ];
-
-			d2 -= d1;
-			d3 -= d1;
-
-			dir[0] = -d2 * scale;
-			dir[1] = -d3 * scale;
-			dir[2] = 1;
-			dir.NormalizeFast();
-
-			a1 -= a3;
-			a4 -= a3;
-
-			dir2[0] = -a4 * scale;
-			dir2[1] = a1 * scale;
-			dir2[2] = 1;
-			dir2.NormalizeFast();
-
-			dir += dir2;
-			dir.NormalizeFast();
-
-			a1 = ( i * width + j ) * 4;
-			data[ a1 + 0 ] = (byte)(dir[0] * 127 + 128);
-			data[ a1 + 1 ] = (byte)(dir[1] * 127 + 128);
-			data[ a1 + 2 ] = (byte)(dir[2] * 127 + 128);
-			data[ a1 + 3 ] = 255;
-		}
-	}
-
+	SIMDProcessor->HeightmapToNormalMap( data, depth, width, height, scale );
 
 	R_StaticFree( depth );
 }
@@ -193,7 +153,6 @@ R_AddNormalMaps
 ===================
 */
 static void R_AddNormalMaps( byte *data1, int width1, int height1, byte *data2, int width2, int height2 ) {
-	int		i, j;
 	byte	*newMap;
 
 	// resample pic2 to the same size as pic1
@@ -205,36 +164,7 @@ static void R_AddNormalMaps( byte *data1, int width1, int height1, byte *data2,
 	}
 
 	// add the normal change from the second and renormalize
-	for ( i = 0 ; i < height1 ; i++ ) {
-		for ( j = 0 ; j < width1 ; j++ ) {
-			byte	*d1, *d2;
-			idVec3	n;
-			float   len;
-
-			d1 = data1 + ( i * width1 + j ) * 4;
-			d2 = data2 + ( i * width1 + j ) * 4;
-
-			n[0] = ( d1[0] - 128 ) / 127.0;
-			n[1] = ( d1[1] - 128 ) / 127.0;
-			n[2] = ( d1[2] - 128 ) / 127.0;
-
-			// There are some normal maps that blend to 0,0,0 at the edges
-			// this screws up compression, so we try to correct that here by instead fading it to 0,0,1
-			len = n.LengthFast();
-			if ( len < 1.0f ) {
-				n[2] = idMath::Sqrt(1.0 - (n[0]*n[0]) - (n[1]*n[1]));
-			}
-
-			n[0] += ( d2[0] - 128 ) / 127.0;
-			n[1] += ( d2[1] - 128 ) / 127.0;
-			n.Normalize();
-
-			d1[0] = (byte)(n[0] * 127 + 128);
-			d1[1] = (byte)(n[1] * 127 + 128);
-			d1[2] = (byte)(n[2] * 127 + 128);
-			d1[3] = 255;
-		}
-	}
+	SIMDProcessor->AddNormalMaps( data1, data2, width1 * height1 );
 
 	if ( newMap ) {
 		R_StaticFree( newMap );
@@ -248,47 +178,11 @@ R_SmoothNormalMap
 */
 static void R_SmoothNormalMap( byte *data, int width, int height ) {
 	byte	*orig;
-	int		i, j, k, l;
-	idVec3	normal;
-	byte	*out;
-	static float	factors[3][3] = {
-		{ 1, 1, 1 },
-		{ 1, 1, 1 },
-		{ 1, 1, 1 }
-	};
 
 	orig = (byte *)R_StaticAlloc( width * height * 4 );
 	memcpy( orig, data, width * height * 4 );
 
-	for ( i = 0 ; i < width ; i++ ) {
-		for ( j = 0 ; j < height ; j++ ) {
-			normal = vec3_origin;
-			for ( k = -1 ; k < 2 ; k++ ) {
-				for ( l = -1 ; l < 2 ; l++ ) {
-					byte	*in;
-
-					in = orig + ( ((j+l)&(height-1))*width + ((i+k)&(width-1)) ) * 4;
-
-					// ignore 000 and -1 -1 -1
-					if ( in[0] == 0 && in[1] == 0 && in[2] == 0 ) {
-						continue;
-					}
-					if ( in[0] == 128 && in[1] == 128 && in[2] == 128 ) {
-						continue;
-					}
-
-					normal[0] += factors[k+1][l+1] * ( in[0] - 128 );
-					normal[1] += factors[k+1][l+1] * ( in[1] - 128 );
-					normal[2] += factors[k+1][l+1] * ( in[2] - 128 );
-				}
-			}
-			normal.Normalize();
-			out = data + ( j * width + i ) * 4;
-			out[0] = (byte)(128 + 127 * normal[0]);
-			out[1] = (byte)(128 + 127 * normal[1]);
-			out[2] = (byte)(128 + 127 * normal[2]);
-		}
-	}
+	SIMDProcessor->SmoothNormalMap( data, orig, width, height );
 
 	R_StaticFree( orig );
 }
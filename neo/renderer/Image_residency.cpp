@@ -0,0 +1,205 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+
+#include "sys/platform.h"
+#include "renderer/tr_local.h"
+
+#include "renderer/Image.h"
+
+/*
+
+Residency management for file based images.
+
+Every loaded file image is linked into cacheLRU, and moved to the head of it
+the first time it is bound in a frame, so the tail always holds the least
+recently bound image.  When image_residencyBudget is set, images are purged from
+the tail until the total fits again.  A purged image is simply reloaded by Bind()
+the next time it is needed.
+
+To keep those on demand loads out of the back end, the render world queues the
+images of the areas around the view whenever the view area changes, nearest
+areas first, and UpdateResidency() loads a time slice of that queue each frame.
+There is no loader thread, the GL uploads have to be done by the thread that
+owns the context anyway.
+
+*/
+
+/*
+===============
+AddResidentImage
+
+Called after every successful file load, stall is true if the
+back end had to wait for the image.
+===============
+*/
+void idImageManager::AddResidentImage( idImage *image, bool stall ) {
+	if ( image->generatorFunction || image->defaulted || image->texnum == idImage::TEXTURE_NOT_LOADED ) {
+		return;
+	}
+	if ( image->cacheUsageNext ) {
+		RemoveResidentImage( image );
+	}
+
+	image->cacheUsageNext = cacheLRU.cacheUsageNext;
+	image->cacheUsagePrev = &cacheLRU;
+	cacheLRU.cacheUsageNext->cacheUsagePrev = image;
+	cacheLRU.cacheUsageNext = image;
+
+	int size = image->StorageSize();
+	totalCachedImageSize += size;
+	residencyBytesStreamed += size;
+	if ( stall ) {
+		residencyStalls++;
+	}
+}
+
+/*
+===============
+RemoveResidentImage
+
+Called by PurgeImage while the upload sizes are still valid.
+===============
+*/
+void idImageManager::RemoveResidentImage( idImage *image ) {
+	if ( !image->cacheUsageNext ) {
+		return;
+	}
+
+	image->cacheUsageNext->cacheUsagePrev = image->cacheUsagePrev;
+	image->cacheUsagePrev->cacheUsageNext = image->cacheUsageNext;
+	image->cacheUsageNext = NULL;
+	image->cacheUsagePrev = NULL;
+
+	totalCachedImageSize -= image->StorageSize();
+}
+
+/*
+===============
+TouchResidentImage
+
+Moves the image to the head of the LRU list.
+===============
+*/
+void idImageManager::TouchResidentImage( idImage *image ) {
+	if ( !image->cacheUsageNext || cacheLRU.cacheUsageNext == image ) {
+		return;
+	}
+
+	image->cacheUsageNext->cacheUsagePrev = image->cacheUsagePrev;
+	image->cacheUsagePrev->cacheUsageNext = image->cacheUsageNext;
+
+	image->cacheUsageNext = cacheLRU.cacheUsageNext;
+	image->cacheUsagePrev = &cacheLRU;
+	cacheLRU.cacheUsageNext->cacheUsagePrev = image;
+	cacheLRU.cacheUsageNext = image;
+}
+
+/*
+===============
+ClearPrefetchQueue
+===============
+*/
+void idImageManager::ClearPrefetchQueue() {
+	for ( int i = 0 ; i < prefetchQueue.Num() ; i++ ) {
+		prefetchQueue[i]->prefetchQueued = false;
+	}
+	prefetchQueue.Clear();
+	prefetchNext = 0;
+}
+
+/*
+===============
+PrefetchImage
+
+Images that are already loaded are queued as well, so
+they are protected from eviction.
+===============
+*/
+void idImageManager::PrefetchImage( idImage *image ) {
+	if ( !image || image->generatorFunction || image->defaulted || image->prefetchQueued ) {
+		return;
+	}
+	image->prefetchQueued = true;
+	prefetchQueue.Append( image );
+}
+
+/*
+===============
+UpdateResidency
+===============
+*/
+void idImageManager::UpdateResidency() {
+	if ( !insideLevelLoad ) {
+		// load queued images until the time slice is used up,
+		// at least one is loaded if the slice isn't zero
+		int msec = image_prefetchMsec.GetInteger();
+		int start = Sys_Milliseconds();
+
+		while ( prefetchNext < prefetchQueue.Num() ) {
+			idImage *image = prefetchQueue[prefetchNext];
+			if ( image->texnum == idImage::TEXTURE_NOT_LOADED ) {
+				if ( Sys_Milliseconds() - start >= msec ) {
+					break;
+				}
+				image->ActuallyLoadImage( false );
+				residencyPrefetches++;
+			}
+			prefetchNext++;
+		}
+
+		// purge the least recently bound images until we fit the budget
+		int budget = image_residencyBudget.GetInteger() * 1024 * 1024;
+		if ( budget > 0 ) {
+			idImage *image = cacheLRU.cacheUsagePrev;
+			while ( totalCachedImageSize > budget && image != &cacheLRU ) {
+				// everything closer to the head was bound more recently
+				if ( image->frameUsed >= backEnd.frameCount - 1 ) {
+					break;
+				}
+				idImage *prev = image->cacheUsagePrev;
+				if ( !image->prefetchQueued ) {
+					image->PurgeImage();
+					residencyEvictions++;
+				}
+				image = prev;
+			}
+		}
+	}
+
+	if ( image_showResidency.GetBool() ) {
+		common->Printf( "images: %i stalls %i prefetched %i evicted %5.2f MB streamed %6.1f MB resident %i/%i queued\n",
+			residencyStalls, residencyPrefetches, residencyEvictions, residencyBytesStreamed / ( 1024.0f * 1024.0f ),
+			totalCachedImageSize / ( 1024.0f * 1024.0f ), prefetchQueue.Num() - prefetchNext, prefetchQueue.Num() );
+	}
+
+	residencyStalls = 0;
+	residencyPrefetches = 0;
+	residencyEvictions = 0;
+	residencyBytesStreamed = 0;
+}
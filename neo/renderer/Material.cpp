@@ -91,6 +91,9 @@ void idMaterial::CommonInit() {
 	deform = DFRM_NONE;
 	numOps = 0;
 	ops = NULL;
+	numViewOps = 0;
+	viewOpsValid = false;
+	viewOpRegisters = NULL;
 	numRegisters = 0;
 	expressionRegisters = NULL;
 	constantRegisters = NULL;
@@ -185,6 +188,12 @@ void idMaterial::FreeData() {
 		R_StaticFree( ops );
 		ops = NULL;
 	}
+	if ( viewOpRegisters != NULL ) {
+		R_StaticFree( viewOpRegisters );
+		viewOpRegisters = NULL;
+	}
+	numViewOps = 0;
+	viewOpsValid = false;
 }
 
 /*
@@ -444,6 +453,39 @@ expOp_t	*idMaterial::GetExpressionOp( void ) {
 	return &pd->shaderOps[numOps++];
 }
 
+/*
+=================
+R_FoldExpressionOp
+
+Must match the results of R_EvaluateExpressionOps.
+=================
+*/
+static float R_FoldExpressionOp( expOpType_t opType, float a, float b ) {
+	int		ib;
+
+	switch( opType ) {
+	case OP_TYPE_ADD:		return a + b;
+	case OP_TYPE_SUBTRACT:	return a - b;
+	case OP_TYPE_MULTIPLY:	return a * b;
+	case OP_TYPE_DIVIDE:	return a / b;
+	case OP_TYPE_MOD:
+		ib = (int)b;
+		ib = ib != 0 ? ib : 1;
+		return (int)a % ib;
+	case OP_TYPE_GT:		return a > b;
+	case OP_TYPE_GE:		return a >= b;
+	case OP_TYPE_LT:		return a < b;
+	case OP_TYPE_LE:		return a <= b;
+	case OP_TYPE_EQ:		return a == b;
+	case OP_TYPE_NE:		return a != b;
+	case OP_TYPE_AND:		return a && b;
+	case OP_TYPE_OR:		return a || b;
+	default:
+		common->FatalError( "R_FoldExpressionOp: bad opcode" );
+	}
+	return 0.0f;
+}
+
 /*
 =================
 idMaterial::EmitOp
@@ -482,6 +524,13 @@ int idMaterial::EmitOp( int a, int b, expOpType_t opType ) {
 		}
 	}
 
+	// fold everything else that only has constant operands,
+	// table lookups are left alone because tables can be reloaded
+	if ( opType != OP_TYPE_TABLE && opType != OP_TYPE_SOUND
+		&& !pd->registerIsTemporary[a] && !pd->registerIsTemporary[b] ) {
+		return GetExpressionConstant( R_FoldExpressionOp( opType, pd->shaderRegisters[a], pd->shaderRegisters[b] ) );
+	}
+
 	op = GetExpressionOp();
 	op->opType = opType;
 	op->a = a;
@@ -2296,7 +2345,7 @@ bool idMaterial::Parse( const char *text, const int textLength ) {
 
 	if ( numOps ) {
 		ops = (expOp_t *)R_StaticAlloc( numOps * sizeof( ops[0] ) );
-		memcpy( ops, pd->shaderOps, numOps * sizeof( ops[0] ) );
+		SortExpressionOps();
 	}
 
 	if ( numRegisters ) {
@@ -2385,45 +2434,12 @@ void idMaterial::AddReference() {
 
 /*
 ===============
-idMaterial::EvaluateRegisters
-
-Parameters are taken from the localSpace and the renderView,
-then all expressions are evaluated, leaving the material registers
-set to their apropriate values.
+R_EvaluateExpressionOps
 ===============
 */
-void idMaterial::EvaluateRegisters( float *registers, const float shaderParms[MAX_ENTITY_SHADER_PARMS],
-									const viewDef_t *view, idSoundEmitter *soundEmitter ) const {
+static void R_EvaluateExpressionOps( float *registers, const expOp_t *ops, int numOps, idSoundEmitter *soundEmitter ) {
 	int		i, b;
-	expOp_t	*op;
-
-	// copy the material constants
-	for ( i = EXP_REG_NUM_PREDEFINED ; i < numRegisters ; i++ ) {
-		registers[i] = expressionRegisters[i];
-	}
-
-	// copy the local and global parameters
-	registers[EXP_REG_TIME] = view->floatTime;
-	registers[EXP_REG_PARM0] = shaderParms[0];
-	registers[EXP_REG_PARM1] = shaderParms[1];
-	registers[EXP_REG_PARM2] = shaderParms[2];
-	registers[EXP_REG_PARM3] = shaderParms[3];
-	registers[EXP_REG_PARM4] = shaderParms[4];
-	registers[EXP_REG_PARM5] = shaderParms[5];
-	registers[EXP_REG_PARM6] = shaderParms[6];
-	registers[EXP_REG_PARM7] = shaderParms[7];
-	registers[EXP_REG_PARM8] = shaderParms[8];
-	registers[EXP_REG_PARM9] = shaderParms[9];
-	registers[EXP_REG_PARM10] = shaderParms[10];
-	registers[EXP_REG_PARM11] = shaderParms[11];
-	registers[EXP_REG_GLOBAL0] = view->renderView.shaderParms[0];
-	registers[EXP_REG_GLOBAL1] = view->renderView.shaderParms[1];
-	registers[EXP_REG_GLOBAL2] = view->renderView.shaderParms[2];
-	registers[EXP_REG_GLOBAL3] = view->renderView.shaderParms[3];
-	registers[EXP_REG_GLOBAL4] = view->renderView.shaderParms[4];
-	registers[EXP_REG_GLOBAL5] = view->renderView.shaderParms[5];
-	registers[EXP_REG_GLOBAL6] = view->renderView.shaderParms[6];
-	registers[EXP_REG_GLOBAL7] = view->renderView.shaderParms[7];
+	const expOp_t	*op;
 
 	op = ops;
 	for ( i = 0 ; i < numOps ; i++, op++ ) {
@@ -2486,7 +2502,74 @@ void idMaterial::EvaluateRegisters( float *registers, const float shaderParms[MA
 			common->FatalError( "R_EvaluateExpression: bad opcode" );
 		}
 	}
+}
+
+/*
+===============
+idMaterial::EvaluateRegisters
+
+Parameters are taken from the localSpace and the renderView,
+then all expressions are evaluated, leaving the material registers
+set to their apropriate values.
+===============
+*/
+void idMaterial::EvaluateRegisters( float *registers, const float shaderParms[MAX_ENTITY_SHADER_PARMS],
+									const viewDef_t *view, idSoundEmitter *soundEmitter ) const {
+	int		i;
+
+	// copy the material constants
+	for ( i = EXP_REG_NUM_PREDEFINED ; i < numRegisters ; i++ ) {
+		registers[i] = expressionRegisters[i];
+	}
+
+	// copy the local and global parameters
+	registers[EXP_REG_TIME] = view->floatTime;
+	registers[EXP_REG_PARM0] = shaderParms[0];
+	registers[EXP_REG_PARM1] = shaderParms[1];
+	registers[EXP_REG_PARM2] = shaderParms[2];
+	registers[EXP_REG_PARM3] = shaderParms[3];
+	registers[EXP_REG_PARM4] = shaderParms[4];
+	registers[EXP_REG_PARM5] = shaderParms[5];
+	registers[EXP_REG_PARM6] = shaderParms[6];
+	registers[EXP_REG_PARM7] = shaderParms[7];
+	registers[EXP_REG_PARM8] = shaderParms[8];
+	registers[EXP_REG_PARM9] = shaderParms[9];
+	registers[EXP_REG_PARM10] = shaderParms[10];
+	registers[EXP_REG_PARM11] = shaderParms[11];
+	registers[EXP_REG_GLOBAL0] = view->renderView.shaderParms[0];
+	registers[EXP_REG_GLOBAL1] = view->renderView.shaderParms[1];
+	registers[EXP_REG_GLOBAL2] = view->renderView.shaderParms[2];
+	registers[EXP_REG_GLOBAL3] = view->renderView.shaderParms[3];
+	registers[EXP_REG_GLOBAL4] = view->renderView.shaderParms[4];
+	registers[EXP_REG_GLOBAL5] = view->renderView.shaderParms[5];
+	registers[EXP_REG_GLOBAL6] = view->renderView.shaderParms[6];
+	registers[EXP_REG_GLOBAL7] = view->renderView.shaderParms[7];
+
+	// the view ops only need to run again if the time or the global parms changed
+	if ( numViewOps ) {
+		float	inputs[9];
+
+		inputs[0] = registers[EXP_REG_TIME];
+		memcpy( &inputs[1], &registers[EXP_REG_GLOBAL0], 8 * sizeof( float ) );
+
+		if ( viewOpsValid && !memcmp( inputs, viewOpInputs, sizeof( inputs ) ) ) {
+			for ( i = 0 ; i < numViewOps ; i++ ) {
+				registers[ops[i].c] = viewOpRegisters[i];
+			}
+			tr.pc.c_expressionOpsCached += numViewOps;
+		} else {
+			R_EvaluateExpressionOps( registers, ops, numViewOps, soundEmitter );
+			for ( i = 0 ; i < numViewOps ; i++ ) {
+				viewOpRegisters[i] = registers[ops[i].c];
+			}
+			memcpy( viewOpInputs, inputs, sizeof( inputs ) );
+			viewOpsValid = true;
+			tr.pc.c_expressionOps += numViewOps;
+		}
+	}
 
+	R_EvaluateExpressionOps( registers, ops + numViewOps, numOps - numViewOps, soundEmitter );
+	tr.pc.c_expressionOps += numOps - numViewOps;
 }
 
 /*
@@ -2590,6 +2673,64 @@ const float *idMaterial::ConstantRegisters() const {
 	return constantRegisters;
 }
 
+/*
+==================
+idMaterial::SortExpressionOps
+
+Copies the parsed ops, with the ones that only depend on constants, time
+and the global shader parms first.  They give the same results for every
+surface of the material drawn with the same time and global parms, so
+EvaluateRegisters can reuse them instead of running them again.
+==================
+*/
+void idMaterial::SortExpressionOps() {
+	bool	viewRegister[MAX_EXPRESSION_REGISTERS];
+	bool	viewOp[MAX_EXPRESSION_OPS];
+	int		i;
+
+	for ( i = 0 ; i < numRegisters ; i++ ) {
+		viewRegister[i] = !pd->registerIsTemporary[i];
+	}
+	viewRegister[EXP_REG_TIME] = true;
+	for ( i = EXP_REG_GLOBAL0 ; i <= EXP_REG_GLOBAL7 ; i++ ) {
+		viewRegister[i] = true;
+	}
+
+	// the ops are in dependency order, and a view op only reads view
+	// registers, so it only depends on earlier view ops.  Moving the view
+	// ops to the front in their original order keeps every op after the
+	// ops it depends on
+	for ( i = 0 ; i < numOps ; i++ ) {
+		const expOp_t *op = &pd->shaderOps[i];
+		if ( op->opType == OP_TYPE_SOUND ) {
+			viewOp[i] = false;
+		} else if ( op->opType == OP_TYPE_TABLE ) {
+			viewOp[i] = viewRegister[op->b];
+		} else {
+			viewOp[i] = viewRegister[op->a] && viewRegister[op->b];
+		}
+		viewRegister[op->c] = viewOp[i];
+	}
+
+	numViewOps = 0;
+	for ( i = 0 ; i < numOps ; i++ ) {
+		if ( viewOp[i] ) {
+			ops[numViewOps++] = pd->shaderOps[i];
+		}
+	}
+	int numSorted = numViewOps;
+	for ( i = 0 ; i < numOps ; i++ ) {
+		if ( !viewOp[i] ) {
+			ops[numSorted++] = pd->shaderOps[i];
+		}
+	}
+
+	if ( numViewOps ) {
+		viewOpRegisters = (float *)R_StaticAlloc( numViewOps * sizeof( viewOpRegisters[0] ) );
+	}
+	viewOpsValid = false;
+}
+
 /*
 ==================
 idMaterial::CheckForConstantRegisters
@@ -619,6 +619,7 @@ private:
 	void				SortInteractionStages();
 	void				AddImplicitStages( const textureRepeat_t trpDefault = TR_REPEAT );
 	void				CheckForConstantRegisters();
+	void				SortExpressionOps();
 
 private:
 	idStr				desc;				// description
@@ -663,6 +664,11 @@ private:
 
 	int					numOps;
 	expOp_t *			ops;				// evaluate to make expressionRegisters
+	int					numViewOps;			// the first ops only depend on constants, time and global parms
+
+	mutable bool		viewOpsValid;
+	mutable float		viewOpInputs[9];	// time and the global parms viewOpRegisters were evaluated with
+	mutable float *		viewOpRegisters;	// results of the view ops, reused while the inputs don't change
 
 	int					numRegisters;																			//
 	float *				expressionRegisters;
@@ -42,6 +42,11 @@ idCVar idRenderModelStatic::r_mergeModelSurfaces( "r_mergeModelSurfaces", "1", C
 idCVar idRenderModelStatic::r_slopVertex( "r_slopVertex", "0.01", CVAR_RENDERER, "merge xyz coordinates this far apart" );
 idCVar idRenderModelStatic::r_slopTexCoord( "r_slopTexCoord", "0.001", CVAR_RENDERER, "merge texture coordinates this far apart" );
 idCVar idRenderModelStatic::r_slopNormal( "r_slopNormal", "0.02", CVAR_RENDERER, "merge normals that dot less than this" );
+idCVar idRenderModelStatic::r_useModelCache( "r_useModelCache", "1", CVAR_RENDERER | CVAR_BOOL | CVAR_ARCHIVE, "store finished static models in fs_savepath and load them from there while the sources are unchanged" );
+
+static bool							deferCleanup;			// between BeginDeferredCleanup and EndDeferredCleanup
+static idList<triCleanup_t>			deferredCleanups;
+static idList<idRenderModelStatic *>	deferredModels;
 
 /*
 ================
@@ -287,6 +292,12 @@ void idRenderModelStatic::InitFromFile( const char *fileName ) {
 
 	name.ExtractFileExtension( extension );
 
+	// a finished copy skips the parsing and FinishSurfaces
+	if ( LoadCachedModel() ) {
+		reloadable = true;
+		return;
+	}
+
 	if ( extension.Icmp( "ase" ) == 0 ) {
 		loaded		= LoadASE( name );
 		reloadable	= true;
@@ -315,6 +326,11 @@ void idRenderModelStatic::InitFromFile( const char *fileName ) {
 
 	// create the bounds for culling and dynamic surface creation
 	FinishSurfaces();
+
+	// a deferred model is written once its surfaces are cleaned up
+	if ( !deferCleanup ) {
+		WriteCachedModel();
+	}
 }
 
 /*
@@ -582,7 +598,6 @@ Extends the bounds of deformed surfaces so they don't cull incorrectly at screen
 */
 void idRenderModelStatic::FinishSurfaces() {
 	int			i;
-	int			totalVerts, totalIndexes;
 
 	purged = false;
 
@@ -606,10 +621,6 @@ void idRenderModelStatic::FinishSurfaces() {
 		return;
 	}
 
-	// cleanup all the final surfaces, but don't create sil edges
-	totalVerts = 0;
-	totalIndexes = 0;
-
 	// decide if we are going to merge all the surfaces into one shadower
 	int	numOriginalSurfaces = surfaces.Num();
 
@@ -651,16 +662,49 @@ void idRenderModelStatic::FinishSurfaces() {
 		}
 	}
 
-	// clean the surfaces
-	for ( i = 0 ; i < surfaces.Num() ; i++ ) {
-		const modelSurface_t	*surf = &surfaces[i];
+	// EndDeferredCleanup cleans up the surfaces of all the deferred models at once
+	if ( deferCleanup ) {
+		AddSurfaceCleanups( deferredCleanups );
+		deferredModels.Append( this );
+		return;
+	}
 
-		R_CleanupTriangles( surf->geometry, surf->geometry->generateNormals, true, surf->shader->UseUnsmoothedTangents() );
-		if ( surf->shader->SurfaceCastsShadow() ) {
-			totalVerts += surf->geometry->numVerts;
-			totalIndexes += surf->geometry->numIndexes;
-		}
+	// clean the surfaces, on the worker threads if there are several
+	idList<triCleanup_t> cleanups;
+	AddSurfaceCleanups( cleanups );
+	R_CleanupTriangleList( cleanups.Ptr(), cleanups.Num() );
+
+	FinishCleanedSurfaces();
+}
+
+/*
+================
+idRenderModelStatic::AddSurfaceCleanups
+================
+*/
+void idRenderModelStatic::AddSurfaceCleanups( idList<triCleanup_t> &cleanups ) const {
+	for ( int i = 0 ; i < surfaces.Num() ; i++ ) {
+		const modelSurface_t	*surf = &surfaces[i];
+		triCleanup_t			&cleanup = cleanups.Alloc();
+
+		cleanup.tri = surf->geometry;
+		cleanup.createNormals = surf->geometry->generateNormals;
+		cleanup.identifySilEdges = true;
+		cleanup.useUnsmoothedTangents = surf->shader->UseUnsmoothedTangents();
+		// deforms like autosprite depend on the original triangle order
+		cleanup.orderIndexes = ( surf->shader->Deform() == DFRM_NONE );
 	}
+}
+
+/*
+================
+idRenderModelStatic::FinishCleanedSurfaces
+
+The part of FinishSurfaces after the surfaces are cleaned up.
+================
+*/
+void idRenderModelStatic::FinishCleanedSurfaces() {
+	int			i;
 
 	// add up the total surface area for development information
 	for ( i = 0 ; i < surfaces.Num() ; i++ ) {
@@ -710,6 +754,56 @@ void idRenderModelStatic::FinishSurfaces() {
 	}
 }
 
+/*
+================
+idRenderModelStatic::BeginDeferredCleanup
+
+FinishSurfaces only queues the surfaces until EndDeferredCleanup, so the
+surfaces of many models can be cleaned up on the worker threads together.
+The deferred models can't be used before that.
+================
+*/
+void idRenderModelStatic::BeginDeferredCleanup() {
+	ClearDeferredCleanup();
+	deferCleanup = true;
+}
+
+/*
+================
+idRenderModelStatic::EndDeferredCleanup
+
+The queue is taken over before the cleanup runs, so an error
+during it doesn't leave models queued for the next load.
+================
+*/
+void idRenderModelStatic::EndDeferredCleanup() {
+	idList<triCleanup_t>			cleanups;
+	idList<idRenderModelStatic *>	models;
+	int i;
+
+	cleanups.Swap( deferredCleanups );
+	models.Swap( deferredModels );
+	deferCleanup = false;
+
+	R_CleanupTriangleList( cleanups.Ptr(), cleanups.Num() );
+
+	for ( i = 0 ; i < models.Num() ; i++ ) {
+		models[i]->FinishCleanedSurfaces();
+		models[i]->WriteCachedModel();
+	}
+}
+
+/*
+================
+idRenderModelStatic::ClearDeferredCleanup
+================
+*/
+void idRenderModelStatic::ClearDeferredCleanup() {
+	deferCleanup = false;
+	deferredCleanups.Clear();
+	deferredModels.Clear();
+}
+
 /*
 =================
 idRenderModelStatic::ConvertASEToModelSurfaces
@@ -2111,6 +2205,18 @@ void idRenderModelStatic::PurgeModel() {
 	int		i;
 	modelSurface_t	*surf;
 
+	// the surfaces of a deferred model are freed before their cleanup runs
+	if ( deferredModels.Remove( this ) ) {
+		for ( i = deferredCleanups.Num() - 1 ; i >= 0 ; i-- ) {
+			for ( int j = 0 ; j < surfaces.Num() ; j++ ) {
+				if ( deferredCleanups[i].tri == surfaces[j].geometry ) {
+					deferredCleanups.RemoveIndex( i );
+					break;
+				}
+			}
+		}
+	}
+
 	for ( i = 0 ; i < surfaces.Num() ; i++ ) {
 		surf = &surfaces[i];
 
@@ -287,6 +287,88 @@ void idRenderModelDecal::AddDepthFadedWinding( const idWinding &w, const idMater
 	AddWinding( front, decalMaterial, fadePlanes, fadeDepth, startTime );
 }
 
+/*
+=================
+idRenderModelDecal::SurfaceTakesDecal
+=================
+*/
+bool idRenderModelDecal::SurfaceTakesDecal( const modelSurface_t *surf, const decalProjectionInfo_t &localInfo ) {
+
+	// if no geometry or no shader
+	if ( !surf->geometry || !surf->shader ) {
+		return false;
+	}
+
+	// decals and overlays use the same rules
+	if ( !localInfo.force && !surf->shader->AllowOverlays() ) {
+		return false;
+	}
+
+	// if the triangle bounds do not overlap with projection bounds
+	if ( !localInfo.projectionBounds.IntersectsBounds( surf->geometry->bounds ) ) {
+		return false;
+	}
+
+	return true;
+}
+
+/*
+=================
+idRenderModelDecal::ClipTriangle
+=================
+*/
+bool idRenderModelDecal::ClipTriangle( idFixedWinding &fw, const srfTriangles_t *stri, const idPlane *facePlanes, int index, int triNum, const byte *cullBits, const decalProjectionInfo_t &localInfo ) {
+	int v1 = stri->indexes[index+0];
+	int v2 = stri->indexes[index+1];
+	int v3 = stri->indexes[index+2];
+
+	// skip triangles completely off one side
+	if ( cullBits[v1] & cullBits[v2] & cullBits[v3] ) {
+		return false;
+	}
+
+	// skip back facing triangles
+	if ( facePlanes && facePlanes[triNum].Normal() * localInfo.boundingPlanes[NUM_DECAL_BOUNDING_PLANES - 2].Normal() < -0.1f ) {
+		return false;
+	}
+
+	// create a winding with texture coordinates for the triangle
+	fw.SetNumPoints( 3 );
+	if ( localInfo.parallel ) {
+		for ( int j = 0; j < 3; j++ ) {
+			fw[j] = stri->verts[stri->indexes[index+j]].xyz;
+			fw[j].s = localInfo.textureAxis[0].Distance( fw[j].ToVec3() );
+			fw[j].t = localInfo.textureAxis[1].Distance( fw[j].ToVec3() );
+		}
+	} else {
+		for ( int j = 0; j < 3; j++ ) {
+			idVec3 dir;
+			float scale;
+
+			fw[j] = stri->verts[stri->indexes[index+j]].xyz;
+			dir = fw[j].ToVec3() - localInfo.projectionOrigin;
+			if (!localInfo.boundingPlanes[NUM_DECAL_BOUNDING_PLANES - 1].RayIntersection( fw[j].ToVec3(), dir, scale ))
+				scale = 0.0f;
+			dir = fw[j].ToVec3() + scale * dir;
+			fw[j].s = localInfo.textureAxis[0].Distance( dir );
+			fw[j].t = localInfo.textureAxis[1].Distance( dir );
+		}
+	}
+
+	int orBits = cullBits[v1] | cullBits[v2] | cullBits[v3];
+
+	// clip the exact surface triangle to the projection volume
+	for ( int j = 0; j < NUM_DECAL_BOUNDING_PLANES; j++ ) {
+		if ( orBits & ( 1 << j ) ) {
+			if ( !fw.ClipInPlace( -localInfo.boundingPlanes[j] ) ) {
+				break;
+			}
+		}
+	}
+
+	return ( fw.GetNumPoints() != 0 );
+}
+
 /*
 =================
 idRenderModelDecal::CreateDecal
@@ -298,22 +380,12 @@ void idRenderModelDecal::CreateDecal( const idRenderModel *model, const decalPro
 	for ( int surfNum = 0; surfNum < model->NumSurfaces(); surfNum++ ) {
 		const modelSurface_t *surf = model->Surface( surfNum );
 
-		// if no geometry or no shader
-		if ( !surf->geometry || !surf->shader ) {
-			continue;
-		}
-
-		// decals and overlays use the same rules
-		if ( !localInfo.force && !surf->shader->AllowOverlays() ) {
+		if ( !SurfaceTakesDecal( surf, localInfo ) ) {
 			continue;
 		}
 
 		srfTriangles_t *stri = surf->geometry;
-
-		// if the triangle bounds do not overlap with projection bounds
-		if ( !localInfo.projectionBounds.IntersectsBounds( stri->bounds ) ) {
-			continue;
-		}
+		const idPlane *facePlanes = stri->facePlanesCalculated ? stri->facePlanes : NULL;
 
 		// allocate memory for the cull bits
 		byte *cullBits = (byte *)_alloca16( stri->numVerts * sizeof( cullBits[0] ) );
@@ -323,62 +395,86 @@ void idRenderModelDecal::CreateDecal( const idRenderModel *model, const decalPro
 
 		// find triangles inside the projection volume
 		for ( int triNum = 0, index = 0; index < stri->numIndexes; index += 3, triNum++ ) {
-			int v1 = stri->indexes[index+0];
-			int v2 = stri->indexes[index+1];
-			int v3 = stri->indexes[index+2];
+			idFixedWinding fw;
 
-			// skip triangles completely off one side
-			if ( cullBits[v1] & cullBits[v2] & cullBits[v3] ) {
+			if ( !ClipTriangle( fw, stri, facePlanes, index, triNum, cullBits, localInfo ) ) {
 				continue;
 			}
 
-			// skip back facing triangles
-			if ( stri->facePlanes && stri->facePlanesCalculated &&
-					stri->facePlanes[triNum].Normal() * localInfo.boundingPlanes[NUM_DECAL_BOUNDING_PLANES - 2].Normal() < -0.1f ) {
-				continue;
-			}
+			AddDepthFadedWinding( fw, localInfo.material, localInfo.fadePlanes, localInfo.fadeDepth, localInfo.startTime );
+		}
+	}
+}
+
+/*
+=================
+idRenderModelDecal::ClipDecal
+=================
+*/
+bool idRenderModelDecal::ClipDecal( const idRenderModel *model, const idPlane * const *facePlanes, const decalProjectionInfo_t &localInfo, decalClip_t &clip ) {
+	const int firstPoint = clip.numPoints;
+	const int firstWinding = clip.numWindings;
+
+	// check all model surfaces
+	for ( int surfNum = 0; surfNum < model->NumSurfaces(); surfNum++ ) {
+		const modelSurface_t *surf = model->Surface( surfNum );
+
+		if ( !SurfaceTakesDecal( surf, localInfo ) ) {
+			continue;
+		}
+
+		const srfTriangles_t *stri = surf->geometry;
+
+		if ( stri->numVerts > clip.maxCullBits ) {
+			clip.numPoints = firstPoint;
+			clip.numWindings = firstWinding;
+			return false;
+		}
+
+		// catagorize all points by the planes
+		SIMDProcessor->DecalPointCull( clip.cullBits, localInfo.boundingPlanes, stri->verts, stri->numVerts );
 
-			// create a winding with texture coordinates for the triangle
+		// find triangles inside the projection volume
+		for ( int triNum = 0, index = 0; index < stri->numIndexes; index += 3, triNum++ ) {
 			idFixedWinding fw;
-			fw.SetNumPoints( 3 );
-			if ( localInfo.parallel ) {
-				for ( int j = 0; j < 3; j++ ) {
-					fw[j] = stri->verts[stri->indexes[index+j]].xyz;
-					fw[j].s = localInfo.textureAxis[0].Distance( fw[j].ToVec3() );
-					fw[j].t = localInfo.textureAxis[1].Distance( fw[j].ToVec3() );
-				}
-			} else {
-				for ( int j = 0; j < 3; j++ ) {
-					idVec3 dir;
-					float scale;
-
-					fw[j] = stri->verts[stri->indexes[index+j]].xyz;
-					dir = fw[j].ToVec3() - localInfo.projectionOrigin;
-					if (!localInfo.boundingPlanes[NUM_DECAL_BOUNDING_PLANES - 1].RayIntersection( fw[j].ToVec3(), dir, scale ))
-						scale = 0.0f;
-					dir = fw[j].ToVec3() + scale * dir;
-					fw[j].s = localInfo.textureAxis[0].Distance( dir );
-					fw[j].t = localInfo.textureAxis[1].Distance( dir );
-				}
-			}
 
-			int orBits = cullBits[v1] | cullBits[v2] | cullBits[v3];
+			if ( !ClipTriangle( fw, stri, facePlanes[surfNum], index, triNum, clip.cullBits, localInfo ) ) {
+				continue;
+			}
 
-			// clip the exact surface triangle to the projection volume
-			for ( int j = 0; j < NUM_DECAL_BOUNDING_PLANES; j++ ) {
-				if ( orBits & ( 1 << j ) ) {
-					if ( !fw.ClipInPlace( -localInfo.boundingPlanes[j] ) ) {
-						break;
-					}
-				}
+			if ( clip.numWindings >= clip.maxWindings || clip.numPoints + fw.GetNumPoints() > clip.maxPoints ) {
+				clip.numPoints = firstPoint;
+				clip.numWindings = firstWinding;
+				return false;
 			}
 
-			if ( fw.GetNumPoints() == 0 ) {
-				continue;
+			for ( int j = 0; j < fw.GetNumPoints(); j++ ) {
+				clip.points[clip.numPoints++] = fw[j];
 			}
+			clip.windingPoints[clip.numWindings++] = fw.GetNumPoints();
+		}
+	}
 
-			AddDepthFadedWinding( fw, localInfo.material, localInfo.fadePlanes, localInfo.fadeDepth, localInfo.startTime );
+	return true;
+}
+
+/*
+=================
+idRenderModelDecal::AddClippedDecal
+=================
+*/
+void idRenderModelDecal::AddClippedDecal( const decalClip_t &clip, int firstPoint, int firstWinding, int numWindings, const decalProjectionInfo_t &localInfo ) {
+	int point = firstPoint;
+
+	for ( int i = firstWinding; i < firstWinding + numWindings; i++ ) {
+		idFixedWinding fw;
+
+		fw.SetNumPoints( clip.windingPoints[i] );
+		for ( int j = 0; j < clip.windingPoints[i]; j++ ) {
+			fw[j] = clip.points[point++];
 		}
+
+		AddDepthFadedWinding( fw, localInfo.material, localInfo.fadePlanes, localInfo.fadeDepth, localInfo.startTime );
 	}
 }
 
@@ -62,6 +62,18 @@ typedef struct decalProjectionInfo_s {
 	bool						force;
 } decalProjectionInfo_t;
 
+// windings clipped by idRenderModelDecal::ClipDecal, the buffers belong to the caller
+typedef struct decalClip_s {
+	idVec5 *					points;				// points of all the windings, with texture coordinates
+	int							maxPoints;
+	int							numPoints;
+	int *						windingPoints;		// number of points of each winding
+	int							maxWindings;
+	int							numWindings;
+	byte *						cullBits;			// scratch for the largest surface
+	int							maxCullBits;
+} decalClip_t;
+
 
 class idRenderModelDecal {
 public:
@@ -80,6 +92,17 @@ public:
 								// Creates a deal on the given model.
 	void						CreateDecal( const idRenderModel *model, const decalProjectionInfo_t &localInfo );
 
+								// Clips the decal against the model surfaces without creating it.
+								// Doesn't allocate, changes nothing and only reads the verts and indexes
+								// of the surfaces, so it can run on any thread.  The face planes that cull
+								// back facing triangles are passed in for each surface, NULL if there are
+								// none, because the main thread derives them lazily.
+								// Returns false if the windings don't fit the buffers.
+	static bool					ClipDecal( const idRenderModel *model, const idPlane * const *facePlanes, const decalProjectionInfo_t &localInfo, decalClip_t &clip );
+
+								// Creates the decal from windings clipped by ClipDecal.
+	void						AddClippedDecal( const decalClip_t &clip, int firstPoint, int firstWinding, int numWindings, const decalProjectionInfo_t &localInfo );
+
 								// Remove decals that are completely faded away.
 	static idRenderModelDecal *	RemoveFadedDecals( idRenderModelDecal *decals, int time );
 
@@ -114,6 +137,14 @@ private:
 								// The part of the winding at the front side of both fade planes is not faded.
 								// The parts at the back sides of the fade planes are faded with the given depth.
 	void						AddDepthFadedWinding( const idWinding &w, const idMaterial *decalMaterial, const idPlane fadePlanes[2], float fadeDepth, int startTime );
+
+								// Returns true if decals can be projected onto the surface.
+	static bool					SurfaceTakesDecal( const modelSurface_t *surf, const decalProjectionInfo_t &localInfo );
+
+								// Clips the triangle starting at the given index to the projection volume.
+								// Back facing triangles are only skipped with face planes.
+								// Returns false if nothing of the triangle is inside.
+	static bool					ClipTriangle( idFixedWinding &fw, const srfTriangles_t *stri, const idPlane *facePlanes, int index, int triNum, const byte *cullBits, const decalProjectionInfo_t &localInfo );
 };
 
 #endif /* !__MODELDECAL_H__ */
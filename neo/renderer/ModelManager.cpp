@@ -27,6 +27,7 @@ If you have questions concerning this license or the applicable additional terms
 */
 
 #include "sys/platform.h"
+#include "idlib/hashing/MD4.h"
 #include "framework/CVarSystem.h"
 #include "framework/Session.h"
 #include "renderer/RenderWorld.h"
@@ -34,6 +35,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "renderer/tr_local.h"	// just for R_FreeWorldInteractions and R_CreateWorldInteractions
 
 #include "renderer/ModelManager.h"
+#include "renderer/DecalQueue.h"
 
 #ifdef __EMSCRIPTEN__
 #include "emscripten.h"
@@ -76,6 +78,7 @@ private:
 	static void				ListModels_f( const idCmdArgs &args );
 	static void				ReloadModels_f( const idCmdArgs &args );
 	static void				TouchModel_f( const idCmdArgs &args );
+	static void				BenchModelLoad_f( const idCmdArgs &args );
 };
 
 
@@ -183,6 +186,130 @@ void idRenderModelManagerLocal::TouchModel_f( const idCmdArgs &args ) {
 	}
 }
 
+/*
+==============
+R_ModelChecksum
+
+Covers the geometry and everything R_CleanupTriangles derives from it.
+==============
+*/
+static int R_ModelChecksum( const idRenderModel *model ) {
+	int checksum = 0;
+
+	for ( int i = 0; i < model->NumSurfaces(); i++ ) {
+		const srfTriangles_t *tri = model->Surface( i )->geometry;
+		if ( !tri ) {
+			continue;
+		}
+		checksum = checksum * 31 + MD4_BlockChecksum( tri->verts, tri->numVerts * sizeof( tri->verts[0] ) );
+		checksum = checksum * 31 + MD4_BlockChecksum( tri->indexes, tri->numIndexes * sizeof( tri->indexes[0] ) );
+		checksum = checksum * 31 + MD4_BlockChecksum( tri->silEdges, tri->numSilEdges * sizeof( tri->silEdges[0] ) );
+		checksum = checksum * 31 + MD4_BlockChecksum( tri->mirroredVerts, tri->numMirroredVerts * sizeof( tri->mirroredVerts[0] ) );
+		checksum = checksum * 31 + MD4_BlockChecksum( tri->dupVerts, tri->numDupVerts * 2 * sizeof( tri->dupVerts[0] ) );
+		if ( tri->silIndexes ) {
+			checksum = checksum * 31 + MD4_BlockChecksum( tri->silIndexes, tri->numIndexes * sizeof( tri->silIndexes[0] ) );
+		}
+		if ( tri->facePlanes ) {
+			checksum = checksum * 31 + MD4_BlockChecksum( tri->facePlanes, tri->numIndexes / 3 * sizeof( tri->facePlanes[0] ) );
+		}
+		if ( tri->dominantTris ) {
+			checksum = checksum * 31 + MD4_BlockChecksum( tri->dominantTris, tri->numVerts * sizeof( tri->dominantTris[0] ) );
+		}
+		checksum = checksum * 31 + MD4_BlockChecksum( &tri->bounds, sizeof( tri->bounds ) );
+	}
+	return checksum;
+}
+
+/*
+==============
+idRenderModelManagerLocal::BenchModelLoad_f
+
+Reloads every loaded ASE, LWO and MA model from its source, first one at a
+time on the main thread, then batched like EndLevelLoad does with the
+surfaces cleaned up on the worker threads, and checks that both produce
+the same surfaces.
+==============
+*/
+void idRenderModelManagerLocal::BenchModelLoad_f( const idCmdArgs &args ) {
+	idList<idRenderModel *>	benchModels;
+	idList<int>				checksums;
+	idStr					extension;
+	int						i, numSurfaces, numThreads, differ, msec[2];
+	int						start;
+
+	for ( i = 1; i < localModelManager.models.Num(); i++ ) {
+		idRenderModel *model = localModelManager.models[i];
+
+		if ( !model->IsLoaded() || !model->IsReloadable() || model->IsDynamicModel() != DM_STATIC ) {
+			continue;
+		}
+		idStr( model->Name() ).ExtractFileExtension( extension );
+		if ( extension.Icmp( "ase" ) && extension.Icmp( "lwo" ) && extension.Icmp( "ma" ) ) {
+			continue;
+		}
+		benchModels.Append( model );
+	}
+
+	if ( !benchModels.Num() ) {
+		common->Printf( "no static models loaded, load a map first\n" );
+		return;
+	}
+
+	numThreads = ( args.Argc() > 1 ) ? atoi( args.Argv( 1 ) ) : r_cleanupThreads.GetInteger();
+
+	bool useModelCache = idRenderModelStatic::r_useModelCache.GetBool();
+	int cleanupThreads = r_cleanupThreads.GetInteger();
+
+	// the cache would skip the work being measured
+	idRenderModelStatic::r_useModelCache.SetBool( false );
+
+	R_FreeDerivedData();
+
+	// one at a time
+	r_cleanupThreads.SetInteger( 0 );
+	start = Sys_Milliseconds();
+	for ( i = 0; i < benchModels.Num(); i++ ) {
+		benchModels[i]->LoadModel();
+	}
+	msec[0] = Sys_Milliseconds() - start;
+
+	numSurfaces = 0;
+	for ( i = 0; i < benchModels.Num(); i++ ) {
+		checksums.Append( R_ModelChecksum( benchModels[i] ) );
+		numSurfaces += benchModels[i]->NumSurfaces();
+	}
+
+	// batched
+	r_cleanupThreads.SetInteger( numThreads );
+	start = Sys_Milliseconds();
+	idRenderModelStatic::BeginDeferredCleanup();
+	for ( i = 0; i < benchModels.Num(); i++ ) {
+		benchModels[i]->LoadModel();
+	}
+	idRenderModelStatic::EndDeferredCleanup();
+	msec[1] = Sys_Milliseconds() - start;
+
+	differ = 0;
+	for ( i = 0; i < benchModels.Num(); i++ ) {
+		if ( R_ModelChecksum( benchModels[i] ) != checksums[i] ) {
+			common->Printf( "%s: surfaces differ\n", benchModels[i]->Name() );
+			differ++;
+		}
+	}
+
+	r_cleanupThreads.SetInteger( cleanupThreads );
+	idRenderModelStatic::r_useModelCache.SetBool( useModelCache );
+
+	R_ReCreateWorldReferences();
+
+#ifdef NOMT
+	numThreads = 0;
+#endif
+	common->Printf( "%i models, %i surfaces: %i msec one at a time, %i msec batched on %i cleanup threads\n",
+		benchModels.Num(), numSurfaces, msec[0], msec[1], numThreads );
+	common->Printf( "%i models differ\n", differ );
+}
+
 /*
 =================
 idRenderModelManagerLocal::WritePrecacheCommands
@@ -216,6 +343,10 @@ void idRenderModelManagerLocal::Init() {
 	cmdSystem->AddCommand( "printModel", PrintModel_f, CMD_FL_RENDERER, "prints model info", idCmdSystem::ArgCompletion_ModelName );
 	cmdSystem->AddCommand( "reloadModels", ReloadModels_f, CMD_FL_RENDERER|CMD_FL_CHEAT, "reloads models" );
 	cmdSystem->AddCommand( "touchModel", TouchModel_f, CMD_FL_RENDERER, "touches a model", idCmdSystem::ArgCompletion_ModelName );
+	cmdSystem->AddCommand( "benchModelLoad", BenchModelLoad_f, CMD_FL_RENDERER|CMD_FL_CHEAT, "reloads the static models of the level one at a time and batched on the cleanup threads" );
+	cmdSystem->AddCommand( "modelCacheStats", R_ModelCacheStats_f, CMD_FL_RENDERER, "prints static model cache statistics" );
+	cmdSystem->AddCommand( "purgeModelCache", R_PurgeModelCache_f, CMD_FL_RENDERER, "removes all static model cache entries" );
+	cmdSystem->AddCommand( "benchmarkParticles", R_BenchmarkParticles_f, CMD_FL_RENDERER, "runs all particle decls one particle at a time and batched" );
 
 	insideLevelLoad = false;
 
@@ -380,6 +511,7 @@ void idRenderModelManagerLocal::FreeModel( idRenderModel *model ) {
 	}
 
 	R_CheckForEntityDefsUsingModel( model );
+	decalQueue.FreeModel( model );
 
 	delete model;
 }
@@ -445,6 +577,9 @@ void idRenderModelManagerLocal::ReloadModels( bool forceAll ) {
 
 	R_FreeDerivedData();
 
+	// the reloaded models are rebuilt in place
+	decalQueue.FreeModel( NULL );
+
 	// skip the default model at index 0
 	for ( int i = 1 ; i < models.Num() ; i++ ) {
 		idRenderModel	*model = models[i];
@@ -494,6 +629,12 @@ idRenderModelManagerLocal::BeginLevelLoad
 void idRenderModelManagerLocal::BeginLevelLoad() {
 	insideLevelLoad = true;
 
+	// models may be purged, so the decal worker must be done with them
+	decalQueue.FreeModel( NULL );
+
+	// a previous load may have stopped with an error before its cleanup ran
+	idRenderModelStatic::ClearDeferredCleanup();
+
 	for ( int i = 0 ; i < models.Num() ; i++ ) {
 		idRenderModel *model = models[i];
 
@@ -521,6 +662,8 @@ void idRenderModelManagerLocal::EndLevelLoad() {
 
 	insideLevelLoad = false;
 	int	purgeCount = 0;
+
+	decalQueue.FreeModel( NULL );
 	int	keepCount = 0;
 	int	loadCount = 0;
 
@@ -549,7 +692,10 @@ void idRenderModelManagerLocal::EndLevelLoad() {
 	// purge unused triangle surface memory
 	R_PurgeTriSurfData( frameData );
 
-	// load any new ones
+	// load any new ones, the surfaces of the static models
+	// are cleaned up together on the worker threads
+	idRenderModelStatic::BeginDeferredCleanup();
+
 	for ( int i = 0 ; i < models.Num() ; i++ ) {
 		idRenderModel *model = models[i];
 
@@ -567,6 +713,8 @@ void idRenderModelManagerLocal::EndLevelLoad() {
 		}
 	}
 
+	idRenderModelStatic::EndDeferredCleanup();
+
 	// _D3XP added this
 	int	end = Sys_Milliseconds();
 	common->Printf( "%5i models purged from previous level, ", purgeCount );
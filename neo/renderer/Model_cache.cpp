@@ -0,0 +1,343 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "sys/platform.h"
+#include "idlib/hashing/MD4.h"
+#include "renderer/tr_local.h"
+
+#include "renderer/Model_local.h"
+
+/*
+
+The model cache stores ASE, LWO and MA models after FinishSurfaces, so a
+later load skips parsing, vertex welding, tangent derivation and sil edge
+creation.
+
+Entries live in fs_savepath under modelcache/, with the model path plus
+MODEL_CACHE_EXTENSION as the file name.  The header holds the settings the
+conversion depends on and the length and timestamp of the source file.
+Files in paks have no timestamp, so their contents are checksummed instead.
+The materials are stored by name together with the flags the conversion and
+FinishSurfaces looked at, and a material that changed them counts as a miss.
+
+The surface data are flat arrays in the native layout, so the cache is
+only meant for the machine that wrote it.
+
+*/
+
+#define MODEL_CACHE_ID			"MDLCACHE"
+#define MODEL_CACHE_VERSION		3
+#define MODEL_CACHE_DIR			"modelcache"
+#define MODEL_CACHE_EXTENSION	".mcache"
+
+// material flags that change the cached surfaces
+#define MODEL_CACHE_BACKSIDES	BIT( 0 )
+#define MODEL_CACHE_UNSMOOTHED	BIT( 1 )
+#define MODEL_CACHE_DEFORM		BIT( 2 )
+#define MODEL_CACHE_DISCRETE	BIT( 3 )
+#define MODEL_CACHE_RENDERBUMP	BIT( 4 )	// the converters drop the explicit normals
+
+static int		modelCacheHits;
+static int		modelCacheMisses;
+static int		modelCacheWrites;
+
+/*
+================
+R_ModelCacheEnabled
+================
+*/
+static bool R_ModelCacheEnabled( const char *name, bool fastLoad ) {
+	idStr extension;
+
+	if ( fastLoad || !idRenderModelStatic::r_useModelCache.GetBool() ) {
+		return false;
+	}
+
+	idStr( name ).ExtractFileExtension( extension );
+	return ( extension.Icmp( "ase" ) == 0 || extension.Icmp( "lwo" ) == 0 || extension.Icmp( "ma" ) == 0 );
+}
+
+/*
+================
+R_ModelCacheKey
+================
+*/
+static void R_ModelCacheKey( const char *name, idStr &key ) {
+	sprintf( key, "%s slopVertex %g slopTexCoord %g slopNormal %g merge %i order %i vert %i index %i",
+		name, cvarSystem->GetCVarFloat( "r_slopVertex" ), cvarSystem->GetCVarFloat( "r_slopTexCoord" ),
+		cvarSystem->GetCVarFloat( "r_slopNormal" ), cvarSystem->GetCVarInteger( "r_mergeModelSurfaces" ),
+		cvarSystem->GetCVarInteger( "r_orderIndexes" ),
+		(int)sizeof( idDrawVert ), (int)sizeof( glIndex_t ) );
+}
+
+/*
+================
+R_ModelCacheSource
+
+Length, timestamp and, for files without a timestamp, a checksum of the source.
+================
+*/
+static bool R_ModelCacheSource( const char *name, int &length, ID_TIME_T &timestamp, int &checksum ) {
+	const void *view;
+
+	length = fileSystem->ReadFile( name, NULL, &timestamp );
+	if ( length < 0 ) {
+		return false;
+	}
+	checksum = 0;
+	if ( timestamp == 0 ) {
+		if ( fileSystem->ReadFileView( name, &view ) != length ) {
+			return false;
+		}
+		checksum = MD4_BlockChecksum( view, length );
+		fileSystem->FreeFileView( view );
+	}
+	return true;
+}
+
+/*
+================
+R_ModelCacheMaterialFlags
+================
+*/
+static int R_ModelCacheMaterialFlags( const idMaterial *material ) {
+	int flags = 0;
+
+	if ( material->ShouldCreateBackSides() ) {
+		flags |= MODEL_CACHE_BACKSIDES;
+	}
+	if ( material->UseUnsmoothedTangents() ) {
+		flags |= MODEL_CACHE_UNSMOOTHED;
+	}
+	if ( material->Deform() != DFRM_NONE ) {
+		flags |= MODEL_CACHE_DEFORM;
+	}
+	if ( material->IsDiscrete() ) {
+		flags |= MODEL_CACHE_DISCRETE;
+	}
+	const char *rb = material->GetRenderBump();
+	if ( rb && rb[0] ) {
+		flags |= MODEL_CACHE_RENDERBUMP;
+	}
+	return flags;
+}
+
+/*
+================
+idRenderModelStatic::LoadCachedModel
+
+Returns false on a miss, in which case the model is still empty.
+================
+*/
+bool idRenderModelStatic::LoadCachedModel( void ) {
+	idStr			key, storedKey, id, materialName;
+	ID_TIME_T		current;
+	int				version, length, checksum, storedLength, storedTimestamp, storedChecksum;
+	int				i, numSurfaces, flags;
+	idBounds		storedBounds;
+	idList<modelSurface_t> cachedSurfaces;
+	idList<float>	areas;
+	void			*buffer;
+	bool			ok;
+
+	if ( !R_ModelCacheEnabled( name, fastLoad ) ) {
+		return false;
+	}
+
+	if ( !R_ModelCacheSource( name, length, current, checksum ) ) {
+		modelCacheMisses++;
+		return false;
+	}
+
+	int cacheLength = fileSystem->ReadFile( MODEL_CACHE_DIR "/" + name + MODEL_CACHE_EXTENSION, &buffer, NULL );
+	if ( cacheLength <= 0 ) {
+		modelCacheMisses++;
+		return false;
+	}
+
+	R_ModelCacheKey( name, key );
+
+	idFile_Memory f( name, (const char *)buffer, cacheLength );
+
+	f.ReadString( id );
+	f.ReadInt( version );
+	f.ReadString( storedKey );
+	f.ReadInt( storedLength );
+	f.ReadInt( storedTimestamp );
+	f.ReadInt( storedChecksum );
+	f.ReadVec3( storedBounds[0] );
+	f.ReadVec3( storedBounds[1] );
+	f.ReadInt( numSurfaces );
+
+	ok = ( id == MODEL_CACHE_ID && version == MODEL_CACHE_VERSION && storedKey == key && storedLength == length
+		&& storedTimestamp == (int)current && storedChecksum == checksum && numSurfaces >= 0 );
+
+	for ( i = 0; ok && i < numSurfaces; i++ ) {
+		modelSurface_t	surf;
+		float			area;
+
+		f.ReadInt( surf.id );
+		f.ReadString( materialName );
+		f.ReadInt( flags );
+		f.ReadFloat( area );
+
+		surf.shader = declManager->FindMaterial( materialName );
+		surf.geometry = NULL;
+		if ( !surf.shader || R_ModelCacheMaterialFlags( surf.shader ) != flags ) {
+			ok = false;
+			break;
+		}
+
+		surf.geometry = R_ReadStaticTriSurf( &f );
+		if ( !surf.geometry ) {
+			common->Warning( "idRenderModelStatic::LoadCachedModel: bad cache entry for %s", name.c_str() );
+			ok = false;
+			break;
+		}
+
+		cachedSurfaces.Append( surf );
+		areas.Append( area );
+	}
+
+	fileSystem->FreeFile( buffer );
+
+	if ( !ok ) {
+		for ( i = 0; i < cachedSurfaces.Num(); i++ ) {
+			R_FreeStaticTriSurf( cachedSurfaces[i].geometry );
+		}
+		modelCacheMisses++;
+		return false;
+	}
+
+	for ( i = 0; i < cachedSurfaces.Num(); i++ ) {
+		AddSurface( cachedSurfaces[i] );
+
+		// keep the development surface area FinishSurfaces would have added
+		const_cast<idMaterial *>( cachedSurfaces[i].shader )->AddToSurfaceArea( areas[i] );
+	}
+
+	bounds = storedBounds;
+	timeStamp = current;
+	purged = false;
+
+	modelCacheHits++;
+
+	return true;
+}
+
+/*
+================
+idRenderModelStatic::WriteCachedModel
+
+Called after FinishSurfaces on a model that was loaded from its source.
+================
+*/
+void idRenderModelStatic::WriteCachedModel( void ) const {
+	ID_TIME_T	current;
+	idStr		key;
+	int			i, j, length, checksum;
+
+	if ( !R_ModelCacheEnabled( name, fastLoad ) || defaulted ) {
+		return;
+	}
+
+	if ( !R_ModelCacheSource( name, length, current, checksum ) ) {
+		return;
+	}
+
+	R_ModelCacheKey( name, key );
+
+	idFile *f = fileSystem->OpenFileWrite( MODEL_CACHE_DIR "/" + name + MODEL_CACHE_EXTENSION );
+	if ( !f ) {
+		common->Warning( "idRenderModelStatic::WriteCachedModel: couldn't write cache entry for %s", name.c_str() );
+		return;
+	}
+
+	f->WriteString( MODEL_CACHE_ID );
+	f->WriteInt( MODEL_CACHE_VERSION );
+	f->WriteString( key );
+	f->WriteInt( length );
+	f->WriteInt( (int)current );
+	f->WriteInt( checksum );
+	f->WriteVec3( bounds[0] );
+	f->WriteVec3( bounds[1] );
+	f->WriteInt( surfaces.Num() );
+
+	for ( i = 0; i < surfaces.Num(); i++ ) {
+		const modelSurface_t *surf = &surfaces[i];
+		const srfTriangles_t *tri = surf->geometry;
+		float area = 0.0f;
+
+		for ( j = 0; j < tri->numIndexes; j += 3 ) {
+			area += idWinding::TriangleArea( tri->verts[tri->indexes[j]].xyz,
+				tri->verts[tri->indexes[j+1]].xyz, tri->verts[tri->indexes[j+2]].xyz );
+		}
+
+		f->WriteInt( surf->id );
+		f->WriteString( surf->shader->GetName() );
+		f->WriteInt( R_ModelCacheMaterialFlags( surf->shader ) );
+		f->WriteFloat( area );
+		R_WriteStaticTriSurf( f, tri );
+	}
+
+	modelCacheWrites++;
+
+	fileSystem->CloseFile( f );
+}
+
+/*
+================
+R_ModelCacheStats_f
+================
+*/
+void R_ModelCacheStats_f( const idCmdArgs &args ) {
+	common->Printf( "model cache is %s\n", idRenderModelStatic::r_useModelCache.GetBool() ? "enabled" : "disabled" );
+	common->Printf( "%5i hits\n", modelCacheHits );
+	common->Printf( "%5i misses\n", modelCacheMisses );
+	common->Printf( "%5i writes\n", modelCacheWrites );
+}
+
+/*
+================
+R_PurgeModelCache_f
+================
+*/
+void R_PurgeModelCache_f( const idCmdArgs &args ) {
+	idFileList *files = fileSystem->ListFilesTree( MODEL_CACHE_DIR, MODEL_CACHE_EXTENSION, false );
+
+	for ( int i = 0; i < files->GetNumFiles(); i++ ) {
+		fileSystem->RemoveFile( files->GetFile( i ) );
+	}
+	common->Printf( "removed %i model cache entries\n", files->GetNumFiles() );
+
+	fileSystem->FreeFileList( files );
+
+	modelCacheHits = 0;
+	modelCacheMisses = 0;
+	modelCacheWrites = 0;
+}
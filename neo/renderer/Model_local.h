@@ -95,6 +95,15 @@ public:
 	bool						LoadFLT( const char *fileName );
 	bool						LoadMA( const char *filename );
 
+	bool						LoadCachedModel( void );
+	void						WriteCachedModel( void ) const;
+
+	// queue the surface cleanup of FinishSurfaces and run it for all models at once
+	static void					BeginDeferredCleanup();
+	static void					EndDeferredCleanup();
+	// drops the queue of a load that didn't reach EndDeferredCleanup
+	static void					ClearDeferredCleanup();
+
 	bool						ConvertASEToModelSurfaces( const struct aseModel_s *ase );
 	bool						ConvertLWOToModelSurfaces( const struct st_lwObject *lwo );
 	bool						ConvertMAToModelSurfaces (const struct maModel_s *ma );
@@ -111,6 +120,9 @@ public:
 	int							overlaysAdded;
 
 protected:
+	void						AddSurfaceCleanups( idList<struct triCleanup_s> &cleanups ) const;
+	void						FinishCleanedSurfaces();
+
 	int							lastModifiedFrame;
 	int							lastArchivedFrame;
 
@@ -128,8 +140,15 @@ protected:
 	static idCVar				r_slopVertex;			// merge xyz coordinates this far apart
 	static idCVar				r_slopTexCoord;			// merge texture coordinates this far apart
 	static idCVar				r_slopNormal;			// merge normals that dot less than this
+
+public:
+	static idCVar				r_useModelCache;		// store finished ASE/LWO/MA surfaces in fs_savepath
 };
 
+void	R_ModelCacheStats_f( const idCmdArgs &args );
+void	R_PurgeModelCache_f( const idCmdArgs &args );
+void	R_BenchmarkParticles_f( const idCmdArgs &args );
+
 /*
 ===============================================================================
 
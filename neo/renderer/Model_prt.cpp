@@ -62,13 +62,170 @@ void idRenderModelPrt::TouchData( void ) {
 	particleSystem = static_cast<const idDeclParticle *>( declManager->FindType( DECL_PARTICLE, name ) );
 }
 
+/*
+===============================================================================
+
+	The static model a particle model instantiates for one entity.
+
+	The quads of a time invariant stage only change when a particle respawns,
+	so they are kept between frames and only the verts are rebuilt.
+
+===============================================================================
+*/
+
+typedef struct {
+	int					seedCycle;		// cycle the random seed came from, -1 if nothing is cached
+	bool				visible;		// false if the particle is faded out
+	idVec3				origin;
+	float				cosAngle;
+	float				sinAngle;
+	float				width;
+	float				height;
+	float				s;
+	float				sWidth;
+	byte				color[4];
+} prtCachedQuad_t;
+
+class idRenderModelPrtSnapshot : public idRenderModelStatic {
+public:
+						idRenderModelPrtSnapshot() { diversity = 0.0f; }
+
+	float				diversity;		// the random seeds of the cached quads depend on it
+	idList< idList<prtCachedQuad_t> > stageQuads;
+};
+
+static idParticleBatch	particleBatch;
+
+/*
+====================
+R_CreateStageParticles
+
+Creates the verts of all the particles of a stage that are alive, one at a time
+with CreateParticle or batched. cachedQuads is only used for time invariant stages.
+====================
+*/
+static int R_CreateStageParticles( const idParticleStage *stage, particleGen_t &g, idDrawVert *verts, bool batched, idList<prtCachedQuad_t> *cachedQuads ) {
+	const renderEntity_t *renderEntity = g.renderEnt;
+	idRandom steppingRandom, steppingRandom2;
+	int numVerts = 0;
+
+	batched = batched && stage->CanBatch();
+	if ( batched ) {
+		particleBatch.Begin( stage->totalParticles * stage->NumQuadsPerParticle() );
+	} else {
+		cachedQuads = NULL;
+	}
+
+	int stageAge = g.renderView->time + renderEntity->shaderParms[SHADERPARM_TIMEOFFSET] * 1000 - stage->timeOffset * 1000;
+	int	stageCycle = stageAge / stage->cycleMsec;
+
+	// some particles will be in this cycle, some will be in the previous cycle
+	steppingRandom.SetSeed( (( stageCycle << 10 ) & idRandom::MAX_RAND) ^ (int)( renderEntity->shaderParms[SHADERPARM_DIVERSITY] * idRandom::MAX_RAND )  );
+	steppingRandom2.SetSeed( (( (stageCycle-1) << 10 ) & idRandom::MAX_RAND) ^ (int)( renderEntity->shaderParms[SHADERPARM_DIVERSITY] * idRandom::MAX_RAND )  );
+
+	for ( int index = 0; index < stage->totalParticles; index++ ) {
+		g.index = index;
+
+		// bump the random
+		steppingRandom.RandomInt();
+		steppingRandom2.RandomInt();
+
+		// calculate local age for this index
+		int	bunchOffset = stage->particleLife * 1000 * stage->spawnBunching * index / stage->totalParticles;
+
+		int particleAge = stageAge - bunchOffset;
+		int	particleCycle = particleAge / stage->cycleMsec;
+		if ( particleCycle < 0 ) {
+			// before the particleSystem spawned
+			continue;
+		}
+		if ( stage->cycles && particleCycle >= stage->cycles ) {
+			// cycled systems will only run cycle times
+			continue;
+		}
+
+		if ( particleCycle == stageCycle ) {
+			g.random = steppingRandom;
+		} else {
+			g.random = steppingRandom2;
+		}
+
+		int	inCycleTime = particleAge - particleCycle * stage->cycleMsec;
+
+		if ( renderEntity->shaderParms[SHADERPARM_PARTICLE_STOPTIME] &&
+			g.renderView->time - inCycleTime >= renderEntity->shaderParms[SHADERPARM_PARTICLE_STOPTIME]*1000 ) {
+			// don't fire any more particles
+			continue;
+		}
+
+		// supress particles before or after the age clamp
+		g.frac = (float)inCycleTime / ( stage->particleLife * 1000 );
+		if ( g.frac < 0.0f ) {
+			// yet to be spawned
+			continue;
+		}
+		if ( g.frac > 1.0f ) {
+			// this particle is in the deadTime band
+			continue;
+		}
+
+		// this is needed so aimed particles can calculate origins at different times
+		g.originalRandom = g.random;
+
+		g.age = g.frac * stage->particleLife;
+
+		if ( !batched ) {
+			// if the particle doesn't get drawn because it is faded out or beyond a kill region, don't increment the verts
+			numVerts += stage->CreateParticle( &g, verts + numVerts );
+			continue;
+		}
+
+		if ( cachedQuads == NULL ) {
+			stage->AddToBatch( &g, particleBatch );
+			continue;
+		}
+
+		// the quad of a time invariant particle only depends on its random seed
+		prtCachedQuad_t &cached = (*cachedQuads)[index];
+		int seedCycle = ( particleCycle == stageCycle ) ? stageCycle : stageCycle - 1;
+
+		if ( cached.seedCycle != seedCycle ) {
+			int n = particleBatch.Num();
+
+			stage->AddToBatch( &g, particleBatch );
+
+			cached.seedCycle = seedCycle;
+			cached.visible = ( particleBatch.Num() > n );
+			if ( cached.visible ) {
+				const particleQuads_t &quads = particleBatch.GetQuads();
+				cached.origin.Set( quads.originX[n], quads.originY[n], quads.originZ[n] );
+				cached.cosAngle = quads.cosAngle[n];
+				cached.sinAngle = quads.sinAngle[n];
+				cached.width = quads.width[n];
+				cached.height = quads.height[n];
+				cached.s = quads.s[n];
+				cached.sWidth = quads.sWidth[n];
+				memcpy( cached.color, &quads.color[n], 4 );
+			}
+		} else if ( cached.visible ) {
+			particleBatch.AddQuad( cached.origin, cached.cosAngle, cached.sinAngle, cached.width, cached.height, cached.s, cached.sWidth, cached.color );
+		}
+	}
+
+	if ( batched ) {
+		numVerts = stage->CreateBatchVerts( &g, particleBatch, verts );
+	}
+
+	return numVerts;
+}
+
 /*
 ====================
 idRenderModelPrt::InstantiateDynamicModel
 ====================
 */
 idRenderModel *idRenderModelPrt::InstantiateDynamicModel( const struct renderEntity_s *renderEntity, const struct viewDef_s *viewDef, idRenderModel *cachedModel ) {
-	idRenderModelStatic	*staticModel;
+	idRenderModelPrtSnapshot	*staticModel;
 
 	if ( cachedModel && !r_useCachedDynamicModels.GetBool() ) {
 		delete cachedModel;
@@ -96,17 +253,24 @@ idRenderModel *idRenderModelPrt::InstantiateDynamicModel( const struct renderEnt
 
 	if ( cachedModel != NULL ) {
 
-		assert( dynamic_cast<idRenderModelStatic *>(cachedModel) != NULL );
+		assert( dynamic_cast<idRenderModelPrtSnapshot *>(cachedModel) != NULL );
 		assert( idStr::Icmp( cachedModel->Name(), parametricParticle_SnapshotName ) == 0 );
 
-		staticModel = static_cast<idRenderModelStatic *>(cachedModel);
+		staticModel = static_cast<idRenderModelPrtSnapshot *>(cachedModel);
 
 	} else {
 
-		staticModel = new idRenderModelStatic;
+		staticModel = new idRenderModelPrtSnapshot;
 		staticModel->InitEmpty( parametricParticle_SnapshotName );
 	}
 
+	// the cached quads were created with the random seeds of another diversity
+	if ( staticModel->stageQuads.Num() != particleSystem->stages.Num() || staticModel->diversity != renderEntity->shaderParms[SHADERPARM_DIVERSITY] ) {
+		staticModel->diversity = renderEntity->shaderParms[SHADERPARM_DIVERSITY];
+		staticModel->stageQuads.Clear();
+		staticModel->stageQuads.SetNum( particleSystem->stages.Num() );
+	}
+
 	particleGen_t g;
 
 	g.renderEnt = renderEntity;
@@ -128,15 +292,6 @@ idRenderModel *idRenderModelPrt::InstantiateDynamicModel( const struct renderEnt
 			continue;
 		}
 
-		idRandom steppingRandom, steppingRandom2;
-
-		int stageAge = g.renderView->time + renderEntity->shaderParms[SHADERPARM_TIMEOFFSET] * 1000 - stage->timeOffset * 1000;
-		int	stageCycle = stageAge / stage->cycleMsec;
-
-		// some particles will be in this cycle, some will be in the previous cycle
-		steppingRandom.SetSeed( (( stageCycle << 10 ) & idRandom::MAX_RAND) ^ (int)( renderEntity->shaderParms[SHADERPARM_DIVERSITY] * idRandom::MAX_RAND )  );
-		steppingRandom2.SetSeed( (( (stageCycle-1) << 10 ) & idRandom::MAX_RAND) ^ (int)( renderEntity->shaderParms[SHADERPARM_DIVERSITY] * idRandom::MAX_RAND )  );
-
 		int	count = stage->totalParticles * stage->NumQuadsPerParticle();
 
 		int surfaceNum;
@@ -155,64 +310,20 @@ idRenderModel *idRenderModelPrt::InstantiateDynamicModel( const struct renderEnt
 			R_AllocStaticTriSurfPlanes( surf->geometry, 6 * count );
 		}
 
-		int numVerts = 0;
-		idDrawVert *verts = surf->geometry->verts;
+		idList<prtCachedQuad_t> *cachedQuads = NULL;
 
-		for ( int index = 0; index < stage->totalParticles; index++ ) {
-			g.index = index;
-
-			// bump the random
-			steppingRandom.RandomInt();
-			steppingRandom2.RandomInt();
-
-			// calculate local age for this index
-			int	bunchOffset = stage->particleLife * 1000 * stage->spawnBunching * index / stage->totalParticles;
-
-			int particleAge = stageAge - bunchOffset;
-			int	particleCycle = particleAge / stage->cycleMsec;
-			if ( particleCycle < 0 ) {
-				// before the particleSystem spawned
-				continue;
+		if ( r_batchParticles.GetBool() && stage->IsTimeInvariant() ) {
+			cachedQuads = &staticModel->stageQuads[stageNum];
+			if ( cachedQuads->Num() != stage->totalParticles ) {
+				cachedQuads->SetNum( stage->totalParticles );
+				for ( int i = 0; i < stage->totalParticles; i++ ) {
+					(*cachedQuads)[i].seedCycle = -1;
+				}
 			}
-			if ( stage->cycles && particleCycle >= stage->cycles ) {
-				// cycled systems will only run cycle times
-				continue;
-			}
-
-			if ( particleCycle == stageCycle ) {
-				g.random = steppingRandom;
-			} else {
-				g.random = steppingRandom2;
-			}
-
-			int	inCycleTime = particleAge - particleCycle * stage->cycleMsec;
-
-			if ( renderEntity->shaderParms[SHADERPARM_PARTICLE_STOPTIME] &&
-				g.renderView->time - inCycleTime >= renderEntity->shaderParms[SHADERPARM_PARTICLE_STOPTIME]*1000 ) {
-				// don't fire any more particles
-				continue;
-			}
-
-			// supress particles before or after the age clamp
-			g.frac = (float)inCycleTime / ( stage->particleLife * 1000 );
-			if ( g.frac < 0.0f ) {
-				// yet to be spawned
-				continue;
-			}
-			if ( g.frac > 1.0f ) {
-				// this particle is in the deadTime band
-				continue;
-			}
-
-			// this is needed so aimed particles can calculate origins at different times
-			g.originalRandom = g.random;
-
-			g.age = g.frac * stage->particleLife;
-
-			// if the particle doesn't get drawn because it is faded out or beyond a kill region, don't increment the verts
-			numVerts += stage->CreateParticle( &g, verts + numVerts );
 		}
 
+		int numVerts = R_CreateStageParticles( stage, g, surf->geometry->verts, r_batchParticles.GetBool(), cachedQuads );
+
 		// numVerts must be a multiple of 4
 		assert( ( numVerts & 3 ) == 0 && numVerts <= 4 * count );
 
@@ -286,3 +397,128 @@ int idRenderModelPrt::Memory() const {
 
 	return total;
 }
+
+/*
+====================
+R_ParticleVertsDiffer
+====================
+*/
+static bool R_ParticleVertsDiffer( const idDrawVert *a, const idDrawVert *b, int numVerts ) {
+	for ( int i = 0; i < numVerts; i++ ) {
+		if ( a[i].xyz != b[i].xyz || a[i].st != b[i].st || a[i].GetColor() != b[i].GetColor() ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+====================
+R_BenchmarkParticles_f
+
+Runs every stage of every particle decl over a number of frames, one particle
+at a time, batched and with the time invariant cache, and checks that all
+of them create the same verts.
+Doesn't need a map or a GL context.
+====================
+*/
+void R_BenchmarkParticles_f( const idCmdArgs &args ) {
+	renderEntity_t			renderEntity;
+	renderView_t			renderView;
+	particleGen_t			g;
+	idList<idDrawVert>		verts[3];
+	idList<prtCachedQuad_t>	cachedQuads;
+	unsigned int			usec[3];
+	int						numDecls, numStages, numInvariant, numQuads, differ[2];
+
+	int numFrames = ( args.Argc() > 1 ) ? atoi( args.Argv( 1 ) ) : 100;
+	if ( numFrames < 1 ) {
+		numFrames = 1;
+	}
+
+	memset( &renderEntity, 0, sizeof( renderEntity ) );
+	renderEntity.axis.Identity();
+	renderEntity.shaderParms[SHADERPARM_RED] = 1.0f;
+	renderEntity.shaderParms[SHADERPARM_GREEN] = 1.0f;
+	renderEntity.shaderParms[SHADERPARM_BLUE] = 1.0f;
+	renderEntity.shaderParms[SHADERPARM_ALPHA] = 1.0f;
+
+	memset( &renderView, 0, sizeof( renderView ) );
+	renderView.viewaxis = idAngles( 20.0f, 30.0f, 0.0f ).ToMat3();
+
+	g.renderEnt = &renderEntity;
+	g.renderView = &renderView;
+	g.origin.Zero();
+	g.axis.Identity();
+
+	numDecls = numStages = numInvariant = numQuads = 0;
+	differ[0] = differ[1] = 0;
+	usec[0] = usec[1] = usec[2] = 0;
+
+	for ( int i = 0; i < declManager->GetNumDecls( DECL_PARTICLE ); i++ ) {
+		const idDeclParticle *particleSystem = static_cast<const idDeclParticle *>( declManager->DeclByIndex( DECL_PARTICLE, i ) );
+
+		numDecls++;
+
+		for ( int stageNum = 0; stageNum < particleSystem->stages.Num(); stageNum++ ) {
+			const idParticleStage *stage = particleSystem->stages[stageNum];
+
+			if ( !stage->cycleMsec || stage->hidden || stage->totalParticles <= 0 ) {
+				continue;
+			}
+
+			numStages++;
+
+			int count = stage->totalParticles * stage->NumQuadsPerParticle();
+			verts[0].AssureSize( 4 * count );
+			verts[1].AssureSize( 4 * count );
+			verts[2].AssureSize( 4 * count );
+
+			bool invariant = stage->IsTimeInvariant();
+			if ( invariant ) {
+				numInvariant++;
+				cachedQuads.SetNum( stage->totalParticles );
+				for ( int j = 0; j < stage->totalParticles; j++ ) {
+					cachedQuads[j].seedCycle = -1;
+				}
+			}
+
+			for ( int frame = 0; frame < numFrames; frame++ ) {
+				renderView.time = frame * 16;
+
+				unsigned int start = Sys_Microseconds();
+				int numVerts = R_CreateStageParticles( stage, g, verts[0].Ptr(), false, NULL );
+				usec[0] += Sys_Microseconds() - start;
+
+				start = Sys_Microseconds();
+				int numBatchedVerts = R_CreateStageParticles( stage, g, verts[1].Ptr(), true, NULL );
+				usec[1] += Sys_Microseconds() - start;
+
+				// the time invariant stages with their cache, the others batched again
+				start = Sys_Microseconds();
+				int numCachedVerts = R_CreateStageParticles( stage, g, verts[2].Ptr(), true, invariant ? &cachedQuads : NULL );
+				usec[2] += Sys_Microseconds() - start;
+
+				numQuads += numVerts / 4;
+
+				if ( numVerts != numBatchedVerts || R_ParticleVertsDiffer( verts[0].Ptr(), verts[1].Ptr(), numVerts ) ) {
+					differ[0]++;
+				}
+				if ( numVerts != numCachedVerts || R_ParticleVertsDiffer( verts[0].Ptr(), verts[2].Ptr(), numVerts ) ) {
+					differ[1]++;
+				}
+			}
+		}
+	}
+
+	if ( !numStages ) {
+		common->Printf( "no particle decls\n" );
+		return;
+	}
+
+	common->Printf( "%i decls, %i stages (%i time invariant), %i frames, %i quads\n", numDecls, numStages, numInvariant, numFrames, numQuads );
+	common->Printf( "one at a time: %6.2f msec\n", usec[0] * 0.001f );
+	common->Printf( "batched:       %6.2f msec using %s\n", usec[1] * 0.001f, SIMDProcessor->GetName() );
+	common->Printf( "cached:        %6.2f msec\n", usec[2] * 0.001f );
+	common->Printf( "%i stage frames differ batched, %i cached\n", differ[0], differ[1] );
+}
@@ -96,6 +96,10 @@ static void R_PerformanceCounters( void ) {
 			tr.pc.c_box_cull_in, tr.pc.c_box_cull_out );
 	}
 
+	if ( r_showExpressions.GetBool() ) {
+		common->Printf( "expressionOps:%i  cachedOps:%i\n", tr.pc.c_expressionOps, tr.pc.c_expressionOpsCached );
+	}
+
 	if ( r_showAlloc.GetBool() ) {
 		common->Printf( "alloc:%i free:%i\n", tr.pc.c_alloc, tr.pc.c_free );
 	}
@@ -631,6 +635,9 @@ void idRenderSystemLocal::EndFrame( int *frontEndMsec, int *backEndMsec ) {
 	// check for dynamic changes that require some initialization
 	R_CheckCvars();
 
+	// stream in prefetched images and stay within the image budget
+	globalImages->UpdateResidency();
+
 	// check for errors
 	GL_CheckErrors();
 
@@ -651,6 +658,7 @@ void idRenderSystemLocal::EndFrame( int *frontEndMsec, int *backEndMsec ) {
 	if ( session->writeDemo ) {
 		session->writeDemo->WriteInt( DS_RENDER );
 		session->writeDemo->WriteInt( DC_END_FRAME );
+		session->writeDemo->EndFrame();
 		if ( r_showDemo.GetBool() ) {
 			common->Printf( "write DC_END_FRAME\n" );
 		}
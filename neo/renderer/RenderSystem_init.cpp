@@ -32,6 +32,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "framework/Console.h"
 #include "framework/Session.h"
 #include "renderer/VertexCache.h"
+#include "renderer/DecalQueue.h"
 #include "renderer/ModelManager.h"
 #include "renderer/RenderWorld_local.h"
 #include "renderer/GuiModel.h"
@@ -50,6 +51,7 @@ glconfig_t	glConfig;
 idCVar r_useLightPortalFlow( "r_useLightPortalFlow", "1", CVAR_RENDERER | CVAR_BOOL, "use a more precise area reference determination" );
 idCVar r_multiSamples( "r_multiSamples", "0", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_INTEGER, "number of antialiasing samples" );
 idCVar r_mode( "r_mode", "5", CVAR_ARCHIVE | CVAR_RENDERER | CVAR_INTEGER, "video mode number" );
+idCVar r_headless( "r_headless", "0", CVAR_RENDERER | CVAR_BOOL | CVAR_INIT, "run without a window or GL context, the back end only counts what it would have drawn" );
 idCVar r_displayRefresh( "r_displayRefresh", "0", CVAR_RENDERER | CVAR_INTEGER | CVAR_NOCHEAT, "optional display refresh rate option for vid mode", 0.0f, 200.0f );
 idCVar r_fullscreen( "r_fullscreen", "0", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_BOOL | CVAR_ROM, "0 = windowed, 1 = full screen" );
 idCVar r_customWidth( "r_customWidth", "720", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_INTEGER, "custom screen width. set r_mode to -1 to activate" );
@@ -123,6 +125,7 @@ idCVar r_shadowPolygonFactor( "r_shadowPolygonFactor", "0", CVAR_RENDERER | CVAR
 idCVar r_skipSubviews( "r_skipSubviews", "0", CVAR_RENDERER | CVAR_INTEGER, "1 = don't render any gui elements on surfaces" );
 idCVar r_skipGuiShaders( "r_skipGuiShaders", "0", CVAR_RENDERER | CVAR_INTEGER, "1 = skip all gui elements on surfaces, 2 = skip drawing but still handle events, 3 = draw but skip events", 0, 3, idCmdSystem::ArgCompletion_Integer<0,3> );
 idCVar r_skipParticles( "r_skipParticles", "0", CVAR_RENDERER | CVAR_INTEGER, "1 = skip all particle systems", 0, 1, idCmdSystem::ArgCompletion_Integer<0,1> );
+idCVar r_batchParticles( "r_batchParticles", "1", CVAR_RENDERER | CVAR_BOOL, "create the particles of a stage in one SIMD batch and keep the quads of time invariant stages" );
 idCVar r_subviewOnly( "r_subviewOnly", "0", CVAR_RENDERER | CVAR_BOOL, "1 = don't render main view, allowing subviews to be debugged" );
 idCVar r_shadows( "r_shadows", "1", CVAR_RENDERER | CVAR_BOOL  | CVAR_ARCHIVE, "enable shadows" );
 idCVar r_testGamma( "r_testGamma", "0", CVAR_RENDERER | CVAR_FLOAT, "if > 0 draw a grid pattern to test gamma levels", 0, 195 );
@@ -170,6 +173,7 @@ idCVar r_showSurfaceInfo( "r_showSurfaceInfo", "0", CVAR_RENDERER | CVAR_BOOL, "
 idCVar r_showNormals( "r_showNormals", "0", CVAR_RENDERER | CVAR_FLOAT, "draws wireframe normals" );
 idCVar r_showMemory( "r_showMemory", "0", CVAR_RENDERER | CVAR_BOOL, "print frame memory utilization" );
 idCVar r_showCull( "r_showCull", "0", CVAR_RENDERER | CVAR_BOOL, "report sphere and box culling stats" );
+idCVar r_showExpressions( "r_showExpressions", "0", CVAR_RENDERER | CVAR_BOOL, "report material expression ops evaluated and reused" );
 idCVar r_showInteractions( "r_showInteractions", "0", CVAR_RENDERER | CVAR_BOOL, "report interaction generation activity" );
 idCVar r_showDepth( "r_showDepth", "0", CVAR_RENDERER | CVAR_BOOL, "display the contents of the depth buffer and the depth range" );
 idCVar r_showSurfaces( "r_showSurfaces", "0", CVAR_RENDERER | CVAR_BOOL, "report surface/light/shadow counts" );
@@ -200,10 +204,71 @@ idCVar r_debugRenderToTexture( "r_debugRenderToTexture", "0", CVAR_RENDERER | CV
 // DG: let users disable the "scale menus to 4:3" hack
 idCVar r_scaleMenusTo43( "r_scaleMenusTo43", "1", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_BOOL, "Scale menus, fullscreen videos and PDA to 4:3 aspect ratio" );
 
+idCVar r_cleanupThreads( "r_cleanupThreads", "2", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_INTEGER, "number of worker threads that clean up model surfaces at load time, 0 cleans them up on the main thread", 0, MAX_CLEANUP_THREADS );
+
+#ifdef NOMT
+// without a worker the queue only delays the decals by a frame
+idCVar r_asyncDecals( "r_asyncDecals", "0", CVAR_RENDERER | CVAR_BOOL, "queue decal and overlay projections and clip the decals on a worker thread at the next frame" );
+#else
+idCVar r_asyncDecals( "r_asyncDecals", "1", CVAR_RENDERER | CVAR_BOOL, "queue decal and overlay projections and clip the decals on a worker thread at the next frame" );
+#endif
+idCVar r_decalBudget( "r_decalBudget", "32", CVAR_RENDERER | CVAR_INTEGER, "number of queued decal and overlay projections taken off the queue each frame", 1, 1024 );
+idCVar r_decalCoalesceDistance( "r_decalCoalesceDistance", "1", CVAR_RENDERER | CVAR_FLOAT, "a queued decal projection with the same material closer than this swallows the new one, 0 never merges" );
+
 // define qgl functions
 #define QGLPROC(name, rettype, args) rettype (GL_APIENTRYP q##name) args;
 #include "renderer/qgl_proc.h"
 
+// null qgl functions for r_headless, they do nothing and return zero
+#define QGLPROC(name, rettype, args) static rettype GL_APIENTRY qglNull_##name args { return (rettype)0; }
+#include "renderer/qgl_proc.h"
+
+static GLuint	nullGLNames;
+
+static void GL_APIENTRY qglNull_GenNames( GLsizei n, GLuint *names ) {
+	for ( int i = 0; i < n; i++ ) {
+		names[i] = ++nullGLNames;
+	}
+}
+
+static void GL_APIENTRY qglNull_GetValues( GLenum pname, GLint *params ) {
+	params[0] = 0;
+}
+
+static const GLubyte * GL_APIENTRY qglNull_GetString( GLenum name ) {
+	return (const GLubyte *)"";
+}
+
+/*
+==================
+R_InitNullGL
+
+Binds every qgl function to a stub, so images, models and the whole front end
+can run on a host without a GPU.  The calls whose results are actually looked
+at (object names, strings and queries) get stubs that return something usable.
+==================
+*/
+static void R_InitNullGL( void ) {
+#define QGLPROC(name, rettype, args) q##name = qglNull_##name;
+#include "renderer/qgl_proc.h"
+
+	qglGenTextures = qglNull_GenNames;
+	qglGenBuffers = qglNull_GenNames;
+	qglGenFramebuffers = qglNull_GenNames;
+	qglGenRenderbuffers = qglNull_GenNames;
+	qglGetIntegerv = qglNull_GetValues;
+	qglGetString = qglNull_GetString;
+
+	glConfig.vendor_string = "none";
+	glConfig.renderer_string = "null renderer";
+	glConfig.version_string = "none";
+	glConfig.extensions_string = "";
+
+	glConfig.maxTextureSize = 4096;
+	glConfig.maxTextureUnits = MAX_MULTITEXTURE_UNITS;
+	glConfig.isFullscreen = false;
+}
+
 /*
 =================
 R_CheckExtension
@@ -417,70 +482,76 @@ void R_InitOpenGL( void ) {
 
 	initSortedVidModes();
 
-	//
-	// initialize OS specific portions of the renderSystem
-	//
-	for ( i = 0 ; i < 2 ; i++ ) {
-		// set the parameters we are trying
+	if ( r_headless.GetBool() ) {
+		common->Printf( "...using the null renderer\n" );
 		R_GetModeInfo( &glConfig.vidWidth, &glConfig.vidHeight, r_mode.GetInteger() );
+		R_InitNullGL();
+	} else {
+		//
+		// initialize OS specific portions of the renderSystem
+		//
+		for ( i = 0 ; i < 2 ; i++ ) {
+			// set the parameters we are trying
+			R_GetModeInfo( &glConfig.vidWidth, &glConfig.vidHeight, r_mode.GetInteger() );
+
+			parms.width = glConfig.vidWidth;
+			parms.height = glConfig.vidHeight;
+			parms.fullScreen = r_fullscreen.GetBool();
+			parms.displayHz = r_displayRefresh.GetInteger();
+			parms.multiSamples = r_multiSamples.GetInteger();
+			parms.stereo = false;
+
+			if ( GLimp_Init( parms ) ) {
+				// it worked
+				break;
+			}
 
-		parms.width = glConfig.vidWidth;
-		parms.height = glConfig.vidHeight;
-		parms.fullScreen = r_fullscreen.GetBool();
-		parms.displayHz = r_displayRefresh.GetInteger();
-		parms.multiSamples = r_multiSamples.GetInteger();
-		parms.stereo = false;
-
-		if ( GLimp_Init( parms ) ) {
-			// it worked
-			break;
-		}
+			if ( i == 1 ) {
+				common->FatalError( "Unable to initialize OpenGL" );
+			}
 
-		if ( i == 1 ) {
-			common->FatalError( "Unable to initialize OpenGL" );
+			// if we failed, set everything back to "safe mode"
+			// and try again
+			r_mode.SetInteger( 3 );
+			r_fullscreen.SetInteger( 0 );
+			r_displayRefresh.SetInteger( 0 );
+			r_multiSamples.SetInteger( 0 );
 		}
 
-		// if we failed, set everything back to "safe mode"
-		// and try again
-		r_mode.SetInteger( 3 );
-		r_fullscreen.SetInteger( 0 );
-		r_displayRefresh.SetInteger( 0 );
-		r_multiSamples.SetInteger( 0 );
-	}
-
-// load qgl function pointers
+		// load qgl function pointers
 #define QGLPROC(name, rettype, args) \
-	q##name = (rettype(GL_APIENTRYP)args)GLimp_ExtensionPointer(#name); \
-	if (!q##name) \
-		common->FatalError("Unable to initialize OpenGL (%s)", #name);
+		q##name = (rettype(GL_APIENTRYP)args)GLimp_ExtensionPointer(#name); \
+		if (!q##name) \
+			common->FatalError("Unable to initialize OpenGL (%s)", #name);
 
 #include "renderer/qgl_proc.h"
 
-	// input and sound systems need to be tied to the new window
-	Sys_InitInput();
-	soundSystem->InitHW();
-
-  // get our config strings
-	glConfig.vendor_string = (const char *)qglGetString(GL_VENDOR);
-	glConfig.renderer_string = (const char *)qglGetString(GL_RENDERER);
-	glConfig.version_string = (const char *)qglGetString(GL_VERSION);
-	glConfig.extensions_string = (const char *)qglGetString(GL_EXTENSIONS);
+		// get our config strings
+		glConfig.vendor_string = (const char *)qglGetString(GL_VENDOR);
+		glConfig.renderer_string = (const char *)qglGetString(GL_RENDERER);
+		glConfig.version_string = (const char *)qglGetString(GL_VERSION);
+		glConfig.extensions_string = (const char *)qglGetString(GL_EXTENSIONS);
 
-  // OpenGL driver constants
-	qglGetIntegerv( GL_MAX_TEXTURE_SIZE, &temp );
-	glConfig.maxTextureSize = temp;
+		// OpenGL driver constants
+		qglGetIntegerv( GL_MAX_TEXTURE_SIZE, &temp );
+		glConfig.maxTextureSize = temp;
 
-	// stubbed or broken drivers may have reported 0...
-	if ( glConfig.maxTextureSize <= 0 ) {
-		glConfig.maxTextureSize = 256;
-	}
+		// stubbed or broken drivers may have reported 0...
+		if ( glConfig.maxTextureSize <= 0 ) {
+			glConfig.maxTextureSize = 256;
+		}
 
-	qglGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, (GLint *)&glConfig.maxTextureUnits);
+		qglGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, (GLint *)&glConfig.maxTextureUnits);
 
-	if (glConfig.maxTextureUnits > MAX_MULTITEXTURE_UNITS) {
-		glConfig.maxTextureUnits = MAX_MULTITEXTURE_UNITS;
+		if (glConfig.maxTextureUnits > MAX_MULTITEXTURE_UNITS) {
+			glConfig.maxTextureUnits = MAX_MULTITEXTURE_UNITS;
+		}
 	}
 
+	// input and sound systems need to be tied to the new window
+	Sys_InitInput();
+	soundSystem->InitHW();
+
 	glConfig.isInitialized = true;
 
   common->Printf("OpenGL vendor: %s\n", glConfig.vendor_string );
@@ -490,8 +561,11 @@ void R_InitOpenGL( void ) {
 	// recheck all the extensions (FIXME: this might be dangerous)
 	R_CheckPortableExtensions();
 
-	cmdSystem->AddCommand("reloadGLSLprograms", R_ReloadGLSLPrograms_f, CMD_FL_RENDERER, "reloads GLSL programs");
-	R_ReloadGLSLPrograms_f(idCmdArgs());
+	// the null renderer never runs a shader
+	if ( !r_headless.GetBool() ) {
+		cmdSystem->AddCommand("reloadGLSLprograms", R_ReloadGLSLPrograms_f, CMD_FL_RENDERER, "reloads GLSL programs");
+		R_ReloadGLSLPrograms_f(idCmdArgs());
+	}
 
 	// allocate the vertex array range or vertex objects
 	vertexCache.Init();
@@ -1576,6 +1650,8 @@ void R_InitCommands( void ) {
 	cmdSystem->AddCommand( "regenerateWorld", R_RegenerateWorld_f, CMD_FL_RENDERER, "regenerates all interactions" );
 	cmdSystem->AddCommand( "showInteractionMemory", R_ShowInteractionMemory_f, CMD_FL_RENDERER, "shows memory used by interactions" );
 	cmdSystem->AddCommand( "showTriSurfMemory", R_ShowTriSurfMemory_f, CMD_FL_RENDERER, "shows memory used by triangle surfaces" );
+	cmdSystem->AddCommand( "vertexCacheStats", R_VertexCacheStats_f, CMD_FL_RENDERER, "shows the simulated vertex cache efficiency of the ordered surfaces" );
+	cmdSystem->AddCommand( "decalQueueStats", R_DecalQueueStats_f, CMD_FL_RENDERER, "shows the decal queue counters and latency" );
 	cmdSystem->AddCommand( "vid_restart", R_VidRestart_f, CMD_FL_RENDERER, "restarts renderSystem" );
 	cmdSystem->AddCommand( "listRenderEntityDefs", R_ListRenderEntityDefs_f, CMD_FL_RENDERER, "lists the entity defs" );
 	cmdSystem->AddCommand( "listRenderLightDefs", R_ListRenderLightDefs_f, CMD_FL_RENDERER, "lists the light defs" );
@@ -1677,6 +1753,9 @@ void idRenderSystemLocal::Shutdown( void ) {
 		globalImages->PurgeAllImages();
 	}
 
+	// the decal worker reads the models
+	decalQueue.Shutdown();
+
 	renderModelManager->Shutdown();
 
 	idCinematic::ShutdownCinematic( );
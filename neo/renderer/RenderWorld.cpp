@@ -29,8 +29,10 @@ If you have questions concerning this license or the applicable additional terms
 #include "sys/platform.h"
 #include "framework/Session.h"
 #include "framework/DeclSkin.h"
+#include "framework/Profiler.h"
 #include "renderer/GuiModel.h"
 #include "renderer/RenderWorld_local.h"
+#include "renderer/DecalQueue.h"
 
 #include "renderer/tr_local.h"
 
@@ -145,6 +147,8 @@ idRenderWorldLocal::idRenderWorldLocal() {
 	interactionTable = 0;
 	interactionTableWidth = 0;
 	interactionTableHeight = 0;
+
+	prefetchAreaNum = -1;
 }
 
 /*
@@ -313,6 +317,9 @@ void idRenderWorldLocal::FreeEntityDef( qhandle_t entityHandle ) {
 		return;
 	}
 
+	// the handle will be reused, so drop the decals queued for this entity
+	decalQueue.RemoveDecals( this, entityHandle );
+
 	R_FreeEntityDefDerivedData( def, false, false );
 
 	if ( session->writeDemo && def->archived ) {
@@ -499,20 +506,19 @@ const renderLight_t *idRenderWorldLocal::GetRenderLight( qhandle_t lightHandle )
 
 /*
 ================
-idRenderWorldLocal::ProjectDecalOntoWorld
+idRenderWorldLocal::DecalEntities
+
+Finds the static entities a projection in global space touches.
 ================
 */
-void idRenderWorldLocal::ProjectDecalOntoWorld( const idFixedWinding &winding, const idVec3 &projectionOrigin, const bool parallel, const float fadeDepth, const idMaterial *material, const int startTime ) {
+void idRenderWorldLocal::DecalEntities( const decalProjectionInfo_t &info, idList<idRenderEntityLocal *> &defs ) {
 	int i, areas[10], numAreas;
 	const areaReference_t *ref;
 	const portalArea_t *area;
 	const idRenderModel *model;
 	idRenderEntityLocal *def;
-	decalProjectionInfo_t info, localInfo;
 
-	if ( !idRenderModelDecal::CreateProjectionInfo( info, winding, projectionOrigin, parallel, fadeDepth, material, startTime ) ) {
-		return;
-	}
+	defs.SetNum( 0, false );
 
 	// get the world areas touched by the projection volume
 	numAreas = BoundsInAreas( info.projectionBounds, areas, 10 );
@@ -544,44 +550,32 @@ void idRenderWorldLocal::ProjectDecalOntoWorld( const idFixedWinding &winding, c
 				continue;
 			}
 
-			// transform the bounding planes, fade planes and texture axis into local space
-			idRenderModelDecal::GlobalProjectionInfoToLocal( localInfo, info, def->parms.origin, def->parms.axis );
-			localInfo.force = ( def->parms.customShader != NULL );
-
-			if ( !def->decals ) {
-				def->decals = idRenderModelDecal::Alloc();
-			}
-			def->decals->CreateDecal( model, localInfo );
+			defs.Append( def );
 		}
 	}
 }
 
 /*
-====================
-idRenderWorldLocal::ProjectDecal
-====================
-*/
-void idRenderWorldLocal::ProjectDecal( qhandle_t entityHandle, const idFixedWinding &winding, const idVec3 &projectionOrigin, const bool parallel, const float fadeDepth, const idMaterial *material, const int startTime ) {
-	decalProjectionInfo_t info, localInfo;
+================
+idRenderWorldLocal::DecalEntity
 
+Returns the entity if it is static and a projection in global space touches it.
+================
+*/
+idRenderEntityLocal *idRenderWorldLocal::DecalEntity( qhandle_t entityHandle, const decalProjectionInfo_t &info ) {
 	if ( entityHandle < 0 || entityHandle >= entityDefs.Num() ) {
-		common->Error( "idRenderWorld::ProjectOverlay: index = %i", entityHandle );
-		return;
+		return NULL;
 	}
 
 	idRenderEntityLocal	*def = entityDefs[ entityHandle ];
 	if ( !def ) {
-		return;
+		return NULL;
 	}
 
 	const idRenderModel *model = def->parms.hModel;
 
 	if ( model == NULL || model->IsDynamicModel() != DM_STATIC || def->parms.callback ) {
-		return;
-	}
-
-	if ( !idRenderModelDecal::CreateProjectionInfo( info, winding, projectionOrigin, parallel, fadeDepth, material, startTime ) ) {
-		return;
+		return NULL;
 	}
 
 	idBounds bounds;
@@ -589,9 +583,20 @@ void idRenderWorldLocal::ProjectDecal( qhandle_t entityHandle, const idFixedWind
 
 	// if the model bounds do not overlap with the projection bounds
 	if ( !info.projectionBounds.IntersectsBounds( bounds ) ) {
-		return;
+		return NULL;
 	}
 
+	return def;
+}
+
+/*
+================
+idRenderWorldLocal::CreateEntityDecal
+================
+*/
+void idRenderWorldLocal::CreateEntityDecal( idRenderEntityLocal *def, const decalProjectionInfo_t &info ) {
+	decalProjectionInfo_t localInfo;
+
 	// transform the bounding planes, fade planes and texture axis into local space
 	idRenderModelDecal::GlobalProjectionInfoToLocal( localInfo, info, def->parms.origin, def->parms.axis );
 	localInfo.force = ( def->parms.customShader != NULL );
@@ -599,21 +604,69 @@ void idRenderWorldLocal::ProjectDecal( qhandle_t entityHandle, const idFixedWind
 	if ( def->decals == NULL ) {
 		def->decals = idRenderModelDecal::Alloc();
 	}
-	def->decals->CreateDecal( model, localInfo );
+	def->decals->CreateDecal( def->parms.hModel, localInfo );
+}
+
+/*
+================
+idRenderWorldLocal::ProjectDecalOntoWorld
+================
+*/
+void idRenderWorldLocal::ProjectDecalOntoWorld( const idFixedWinding &winding, const idVec3 &projectionOrigin, const bool parallel, const float fadeDepth, const idMaterial *material, const int startTime ) {
+	static idList<idRenderEntityLocal *> defs;
+	decalProjectionInfo_t info;
+
+	if ( !idRenderModelDecal::CreateProjectionInfo( info, winding, projectionOrigin, parallel, fadeDepth, material, startTime ) ) {
+		return;
+	}
+
+	DecalEntities( info, defs );
+	for ( int i = 0; i < defs.Num(); i++ ) {
+		if ( !decalQueue.QueueDecal( this, defs[i], info ) ) {
+			CreateEntityDecal( defs[i], info );
+		}
+	}
 }
 
 /*
 ====================
-idRenderWorldLocal::ProjectOverlay
+idRenderWorldLocal::ProjectDecal
 ====================
 */
-void idRenderWorldLocal::ProjectOverlay( qhandle_t entityHandle, const idPlane localTextureAxis[2], const idMaterial *material ) {
+void idRenderWorldLocal::ProjectDecal( qhandle_t entityHandle, const idFixedWinding &winding, const idVec3 &projectionOrigin, const bool parallel, const float fadeDepth, const idMaterial *material, const int startTime ) {
+	decalProjectionInfo_t info;
 
 	if ( entityHandle < 0 || entityHandle >= entityDefs.Num() ) {
 		common->Error( "idRenderWorld::ProjectOverlay: index = %i", entityHandle );
 		return;
 	}
 
+	if ( !idRenderModelDecal::CreateProjectionInfo( info, winding, projectionOrigin, parallel, fadeDepth, material, startTime ) ) {
+		return;
+	}
+
+	idRenderEntityLocal *def = DecalEntity( entityHandle, info );
+	if ( def == NULL ) {
+		return;
+	}
+
+	if ( decalQueue.QueueDecal( this, def, info ) ) {
+		return;
+	}
+
+	CreateEntityDecal( def, info );
+}
+
+/*
+====================
+idRenderWorldLocal::CreateEntityOverlay
+====================
+*/
+void idRenderWorldLocal::CreateEntityOverlay( qhandle_t entityHandle, const idPlane localTextureAxis[2], const idMaterial *material ) {
+	if ( entityHandle < 0 || entityHandle >= entityDefs.Num() ) {
+		return;
+	}
+
 	idRenderEntityLocal	*def = entityDefs[ entityHandle ];
 	if ( !def ) {
 		return;
@@ -633,6 +686,34 @@ void idRenderWorldLocal::ProjectOverlay( qhandle_t entityHandle, const idPlane l
 	def->overlay->CreateOverlay( model, localTextureAxis, material );
 }
 
+/*
+====================
+idRenderWorldLocal::ProjectOverlay
+====================
+*/
+void idRenderWorldLocal::ProjectOverlay( qhandle_t entityHandle, const idPlane localTextureAxis[2], const idMaterial *material ) {
+
+	if ( entityHandle < 0 || entityHandle >= entityDefs.Num() ) {
+		common->Error( "idRenderWorld::ProjectOverlay: index = %i", entityHandle );
+		return;
+	}
+
+	idRenderEntityLocal	*def = entityDefs[ entityHandle ];
+	if ( !def ) {
+		return;
+	}
+
+	if ( def->parms.hModel->IsDynamicModel() != DM_CACHED ) {	// FIXME: probably should be MD5 only
+		return;
+	}
+
+	if ( decalQueue.QueueOverlay( this, entityHandle, localTextureAxis, material ) ) {
+		return;
+	}
+
+	CreateEntityOverlay( entityHandle, localTextureAxis, material );
+}
+
 /*
 ====================
 idRenderWorldLocal::RemoveDecals
@@ -644,6 +725,9 @@ void idRenderWorldLocal::RemoveDecals( qhandle_t entityHandle ) {
 		return;
 	}
 
+	// decals still on the queue would show up after the removal
+	decalQueue.RemoveDecals( this, entityHandle );
+
 	idRenderEntityLocal	*def = entityDefs[ entityHandle ];
 	if ( !def ) {
 		return;
@@ -682,6 +766,8 @@ void idRenderWorldLocal::RenderScene( const renderView_t *renderView ) {
 		return;
 	}
 
+	PROFILE_SCOPE( "RenderScene" );
+
 	copy = *renderView;
 
 	// skip front end rendering work, which will result
@@ -690,6 +776,9 @@ void idRenderWorldLocal::RenderScene( const renderView_t *renderView ) {
 		return;
 	}
 
+	// publish the decals clipped since the last frame and start clipping the queued ones
+	decalQueue.RunFrame();
+
 	if ( renderView->fov_x <= 0 || renderView->fov_y <= 0 ) {
 		common->Error( "idRenderWorld::RenderScene: bad FOVs: %f, %f", renderView->fov_x, renderView->fov_y );
 	}
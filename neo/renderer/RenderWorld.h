@@ -394,6 +394,9 @@ public:
 	virtual void			StartWritingDemo( idDemoFile *demo ) = 0;
 	virtual void			StopWritingDemo() = 0;
 
+	// Writes the state needed to start playback from this point of an indexed demo.
+	virtual void			WriteDemoKeyframe() = 0;
+
 	// Returns true when demoRenderView has been filled in.
 	// adds/updates/frees entityDefs and lightDefs based on the current demo file
 	// and returns the renderView to be used to render this frame.
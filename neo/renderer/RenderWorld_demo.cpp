@@ -86,6 +86,55 @@ void idRenderWorldLocal::StopWritingDemo() {
 //	writeDemo = NULL;
 }
 
+/*
+==============
+WriteDemoKeyframe
+
+Playback after a seek replaces all defs at a keyframe, so every def is
+written again right after it.  The archived flags are left alone: regular
+playback skips keyframe blocks, so the stream still has to write every
+new or changed def itself.
+==============
+*/
+void		idRenderWorldLocal::WriteDemoKeyframe() {
+	int		i;
+
+	// only the main renderWorld writes stuff to demos, not the wipes or
+	// menu renders
+	if ( this != session->rw ) {
+		return;
+	}
+
+	session->writeDemo->WriteInt( DS_RENDER );
+	session->writeDemo->WriteInt( DC_KEYFRAME );
+	session->writeDemo->WriteHashString( mapName );
+
+	// SetPortalState only writes changes
+	for ( i = 0 ; i < numInterAreaPortals ; i++ ) {
+		if ( doublePortals[i].blockingBits ) {
+			session->writeDemo->WriteInt( DS_RENDER );
+			session->writeDemo->WriteInt( DC_SET_PORTAL_STATE );
+			session->writeDemo->WriteInt( i+1 );
+			session->writeDemo->WriteInt( doublePortals[i].blockingBits );
+		}
+	}
+
+	for ( i = 0 ; i < lightDefs.Num() ; i++ ) {
+		if ( lightDefs[i] ) {
+			WriteRenderLight( i, &lightDefs[i]->parms );
+		}
+	}
+	for ( i = 0 ; i < entityDefs.Num() ; i++ ) {
+		if ( entityDefs[i] ) {
+			WriteRenderEntity( i, &entityDefs[i]->parms );
+		}
+	}
+
+	if ( r_showDemo.GetBool() ) {
+		common->Printf( "write DC_KEYFRAME: %s\n", mapName.c_str() );
+	}
+}
+
 /*
 ==============
 ProcessDemoCommand
@@ -250,6 +299,23 @@ bool		idRenderWorldLocal::ProcessDemoCommand( idDemoFile *readDemo, renderView_t
 		}
 
 		break;
+	case DC_KEYFRAME:
+		{
+		// drop everything from before a seek, the keyframe writes all defs next
+		idStr name = readDemo->ReadHashString();
+		if ( r_showDemo.GetBool() ) {
+			common->Printf( "DC_KEYFRAME: %s\n", name.c_str() );
+		}
+		if ( name != mapName ) {
+			InitFromMap( name );
+		} else {
+			FreeDefs();
+			AddWorldModelEntities();
+			ClearPortalStates();
+		}
+		break;
+		}
+
 	case DC_END_FRAME:
 		return true;
 
@@ -32,6 +32,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "renderer/RenderWorld_local.h"
 
 #include "renderer/tr_local.h"
+#include "renderer/DecalQueue.h"
 
 /*
 ================
@@ -96,6 +97,7 @@ void idRenderWorldLocal::FreeWorld() {
 	areaNumRefAllocator.Shutdown();
 
 	mapName = "<FREED>";
+	prefetchAreaNum = -1;
 }
 
 /*
@@ -439,6 +441,10 @@ dump all the interactions
 void idRenderWorldLocal::FreeDefs() {
 	int		i;
 
+	// the decal worker may be clipping against the area models, and
+	// the queued projections refer to entity handles that are going away
+	decalQueue.FreeWorld( this );
+
 	generateAllInteractionsCalled = false;
 
 	if ( interactionTable ) {
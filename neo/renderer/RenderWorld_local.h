@@ -175,6 +175,8 @@ public:
 
 	bool					generateAllInteractionsCalled;
 
+	int						prefetchAreaNum;		// view area the image prefetch queue was built for
+
 	//-----------------------
 	// RenderWorld_load.cpp
 
@@ -211,6 +213,7 @@ public:
 	void					BuildConnectedAreas_r( int areaNum );
 	void					BuildConnectedAreas( void );
 	void					FindViewLightsAndEntities( void );
+	void					PrefetchAreaImages( void );
 
 	int						NumPortals( void ) const;
 	qhandle_t				FindPortal( const idBounds &b ) const;
@@ -225,6 +228,7 @@ public:
 
 	void					StartWritingDemo( idDemoFile *demo );
 	void					StopWritingDemo();
+	void					WriteDemoKeyframe();
 	bool					ProcessDemoCommand( idDemoFile *readDemo, renderView_t *demoRenderView, int *demoTimeOffset );
 
 	void					WriteLoadMap();
@@ -243,6 +247,11 @@ public:
 
 	void					ResizeInteractionTable();
 
+	void					DecalEntities( const decalProjectionInfo_t &info, idList<idRenderEntityLocal *> &defs );
+	idRenderEntityLocal *	DecalEntity( qhandle_t entityHandle, const decalProjectionInfo_t &info );
+	void					CreateEntityDecal( idRenderEntityLocal *def, const decalProjectionInfo_t &info );
+	void					CreateEntityOverlay( qhandle_t entityHandle, const idPlane localTextureAxis[2], const idMaterial *material );
+
 	void					AddEntityRefToArea( idRenderEntityLocal *def, portalArea_t *area );
 	void					AddLightRefToArea( idRenderLightLocal *light, portalArea_t *area );
 
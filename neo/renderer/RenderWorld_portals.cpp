@@ -887,6 +887,101 @@ void idRenderWorldLocal::FindViewLightsAndEntities( void ) {
 		// may have the viewOrigin in a solid/invalid area
 		FlowViewThroughPortals( tr.viewDef->renderView.vieworg, 5, tr.viewDef->frustum );
 	}
+
+	PrefetchAreaImages();
+}
+
+/*
+=============
+R_PrefetchMaterialImages
+=============
+*/
+static void R_PrefetchMaterialImages( const idMaterial *shader ) {
+	if ( !shader ) {
+		return;
+	}
+	for ( int i = 0 ; i < shader->GetNumStages() ; i++ ) {
+		const shaderStage_t *stage = shader->GetStage( i );
+
+		globalImages->PrefetchImage( stage->texture.image );
+
+		if ( stage->newStage ) {
+			for ( int j = 0 ; j < stage->newStage->numFragmentProgramImages ; j++ ) {
+				globalImages->PrefetchImage( stage->newStage->fragmentProgramImages[j] );
+			}
+		}
+	}
+}
+
+/*
+=============
+PrefetchAreaImages
+
+Queues the images used by the models and lights in the view area and
+the areas up to image_prefetchDepth portals away, nearest areas first,
+so they can be streamed in before the back end binds them.
+Closed portals are crossed as well, because doors can open at any time.
+The queue is only rebuilt when the view moves to another area.
+=============
+*/
+void idRenderWorldLocal::PrefetchAreaImages( void ) {
+	int maxDepth = globalImages->image_prefetchDepth.GetInteger();
+
+	if ( maxDepth < 0 || tr.viewDef->isSubview || tr.viewDef->areaNum < 0 ) {
+		return;
+	}
+	if ( tr.viewDef->areaNum == prefetchAreaNum ) {
+		return;
+	}
+	prefetchAreaNum = tr.viewDef->areaNum;
+
+	globalImages->ClearPrefetchQueue();
+
+	idList<int>		areas;
+	idList<bool>	visited;
+
+	visited.SetNum( numPortalAreas );
+	memset( visited.Ptr(), 0, numPortalAreas * sizeof( bool ) );
+
+	areas.Append( prefetchAreaNum );
+	visited[prefetchAreaNum] = true;
+
+	// breadth first, one ring of areas per depth
+	for ( int depth = 0, first = 0 ; depth <= maxDepth && first < areas.Num() ; depth++ ) {
+		int last = areas.Num();
+
+		for ( int i = first ; i < last ; i++ ) {
+			portalArea_t *area = &portalAreas[areas[i]];
+
+			for ( areaReference_t *ref = area->entityRefs.areaNext ; ref != &area->entityRefs ; ref = ref->areaNext ) {
+				const renderEntity_t *parms = &ref->entity->parms;
+				if ( !parms->hModel ) {
+					continue;
+				}
+				for ( int j = 0 ; j < parms->hModel->NumSurfaces() ; j++ ) {
+					const modelSurface_t *surf = parms->hModel->Surface( j );
+					R_PrefetchMaterialImages( R_RemapShaderBySkin( surf->shader, parms->customSkin, parms->customShader ) );
+				}
+			}
+
+			for ( areaReference_t *ref = area->lightRefs.areaNext ; ref != &area->lightRefs ; ref = ref->areaNext ) {
+				R_PrefetchMaterialImages( ref->light->lightShader );
+				globalImages->PrefetchImage( ref->light->falloffImage );
+			}
+
+			if ( depth == maxDepth ) {
+				continue;
+			}
+			for ( portal_t *p = area->portals ; p ; p = p->next ) {
+				if ( !visited[p->intoArea] ) {
+					visited[p->intoArea] = true;
+					areas.Append( p->intoArea );
+				}
+			}
+		}
+
+		first = last;
+	}
 }
 
 /*
@@ -80,7 +80,12 @@ void idVertexCache::ActuallyFree( vertCache_t *block ) {
 	if ( block->tag != TAG_TEMP ) {
 		staticAllocTotal -= block->size;
 		staticCountTotal--;
+
+		if ( block->cpuData ) {
+			Mem_Free( block->cpuData );
+		}
 	}
+	block->cpuData = NULL;
 	block->tag = TAG_FREE;		// mark as free
 
 	// unlink stick it back on the free list
@@ -108,7 +113,7 @@ void idVertexCache::ActuallyFree( vertCache_t *block ) {
 ==============
 idVertexCache::Position
 
-this will be a real pointer with virtual memory,
+this will be a real pointer with cpu buffers,
 but it will be an int offset cast to a pointer with
 ARB_vertex_buffer_object
 
@@ -120,6 +125,10 @@ void *idVertexCache::Position( vertCache_t *buffer ) {
 		common->FatalError( "idVertexCache::Position: bad vertCache_t" );
 	}
 
+	if ( cpuBuffers ) {
+		return buffer->cpuData + buffer->offset;
+	}
+
 	// the ARB vertex object just uses an offset
 		if ( r_showVertexCache.GetInteger() == 2 ) {
 			if ( buffer->tag == TAG_TEMP ) {
@@ -157,6 +166,10 @@ void idVertexCache::Init() {
 	currentBoundVBO = -1;
 	currentBoundVBO_Index = -1;
 
+	// the null renderer has no buffer objects, so everything is
+	// kept in system memory where the back end can still reach it
+	cpuBuffers = r_headless.GetBool();
+
 	if ( r_vertexBufferMegs.GetInteger() < 8 ) {
 		r_vertexBufferMegs.SetInteger( 8 );
 	}
@@ -261,7 +274,11 @@ void idVertexCache::Alloc( void *data, int size, vertCache_t **buffer, bool inde
         block->next->prev = block;
         block->prev->next = block;
 
-        qglGenBuffers( 1, & block->vbo );
+        block->vbo = 0;
+        block->cpuData = NULL;
+        if ( !cpuBuffers ) {
+          qglGenBuffers( 1, & block->vbo );
+        }
       }
     }
   }
@@ -277,7 +294,11 @@ void idVertexCache::Alloc( void *data, int size, vertCache_t **buffer, bool inde
         block->next->prev = block;
         block->prev->next = block;
 
-        qglGenBuffers( 1, & block->vbo );
+        block->vbo = 0;
+        block->cpuData = NULL;
+        if ( !cpuBuffers ) {
+          qglGenBuffers( 1, & block->vbo );
+        }
       }
     }
 
@@ -335,6 +356,12 @@ void idVertexCache::Alloc( void *data, int size, vertCache_t **buffer, bool inde
 	block->indexBuffer = indexBuffer;
 
 	// copy the data
+	if ( cpuBuffers ) {
+		block->cpuData = (byte *)Mem_Alloc( size );
+		memcpy( block->cpuData, data, size );
+		return;
+	}
+
 		if ( indexBuffer ) {
       if (block->vbo != currentBoundVBO_Index) {
         qglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, block->vbo);
@@ -479,6 +506,7 @@ vertCache_t	*idVertexCache::AllocFrameTemp( void *data, int size, bool indexBuff
 				block->prev = &freeDynamicIndexHeaders;
 				block->next->prev = block;
 				block->prev->next = block;
+				block->cpuData = NULL;
 			}
 		}
 	}
@@ -493,6 +521,7 @@ vertCache_t	*idVertexCache::AllocFrameTemp( void *data, int size, bool indexBuff
 				block->prev = &freeDynamicHeaders;
 				block->next->prev = block;
 				block->prev->next = block;
+				block->cpuData = NULL;
 			}
 		}
 	}
@@ -541,6 +570,14 @@ vertCache_t	*idVertexCache::AllocFrameTemp( void *data, int size, bool indexBuff
 
 	// copy the data
 
+  if ( cpuBuffers ) {
+    vertCache_t *temp = indexBuffer ? tempIndexBuffers[listNum] : tempBuffers[listNum];
+    block->vbo = 0;
+    block->cpuData = temp->cpuData;
+    memcpy( block->cpuData + block->offset, data, size );
+    return block;
+  }
+
   if ( indexBuffer ) {
 		block->vbo = tempIndexBuffers[listNum]->vbo;
 
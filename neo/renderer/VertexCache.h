@@ -42,6 +42,7 @@ typedef enum {
 
 typedef struct vertCache_s {
   GLuint vbo;
+  byte *cpuData;    // system memory copy used instead of the vbo with r_headless
   bool indexBuffer;    // holds indexes instead of vertexes
   intptr_t offset;
   int size;        // may be larger than the amount asked for, due
@@ -70,7 +71,7 @@ public:
   // These allocations can be purged, which will zero the pointer.
   void Alloc(void *data, int bytes, vertCache_t **buffer, bool indexBuffer);
 
-  // This will be a real pointer with virtual memory,
+  // This will be a real pointer with cpu buffers,
   // but it will be an int offset cast to a pointer of ARB_vertex_buffer_object
   void *Position(vertCache_t *buffer);
 
@@ -123,6 +124,8 @@ private:
 
   bool allocatingTempBuffer;  // force GL_STREAM_DRAW_ARB
 
+  bool cpuBuffers;      // r_headless, keep everything in system memory and never touch GL
+
   vertCache_t *tempBuffers[NUM_VERTEX_FRAMES];    // allocated at startup
   vertCache_t *tempIndexBuffers[NUM_VERTEX_FRAMES];    // allocated at startup (for Index buffers)
 
@@ -26,6 +26,7 @@ If you have questions concerning this license or the applicable additional terms
 ===========================================================================
 */
 #include "sys/platform.h"
+#include "framework/Profiler.h"
 
 #include "renderer/tr_local.h"
 
@@ -361,6 +362,139 @@ const void	RB_CopyRender( const void *data ) {
 	}
 }
 
+int		backEndStartTime, backEndFinishTime;
+
+/*
+=============
+RB_CountElements
+
+Same counters as RB_DrawElementsWithCounters, without the draw.
+=============
+*/
+static void RB_CountElements( const srfTriangles_t *tri ) {
+	backEnd.pc.c_drawElements++;
+	backEnd.pc.c_drawIndexes += tri->numIndexes;
+	backEnd.pc.c_drawVertexes += tri->numVerts;
+
+	if ( tri->ambientSurface != NULL ) {
+		if ( tri->indexes == tri->ambientSurface->indexes ) {
+			backEnd.pc.c_drawRefIndexes += tri->numIndexes;
+		}
+		if ( tri->verts == tri->ambientSurface->verts ) {
+			backEnd.pc.c_drawRefVertexes += tri->numVerts;
+		}
+	}
+
+	if ( tri->indexCache ) {
+		backEnd.pc.c_vboIndexes += tri->numIndexes;
+	}
+}
+
+/*
+=============
+RB_CountShadowElements
+=============
+*/
+static void RB_CountShadowElements( const srfTriangles_t *tri ) {
+	backEnd.pc.c_shadowElements++;
+	backEnd.pc.c_shadowIndexes += tri->numIndexes;
+	backEnd.pc.c_shadowVertexes += tri->numVerts;
+
+	if ( tri->indexCache ) {
+		backEnd.pc.c_vboIndexes += tri->numIndexes;
+	}
+}
+
+/*
+=============
+RB_CountDrawSurfChain
+=============
+*/
+static void RB_CountDrawSurfChain( const drawSurf_t *surf, bool shadows ) {
+	for ( ; surf ; surf = surf->nextOnLight ) {
+		if ( !surf->geo ) {
+			continue;
+		}
+		if ( shadows ) {
+			RB_CountShadowElements( surf->geo );
+		} else {
+			RB_CountElements( surf->geo );
+		}
+	}
+}
+
+/*
+=============
+RB_CountDrawView
+
+The null renderer version of RB_DrawView.  Every surface and light
+interaction the GLSL back end would submit is counted once, shadow volumes
+are counted with all of their caps.
+=============
+*/
+static void RB_CountDrawView( const void *data ) {
+	const drawSurfsCommand_t *cmd = (const drawSurfsCommand_t *)data;
+
+	backEnd.viewDef = cmd->viewDef;
+
+	if ( !backEnd.viewDef->numDrawSurfs ) {
+		return;
+	}
+	if ( r_skipRender.GetBool() && backEnd.viewDef->viewEntitys ) {
+		return;
+	}
+
+	backEnd.pc.c_surfaces += backEnd.viewDef->numDrawSurfs;
+
+	for ( int i = 0; i < backEnd.viewDef->numDrawSurfs; i++ ) {
+		const drawSurf_t *surf = backEnd.viewDef->drawSurfs[i];
+		if ( surf->geo ) {
+			RB_CountElements( surf->geo );
+		}
+	}
+
+	for ( const viewLight_t *vLight = backEnd.viewDef->viewLights; vLight; vLight = vLight->next ) {
+		RB_CountDrawSurfChain( vLight->globalShadows, true );
+		RB_CountDrawSurfChain( vLight->localShadows, true );
+		RB_CountDrawSurfChain( vLight->localInteractions, false );
+		RB_CountDrawSurfChain( vLight->globalInteractions, false );
+		RB_CountDrawSurfChain( vLight->translucentInteractions, false );
+	}
+}
+
+/*
+====================
+RB_CountBackEndCommands
+
+With r_headless there is no GL context, so the command list is walked and
+counted into backEnd.pc instead of being executed.
+====================
+*/
+static void RB_CountBackEndCommands( const emptyCommand_t *cmds ) {
+	backEndStartTime = Sys_Milliseconds();
+
+	for ( ; cmds ; cmds = (const emptyCommand_t *)cmds->next ) {
+		switch ( cmds->commandId ) {
+		case RC_NOP:
+		case RC_SWAP_BUFFERS:
+		case RC_COPY_RENDER:
+			break;
+		case RC_DRAW_VIEW:
+			RB_CountDrawView( cmds );
+			break;
+		case RC_SET_BUFFER:
+			backEnd.frameCount = ((const setBufferCommand_t *)cmds)->frameCount;
+			break;
+		default:
+			common->Error( "RB_CountBackEndCommands: bad commandId" );
+			break;
+		}
+	}
+
+	backEndFinishTime = Sys_Milliseconds();
+	backEnd.pc.msec = backEndFinishTime - backEndStartTime;
+}
+
 /*
 ====================
 RB_ExecuteBackEndCommands
@@ -369,7 +503,6 @@ This function will be called syncronously if running without
 smp extensions, or asyncronously by another thread.
 ====================
 */
-int		backEndStartTime, backEndFinishTime;
 void RB_ExecuteBackEndCommands( const emptyCommand_t *cmds ) {
 	// r_debugRenderToTexture
 	int	c_draw3d = 0, c_draw2d = 0, c_setBuffers = 0, c_swapBuffers = 0, c_copyRenders = 0;
@@ -378,6 +511,13 @@ void RB_ExecuteBackEndCommands( const emptyCommand_t *cmds ) {
 		return;
 	}
 
+	PROFILE_SCOPE( "RB_ExecuteBackEndCommands" );
+
+	if ( r_headless.GetBool() ) {
+		RB_CountBackEndCommands( cmds );
+		return;
+	}
+
 	backEndStartTime = Sys_Milliseconds();
 
 	// needed for editor rendering
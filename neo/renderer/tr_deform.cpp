@@ -1011,6 +1011,8 @@ static void R_EyeballDeform( drawSurf_t *surf ) {
 //==========================================================================================
 
 
+static idParticleBatch	particleDeformBatch;
+
 /*
 =====================
 R_ParticleDeform
@@ -1099,6 +1101,11 @@ static void R_ParticleDeform( drawSurf_t *surf, bool useArea ) {
 
 			tri->numVerts = 0;
 
+			bool batched = r_batchParticles.GetBool() && stage->CanBatch();
+			if ( batched ) {
+				particleDeformBatch.Begin( count );
+			}
+
 			idRandom	steppingRandom, steppingRandom2;
 
 			int stageAge = g.renderView->time + renderEntity->shaderParms[SHADERPARM_TIMEOFFSET] * 1000 - stage->timeOffset * 1000;
@@ -1192,11 +1199,20 @@ static void R_ParticleDeform( drawSurf_t *surf, bool useArea ) {
 
 				g.age = g.frac * stage->particleLife;
 
+				if ( batched ) {
+					stage->AddToBatch( &g, particleDeformBatch );
+					continue;
+				}
+
 				// if the particle doesn't get drawn because it is faded out or beyond a kill region,
 				// don't increment the verts
 				tri->numVerts += stage->CreateParticle( &g, tri->verts + tri->numVerts );
 			}
 
+			if ( batched ) {
+				tri->numVerts = stage->CreateBatchVerts( &g, particleDeformBatch, tri->verts );
+			}
+
 			if ( tri->numVerts > 0 ) {
 				// build the index list
 				int	indexes = 0;
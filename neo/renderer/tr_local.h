@@ -90,7 +90,8 @@ typedef enum {
 	DC_DEFINE_MODEL,
 	DC_SET_PORTAL_STATE,
 	DC_UPDATE_SOUNDOCCLUSION,
-	DC_GUI_MODEL
+	DC_GUI_MODEL,
+	DC_KEYFRAME
 } demoCommand_t;
 
 /*
@@ -589,6 +590,8 @@ typedef struct {
 	int		c_tangentIndexes;	// R_DeriveTangents()
 	int		c_entityUpdates, c_lightUpdates, c_entityReferences, c_lightReferences;
 	int		c_guiSurfs;
+	int		c_expressionOps;		// material expression ops run by idMaterial::EvaluateRegisters
+	int		c_expressionOpsCached;	// time and global parm dependent ops reused from the same frame
 	int		frontEndMsec;		// sum of time in all RE_RenderScene's in a frame
 } performanceCounters_t;
 
@@ -770,6 +773,7 @@ extern glconfig_t			glConfig;		// outside of TR since it shouldn't be cleared du
 // cvars
 //
 extern idCVar r_mode;					// video mode number
+extern idCVar r_headless;				// no window or GL context, the back end only counts draws
 extern idCVar r_displayRefresh;			// optional display refresh rate option for vid mode
 extern idCVar r_fullscreen;				// 0 = windowed, 1 = full screen
 extern idCVar r_multiSamples;			// number of antialiasing samples
@@ -840,6 +844,7 @@ extern idCVar r_skipFogLights;			// skip all fog lights
 extern idCVar r_skipSubviews;			// 1 = don't render any mirrors / cameras / etc
 extern idCVar r_skipGuiShaders;			// 1 = don't render any gui elements on surfaces
 extern idCVar r_skipParticles;			// 1 = don't render any particles
+extern idCVar r_batchParticles;			// create the particles of a stage in one SIMD batch
 extern idCVar r_skipUpdates;			// 1 = don't accept any entity or light updates, making everything static
 extern idCVar r_skipDeforms;			// leave all deform materials in their original state
 extern idCVar r_skipDynamicTextures;	// don't dynamically create textures
@@ -882,6 +887,7 @@ extern idCVar r_showInteractionFrustums;// show a frustum for each interaction
 extern idCVar r_showInteractionScissors;// show screen rectangle which contains the interaction frustum
 extern idCVar r_showMemory;				// print frame memory utilization
 extern idCVar r_showCull;				// report sphere and box culling stats
+extern idCVar r_showExpressions;		// report material expression ops evaluated and reused
 extern idCVar r_showInteractions;		// report interaction generation activity
 extern idCVar r_showSurfaces;			// report surface/light/shadow counts
 extern idCVar r_showPrimitives;			// report vertex/index/draw counts
@@ -916,6 +922,12 @@ extern idCVar r_materialOverride;		// override all materials
 
 extern idCVar r_debugRenderToTexture;
 
+extern idCVar r_cleanupThreads;		// worker threads that clean up model surfaces at load time
+
+extern idCVar r_asyncDecals;			// queue decal projections and clip them on a worker thread
+extern idCVar r_decalBudget;			// queued decal projections processed per frame
+extern idCVar r_decalCoalesceDistance;	// distance under which queued decal projections are merged
+
 /*
 ====================================================================
 
@@ -1308,9 +1320,32 @@ void				R_RemoveUnusedVerts( srfTriangles_t *tri );
 void				R_RangeCheckIndexes( const srfTriangles_t *tri );
 void				R_CreateVertexNormals( srfTriangles_t *tri );	// also called by dmap
 void				R_DeriveFacePlanes( srfTriangles_t *tri );		// also called by renderbump
-void				R_CleanupTriangles( srfTriangles_t *tri, bool createNormals, bool identifySilEdges, bool useUnsmoothedTangents );
+void				R_CleanupTriangles( srfTriangles_t *tri, bool createNormals, bool identifySilEdges, bool useUnsmoothedTangents, bool orderIndexes = false );
+
+// arguments of one R_CleanupTriangles call
+typedef struct triCleanup_s {
+	srfTriangles_t *	tri;
+	bool				createNormals;
+	bool				identifySilEdges;
+	bool				useUnsmoothedTangents;
+	bool				orderIndexes;
+} triCleanup_t;
+
+const int MAX_CLEANUP_THREADS = 8;
+
+// cleans up independent surfaces on r_cleanupThreads worker threads
+void				R_CleanupTriangleList( const triCleanup_t *jobs, int numJobs );
+
+// the allocators and printing are only safe for the cleanup threads through these
+void				R_LockTriSurfData( void );
+void				R_UnlockTriSurfData( void );
+void				R_TriSurfMessage( bool developerWarning, const char *fmt, ... ) id_attribute((format(printf,2,3)));
 void				R_ReverseTriangles( srfTriangles_t *tri );
 
+// cleaned up surfaces with all their derived data, for the static model cache
+void				R_WriteStaticTriSurf( idFile *f, const srfTriangles_t *tri );
+srfTriangles_t *	R_ReadStaticTriSurf( idFile *f );
+
 // Only deals with vertexes and indexes, not silhouettes, planes, etc.
 // Does NOT perform a cleanup triangles, so there may be duplicated verts in the result.
 srfTriangles_t *	R_MergeSurfaceList( const srfTriangles_t **surfaces, int numSurfaces );
@@ -1414,7 +1449,9 @@ TR_ORDERINDEXES
 =============================================================
 */
 
-void R_OrderIndexes( int numIndexes, glIndex_t *indexes );
+int R_MeshCost( int numIndexes, const glIndex_t *indexes );
+void R_OrderIndexes( srfTriangles_t *tri );
+void R_VertexCacheStats_f( const idCmdArgs &args );
 
 /*
 =============================================================
@@ -32,6 +32,7 @@ If you have questions concerning this license or the applicable additional terms
 
 #include "sys/platform.h"
 #include "framework/Session.h"
+#include "framework/Profiler.h"
 #include "renderer/RenderWorld_local.h"
 
 #include "renderer/tr_local.h"
@@ -1093,6 +1094,8 @@ void R_RenderView( viewDef_t *parms ) {
 		return;
 	}
 
+	PROFILE_SCOPE( "R_RenderView" );
+
 	tr.viewCount++;
 
 	// save view in case we are a subview
@@ -30,183 +30,385 @@ If you have questions concerning this license or the applicable additional terms
 
 #include "renderer/tr_local.h"
 
+/*
+===============================================================================
+
+  Vertex cache optimization
+
+  The triangles of a surface are reordered with Tom Forsyth's linear-speed
+  vertex cache optimizer.  Every vertex is scored by its position in a
+  simulated LRU cache and by the number of triangles still waiting for it,
+  and the triangle with the highest summed vertex score is emitted next.
+  Only the triangles of the vertexes that were in the cache get rescored
+  after each emit, so the pass stays linear in the number of triangles.
+
+  The vertexes are then renumbered in the order the new indexes first use
+  them, so the vertex fetches walk the buffer front to back.
+
+  R_MeshCost feeds indexes through a FIFO post-transform cache and counts the
+  vertex transforms, which gives the ACMR (transforms per triangle) and the
+  ATVR (transforms per referenced vertex) of a surface without a GPU.
+
+===============================================================================
+*/
+
+#define	OPT_CACHE_SIZE			32		// LRU cache the optimizer scores against
+#define	OPT_CACHE_DECAY_POWER	1.5f
+#define	OPT_LAST_TRI_SCORE		0.75f
+#define	OPT_VALENCE_BOOST_SCALE	2.0f
+#define	OPT_VALENCE_BOOST_POWER	0.5f
+#define	OPT_MAX_VALENCE			64		// valence scores beyond this are computed on the fly
+
+#define	FIFO_CACHE_SIZE			24		// FIFO cache R_MeshCost simulates
+
+typedef struct {
+	int			numSurfaces;
+	int			numTris;
+	int			numVerts;
+	int			transformsBefore;
+	int			transformsAfter;
+} vertexCacheStats_t;
+
+static vertexCacheStats_t	vertexCacheStats;
+
+idCVar r_showVertexCache( "r_showVertexCache", "0", CVAR_RENDERER | CVAR_BOOL, "print the simulated vertex cache ACMR and ATVR of each surface R_OrderIndexes optimizes" );
+
 /*
 ===============
 R_MeshCost
+
+Returns the number of vertex transforms a FIFO post-transform cache
+of FIFO_CACHE_SIZE entries needs for the indexes.
 ===============
 */
-#if 0
-#define	CACHE_SIZE	24
-#define	STALL_SIZE	8
-int	R_MeshCost( int numIndexes, glIndex_t *indexes ) {
-	int	inCache[CACHE_SIZE];
-	int	i, j, v;
-	int	c_stalls;
-	int	c_loads;
-	int	fifo;
+int	R_MeshCost( int numIndexes, const glIndex_t *indexes ) {
+	int		i, v;
+	int		numVerts;
+	int		*insertedAt;
+	int		c_loads;
+
+	if ( numIndexes <= 0 ) {
+		return 0;
+	}
 
-	for ( i = 0 ; i < CACHE_SIZE ; i++ ) {
-		inCache[i] = -1;
+	numVerts = 0;
+	for ( i = 0 ; i < numIndexes ; i++ ) {
+		if ( indexes[i] >= numVerts ) {
+			numVerts = indexes[i] + 1;
+		}
 	}
 
-	c_loads = 0;
-	c_stalls = 0;
-	fifo = 0;
+	R_LockTriSurfData();
+	insertedAt = (int *)R_StaticAlloc( numVerts * sizeof( *insertedAt ) );
+	R_UnlockTriSurfData();
+
+	// a vertex is in the cache while fewer than FIFO_CACHE_SIZE
+	// other vertexes were loaded after it
+	for ( i = 0 ; i < numVerts ; i++ ) {
+		insertedAt[i] = -FIFO_CACHE_SIZE - 1;
+	}
 
+	c_loads = 0;
 	for ( i = 0 ; i < numIndexes ; i++ ) {
 		v = indexes[i];
-		for ( j = 0 ; j < CACHE_SIZE ; j++ ) {
-			if ( inCache[ ( fifo + j ) % CACHE_SIZE ] == v ) {
-				break;
-			}
-		}
-		if ( j == CACHE_SIZE ) {
+		if ( c_loads - insertedAt[v] > FIFO_CACHE_SIZE ) {
+			insertedAt[v] = c_loads;
 			c_loads++;
-			inCache[ fifo % CACHE_SIZE ] = v;
-			fifo++;
-		} else if ( j < STALL_SIZE ) {
-			c_stalls++;
 		}
 	}
 
+	R_LockTriSurfData();
+	R_StaticFree( insertedAt );
+	R_UnlockTriSurfData();
+
 	return c_loads;
 }
-#endif
 
+/*
+===============
+R_VertexScore
+===============
+*/
+static float R_VertexScore( const float *cacheScores, const float *valenceScores, int cachePosition, int numActiveTris ) {
+	float	score;
+
+	// a vertex without remaining triangles doesn't pull anything
+	if ( numActiveTris == 0 ) {
+		return -1.0f;
+	}
+
+	score = ( cachePosition >= 0 ) ? cacheScores[cachePosition] : 0.0f;
+
+	// boost the vertexes with few triangles left, to get rid of lone triangles
+	if ( numActiveTris < OPT_MAX_VALENCE ) {
+		score += valenceScores[numActiveTris];
+	} else {
+		score += OPT_VALENCE_BOOST_SCALE * idMath::Pow( (float)numActiveTris, -OPT_VALENCE_BOOST_POWER );
+	}
 
-typedef struct vertRef_s {
-	struct vertRef_s	*next;
-	int			tri;
-} vertRef_t;
+	return score;
+}
 
 /*
 ====================
 R_OrderIndexes
 
 Reorganizes the indexes so they will take best advantage
-of the internal GPU vertex caches
+of the internal GPU vertex caches, then renumbers the vertexes
+in the order they are first used.
+
+This has to run before anything stores triangle or vertex
+numbers, so right after the degenerate triangles are removed.
+The silIndexes are kept in sync with the indexes.
 ====================
 */
-void R_OrderIndexes( int numIndexes, glIndex_t *indexes ) {
-	bool	*triangleUsed;
-	int			numTris;
-	glIndex_t	*oldIndexes;
-	glIndex_t	*base;
-	int			numOldIndexes;
-	int			tri;
-	int			i;
-	vertRef_t	*vref, **vrefs, *vrefTable;
-	int			numVerts;
-	int			v1, v2;
-	int			c_starts;
-	//int			c_cost;
+void R_OrderIndexes( srfTriangles_t *tri ) {
+	float		cacheScores[OPT_CACHE_SIZE];
+	float		valenceScores[OPT_MAX_VALENCE];
+	int			cache[OPT_CACHE_SIZE+3];
+	int			newCache[OPT_CACHE_SIZE+3];
+	int			numCached, numNewCached;
+	int			i, j, k;
+	int			numTris, numVerts, numUsedVerts;
+	int			transformsBefore, transformsAfter;
 
 	if ( !r_orderIndexes.GetBool() ) {
 		return;
 	}
 
-	// save off the original indexes
-	oldIndexes = (glIndex_t *)_alloca( numIndexes * sizeof( *oldIndexes ) );
-	memcpy( oldIndexes, indexes, numIndexes * sizeof( *oldIndexes ) );
-	numOldIndexes = numIndexes;
+	numTris = tri->numIndexes / 3;
+	numVerts = tri->numVerts;
+	if ( numTris < 2 || tri->silIndexes == NULL ) {
+		return;
+	}
 
-	// make a table to mark the triangles when they are emited
-	numTris = numIndexes / 3;
-	triangleUsed = (bool *)_alloca( numTris * sizeof( *triangleUsed ) );
-	memset( triangleUsed, 0, numTris * sizeof( *triangleUsed ) );
+	transformsBefore = R_MeshCost( tri->numIndexes, tri->indexes );
 
-	// find the highest vertex number
-	numVerts = 0;
-	for ( i = 0 ; i < numIndexes ; i++ ) {
-		if ( indexes[i] > numVerts ) {
-			numVerts = indexes[i];
+	// the first three cache positions belong to the last triangle and all get
+	// the same score, so there is no preference for one of its edges
+	for ( i = 0 ; i < OPT_CACHE_SIZE ; i++ ) {
+		if ( i < 3 ) {
+			cacheScores[i] = OPT_LAST_TRI_SCORE;
+		} else {
+			cacheScores[i] = idMath::Pow( 1.0f - (float)( i - 3 ) / ( OPT_CACHE_SIZE - 3 ), OPT_CACHE_DECAY_POWER );
 		}
 	}
-	numVerts++;
-
-	// create a table of triangles used by each vertex
-	vrefs = (vertRef_t **)_alloca( numVerts * sizeof( *vrefs ) );
-	memset( vrefs, 0, numVerts * sizeof( *vrefs ) );
+	valenceScores[0] = 0.0f;
+	for ( i = 1 ; i < OPT_MAX_VALENCE ; i++ ) {
+		valenceScores[i] = OPT_VALENCE_BOOST_SCALE * idMath::Pow( (float)i, -OPT_VALENCE_BOOST_POWER );
+	}
 
-	vrefTable = (vertRef_t *)_alloca( numIndexes * sizeof( *vrefTable ) );
-	for ( i = 0 ; i < numIndexes ; i++ ) {
-		tri = i / 3;
+	// all the work arrays come out of one allocation
+	int workSize = ( numVerts + 1 ) * sizeof( int )		// vertTriStart
+		+ numVerts * sizeof( int )						// vertNumTris
+		+ numVerts * sizeof( int )						// vertCachePos
+		+ numVerts * sizeof( float )					// vertScores
+		+ tri->numIndexes * sizeof( int )				// vertTris
+		+ 2 * tri->numIndexes * sizeof( glIndex_t )		// newIndexes, newSilIndexes
+		+ numTris * sizeof( bool );						// triAdded
+
+	R_LockTriSurfData();
+	byte *work = (byte *)R_StaticAlloc( workSize );
+	R_UnlockTriSurfData();
+
+	int *vertTriStart = (int *)work;
+	int *vertNumTris = vertTriStart + numVerts + 1;
+	int *vertCachePos = vertNumTris + numVerts;
+	float *vertScores = (float *)( vertCachePos + numVerts );
+	int *vertTris = (int *)( vertScores + numVerts );
+	glIndex_t *newIndexes = (glIndex_t *)( vertTris + tri->numIndexes );
+	glIndex_t *newSilIndexes = newIndexes + tri->numIndexes;
+	bool *triAdded = (bool *)( newSilIndexes + tri->numIndexes );
+
+	// create a table of the triangles used by each vertex
+	memset( vertNumTris, 0, numVerts * sizeof( vertNumTris[0] ) );
+	for ( i = 0 ; i < tri->numIndexes ; i++ ) {
+		vertNumTris[tri->indexes[i]]++;
+	}
+	vertTriStart[0] = 0;
+	for ( i = 0 ; i < numVerts ; i++ ) {
+		vertTriStart[i+1] = vertTriStart[i] + vertNumTris[i];
+		vertNumTris[i] = 0;
+	}
+	for ( i = 0 ; i < tri->numIndexes ; i++ ) {
+		int v = tri->indexes[i];
+		vertTris[vertTriStart[v] + vertNumTris[v]++] = i / 3;
+	}
 
-		vrefTable[i].tri = tri;
-		vrefTable[i].next = vrefs[oldIndexes[i]];
-		vrefs[oldIndexes[i]] = &vrefTable[i];
+	for ( i = 0 ; i < numVerts ; i++ ) {
+		vertCachePos[i] = -1;
+		vertScores[i] = R_VertexScore( cacheScores, valenceScores, -1, vertNumTris[i] );
+	}
+	memset( triAdded, 0, numTris * sizeof( triAdded[0] ) );
+
+	// start with the best triangle of the whole surface
+	int bestTri = -1;
+	float bestScore = -1.0f;
+	for ( i = 0 ; i < numTris ; i++ ) {
+		const glIndex_t *base = tri->indexes + i * 3;
+		float score = vertScores[base[0]] + vertScores[base[1]] + vertScores[base[2]];
+		if ( score > bestScore ) {
+			bestScore = score;
+			bestTri = i;
+		}
 	}
 
-	// generate new indexes
-	numIndexes = 0;
-	c_starts = 0;
-	while ( numIndexes != numOldIndexes ) {
-		// find a triangle that hasn't been used
-		for ( tri = 0 ; tri < numTris ; tri++ ) {
-			if ( !triangleUsed[tri] ) {
-				break;
+	numCached = 0;
+	int nextUnadded = 0;
+	for ( i = 0 ; i < numTris ; i++ ) {
+		// if nothing in the cache has triangles left, take the next unused one
+		if ( bestTri < 0 ) {
+			while ( triAdded[nextUnadded] ) {
+				nextUnadded++;
 			}
-		}
-		if ( tri == numTris ) {
-			common->Error( "R_OrderIndexes: ran out of unused tris" );
+			bestTri = nextUnadded;
 		}
 
-		c_starts++;
-
-		do {
-			// emit this tri
-			base = oldIndexes + tri * 3;
-			indexes[numIndexes+0] = base[0];
-			indexes[numIndexes+1] = base[1];
-			indexes[numIndexes+2] = base[2];
-			numIndexes += 3;
-
-			triangleUsed[tri] = true;
-
-			// try to find a shared edge to another unused tri
-			for ( i = 0 ; i < 3 ; i++ ) {
-				v1 = base[i];
-				v2 = base[(i+1)%3];
-
-				for ( vref = vrefs[v1] ; vref ; vref = vref->next ) {
-					tri = vref->tri;
-					if ( triangleUsed[tri] ) {
-						continue;
-					}
-
-					// if this triangle also uses v2, grab it
-					if ( oldIndexes[tri*3+0] == v2
-						|| oldIndexes[tri*3+1] == v2
-						|| oldIndexes[tri*3+2] == v2 ) {
-						break;
-					}
-				}
-				if ( vref ) {
+		// emit the triangle
+		const glIndex_t *base = tri->indexes + bestTri * 3;
+		const glIndex_t *silBase = tri->silIndexes + bestTri * 3;
+		for ( j = 0 ; j < 3 ; j++ ) {
+			newIndexes[i*3+j] = base[j];
+			newSilIndexes[i*3+j] = silBase[j];
+		}
+		triAdded[bestTri] = true;
+
+		// take it out of the active triangles of its vertexes
+		for ( j = 0 ; j < 3 ; j++ ) {
+			int v = base[j];
+			int *tris = vertTris + vertTriStart[v];
+			int last = vertNumTris[v] - 1;
+			for ( k = 0 ; k < last ; k++ ) {
+				if ( tris[k] == bestTri ) {
+					tris[k] = tris[last];
 					break;
 				}
 			}
+			vertNumTris[v] = last;
+		}
+
+		// move its vertexes to the front of the cache
+		numNewCached = 0;
+		for ( j = 0 ; j < 3 ; j++ ) {
+			newCache[numNewCached++] = base[j];
+		}
+		for ( j = 0 ; j < numCached ; j++ ) {
+			int v = cache[j];
+			if ( v != base[0] && v != base[1] && v != base[2] ) {
+				newCache[numNewCached++] = v;
+			}
+		}
 
-			// if we couldn't chain off of any verts, we need to find a new one
-			if ( i == 3 ) {
-				break;
+		// rescore the vertexes, including the ones that just fell out
+		for ( j = 0 ; j < numNewCached ; j++ ) {
+			int v = newCache[j];
+			if ( j < OPT_CACHE_SIZE ) {
+				vertCachePos[v] = j;
+				cache[j] = v;
+			} else {
+				vertCachePos[v] = -1;
 			}
-		} while ( 1 );
+			vertScores[v] = R_VertexScore( cacheScores, valenceScores, vertCachePos[v], vertNumTris[v] );
+		}
+		numCached = Min( numNewCached, OPT_CACHE_SIZE );
+
+		// only the triangles of those vertexes changed score
+		bestTri = -1;
+		bestScore = -1.0f;
+		for ( j = 0 ; j < numNewCached ; j++ ) {
+			int v = newCache[j];
+			const int *tris = vertTris + vertTriStart[v];
+			for ( k = 0 ; k < vertNumTris[v] ; k++ ) {
+				const glIndex_t *other = tri->indexes + tris[k] * 3;
+				float score = vertScores[other[0]] + vertScores[other[1]] + vertScores[other[2]];
+				if ( score > bestScore ) {
+					bestScore = score;
+					bestTri = tris[k];
+				}
+			}
+		}
 	}
 
-	//c_cost = R_MeshCost( numIndexes, indexes );
+	// renumber the vertexes in the order the new indexes use them,
+	// the unreferenced ones go to the end
+	int *remap = vertTriStart;
+	for ( i = 0 ; i < numVerts ; i++ ) {
+		remap[i] = -1;
+	}
+	numUsedVerts = 0;
+	for ( i = 0 ; i < tri->numIndexes ; i++ ) {
+		if ( remap[newIndexes[i]] == -1 ) {
+			remap[newIndexes[i]] = numUsedVerts++;
+		}
+	}
+	j = numUsedVerts;
+	for ( i = 0 ; i < numVerts ; i++ ) {
+		if ( remap[i] == -1 ) {
+			remap[i] = j++;
+		}
+	}
 
-}
+	R_LockTriSurfData();
+	idDrawVert *oldVerts = (idDrawVert *)R_StaticAlloc( numVerts * sizeof( oldVerts[0] ) );
+	R_UnlockTriSurfData();
 
+	memcpy( oldVerts, tri->verts, numVerts * sizeof( oldVerts[0] ) );
+	for ( i = 0 ; i < numVerts ; i++ ) {
+		tri->verts[remap[i]] = oldVerts[i];
+	}
+	for ( i = 0 ; i < tri->numIndexes ; i++ ) {
+		tri->indexes[i] = remap[newIndexes[i]];
+		tri->silIndexes[i] = remap[newSilIndexes[i]];
+	}
 
-/*
+	R_LockTriSurfData();
+	R_StaticFree( oldVerts );
+	R_StaticFree( work );
+	R_UnlockTriSurfData();
+
+	transformsAfter = R_MeshCost( tri->numIndexes, tri->indexes );
+
+	R_LockTriSurfData();
+	vertexCacheStats.numSurfaces++;
+	vertexCacheStats.numTris += numTris;
+	vertexCacheStats.numVerts += numUsedVerts;
+	vertexCacheStats.transformsBefore += transformsBefore;
+	vertexCacheStats.transformsAfter += transformsAfter;
+	R_UnlockTriSurfData();
+
+	if ( r_showVertexCache.GetBool() ) {
+		R_TriSurfMessage( false, "%6i tris %6i verts: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", numTris, numUsedVerts,
+			(float)transformsBefore / numTris, (float)transformsAfter / numTris,
+			(float)transformsBefore / numUsedVerts, (float)transformsAfter / numUsedVerts );
+	}
+}
 
-  add all triangles that can be specified by the vertexes in the last 14 cache positions
+/*
+===============
+R_VertexCacheStats_f
 
-  pick a new vert to add to the cache
-  don't pick one in the 24 previous cache positions
-  try to pick one that will enable the creation of as many triangles as possible
+Prints the simulated vertex cache efficiency of all the surfaces
+R_OrderIndexes optimized, "vertexCacheStats clear" starts over.
+===============
+*/
+void R_VertexCacheStats_f( const idCmdArgs &args ) {
+	const vertexCacheStats_t &s = vertexCacheStats;
 
-  look for a vert that shares an edge with the vert about to be evicted
+	if ( args.Argc() > 1 && !idStr::Icmp( args.Argv( 1 ), "clear" ) ) {
+		memset( &vertexCacheStats, 0, sizeof( vertexCacheStats ) );
+		return;
+	}
 
+	if ( !r_orderIndexes.GetBool() ) {
+		common->Printf( "r_orderIndexes is off\n" );
+	}
+	if ( s.numTris == 0 ) {
+		common->Printf( "no surfaces ordered\n" );
+		return;
+	}
 
-*/
+	common->Printf( "%i surfaces, %i tris, %i verts, %i entry FIFO cache\n", s.numSurfaces, s.numTris, s.numVerts, FIFO_CACHE_SIZE );
+	common->Printf( "transforms: %i -> %i\n", s.transformsBefore, s.transformsAfter );
+	common->Printf( "ACMR: %.3f -> %.3f\n", (float)s.transformsBefore / s.numTris, (float)s.transformsAfter / s.numTris );
+	common->Printf( "ATVR: %.3f -> %.3f\n", (float)s.transformsBefore / s.numVerts, (float)s.transformsAfter / s.numVerts );
+}
@@ -30,6 +30,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "renderer/VertexCache.h"
 
 #include "renderer/tr_local.h"
+#include "renderer/DecalQueue.h"
 
 /*
 ==============================================================================
@@ -119,10 +120,29 @@ is highly uneven.
 const int MAX_SIL_EDGES			= 0x10000;
 const int SILEDGE_HASH_SIZE		= 1024;
 
-static int			numSilEdges;
-static silEdge_t *	silEdges;
-static idHashIndex	silEdgeHash( SILEDGE_HASH_SIZE, MAX_SIL_EDGES );
-static int			numPlanes;
+// R_IdentifySilEdges keeps its edges here, one per call, so
+// surfaces can be cleaned up on several threads at once
+typedef struct {
+	int				numSilEdges;
+	int				maxSilEdges;
+	silEdge_t *		silEdges;
+	idHashIndex		silEdgeHash;
+	int				numPlanes;
+	int				c_duplicatedEdges;
+	int				c_tripledEdges;
+} silEdgeWorkspace_t;
+
+// set while R_CleanupTriangleList runs on worker threads, the
+// allocators below and the heap then need CRITICAL_SECTION_THREE
+static bool			triSurfThreaded;
+
+typedef struct {
+	bool			developerWarning;
+	idStr			text;
+} triSurfMessage_t;
+
+// messages of the worker threads, printed by the main thread
+static idList<triSurfMessage_t>	triSurfMessages;
 
 static idBlockAlloc<srfTriangles_t, 1<<8>				srfTrianglesAllocator;
 
@@ -149,14 +169,68 @@ static idDynamicAlloc<int, 1<<16, 1<<10>				triDupVertAllocator;
 #endif
 
 
+/*
+===============
+R_LockTriSurfData
+
+Only locks while R_CleanupTriangleList runs on worker threads.
+===============
+*/
+void R_LockTriSurfData( void ) {
+#ifndef NOMT
+	if ( triSurfThreaded ) {
+		Sys_EnterCriticalSection( CRITICAL_SECTION_THREE );
+	}
+#endif
+}
+
+/*
+===============
+R_UnlockTriSurfData
+===============
+*/
+void R_UnlockTriSurfData( void ) {
+#ifndef NOMT
+	if ( triSurfThreaded ) {
+		Sys_LeaveCriticalSection( CRITICAL_SECTION_THREE );
+	}
+#endif
+}
+
+/*
+===============
+R_TriSurfMessage
+
+Worker threads can't print, their messages wait for R_CleanupTriangleList.
+===============
+*/
+void R_TriSurfMessage( bool developerWarning, const char *fmt, ... ) {
+	va_list		argptr;
+	char		text[MAX_STRING_CHARS];
+
+	va_start( argptr, fmt );
+	idStr::vsnPrintf( text, sizeof( text ), fmt, argptr );
+	va_end( argptr );
+
+	if ( triSurfThreaded ) {
+		R_LockTriSurfData();
+		triSurfMessage_t &message = triSurfMessages.Alloc();
+		message.developerWarning = developerWarning;
+		message.text = text;
+		R_UnlockTriSurfData();
+	} else if ( developerWarning ) {
+		common->DWarning( "%s", text );
+	} else {
+		common->Printf( "%s", text );
+	}
+}
+
 /*
 ===============
 R_InitTriSurfData
 ===============
 */
 void R_InitTriSurfData( void ) {
-	silEdges = (silEdge_t *)R_StaticAlloc( MAX_SIL_EDGES * sizeof( silEdges[0] ) );
-
 	// initialize allocators for triangle surfaces
 	triVertexAllocator.Init();
 	triIndexAllocator.Init();
@@ -186,8 +260,6 @@ R_ShutdownTriSurfData
 ===============
 */
 void R_ShutdownTriSurfData( void ) {
-	R_StaticFree( silEdges );
-	silEdgeHash.Free();
 	srfTrianglesAllocator.Shutdown();
 	triVertexAllocator.Shutdown();
 	triIndexAllocator.Shutdown();
@@ -496,6 +568,9 @@ void R_FreeStaticTriSurf( srfTriangles_t *tri ) {
 		return;
 	}
 
+	// the decal worker reads the geometry until the model is freed
+	assert( !decalQueue.IsClipping( tri ) );
+
 	if ( tri->nextDeferredFree ) {
 		common->Error( "R_FreeStaticTriSurf: freed a freed triangle" );
 	}
@@ -524,7 +599,9 @@ R_AllocStaticTriSurf
 ==============
 */
 srfTriangles_t *R_AllocStaticTriSurf( void ) {
+	R_LockTriSurfData();
 	srfTriangles_t *tris = srfTrianglesAllocator.Alloc();
+	R_UnlockTriSurfData();
 	memset( tris, 0, sizeof( srfTriangles_t ) );
 	return tris;
 }
@@ -557,7 +634,9 @@ R_AllocStaticTriSurfVerts
 */
 void R_AllocStaticTriSurfVerts( srfTriangles_t *tri, int numVerts ) {
 	assert( tri->verts == NULL );
+	R_LockTriSurfData();
 	tri->verts = triVertexAllocator.Alloc( numVerts );
+	R_UnlockTriSurfData();
 }
 
 /*
@@ -567,7 +646,9 @@ R_AllocStaticTriSurfIndexes
 */
 void R_AllocStaticTriSurfIndexes( srfTriangles_t *tri, int numIndexes ) {
 	assert( tri->indexes == NULL );
+	R_LockTriSurfData();
 	tri->indexes = triIndexAllocator.Alloc( numIndexes );
+	R_UnlockTriSurfData();
 }
 
 /*
@@ -586,10 +667,12 @@ R_AllocStaticTriSurfPlanes
 =================
 */
 void R_AllocStaticTriSurfPlanes( srfTriangles_t *tri, int numIndexes ) {
+	R_LockTriSurfData();
 	if ( tri->facePlanes ) {
 		triPlaneAllocator.Free( tri->facePlanes );
 	}
 	tri->facePlanes = triPlaneAllocator.Alloc( numIndexes / 3 );
+	R_UnlockTriSurfData();
 }
 
 /*
@@ -598,6 +681,7 @@ R_ResizeStaticTriSurfVerts
 =================
 */
 void R_ResizeStaticTriSurfVerts( srfTriangles_t *tri, int numVerts ) {
+	assert( !decalQueue.IsClipping( tri ) );
 #ifdef USE_TRI_DATA_ALLOCATOR
 	tri->verts = triVertexAllocator.Resize( tri->verts, numVerts );
 #else
@@ -611,6 +695,7 @@ R_ResizeStaticTriSurfIndexes
 =================
 */
 void R_ResizeStaticTriSurfIndexes( srfTriangles_t *tri, int numIndexes ) {
+	assert( !decalQueue.IsClipping( tri ) );
 #ifdef USE_TRI_DATA_ALLOCATOR
 	tri->indexes = triIndexAllocator.Resize( tri->indexes, numIndexes );
 #else
@@ -719,7 +804,9 @@ static int *R_CreateSilRemap( const srfTriangles_t *tri ) {
 	int		i, j, hashKey;
 	const idDrawVert *v1, *v2;
 
+	R_LockTriSurfData();
 	remap = (int *)R_ClearedStaticAlloc( tri->numVerts * sizeof( remap[0] ) );
+	R_UnlockTriSurfData();
 
 	if ( !r_useSilRemap.GetBool() ) {
 		for ( i = 0 ; i < tri->numVerts ; i++ ) {
@@ -769,20 +856,26 @@ void R_CreateSilIndexes( srfTriangles_t *tri ) {
 	int		i;
 	int		*remap;
 
+	R_LockTriSurfData();
 	if ( tri->silIndexes ) {
 		triSilIndexAllocator.Free( tri->silIndexes );
 		tri->silIndexes = NULL;
 	}
+	R_UnlockTriSurfData();
 
 	remap = R_CreateSilRemap( tri );
 
 	// remap indexes to the first one
+	R_LockTriSurfData();
 	tri->silIndexes = triSilIndexAllocator.Alloc( tri->numIndexes );
+	R_UnlockTriSurfData();
 	for ( i = 0; i < tri->numIndexes; i++ ) {
 		tri->silIndexes[i] = remap[tri->indexes[i]];
 	}
 
+	R_LockTriSurfData();
 	R_StaticFree( remap );
+	R_UnlockTriSurfData();
 }
 
 /*
@@ -816,7 +909,9 @@ void R_CreateDupVerts( srfTriangles_t *tri ) {
 		}
 	}
 
+	R_LockTriSurfData();
 	tri->dupVerts = triDupVertAllocator.Alloc( tri->numDupVerts * 2 );
+	R_UnlockTriSurfData();
 	memcpy( tri->dupVerts, tempDupVerts, tri->numDupVerts * 2 * sizeof( tri->dupVerts[0] ) );
 }
 
@@ -830,6 +925,9 @@ Writes the facePlanes values, overwriting existing ones if present
 void R_DeriveFacePlanes( srfTriangles_t *tri ) {
 	idPlane *	planes;
 
+	// the decal worker only gets the planes of surfaces that already have them
+	assert( !tri->facePlanesCalculated || !decalQueue.IsClipping( tri ) );
+
 	if ( !tri->facePlanes ) {
 		R_AllocStaticTriSurfPlanes( tri, tri->numIndexes );
 	}
@@ -925,26 +1023,25 @@ void R_CreateVertexNormals( srfTriangles_t *tri ) {
 R_DefineEdge
 ===============
 */
-static int c_duplicatedEdges, c_tripledEdges;
-
-static void R_DefineEdge( int v1, int v2, int planeNum ) {
+static void R_DefineEdge( silEdgeWorkspace_t &ws, int v1, int v2, int planeNum ) {
 	int		i, hashKey;
+	silEdge_t *silEdges = ws.silEdges;
 
 	// check for degenerate edge
 	if ( v1 == v2 ) {
 		return;
 	}
-	hashKey = silEdgeHash.GenerateKey( v1, v2 );
+	hashKey = ws.silEdgeHash.GenerateKey( v1, v2 );
 	// search for a matching other side
-	for ( i = silEdgeHash.First( hashKey ); i >= 0 && i < MAX_SIL_EDGES; i = silEdgeHash.Next( i ) ) {
+	for ( i = ws.silEdgeHash.First( hashKey ); i >= 0 && i < MAX_SIL_EDGES; i = ws.silEdgeHash.Next( i ) ) {
 		if ( silEdges[i].v1 == v1 && silEdges[i].v2 == v2 ) {
-			c_duplicatedEdges++;
+			ws.c_duplicatedEdges++;
 			// allow it to still create a new edge
 			continue;
 		}
 		if ( silEdges[i].v2 == v1 && silEdges[i].v1 == v2 ) {
-			if ( silEdges[i].p2 != numPlanes )  {
-				c_tripledEdges++;
+			if ( silEdges[i].p2 != ws.numPlanes )  {
+				ws.c_tripledEdges++;
 				// allow it to still create a new edge
 				continue;
 			}
@@ -956,19 +1053,21 @@ static void R_DefineEdge( int v1, int v2, int planeNum ) {
 	}
 
 	// define the new edge
-	if ( numSilEdges == MAX_SIL_EDGES ) {
-		common->DWarning( "MAX_SIL_EDGES" );
+	if ( ws.numSilEdges == ws.maxSilEdges ) {
+		if ( ws.maxSilEdges == MAX_SIL_EDGES ) {
+			R_TriSurfMessage( true, "MAX_SIL_EDGES" );
+		}
 		return;
 	}
 
-	silEdgeHash.Add( hashKey, numSilEdges );
+	ws.silEdgeHash.Add( hashKey, ws.numSilEdges );
 
-	silEdges[numSilEdges].p1 = planeNum;
-	silEdges[numSilEdges].p2 = numPlanes;
-	silEdges[numSilEdges].v1 = v1;
-	silEdges[numSilEdges].v2 = v2;
+	silEdges[ws.numSilEdges].p1 = planeNum;
+	silEdges[ws.numSilEdges].p2 = ws.numPlanes;
+	silEdges[ws.numSilEdges].v1 = v1;
+	silEdges[ws.numSilEdges].v2 = v2;
 
-	numSilEdges++;
+	ws.numSilEdges++;
 }
 
 /*
@@ -1007,17 +1106,25 @@ void R_IdentifySilEdges( srfTriangles_t *tri, bool omitCoplanarEdges ) {
 	int		i;
 	int		numTris;
 	int		shared, single;
+	silEdgeWorkspace_t ws;
 
 	omitCoplanarEdges = false;	// optimization doesn't work for some reason
 
 	numTris = tri->numIndexes / 3;
 
-	numSilEdges = 0;
-	silEdgeHash.Clear();
-	numPlanes = numTris;
+	// an edge is only defined by a triangle side, so there can't be more than numIndexes
+	ws.numSilEdges = 0;
+	ws.maxSilEdges = Min( tri->numIndexes, MAX_SIL_EDGES );
+	ws.numPlanes = numTris;
+	ws.c_duplicatedEdges = 0;
+	ws.c_tripledEdges = 0;
+
+	R_LockTriSurfData();
+	ws.silEdges = (silEdge_t *)R_StaticAlloc( ws.maxSilEdges * sizeof( ws.silEdges[0] ) );
+	R_UnlockTriSurfData();
+	ws.silEdgeHash.Clear( SILEDGE_HASH_SIZE, Max( ws.maxSilEdges, 1 ) );
 
-	c_duplicatedEdges = 0;
-	c_tripledEdges = 0;
+	silEdge_t *silEdges = ws.silEdges;
 
 	for ( i = 0 ; i < numTris ; i++ ) {
 		int		i1, i2, i3;
@@ -1027,13 +1134,13 @@ void R_IdentifySilEdges( srfTriangles_t *tri, bool omitCoplanarEdges ) {
 		i3 = tri->silIndexes[ i*3 + 2 ];
 
 		// create the edges
-		R_DefineEdge( i1, i2, i );
-		R_DefineEdge( i2, i3, i );
-		R_DefineEdge( i3, i1, i );
+		R_DefineEdge( ws, i1, i2, i );
+		R_DefineEdge( ws, i2, i3, i );
+		R_DefineEdge( ws, i3, i1, i );
 	}
 
-	if ( c_duplicatedEdges || c_tripledEdges ) {
-		common->DWarning( "%i duplicated edge directions, %i tripled edges", c_duplicatedEdges, c_tripledEdges );
+	if ( ws.c_duplicatedEdges || ws.c_tripledEdges ) {
+		R_TriSurfMessage( true, "%i duplicated edge directions, %i tripled edges", ws.c_duplicatedEdges, ws.c_tripledEdges );
 	}
 
 	// if we know that the vertexes aren't going
@@ -1047,14 +1154,14 @@ void R_IdentifySilEdges( srfTriangles_t *tri, bool omitCoplanarEdges ) {
 
 	c_coplanarCulled = 0;
 	if ( omitCoplanarEdges ) {
-		for ( i = 0 ; i < numSilEdges ; i++ ) {
+		for ( i = 0 ; i < ws.numSilEdges ; i++ ) {
 			int			i1, i2, i3;
 			idPlane		plane;
 			int			base;
 			int			j;
 			float		d;
 
-			if ( silEdges[i].p2 == numPlanes ) {	// the fake dangling edge
+			if ( silEdges[i].p2 == ws.numPlanes ) {	// the fake dangling edge
 				continue;
 			}
 
@@ -1077,22 +1184,23 @@ void R_IdentifySilEdges( srfTriangles_t *tri, bool omitCoplanarEdges ) {
 
 			if ( j == 3 ) {
 				// we can cull this sil edge
-				memmove( &silEdges[i], &silEdges[i+1], (numSilEdges-i-1) * sizeof( silEdges[i] ) );
+				memmove( &silEdges[i], &silEdges[i+1], (ws.numSilEdges-i-1) * sizeof( silEdges[i] ) );
 				c_coplanarCulled++;
-				numSilEdges--;
+				ws.numSilEdges--;
 				i--;
 			}
 		}
 		if ( c_coplanarCulled ) {
+			R_LockTriSurfData();
 			c_coplanarSilEdges += c_coplanarCulled;
+			R_UnlockTriSurfData();
 //			common->Printf( "%i of %i sil edges coplanar culled\n", c_coplanarCulled,
 //				c_coplanarCulled + numSilEdges );
 		}
 	}
-	c_totalSilEdges += numSilEdges;
 
 	// sort the sil edges based on plane number
-	qsort( silEdges, numSilEdges, sizeof( silEdges[0] ), SilEdgeSort );
+	qsort( silEdges, ws.numSilEdges, sizeof( silEdges[0] ), SilEdgeSort );
 
 	// count up the distribution.
 	// a perfectly built model should only have shared
@@ -1100,8 +1208,8 @@ void R_IdentifySilEdges( srfTriangles_t *tri, bool omitCoplanarEdges ) {
 	// and dangling edges
 	shared = 0;
 	single = 0;
-	for ( i = 0 ; i < numSilEdges ; i++ ) {
-		if ( silEdges[i].p2 == numPlanes ) {
+	for ( i = 0 ; i < ws.numSilEdges ; i++ ) {
+		if ( silEdges[i].p2 == ws.numPlanes ) {
 			single++;
 		} else {
 			shared++;
@@ -1114,9 +1222,18 @@ void R_IdentifySilEdges( srfTriangles_t *tri, bool omitCoplanarEdges ) {
 		tri->perfectHull = false;
 	}
 
-	tri->numSilEdges = numSilEdges;
-	tri->silEdges = triSilEdgeAllocator.Alloc( numSilEdges );
-	memcpy( tri->silEdges, silEdges, numSilEdges * sizeof( tri->silEdges[0] ) );
+	tri->numSilEdges = ws.numSilEdges;
+
+	R_LockTriSurfData();
+	c_totalSilEdges += ws.numSilEdges;
+	tri->silEdges = triSilEdgeAllocator.Alloc( ws.numSilEdges );
+	R_UnlockTriSurfData();
+
+	memcpy( tri->silEdges, silEdges, ws.numSilEdges * sizeof( tri->silEdges[0] ) );
+
+	R_LockTriSurfData();
+	R_StaticFree( ws.silEdges );
+	R_UnlockTriSurfData();
 }
 
 /*
@@ -1307,15 +1424,21 @@ static void	R_DuplicateMirroredVertexes( srfTriangles_t *tri ) {
 		return;
 	}
 
+	R_LockTriSurfData();
 	tri->mirroredVerts = triMirroredVertAllocator.Alloc( tri->numMirroredVerts );
+	R_UnlockTriSurfData();
 
 #ifdef USE_TRI_DATA_ALLOCATOR
+	R_LockTriSurfData();
 	tri->verts = triVertexAllocator.Resize( tri->verts, totalVerts );
+	R_UnlockTriSurfData();
 #else
 	idDrawVert *oldVerts = tri->verts;
 	R_AllocStaticTriSurfVerts( tri, totalVerts );
 	memcpy( tri->verts, oldVerts, tri->numVerts * sizeof( tri->verts[0] ) );
+	R_LockTriSurfData();
 	triVertexAllocator.Free( oldVerts );
+	R_UnlockTriSurfData();
 #endif
 
 	// create the duplicates
@@ -1473,7 +1596,10 @@ static int IndexSort( const void *a, const void *b ) {
 void R_BuildDominantTris( srfTriangles_t *tri ) {
 	int i, j;
 	dominantTri_t *dt;
+
+	R_LockTriSurfData();
 	indexSort_t *ind = (indexSort_t *)R_StaticAlloc( tri->numIndexes * sizeof( *ind ) );
+	R_UnlockTriSurfData();
 
 	for ( i = 0; i < tri->numIndexes; i++ ) {
 		ind[i].vertexNum = tri->indexes[i];
@@ -1481,7 +1607,9 @@ void R_BuildDominantTris( srfTriangles_t *tri ) {
 	}
 	qsort( ind, tri->numIndexes, sizeof( *ind ), IndexSort );
 
+	R_LockTriSurfData();
 	tri->dominantTris = dt = triDominantTrisAllocator.Alloc( tri->numVerts );
+	R_UnlockTriSurfData();
 	memset( dt, 0, tri->numVerts * sizeof( dt[0] ) );
 
 	for ( i = 0; i < tri->numIndexes; i += j ) {
@@ -1568,7 +1696,9 @@ void R_BuildDominantTris( srfTriangles_t *tri ) {
 		}
 	}
 
+	R_LockTriSurfData();
 	R_StaticFree( ind );
+	R_UnlockTriSurfData();
 }
 
 /*
@@ -1660,7 +1790,9 @@ void R_DeriveTangents( srfTriangles_t *tri, bool allocFacePlanes ) {
 		return;
 	}
 
+	R_LockTriSurfData();
 	tr.pc.c_tangentIndexes += tri->numIndexes;
+	R_UnlockTriSurfData();
 
 	if ( !tri->facePlanes && allocFacePlanes ) {
 		R_AllocStaticTriSurfPlanes( tri, tri->numIndexes );
@@ -1907,7 +2039,7 @@ void R_RemoveDegenerateTriangles( srfTriangles_t *tri ) {
 	// this doesn't free the memory used by the unused verts
 
 	if ( c_removed ) {
-		common->Printf( "removed %i degenerate triangles\n", c_removed );
+		R_TriSurfMessage( false, "removed %i degenerate triangles\n", c_removed );
 	}
 }
 
@@ -2096,8 +2228,11 @@ R_CleanupTriangles
 FIXME: allow createFlat and createSmooth normals, as well as explicit
 =================
 */
-void R_CleanupTriangles( srfTriangles_t *tri, bool createNormals, bool identifySilEdges, bool useUnsmoothedTangents ) {
-	R_RangeCheckIndexes( tri );
+void R_CleanupTriangles( srfTriangles_t *tri, bool createNormals, bool identifySilEdges, bool useUnsmoothedTangents, bool orderIndexes ) {
+	// the worker threads can't error out, R_CleanupTriangleList checked the indexes
+	if ( !triSurfThreaded ) {
+		R_RangeCheckIndexes( tri );
+	}
 
 	R_CreateSilIndexes( tri );
 
@@ -2109,6 +2244,12 @@ void R_CleanupTriangles( srfTriangles_t *tri, bool createNormals, bool identifyS
 
 //	R_RemoveUnusedVerts( tri );
 
+	// optimize the index and vertex order for the vertex cache, before
+	// the sil edges and dup verts store triangle and vertex numbers
+	if ( orderIndexes ) {
+		R_OrderIndexes( tri );
+	}
+
 	if ( identifySilEdges ) {
 		R_IdentifySilEdges( tri, true );	// assume it is non-deformable, and omit coplanar edges
 	}
@@ -2116,9 +2257,6 @@ void R_CleanupTriangles( srfTriangles_t *tri, bool createNormals, bool identifyS
 	// bust vertexes that share a mirrored edge into separate vertexes
 	R_DuplicateMirroredVertexes( tri );
 
-	// optimize the index order (not working?)
-//	R_OrderIndexes( tri->numIndexes, tri->indexes );
-
 	R_CreateDupVerts( tri );
 
 	R_BoundTriSurf( tri );
@@ -2134,6 +2272,253 @@ void R_CleanupTriangles( srfTriangles_t *tri, bool createNormals, bool identifyS
 	}
 }
 
+/*
+=================
+R_RunCleanupJobs
+
+Claims the surfaces of R_CleanupTriangleList one at a time until none are left.
+=================
+*/
+static const triCleanup_t *	cleanupJobs;
+static int					numCleanupJobs;
+static int					nextCleanupJob;
+
+static void R_RunCleanupJobs( void ) {
+	while ( 1 ) {
+		R_LockTriSurfData();
+		int job = ( nextCleanupJob < numCleanupJobs ) ? nextCleanupJob++ : -1;
+		R_UnlockTriSurfData();
+
+		if ( job < 0 ) {
+			break;
+		}
+
+		const triCleanup_t &cleanup = cleanupJobs[job];
+		R_CleanupTriangles( cleanup.tri, cleanup.createNormals, cleanup.identifySilEdges, cleanup.useUnsmoothedTangents, cleanup.orderIndexes );
+	}
+}
+
+#ifndef NOMT
+/*
+=================
+R_CleanupThread
+=================
+*/
+static int R_CleanupThread( void *parm ) {
+	R_RunCleanupJobs();
+	return 0;
+}
+#endif
+
+/*
+=================
+R_CleanupTriangleList
+
+Runs R_CleanupTriangles on every surface of the list, spread over
+r_cleanupThreads worker threads and the calling thread.  The surfaces
+don't share any state, so the result is the same as running them one
+after the other.
+=================
+*/
+void R_CleanupTriangleList( const triCleanup_t *jobs, int numJobs ) {
+	int numThreads = 0;
+
+#ifndef NOMT
+	numThreads = Min( idMath::ClampInt( 0, MAX_CLEANUP_THREADS, r_cleanupThreads.GetInteger() ), numJobs - 1 );
+#endif
+
+	cleanupJobs = jobs;
+	numCleanupJobs = numJobs;
+	nextCleanupJob = 0;
+
+	if ( numThreads <= 0 ) {
+		R_RunCleanupJobs();
+		cleanupJobs = NULL;
+		return;
+	}
+
+#ifndef NOMT
+	// bad surfaces error out here, before any worker runs
+	for ( int i = 0; i < numJobs; i++ ) {
+		R_RangeCheckIndexes( jobs[i].tri );
+	}
+
+	xthreadInfo threads[MAX_CLEANUP_THREADS];
+
+	triSurfThreaded = true;
+	for ( int i = 0; i < numThreads; i++ ) {
+		Sys_CreateThread( R_CleanupThread, NULL, threads[i], "cleanup" );
+	}
+	R_RunCleanupJobs();
+	for ( int i = 0; i < numThreads; i++ ) {
+		Sys_DestroyThread( threads[i] );
+	}
+	triSurfThreaded = false;
+
+	for ( int i = 0; i < triSurfMessages.Num(); i++ ) {
+		if ( triSurfMessages[i].developerWarning ) {
+			common->DWarning( "%s", triSurfMessages[i].text.c_str() );
+		} else {
+			common->Printf( "%s", triSurfMessages[i].text.c_str() );
+		}
+	}
+	triSurfMessages.Clear();
+#endif
+
+	cleanupJobs = NULL;
+}
+
+/*
+===================================================================================
+
+CACHED SURFACES
+
+===================================================================================
+*/
+
+/*
+=================
+R_WriteStaticTriSurf
+
+Writes a cleaned up surface with everything R_CleanupTriangles derived,
+as flat arrays in the native layout, so R_ReadStaticTriSurf can copy them
+straight into the allocators.
+=================
+*/
+void R_WriteStaticTriSurf( idFile *f, const srfTriangles_t *tri ) {
+	f->WriteVec3( tri->bounds[0] );
+	f->WriteVec3( tri->bounds[1] );
+	f->WriteBool( tri->generateNormals );
+	f->WriteBool( tri->tangentsCalculated );
+	f->WriteBool( tri->facePlanesCalculated );
+	f->WriteBool( tri->perfectHull );
+
+	f->WriteInt( tri->numVerts );
+	f->WriteInt( tri->numIndexes );
+	f->WriteInt( tri->numMirroredVerts );
+	f->WriteInt( tri->numDupVerts );
+	f->WriteInt( tri->numSilEdges );
+	f->WriteBool( tri->silIndexes != NULL );
+	f->WriteBool( tri->facePlanes != NULL );
+	f->WriteBool( tri->dominantTris != NULL );
+
+	f->Write( tri->verts, tri->numVerts * sizeof( tri->verts[0] ) );
+	f->Write( tri->indexes, tri->numIndexes * sizeof( tri->indexes[0] ) );
+	f->Write( tri->mirroredVerts, tri->numMirroredVerts * sizeof( tri->mirroredVerts[0] ) );
+	f->Write( tri->dupVerts, tri->numDupVerts * 2 * sizeof( tri->dupVerts[0] ) );
+	f->Write( tri->silEdges, tri->numSilEdges * sizeof( tri->silEdges[0] ) );
+	if ( tri->silIndexes ) {
+		f->Write( tri->silIndexes, tri->numIndexes * sizeof( tri->silIndexes[0] ) );
+	}
+	if ( tri->facePlanes ) {
+		f->Write( tri->facePlanes, tri->numIndexes / 3 * sizeof( tri->facePlanes[0] ) );
+	}
+	if ( tri->dominantTris ) {
+		f->Write( tri->dominantTris, tri->numVerts * sizeof( tri->dominantTris[0] ) );
+	}
+}
+
+/*
+=================
+R_ReadStaticTriSurfArray
+=================
+*/
+static bool R_ReadStaticTriSurfArray( idFile *f, void *data, int size ) {
+	return f->Read( data, size ) == size;
+}
+
+/*
+=================
+R_ReadStaticTriSurf
+
+Returns NULL if the data is truncated or doesn't describe a valid surface.
+=================
+*/
+srfTriangles_t *R_ReadStaticTriSurf( idFile *f ) {
+	srfTriangles_t	*tri;
+	bool			hasSilIndexes, hasFacePlanes, hasDominantTris;
+	bool			ok;
+	int				i;
+
+	tri = R_AllocStaticTriSurf();
+
+	f->ReadVec3( tri->bounds[0] );
+	f->ReadVec3( tri->bounds[1] );
+	f->ReadBool( tri->generateNormals );
+	f->ReadBool( tri->tangentsCalculated );
+	f->ReadBool( tri->facePlanesCalculated );
+	f->ReadBool( tri->perfectHull );
+
+	f->ReadInt( tri->numVerts );
+	f->ReadInt( tri->numIndexes );
+	f->ReadInt( tri->numMirroredVerts );
+	f->ReadInt( tri->numDupVerts );
+	f->ReadInt( tri->numSilEdges );
+	f->ReadBool( hasSilIndexes );
+	f->ReadBool( hasFacePlanes );
+	f->ReadBool( hasDominantTris );
+
+	if ( tri->numVerts < 0 || tri->numIndexes < 0 || tri->numIndexes % 3 != 0 || tri->numMirroredVerts < 0
+		|| tri->numMirroredVerts > tri->numVerts || tri->numDupVerts < 0 || tri->numDupVerts > tri->numVerts
+		|| tri->numSilEdges < 0 || tri->numSilEdges > MAX_SIL_EDGES || f->Tell() + tri->numVerts * (int)sizeof( idDrawVert ) + tri->numIndexes * (int)sizeof( glIndex_t ) > f->Length() ) {
+		R_ReallyFreeStaticTriSurf( tri );
+		return NULL;
+	}
+
+	R_AllocStaticTriSurfVerts( tri, tri->numVerts );
+	R_AllocStaticTriSurfIndexes( tri, tri->numIndexes );
+	tri->mirroredVerts = triMirroredVertAllocator.Alloc( tri->numMirroredVerts );
+	tri->dupVerts = triDupVertAllocator.Alloc( tri->numDupVerts * 2 );
+	tri->silEdges = triSilEdgeAllocator.Alloc( tri->numSilEdges );
+
+	ok = R_ReadStaticTriSurfArray( f, tri->verts, tri->numVerts * sizeof( tri->verts[0] ) )
+		&& R_ReadStaticTriSurfArray( f, tri->indexes, tri->numIndexes * sizeof( tri->indexes[0] ) )
+		&& R_ReadStaticTriSurfArray( f, tri->mirroredVerts, tri->numMirroredVerts * sizeof( tri->mirroredVerts[0] ) )
+		&& R_ReadStaticTriSurfArray( f, tri->dupVerts, tri->numDupVerts * 2 * sizeof( tri->dupVerts[0] ) )
+		&& R_ReadStaticTriSurfArray( f, tri->silEdges, tri->numSilEdges * sizeof( tri->silEdges[0] ) );
+
+	if ( ok && hasSilIndexes ) {
+		tri->silIndexes = triSilIndexAllocator.Alloc( tri->numIndexes );
+		ok = R_ReadStaticTriSurfArray( f, tri->silIndexes, tri->numIndexes * sizeof( tri->silIndexes[0] ) );
+	}
+	if ( ok && hasFacePlanes ) {
+		R_AllocStaticTriSurfPlanes( tri, tri->numIndexes );
+		ok = R_ReadStaticTriSurfArray( f, tri->facePlanes, tri->numIndexes / 3 * sizeof( tri->facePlanes[0] ) );
+	}
+	if ( ok && hasDominantTris ) {
+		tri->dominantTris = triDominantTrisAllocator.Alloc( tri->numVerts );
+		ok = R_ReadStaticTriSurfArray( f, tri->dominantTris, tri->numVerts * sizeof( tri->dominantTris[0] ) );
+	}
+
+	// everything that indexes the vertexes has to stay in range
+	for ( i = 0; ok && i < tri->numIndexes; i++ ) {
+		ok = ( tri->indexes[i] >= 0 && tri->indexes[i] < tri->numVerts )
+			&& ( !tri->silIndexes || ( tri->silIndexes[i] >= 0 && tri->silIndexes[i] < tri->numVerts ) );
+	}
+	for ( i = 0; ok && i < tri->numMirroredVerts; i++ ) {
+		ok = ( tri->mirroredVerts[i] >= 0 && tri->mirroredVerts[i] < tri->numVerts );
+	}
+	for ( i = 0; ok && i < tri->numDupVerts * 2; i++ ) {
+		ok = ( tri->dupVerts[i] >= 0 && tri->dupVerts[i] < tri->numVerts );
+	}
+	for ( i = 0; ok && tri->dominantTris && i < tri->numVerts; i++ ) {
+		const dominantTri_t *dt = &tri->dominantTris[i];
+		ok = ( dt->v2 >= 0 && dt->v2 < tri->numVerts && dt->v3 >= 0 && dt->v3 < tri->numVerts );
+	}
+	for ( i = 0; ok && i < tri->numSilEdges; i++ ) {
+		const silEdge_t *edge = &tri->silEdges[i];
+		ok = ( edge->v1 >= 0 && edge->v1 < tri->numVerts && edge->v2 >= 0 && edge->v2 < tri->numVerts
+			&& edge->p1 >= 0 && edge->p1 < tri->numIndexes / 3 && edge->p2 >= 0 && edge->p2 <= tri->numIndexes / 3 );
+	}
+
+	if ( !ok ) {
+		R_ReallyFreeStaticTriSurf( tri );
+		return NULL;
+	}
+
+	return tri;
+}
+
 /*
 ===================================================================================
 
@@ -573,6 +573,8 @@ idSoundSample::PurgeSoundSample
 void idSoundSample::PurgeSoundSample() {
 	purged = true;
 
+	idSampleDecoder::PurgeSample( this );
+
 	alGetError();
 	alDeleteBuffers( 1, &openalBuffer );
 	if ( alGetError() != AL_NO_ERROR ) {
@@ -56,27 +56,37 @@ extern "C" {
 	void _decoder_free( void *memblock );
 }
 
+// the allocator is the only state shared between decoders, so it is the only
+// thing that takes a lock, decoding itself runs unlocked
 void *_decoder_malloc( size_t size ) {
+	Sys_EnterCriticalSection( CRITICAL_SECTION_ONE );
 	void *ptr = decoderMemoryAllocator.Alloc( size );
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_ONE );
 	assert( size == 0 || ptr != NULL );
 	return ptr;
 }
 
 void *_decoder_calloc( size_t num, size_t size ) {
+	Sys_EnterCriticalSection( CRITICAL_SECTION_ONE );
 	void *ptr = decoderMemoryAllocator.Alloc( num * size );
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_ONE );
 	assert( ( num * size ) == 0 || ptr != NULL );
 	memset( ptr, 0, num * size );
 	return ptr;
 }
 
 void *_decoder_realloc( void *memblock, size_t size ) {
+	Sys_EnterCriticalSection( CRITICAL_SECTION_ONE );
 	void *ptr = decoderMemoryAllocator.Resize( (byte *)memblock, size );
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_ONE );
 	assert( size == 0 || ptr != NULL );
 	return ptr;
 }
 
 void _decoder_free( void *memblock ) {
+	Sys_EnterCriticalSection( CRITICAL_SECTION_ONE );
 	decoderMemoryAllocator.Free( (byte *)memblock );
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_ONE );
 }
 
 
@@ -170,13 +180,10 @@ int idWaveFile::OpenOGG( const char* strFileName, waveformatex_t *pwfx ) {
 		return -1;
 	}
 
-	Sys_EnterCriticalSection( CRITICAL_SECTION_ONE );
-
 	ov = new OggVorbis_File;
 
 	if( ov_openFile( mhmmio, ov ) < 0 ) {
 		delete ov;
-		Sys_LeaveCriticalSection( CRITICAL_SECTION_ONE );
 		fileSystem->CloseFile( mhmmio );
 		mhmmio = NULL;
 		return -1;
@@ -213,8 +220,6 @@ int idWaveFile::OpenOGG( const char* strFileName, waveformatex_t *pwfx ) {
 
 	memcpy( pwfx, &mpwfx, sizeof( waveformatex_t ) );
 
-	Sys_LeaveCriticalSection( CRITICAL_SECTION_ONE );
-
 	isOgg = true;
 
 	return 0;
@@ -259,10 +264,8 @@ idWaveFile::CloseOGG
 int idWaveFile::CloseOGG( void ) {
 	OggVorbis_File *ov = (OggVorbis_File *) ogg;
 	if ( ov != NULL ) {
-		Sys_EnterCriticalSection( CRITICAL_SECTION_ONE );
 		ov_clear( ov );
 		delete ov;
-		Sys_LeaveCriticalSection( CRITICAL_SECTION_ONE );
 		fileSystem->CloseFile( mhmmio );
 		mhmmio = NULL;
 		ogg = NULL;
@@ -280,6 +283,8 @@ int idWaveFile::CloseOGG( void ) {
 ===================================================================================
 */
 
+struct decodedBlock_s;
+
 class idSampleDecoderLocal : public idSampleDecoder {
 public:
 	virtual void			Decode( idSoundSample *sample, int sampleOffset44k, int sampleCount44k, float *dest );
@@ -288,15 +293,28 @@ public:
 	virtual int				GetLastDecodeTime( void ) const;
 
 	void					Clear( void );
+	void					CloseStream( void );
 	int						DecodePCM( idSoundSample *sample, int sampleOffset44k, int sampleCount44k, float *dest );
 	int						DecodeOGG( idSoundSample *sample, int sampleOffset44k, int sampleCount44k, float *dest );
+	int						DecodeOGGBlocks( idSoundSample *sample, int sampleOffset44k, int sampleCount44k, float *dest );
+	struct decodedBlock_s *	DecodeBlock( idSoundSample *sample, int block );
+	void					DecodeAhead( int numBlocks );
+
+							// the caller holds the decoded block lock
+	bool					TryClaim( const idSoundSample *sample );
+	void					Unclaim( void );
+	bool					IsClaimedFor( const idSoundSample *sample ) const { return claimed && claimedSample == sample; }
 
 private:
+	bool					claimed;			// a thread decodes with this decoder outside the lock
+	const idSoundSample *	claimedSample;		// sample it decodes
 	bool					failed;				// set if decoding failed
 	int						lastFormat;			// last format being decoded
 	idSoundSample *			lastSample;			// last sample being decoded
 	int						lastSampleOffset;	// last offset into the decoded sample
 	int						lastDecodeTime;		// last time decoding sound
+	int						aheadBlock;			// next block of lastSample the channel will need
+	bool					streamOpen;			// set if ogg is open on lastSample
 	idFile_Memory			file;				// encoded file in memory
 
 	OggVorbis_File			ogg;				// OggVorbis file
@@ -304,6 +322,200 @@ private:
 
 idBlockAlloc<idSampleDecoderLocal, 64>		sampleDecoderAllocator;
 
+/*
+===================================================================================
+
+  Decoded block cache.
+
+  Streaming OGG samples are decoded in fixed size blocks that are shared by all
+  channels playing the same sample, so a loop played by several emitters is only
+  decoded once, and a retriggered sound usually doesn't have to reopen its stream.
+  Between mixes the sound system decodes the next blocks of every open stream,
+  so the mix itself rarely waits on the decoder.
+
+  The mixer thread and the main thread both decode through the cache, the main
+  thread samples the channels of emitters with shakes in FindAmplitude, and those
+  can be OGG, so the cache and the list of open streams are guarded by
+  CRITICAL_SECTION_FOUR.  The lock is only held to look up, reserve and publish
+  blocks.  A reserved block is pending and only written by the decoder that
+  reserved it, which decodes into it outside the lock.  A decoder is claimed by
+  the thread decoding with it, so its stream is never used by two threads or
+  closed while the decode ahead uses it.
+
+===================================================================================
+*/
+
+const int DECODE_BLOCK_SAMPLES				= MIXBUFFER_SAMPLES * 2;		// 44kHz samples, a stereo mix buffer
+
+typedef struct decodedBlock_s {
+	const idSoundSample *	sample;			// NULL if the block is free
+	int						block;
+	int						numSamples;		// the last block of a sample is short
+	int						lastUsed;
+	bool					pending;		// reserved and still being decoded outside the lock
+	const idSampleDecoderLocal *decoder;	// decoder that filled the block
+	float *					samples;
+} decodedBlock_t;
+
+static decodedBlock_t *		decodedBlocks;
+static float *				decodedBlockMemory;
+static int					numDecodedBlocks;
+static int					decodedBlockUse;
+static idHashIndex			decodedBlockHash;
+static idList<idSampleDecoderLocal *> streamingDecoders;
+
+static int					decodeBlocks;			// blocks decoded
+static int					decodeUsec;				// time spent decoding them
+static int					decodeAheadBlocks;		// blocks decoded between mixes
+static int					decodeCacheHits;
+static int					decodeSharedHits;		// hits on blocks filled by another channel
+static int					decodeUnderruns;		// mixes that had to decode a block that should have been ahead
+static int					decodeStreamOpens;
+
+const int MAX_DECODE_AHEAD_STREAMS			= 64;		// streams decoded ahead per mix
+
+/*
+====================
+LockDecodedBlocks
+====================
+*/
+static void LockDecodedBlocks( void ) {
+	Sys_EnterCriticalSection( CRITICAL_SECTION_FOUR );
+}
+
+/*
+====================
+UnlockDecodedBlocks
+====================
+*/
+static void UnlockDecodedBlocks( void ) {
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_FOUR );
+}
+
+/*
+====================
+ClaimDecoder
+
+Waits until no other thread decodes with the decoder.
+====================
+*/
+static void ClaimDecoder( idSampleDecoderLocal *decoder, const idSoundSample *sample ) {
+	LockDecodedBlocks();
+	while ( !decoder->TryClaim( sample ) ) {
+		UnlockDecodedBlocks();
+		Sys_Sleep( 0 );
+		LockDecodedBlocks();
+	}
+	UnlockDecodedBlocks();
+}
+
+/*
+====================
+UnclaimDecoder
+====================
+*/
+static void UnclaimDecoder( idSampleDecoderLocal *decoder ) {
+	LockDecodedBlocks();
+	decoder->Unclaim();
+	UnlockDecodedBlocks();
+}
+
+/*
+====================
+DecodedBlockKey
+====================
+*/
+static int DecodedBlockKey( const idSoundSample *sample, int block ) {
+	return (int)( (intptr_t)sample >> 4 ) + block * 31;
+}
+
+/*
+====================
+FindDecodedBlock
+====================
+*/
+static decodedBlock_t *FindDecodedBlock( const idSoundSample *sample, int block ) {
+	int key = DecodedBlockKey( sample, block );
+
+	for ( int i = decodedBlockHash.First( key ); i != -1; i = decodedBlockHash.Next( i ) ) {
+		if ( decodedBlocks[i].sample == sample && decodedBlocks[i].block == block && !decodedBlocks[i].pending ) {
+			decodedBlocks[i].lastUsed = ++decodedBlockUse;
+			return &decodedBlocks[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+====================
+FreeDecodedBlock
+====================
+*/
+static void FreeDecodedBlock( int index ) {
+	decodedBlock_t *b = &decodedBlocks[index];
+
+	if ( b->sample ) {
+		decodedBlockHash.Remove( DecodedBlockKey( b->sample, b->block ), index );
+		b->sample = NULL;
+	}
+	b->pending = false;
+}
+
+/*
+====================
+PublishDecodedBlock
+
+Makes a block filled outside the lock visible to the other decoders.
+====================
+*/
+static void PublishDecodedBlock( decodedBlock_t *b ) {
+	LockDecodedBlocks();
+	b->pending = false;
+	UnlockDecodedBlocks();
+}
+
+/*
+====================
+AllocDecodedBlock
+
+Reserves a free or the least recently used block that isn't pending, returns
+NULL if every block is being decoded.
+====================
+*/
+static decodedBlock_t *AllocDecodedBlock( const idSoundSample *sample, int block, const idSampleDecoderLocal *decoder ) {
+	int best = -1;
+
+	for ( int i = 0; i < numDecodedBlocks; i++ ) {
+		if ( decodedBlocks[i].pending ) {
+			continue;
+		}
+		if ( !decodedBlocks[i].sample ) {
+			best = i;
+			break;
+		}
+		if ( best == -1 || decodedBlocks[i].lastUsed < decodedBlocks[best].lastUsed ) {
+			best = i;
+		}
+	}
+
+	if ( best == -1 ) {
+		return NULL;
+	}
+
+	FreeDecodedBlock( best );
+
+	decodedBlock_t *b = &decodedBlocks[best];
+	b->sample = sample;
+	b->block = block;
+	b->numSamples = 0;
+	b->lastUsed = ++decodedBlockUse;
+	b->pending = true;
+	b->decoder = decoder;
+	decodedBlockHash.Add( DecodedBlockKey( sample, block ), best );
+
+	return b;
+}
+
 /*
 ====================
 idSampleDecoder::Init
@@ -313,6 +525,23 @@ void idSampleDecoder::Init( void ) {
 	decoderMemoryAllocator.Init();
 	decoderMemoryAllocator.SetLockMemory( true );
 	decoderMemoryAllocator.SetFixedBlocks( idSoundSystemLocal::s_realTimeDecoding.GetBool() ? 10 : 1 );
+
+	numDecodedBlocks = idSoundSystemLocal::s_decodeCacheBlocks.GetInteger();
+	if ( !idSoundSystemLocal::s_realTimeDecoding.GetBool() || numDecodedBlocks < 0 ) {
+		numDecodedBlocks = 0;
+	}
+	if ( numDecodedBlocks ) {
+		decodedBlocks = (decodedBlock_t *)Mem_ClearedAlloc( numDecodedBlocks * sizeof( decodedBlocks[0] ) );
+		decodedBlockMemory = (float *)Mem_Alloc16( numDecodedBlocks * DECODE_BLOCK_SAMPLES * sizeof( float ) );
+		for ( int i = 0; i < numDecodedBlocks; i++ ) {
+			decodedBlocks[i].samples = decodedBlockMemory + i * DECODE_BLOCK_SAMPLES;
+		}
+		decodedBlockHash.Clear( 256, numDecodedBlocks );
+	}
+	decodedBlockUse = 0;
+
+	decodeBlocks = decodeUsec = decodeAheadBlocks = 0;
+	decodeCacheHits = decodeSharedHits = decodeUnderruns = decodeStreamOpens = 0;
 }
 
 /*
@@ -321,6 +550,18 @@ idSampleDecoder::Shutdown
 ====================
 */
 void idSampleDecoder::Shutdown( void ) {
+	LockDecodedBlocks();
+	if ( decodedBlocks ) {
+		Mem_Free( decodedBlocks );
+		Mem_Free16( decodedBlockMemory );
+		decodedBlocks = NULL;
+		decodedBlockMemory = NULL;
+	}
+	numDecodedBlocks = 0;
+	decodedBlockHash.Free();
+	streamingDecoders.Clear();
+	UnlockDecodedBlocks();
+
 	decoderMemoryAllocator.Shutdown();
 	sampleDecoderAllocator.Shutdown();
 }
@@ -333,6 +574,7 @@ idSampleDecoder::Alloc
 idSampleDecoder *idSampleDecoder::Alloc( void ) {
 	idSampleDecoderLocal *decoder = sampleDecoderAllocator.Alloc();
 	decoder->Clear();
+	decoder->Unclaim();
 	return decoder;
 }
 
@@ -365,6 +607,98 @@ int idSampleDecoder::GetUsedBlockMemory( void ) {
 	return decoderMemoryAllocator.GetUsedBlockMemory();
 }
 
+/*
+====================
+idSampleDecoder::DecodeAhead
+
+Called by the sound system between mixes.  Streams another thread is decoding
+with are skipped, the others are claimed so they can be decoded unlocked.
+====================
+*/
+void idSampleDecoder::DecodeAhead( void ) {
+	idSampleDecoderLocal *	decoders[MAX_DECODE_AHEAD_STREAMS];
+	int						numDecoders;
+	int						numBlocks = idSoundSystemLocal::s_decodeAhead.GetInteger();
+
+	if ( numBlocks <= 0 || !numDecodedBlocks ) {
+		return;
+	}
+	LockDecodedBlocks();
+
+	// the blocks of all streams have to fit, or they would evict each other
+	numBlocks = Min( numBlocks, numDecodedBlocks / ( 2 * Max( streamingDecoders.Num(), 1 ) ) );
+
+	numDecoders = 0;
+	for ( int i = 0; i < streamingDecoders.Num() && numDecoders < MAX_DECODE_AHEAD_STREAMS; i++ ) {
+		if ( streamingDecoders[i]->TryClaim( streamingDecoders[i]->GetSample() ) ) {
+			decoders[numDecoders++] = streamingDecoders[i];
+		}
+	}
+
+	UnlockDecodedBlocks();
+
+	for ( int i = 0; i < numDecoders; i++ ) {
+		decoders[i]->DecodeAhead( numBlocks );
+	}
+
+	LockDecodedBlocks();
+	for ( int i = 0; i < numDecoders; i++ ) {
+		decoders[i]->Unclaim();
+	}
+	UnlockDecodedBlocks();
+}
+
+/*
+====================
+idSampleDecoder::PurgeSample
+
+Drops the decoded blocks of a sample that is being unloaded, after waiting for
+the decoders still decoding it.
+====================
+*/
+void idSampleDecoder::PurgeSample( const idSoundSample *sample ) {
+	LockDecodedBlocks();
+	for ( int i = 0; i < streamingDecoders.Num(); i++ ) {
+		while ( streamingDecoders.Num() > i && streamingDecoders[i]->IsClaimedFor( sample ) ) {
+			UnlockDecodedBlocks();
+			Sys_Sleep( 0 );
+			LockDecodedBlocks();
+		}
+	}
+	for ( int i = 0; i < numDecodedBlocks; i++ ) {
+		if ( decodedBlocks[i].sample == sample ) {
+			FreeDecodedBlock( i );
+		}
+	}
+	UnlockDecodedBlocks();
+}
+
+/*
+====================
+idSampleDecoder::PrintStats
+====================
+*/
+void idSampleDecoder::PrintStats( void ) {
+	if ( !numDecodedBlocks ) {
+		common->Printf( "decoded block cache disabled\n" );
+		return;
+	}
+
+	LockDecodedBlocks();
+	int numUsed = 0;
+	for ( int i = 0; i < numDecodedBlocks; i++ ) {
+		if ( decodedBlocks[i].sample ) {
+			numUsed++;
+		}
+	}
+	UnlockDecodedBlocks();
+
+	common->Printf( "%d of %d decoded blocks used, %d kB\n", numUsed, numDecodedBlocks, ( numDecodedBlocks * DECODE_BLOCK_SAMPLES * (int)sizeof( float ) ) >> 10 );
+	common->Printf( "%d blocks decoded, %d ahead of the mix, %d usec per block\n", decodeBlocks, decodeAheadBlocks, decodeBlocks ? decodeUsec / decodeBlocks : 0 );
+	common->Printf( "%d cache hits, %d shared between channels\n", decodeCacheHits, decodeSharedHits );
+	common->Printf( "%d underruns, %d streams opened\n", decodeUnderruns, decodeStreamOpens );
+}
+
 /*
 ====================
 idSampleDecoderLocal::Clear
@@ -376,30 +710,62 @@ void idSampleDecoderLocal::Clear( void ) {
 	lastSample = NULL;
 	lastSampleOffset = 0;
 	lastDecodeTime = 0;
+	aheadBlock = 0;
+	streamOpen = false;
 }
 
 /*
 ====================
-idSampleDecoderLocal::ClearDecoder
+idSampleDecoderLocal::TryClaim
 ====================
 */
-void idSampleDecoderLocal::ClearDecoder( void ) {
-	Sys_EnterCriticalSection( CRITICAL_SECTION_ONE );
+bool idSampleDecoderLocal::TryClaim( const idSoundSample *sample ) {
+	if ( claimed ) {
+		return false;
+	}
+	claimed = true;
+	claimedSample = sample;
+	return true;
+}
 
-	switch( lastFormat ) {
-		case WAVE_FORMAT_TAG_PCM: {
-			break;
-		}
-		case WAVE_FORMAT_TAG_OGG: {
-			ov_clear( &ogg );
-			memset( &ogg, 0, sizeof( ogg ) );
-			break;
-		}
+/*
+====================
+idSampleDecoderLocal::Unclaim
+====================
+*/
+void idSampleDecoderLocal::Unclaim( void ) {
+	claimed = false;
+	claimedSample = NULL;
+}
+
+/*
+====================
+idSampleDecoderLocal::CloseStream
+
+The caller has claimed the decoder.
+====================
+*/
+void idSampleDecoderLocal::CloseStream( void ) {
+	if ( streamOpen ) {
+		ov_clear( &ogg );
+		memset( &ogg, 0, sizeof( ogg ) );
+		LockDecodedBlocks();
+		streamingDecoders.Remove( this );
+		UnlockDecodedBlocks();
 	}
 
 	Clear();
+}
 
-	Sys_LeaveCriticalSection( CRITICAL_SECTION_ONE );
+/*
+====================
+idSampleDecoderLocal::ClearDecoder
+====================
+*/
+void idSampleDecoderLocal::ClearDecoder( void ) {
+	ClaimDecoder( this, lastSample );
+	CloseStream();
+	UnclaimDecoder( this );
 }
 
 /*
@@ -428,27 +794,35 @@ idSampleDecoderLocal::Decode
 void idSampleDecoderLocal::Decode( idSoundSample *sample, int sampleOffset44k, int sampleCount44k, float *dest ) {
 	int readSamples44k;
 
+	// samples can be decoded both from the sound thread and the main thread for shakes,
+	// and the decode ahead uses open streams between mixes, so the decoder is claimed
+	// while it is used.  Only the block cache lookups take the decoded block lock.
+	ClaimDecoder( this, sample );
+
 	if ( sample->objectInfo.wFormatTag != lastFormat || sample != lastSample ) {
-		ClearDecoder();
+		CloseStream();
 	}
 
 	lastDecodeTime = soundSystemLocal.CurrentSoundTime;
 
 	if ( failed ) {
+		UnclaimDecoder( this );
 		memset( dest, 0, sampleCount44k * sizeof( dest[0] ) );
 		return;
 	}
 
-	// samples can be decoded both from the sound thread and the main thread for shakes
-	Sys_EnterCriticalSection( CRITICAL_SECTION_ONE );
-
 	switch( sample->objectInfo.wFormatTag ) {
 		case WAVE_FORMAT_TAG_PCM: {
 			readSamples44k = DecodePCM( sample, sampleOffset44k, sampleCount44k, dest );
 			break;
 		}
 		case WAVE_FORMAT_TAG_OGG: {
-			readSamples44k = DecodeOGG( sample, sampleOffset44k, sampleCount44k, dest );
+			// whole samples decompressed at load time go straight through
+			if ( numDecodedBlocks && sampleCount44k <= DECODE_BLOCK_SAMPLES ) {
+				readSamples44k = DecodeOGGBlocks( sample, sampleOffset44k, sampleCount44k, dest );
+			} else {
+				readSamples44k = DecodeOGG( sample, sampleOffset44k, sampleCount44k, dest );
+			}
 			break;
 		}
 		default: {
@@ -457,7 +831,7 @@ void idSampleDecoderLocal::Decode( idSoundSample *sample, int sampleOffset44k, i
 		}
 	}
 
-	Sys_LeaveCriticalSection( CRITICAL_SECTION_ONE );
+	UnclaimDecoder( this );
 
 	if ( readSamples44k < sampleCount44k ) {
 		memset( dest + readSamples44k, 0, ( sampleCount44k - readSamples44k ) * sizeof( dest[0] ) );
@@ -516,7 +890,7 @@ int idSampleDecoderLocal::DecodeOGG( idSoundSample *sample, int sampleOffset44k,
 	int sampleCount = sampleCount44k >> shift;
 
 	// open OGG file if not yet opened
-	if ( lastSample == NULL ) {
+	if ( !streamOpen ) {
 		// make sure there is enough space for another decoder
 		if ( decoderMemoryAllocator.GetFreeBlockMemory() < MIN_OGGVORBIS_MEMORY ) {
 			return 0;
@@ -533,6 +907,12 @@ int idSampleDecoderLocal::DecodeOGG( idSoundSample *sample, int sampleOffset44k,
 		}
 		lastFormat = WAVE_FORMAT_TAG_OGG;
 		lastSample = sample;
+		lastSampleOffset = 0;
+		streamOpen = true;
+		LockDecodedBlocks();
+		streamingDecoders.Append( this );
+		decodeStreamOpens++;
+		UnlockDecodedBlocks();
 	}
 
 	// seek to the right offset if necessary
@@ -571,3 +951,147 @@ int idSampleDecoderLocal::DecodeOGG( idSoundSample *sample, int sampleOffset44k,
 
 	return ( readSamples << shift );
 }
+
+/*
+====================
+idSampleDecoderLocal::DecodeOGGBlocks
+
+Copies the requested range out of the decoded block cache, decoding any missing blocks.
+====================
+*/
+int idSampleDecoderLocal::DecodeOGGBlocks( idSoundSample *sample, int sampleOffset44k, int sampleCount44k, float *dest ) {
+	int readSamples44k = 0;
+	int length44k = sample->LengthIn44kHzSamples();
+
+	lastFormat = WAVE_FORMAT_TAG_OGG;
+	lastSample = sample;
+
+	while ( readSamples44k < sampleCount44k ) {
+		int offset44k = sampleOffset44k + readSamples44k;
+		if ( offset44k >= length44k ) {
+			break;
+		}
+
+		int block = offset44k / DECODE_BLOCK_SAMPLES;
+		int start = offset44k - block * DECODE_BLOCK_SAMPLES;
+		int count;
+
+		// a published block can be evicted by another thread as soon as the lock is
+		// released, so hits are copied under the lock
+		LockDecodedBlocks();
+		decodedBlock_t *b = FindDecodedBlock( sample, block );
+		if ( b ) {
+			decodeCacheHits++;
+			if ( b->decoder != this ) {
+				decodeSharedHits++;
+			}
+			count = Min( b->numSamples - start, sampleCount44k - readSamples44k );
+			if ( count > 0 ) {
+				SIMDProcessor->Memcpy( dest + readSamples44k, b->samples + start, count * sizeof( float ) );
+			}
+			UnlockDecodedBlocks();
+		} else {
+			if ( block > 0 && block == aheadBlock && idSoundSystemLocal::s_decodeAhead.GetInteger() > 0 ) {
+				decodeUnderruns++;
+			}
+			UnlockDecodedBlocks();
+
+			// a block this decoder reserved stays pending until it is published
+			b = DecodeBlock( sample, block );
+			if ( !b ) {
+				break;
+			}
+			count = Min( b->numSamples - start, sampleCount44k - readSamples44k );
+			if ( count > 0 ) {
+				SIMDProcessor->Memcpy( dest + readSamples44k, b->samples + start, count * sizeof( float ) );
+			}
+			PublishDecodedBlock( b );
+		}
+
+		if ( count <= 0 ) {
+			break;
+		}
+		readSamples44k += count;
+
+		aheadBlock = block + 1;
+	}
+
+	return readSamples44k;
+}
+
+/*
+====================
+idSampleDecoderLocal::DecodeBlock
+
+Reserves a block and decodes into it without holding the lock.  The block is
+returned pending, the caller publishes it with PublishDecodedBlock.
+====================
+*/
+decodedBlock_t *idSampleDecoderLocal::DecodeBlock( idSoundSample *sample, int block ) {
+	int offset44k = block * DECODE_BLOCK_SAMPLES;
+	int count44k = Min( DECODE_BLOCK_SAMPLES, sample->LengthIn44kHzSamples() - offset44k );
+
+	if ( count44k <= 0 ) {
+		return NULL;
+	}
+
+	LockDecodedBlocks();
+	decodedBlock_t *b = AllocDecodedBlock( sample, block, this );
+	UnlockDecodedBlocks();
+
+	if ( !b ) {
+		return NULL;
+	}
+
+	unsigned int start = Sys_Microseconds();
+	int readSamples44k = DecodeOGG( sample, offset44k, count44k, b->samples );
+	unsigned int usec = Sys_Microseconds() - start;
+
+	LockDecodedBlocks();
+	if ( readSamples44k <= 0 ) {
+		FreeDecodedBlock( b - decodedBlocks );
+		b = NULL;
+	} else {
+		b->numSamples = readSamples44k;
+		decodeBlocks++;
+		decodeUsec += usec;
+	}
+	UnlockDecodedBlocks();
+
+	return b;
+}
+
+/*
+====================
+idSampleDecoderLocal::DecodeAhead
+
+Decodes at most one missing block within numBlocks of the play position,
+which keeps the cost of an idle sound tic bounded.
+====================
+*/
+void idSampleDecoderLocal::DecodeAhead( int numBlocks ) {
+	if ( failed || !streamOpen ) {
+		return;
+	}
+
+	int length44k = lastSample->LengthIn44kHzSamples();
+
+	for ( int i = 0; i < numBlocks; i++ ) {
+		int block = aheadBlock + i;
+		if ( block * DECODE_BLOCK_SAMPLES >= length44k ) {
+			return;
+		}
+		LockDecodedBlocks();
+		bool cached = ( FindDecodedBlock( lastSample, block ) != NULL );
+		UnlockDecodedBlocks();
+		if ( cached ) {
+			continue;
+		}
+		decodedBlock_t *b = DecodeBlock( lastSample, block );
+		if ( b ) {
+			PublishDecodedBlock( b );
+			decodeAheadBlocks++;
+		}
+		return;
+	}
+}
@@ -619,10 +619,14 @@ class idSoundSystemLocal : public idSoundSystem {
 public:
 	idSoundSystemLocal( ) {
 		isInitialized = false;
+		waveFile = NULL;
+		waveMixerOnly = false;
 	}
 
 	// all non-hardware initialization
 	virtual void			Init( void );
+	// opens the OpenAL device, skipped with s_noSound
+	void					InitOpenAL( void );
 
 	// shutdown routine
 	virtual	void			Shutdown( void );
@@ -661,6 +665,10 @@ public:
 
 	virtual int				IsEFXAvailable( void );
 
+	virtual bool			StartWritingWave( const char *fileName );
+	virtual void			StopWritingWave( void );
+	virtual bool			IsWritingWave( void ) const { return waveFile != NULL; }
+
 	//-------------------------
 
 	int						GetCurrent44kHzTime( void ) const;
@@ -670,6 +678,8 @@ public:
 
 	void					DoEnviroSuit( float* samples, int numSamples, int numSpeakers );
 
+	void					UpdateWave( int game44kHz );
+
 	ALuint					AllocOpenALSource( idSoundChannel *chan, bool looping, bool stereo );
 	void					FreeOpenALSource( ALuint handle );
 
@@ -692,6 +702,14 @@ public:
 
 	s_stats					soundStats;				// NOTE: updated throughout the code, not displayed anywhere
 
+	idFile *				waveFile;				// software mixed output, the channels bypass OpenAL while this is open
+	int						waveSpeakers;
+	int						waveGame44kHz;			// listener game time the wave clock was last synced to
+	int						waveSamples;			// sample frames written
+	int						waveStartTime;
+	int						waveMixTime;			// msec spent mixing
+	bool					waveMixerOnly;			// the wave file brought up the mixer without OpenAL
+
 	int						meterTops[256];
 	int						meterTopsTime[256];
 
@@ -760,6 +778,8 @@ public:
 	static idCVar			s_realTimeDecoding;
 	static idCVar			s_useEAXReverb;
 	static idCVar			s_decompressionLimit;
+	static idCVar			s_decodeAhead;
+	static idCVar			s_decodeCacheBlocks;
 
 	static idCVar			s_slowAttenuate;
 
@@ -834,6 +854,9 @@ public:
 	static void				Free( idSampleDecoder *decoder );
 	static int				GetNumUsedBlocks( void );
 	static int				GetUsedBlockMemory( void );
+	static void				DecodeAhead( void );
+	static void				PurgeSample( const idSoundSample *sample );
+	static void				PrintStats( void );
 
 	virtual					~idSampleDecoder( void ) {}
 	virtual void			Decode( idSoundSample *sample, int sampleOffset44k, int sampleCount44k, float *dest ) = 0;
@@ -27,6 +27,8 @@ If you have questions concerning this license or the applicable additional terms
 */
 
 #include "sys/platform.h"
+#include "framework/FileSystem.h"
+#include "framework/Profiler.h"
 
 #include "sound/snd_local.h"
 
@@ -65,6 +67,8 @@ idCVar idSoundSystemLocal::s_reverbFeedback( "s_reverbFeedback", "0.333", CVAR_S
 idCVar idSoundSystemLocal::s_enviroSuitVolumeScale( "s_enviroSuitVolumeScale", "0.9", CVAR_SOUND | CVAR_FLOAT, "" );
 idCVar idSoundSystemLocal::s_skipHelltimeFX( "s_skipHelltimeFX", "0", CVAR_SOUND | CVAR_BOOL, "" );
 idCVar idSoundSystemLocal::s_decompressionLimit( "s_decompressionLimit", "6", CVAR_SOUND | CVAR_INTEGER | CVAR_ARCHIVE, "specifies maximum uncompressed sample length in seconds" );
+idCVar idSoundSystemLocal::s_decodeAhead( "s_decodeAhead", "2", CVAR_SOUND | CVAR_INTEGER, "number of blocks decoded ahead of each streaming OGG channel between mixes" );
+idCVar idSoundSystemLocal::s_decodeCacheBlocks( "s_decodeCacheBlocks", "64", CVAR_SOUND | CVAR_INTEGER | CVAR_INIT, "number of decoded OGG blocks shared between channels, 0 disables the cache" );
 
 #ifdef NOEFX
 idCVar idSoundSystemLocal::s_useEAXReverb( "s_useEAXReverb", "0", CVAR_SOUND | CVAR_BOOL | CVAR_ROM, "EFX not available in this build" );
@@ -236,6 +240,7 @@ void ListSoundDecoders_f( const idCmdArgs &args ) {
 	common->Printf( "%d waiting decoders\n", numWaitingDecoders );
 	common->Printf( "%d active decoders\n", numActiveDecoders );
 	common->Printf( "%d kB decoder memory in %d blocks\n", idSampleDecoder::GetUsedBlockMemory() >> 10, idSampleDecoder::GetNumUsedBlocks() );
+	idSampleDecoder::PrintStats();
 }
 
 /*
@@ -273,45 +278,12 @@ void SoundSystemRestart_f( const idCmdArgs &args ) {
 
 /*
 ===============
-idSoundSystemLocal::Init
+idSoundSystemLocal::InitOpenAL
 
-initialize the sound system
+opens the OpenAL device and context and allocates the hardware voices
 ===============
 */
-void idSoundSystemLocal::Init() {
-	common->Printf( "----- Initializing OpenAL -----\n" );
-
-	isInitialized = false;
-	muted = false;
-	shutdown = false;
-
-	currentSoundWorld = NULL;
-	soundCache = NULL;
-
-	olddwCurrentWritePos = 0;
-	buffers = 0;
-	CurrentSoundTime = 0;
-
-	nextWriteBlock = 0xffffffff;
-
-	memset( meterTops, 0, sizeof( meterTops ) );
-	memset( meterTopsTime, 0, sizeof( meterTopsTime ) );
-
-	for( int i = -600; i < 600; i++ ) {
-		float pt = i * 0.1f;
-		volumesDB[i+600] = pow( 2.0f,( pt * ( 1.0f / 6.0f ) ) );
-	}
-
-	// make a 16 byte aligned finalMixBuffer
-	finalMixBuffer = (float *) ( ( ( (intptr_t)realAccum ) + 15 ) & ~15 );
-
-	graph = NULL;
-
-	if ( !s_noSound.GetBool() ) {
-		idSampleDecoder::Init();
-		soundCache = new idSoundCache();
-	}
-
+void idSoundSystemLocal::InitOpenAL( void ) {
 	// set up openal device and context
 	common->Printf( "Setup OpenAL device and context\n" );
 
@@ -432,6 +404,65 @@ void idSoundSystemLocal::Init() {
 
 	// adjust source count to allow for at least eight stereo sounds to play
 	openalSourceCount -= 8;
+}
+
+/*
+===============
+idSoundSystemLocal::Init
+
+initialize the sound system
+===============
+*/
+void idSoundSystemLocal::Init() {
+	common->Printf( "----- Initializing OpenAL -----\n" );
+
+	isInitialized = false;
+	muted = false;
+	shutdown = false;
+
+	currentSoundWorld = NULL;
+	soundCache = NULL;
+
+	olddwCurrentWritePos = 0;
+	buffers = 0;
+	CurrentSoundTime = 0;
+
+	nextWriteBlock = 0xffffffff;
+
+	waveFile = NULL;
+	waveSpeakers = 0;
+	waveGame44kHz = -1;
+	waveSamples = 0;
+	waveStartTime = 0;
+	waveMixTime = 0;
+	waveMixerOnly = false;
+
+	memset( meterTops, 0, sizeof( meterTops ) );
+	memset( meterTopsTime, 0, sizeof( meterTopsTime ) );
+
+	for( int i = -600; i < 600; i++ ) {
+		float pt = i * 0.1f;
+		volumesDB[i+600] = pow( 2.0f,( pt * ( 1.0f / 6.0f ) ) );
+	}
+
+	// make a 16 byte aligned finalMixBuffer
+	finalMixBuffer = (float *) ( ( ( (intptr_t)realAccum ) + 15 ) & ~15 );
+
+	graph = NULL;
+
+	if ( !s_noSound.GetBool() ) {
+		idSampleDecoder::Init();
+		soundCache = new idSoundCache();
+	}
+
+	openalDevice = NULL;
+	openalContext = NULL;
+	openalSourceCount = 0;
+
+	// with s_noSound the device is never opened, dedicated servers force it
+	if ( !s_noSound.GetBool() ) {
+		InitOpenAL();
+	}
 
 #ifdef NOEFX
 #else
@@ -463,7 +494,9 @@ void idSoundSystemLocal::Shutdown() {
 #endif
 
 	// adjust source count back up to allow for freeing of all resources
-	openalSourceCount += 8;
+	if ( openalContext ) {
+		openalSourceCount += 8;
+	}
 
 	for ( ALsizei i = 0; i < openalSourceCount; i++ ) {
 		// stop source
@@ -486,13 +519,17 @@ void idSoundSystemLocal::Shutdown() {
 	soundCache = NULL;
 
 	// destroy openal device and context
-	alcMakeContextCurrent( NULL );
+	if ( openalContext ) {
+		alcMakeContextCurrent( NULL );
 
-	alcDestroyContext( openalContext );
-	openalContext = NULL;
+		alcDestroyContext( openalContext );
+		openalContext = NULL;
+	}
 
-	alcCloseDevice( openalDevice );
-	openalDevice = NULL;
+	if ( openalDevice ) {
+		alcCloseDevice( openalDevice );
+		openalDevice = NULL;
+	}
 
 	idSampleDecoder::Shutdown();
 }
@@ -511,7 +548,8 @@ bool idSoundSystemLocal::InitHW() {
 		s_numberOfSpeakers.SetInteger(numSpeakers);
 	}
 
-	if ( s_noSound.GetBool() ) {
+	// without a device only the wave writer can mix
+	if ( s_noSound.GetBool() || !openalContext ) {
 		return false;
 	}
 
@@ -534,6 +572,8 @@ bool idSoundSystemLocal::ShutdownHW() {
 		return false;
 	}
 
+	StopWritingWave();
+
 	shutdown = true;		// don't do anything at AsyncUpdate() time
 	Sys_Sleep( 100 );		// sleep long enough to make sure any async sound talking to hardware has returned
 
@@ -573,7 +613,8 @@ Mac OSX version. The system uses it's own thread and an IOProc callback
 int idSoundSystemLocal::AsyncMix( int soundTime, float *mixBuffer ) {
 	int	inTime, numSpeakers;
 
-	if ( !isInitialized || shutdown ) {
+	// the wave writer owns the sound clock while it is open
+	if ( !isInitialized || shutdown || waveFile ) {
 		return 0;
 	}
 
@@ -598,7 +639,8 @@ called from async sound thread when com_asyncSound == 1 ( Windows )
 */
 int idSoundSystemLocal::AsyncUpdate( int inTime ) {
 
-	if ( !isInitialized || shutdown ) {
+	// the wave writer owns the sound clock while it is open
+	if ( !isInitialized || shutdown || waveFile ) {
 		return 0;
 	}
 
@@ -614,6 +656,8 @@ int idSoundSystemLocal::AsyncUpdate( int inTime ) {
 	}
 
 	if ( dwCurrentBlock != nextWriteBlock ) {
+		// use the time between mixes to decode the streams ahead
+		idSampleDecoder::DecodeAhead();
 		return 0;
 	}
 
@@ -677,7 +721,8 @@ called by the sound thread when com_asyncSound is 3 ( Linux )
 */
 int idSoundSystemLocal::AsyncUpdateWrite( int inTime ) {
 
-	if ( !isInitialized || shutdown ) {
+	// the wave writer owns the sound clock while it is open
+	if ( !isInitialized || shutdown || waveFile ) {
 		return 0;
 	}
 
@@ -688,6 +733,8 @@ int idSoundSystemLocal::AsyncUpdateWrite( int inTime ) {
 	}
 
 	if ( dwCurrentBlock < nextWriteBlock ) {
+		// use the time between mixes to decode the streams ahead
+		idSampleDecoder::DecodeAhead();
 		return 0;
 	}
 
@@ -716,6 +763,175 @@ int idSoundSystemLocal::AsyncUpdateWrite( int inTime ) {
 	return Sys_Milliseconds() - inTime;
 }
 
+/*
+===================
+S_WriteWaveHeader
+===================
+*/
+static void S_WriteWaveHeader( idFile *f, int numSpeakers, int numSamples ) {
+	int dataSize = numSamples * numSpeakers * sizeof( short );
+
+	f->Write( "RIFF", 4 );
+	f->WriteInt( 36 + dataSize );
+	f->Write( "WAVE", 4 );
+	f->Write( "fmt ", 4 );
+	f->WriteInt( 16 );
+	f->WriteShort( WAVE_FORMAT_TAG_PCM );
+	f->WriteShort( numSpeakers );
+	f->WriteInt( PRIMARYFREQ );
+	f->WriteInt( PRIMARYFREQ * numSpeakers * sizeof( short ) );
+	f->WriteShort( numSpeakers * sizeof( short ) );
+	f->WriteShort( 16 );
+	f->Write( "data", 4 );
+	f->WriteInt( dataSize );
+}
+
+/*
+===================
+idSoundSystemLocal::StartWritingWave
+
+While the wave file is open every channel goes through the software mixing
+path in AddChannelContribution instead of OpenAL, and the sound clock is
+advanced from the listener game time by UpdateWave.  Nothing depends on the
+audio device or the wall clock, so a timedemo renders its audio as fast as
+it can run, and the same demo always produces the same samples.
+
+Without an OpenAL device, or with s_noSound set, the mixer is brought up
+for as long as the file is open.  Sound shaders parsed before that have
+no samples, so they are parsed again the next time they are used.
+===================
+*/
+bool idSoundSystemLocal::StartWritingWave( const char *fileName ) {
+	StopWritingWave();
+
+	if ( !isInitialized ) {
+		if ( !soundCache ) {
+			idSampleDecoder::Init();
+			soundCache = new idSoundCache();
+
+			for ( int i = 0; i < declManager->GetNumDecls( DECL_SOUND ); i++ ) {
+				const_cast<idDecl *>( declManager->DeclByIndex( DECL_SOUND, i, false ) )->Invalidate();
+			}
+		}
+		isInitialized = true;
+		shutdown = false;
+		waveMixerOnly = true;
+	}
+
+	idStr name = fileName;
+	name.DefaultFileExtension( ".wav" );
+
+	waveFile = fileSystem->OpenFileWrite( name );
+	if ( !waveFile ) {
+		common->Warning( "StartWritingWave: couldn't open %s", name.c_str() );
+		if ( waveMixerOnly ) {
+			isInitialized = false;
+			waveMixerOnly = false;
+		}
+		return false;
+	}
+
+	// the sample count is patched in when the file is closed
+	waveSpeakers = s_numberOfSpeakers.GetInteger();
+	S_WriteWaveHeader( waveFile, waveSpeakers, 0 );
+
+	waveGame44kHz = -1;
+	waveSamples = 0;
+	waveStartTime = Sys_Milliseconds();
+	waveMixTime = 0;
+
+	// anything still playing through OpenAL continues in software
+	for ( int i = 0; i < openalSourceCount; i++ ) {
+		if ( openalSources[i].inUse && openalSources[i].chan ) {
+			openalSources[i].chan->ALStop();
+		}
+	}
+
+	common->Printf( "writing %s\n", waveFile->GetName() );
+
+	return true;
+}
+
+/*
+===================
+idSoundSystemLocal::StopWritingWave
+===================
+*/
+void idSoundSystemLocal::StopWritingWave( void ) {
+	if ( !waveFile ) {
+		return;
+	}
+
+	waveFile->Seek( 0, FS_SEEK_SET );
+	S_WriteWaveHeader( waveFile, waveSpeakers, waveSamples );
+
+	float audioSeconds = waveSamples / (float)PRIMARYFREQ;
+	float totalSeconds = ( Sys_Milliseconds() - waveStartTime ) * 0.001f;
+	common->Printf( "wrote %s: %3.1f seconds of audio in %3.1f seconds (%i msec mixing), %3.1fx realtime\n",
+		waveFile->GetName(), audioSeconds, totalSeconds, waveMixTime, totalSeconds > 0.0f ? audioSeconds / totalSeconds : 0.0f );
+
+	fileSystem->CloseFile( waveFile );
+	waveFile = NULL;
+
+	// the sound cache stays, it is freed with the sound system
+	if ( waveMixerOnly ) {
+		isInitialized = false;
+		waveMixerOnly = false;
+	}
+
+	// resync with the device clock
+	nextWriteBlock = 0xffffffff;
+}
+
+/*
+===================
+idSoundSystemLocal::UpdateWave
+
+Mixes and writes whole blocks until the sound clock has caught up with the
+listener game time.  Called by the playing sound world when the listener
+is placed.
+===================
+*/
+void idSoundSystemLocal::UpdateWave( int game44kHz ) {
+	short samples[MIXBUFFER_SAMPLES*6];
+
+	if ( !waveFile ) {
+		return;
+	}
+
+	PROFILE_SCOPE( "Sound_UpdateWave" );
+
+	// a level load or a skipped cinematic jumps the game time, don't write the gap as silence
+	if ( waveGame44kHz < 0 || game44kHz < waveGame44kHz || game44kHz - waveGame44kHz > PRIMARYFREQ ) {
+		waveGame44kHz = game44kHz;
+		return;
+	}
+
+	int inTime = Sys_Milliseconds();
+
+	while ( game44kHz - waveGame44kHz >= MIXBUFFER_SAMPLES ) {
+		int sampleTime = CurrentSoundTime + MIXBUFFER_SAMPLES;
+
+		soundStats.runs++;
+		soundStats.activeSounds = 0;
+
+		// unlike the device path this doesn't honor muted, timedemos mute the device
+		SIMDProcessor->Memset( finalMixBuffer, 0, MIXBUFFER_SAMPLES * waveSpeakers * sizeof( float ) );
+		if ( currentSoundWorld ) {
+			currentSoundWorld->MixLoop( sampleTime, waveSpeakers, finalMixBuffer );
+		}
+		SIMDProcessor->MixedSoundToSamples( samples, finalMixBuffer, MIXBUFFER_SAMPLES * waveSpeakers );
+
+		waveFile->Write( samples, MIXBUFFER_SAMPLES * waveSpeakers * sizeof( short ) );
+		waveSamples += MIXBUFFER_SAMPLES;
+
+		CurrentSoundTime = sampleTime;
+		waveGame44kHz += MIXBUFFER_SAMPLES;
+	}
+
+	waveMixTime += Sys_Milliseconds() - inTime;
+}
+
 /*
 ===================
 idSoundSystemLocal::dB2Scale
@@ -1259,9 +1475,7 @@ void idSoundSystemLocal::DoEnviroSuit( float* samples, int numSamples, int numSp
 	float out[10000], *out_p = out + 2;
 	float in[10000], *in_p = in + 2;
 
-	// TODO port to OpenAL
-	assert( false );
-
+	// only the software mixer runs this, OpenAL output has no enviro suit filter
 	if ( !fxList.Num() ) {
 		for ( int i = 0; i < 6; i++ ) {
 			SoundFX* fx;
@@ -29,6 +29,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "sys/platform.h"
 #include "framework/FileSystem.h"
 #include "framework/Session.h"
+#include "framework/Profiler.h"
 #include "renderer/RenderWorld.h"
 
 #include "sound/snd_local.h"
@@ -467,55 +468,60 @@ void idSoundWorldLocal::MixLoop( int current44kHz, int numSpeakers, float *final
 
 	// if noclip flying outside the world, leave silence
 	if ( listenerArea == -1 ) {
-		alListenerf( AL_GAIN, 0.0f );
+		if ( !soundSystemLocal.waveFile ) {
+			alListenerf( AL_GAIN, 0.0f );
+		}
 		return;
 	}
 
-	// update the listener position and orientation
-	ALfloat listenerPosition[3];
+	// the software mixer spatializes each channel itself
+	if ( !soundSystemLocal.waveFile ) {
+		// update the listener position and orientation
+		ALfloat listenerPosition[3];
 
-	listenerPosition[0] = -listenerPos.y;
-	listenerPosition[1] =  listenerPos.z;
-	listenerPosition[2] = -listenerPos.x;
+		listenerPosition[0] = -listenerPos.y;
+		listenerPosition[1] =  listenerPos.z;
+		listenerPosition[2] = -listenerPos.x;
 
-	ALfloat listenerOrientation[6];
+		ALfloat listenerOrientation[6];
 
-	listenerOrientation[0] = -listenerAxis[0].y;
-	listenerOrientation[1] =  listenerAxis[0].z;
-	listenerOrientation[2] = -listenerAxis[0].x;
+		listenerOrientation[0] = -listenerAxis[0].y;
+		listenerOrientation[1] =  listenerAxis[0].z;
+		listenerOrientation[2] = -listenerAxis[0].x;
 
-	listenerOrientation[3] = -listenerAxis[2].y;
-	listenerOrientation[4] =  listenerAxis[2].z;
-	listenerOrientation[5] = -listenerAxis[2].x;
+		listenerOrientation[3] = -listenerAxis[2].y;
+		listenerOrientation[4] =  listenerAxis[2].z;
+		listenerOrientation[5] = -listenerAxis[2].x;
 
-	alListenerf( AL_GAIN, 1.0f );
-	alListenerfv( AL_POSITION, listenerPosition );
-	alListenerfv( AL_ORIENTATION, listenerOrientation );
+		alListenerf( AL_GAIN, 1.0f );
+		alListenerfv( AL_POSITION, listenerPosition );
+		alListenerfv( AL_ORIENTATION, listenerOrientation );
 
 #ifdef NOEFX
 #else
-	if (idSoundSystemLocal::useEFXReverb && soundSystemLocal.efxloaded) {
-		ALuint effect = 0;
-		idStr s(listenerArea);
-
-		bool found = soundSystemLocal.EFXDatabase.FindEffect(s, &effect);
-		if (!found) {
-			s = listenerAreaName;
-			found = soundSystemLocal.EFXDatabase.FindEffect(s, &effect);
-		}
-		if (!found) {
-			s = "default";
-			found = soundSystemLocal.EFXDatabase.FindEffect(s, &effect);
-		}
+		if (idSoundSystemLocal::useEFXReverb && soundSystemLocal.efxloaded) {
+			ALuint effect = 0;
+			idStr s(listenerArea);
+
+			bool found = soundSystemLocal.EFXDatabase.FindEffect(s, &effect);
+			if (!found) {
+				s = listenerAreaName;
+				found = soundSystemLocal.EFXDatabase.FindEffect(s, &effect);
+			}
+			if (!found) {
+				s = "default";
+				found = soundSystemLocal.EFXDatabase.FindEffect(s, &effect);
+			}
 
-		// only update if change in settings
-		if (found && listenerEffect != effect) {
-			EFXprintf("Switching to EFX '%s' (#%u)\n", s.c_str(), effect);
-			listenerEffect = effect;
-			soundSystemLocal.alAuxiliaryEffectSloti(listenerSlot, AL_EFFECTSLOT_EFFECT, effect);
+			// only update if change in settings
+			if (found && listenerEffect != effect) {
+				EFXprintf("Switching to EFX '%s' (#%u)\n", s.c_str(), effect);
+				listenerEffect = effect;
+				soundSystemLocal.alAuxiliaryEffectSloti(listenerSlot, AL_EFFECTSLOT_EFFECT, effect);
+			}
 		}
-	}
 #endif
+	}
 
 	// debugging option to mute all but a single soundEmitter
 	if ( idSoundSystemLocal::s_singleEmitter.GetInteger() > 0 && idSoundSystemLocal::s_singleEmitter.GetInteger() < emitters.Num() ) {
@@ -562,8 +568,8 @@ void idSoundWorldLocal::MixLoop( int current44kHz, int numSpeakers, float *final
 		}
 	}
 
-	// TODO port to OpenAL
-	if ( false && enviroSuitActive ) {
+	// OpenAL output has no enviro suit filter, only the software mix gets it
+	if ( soundSystemLocal.waveFile && enviroSuitActive ) {
 		soundSystemLocal.DoEnviroSuit( finalMixBuffer, MIXBUFFER_SAMPLES, numSpeakers );
 	}
 }
@@ -767,8 +773,6 @@ void idSoundWorldLocal::PlaceListener( const idVec3& origin, const idMat3& axis,
 		writeDemo->WriteInt( gameTime );
 	}
 
-	current44kHzTime = soundSystemLocal.GetCurrent44kHzTime();
-
 	// we usually expect gameTime to be increasing by 16 or 32 msec, but when
 	// a cinematic is fast-forward skipped through, it can jump by a significant
 	// amount, while the hardware 44kHz position will not have changed accordingly,
@@ -782,6 +786,13 @@ void idSoundWorldLocal::PlaceListener( const idVec3& origin, const idMat3& axis,
 	// the normal 16 msec / frame
 	game44kHz = idMath::FtoiFast( gameMsec * 0.001f * 44100.0f );
 
+	// when writing a wave file the sound clock follows the game time
+	if ( soundSystemLocal.currentSoundWorld == this ) {
+		soundSystemLocal.UpdateWave( game44kHz );
+	}
+
+	current44kHzTime = soundSystemLocal.GetCurrent44kHzTime();
+
 
 	listenerPrivateId = listenerId;
 
@@ -817,6 +828,8 @@ void idSoundWorldLocal::ForegroundUpdate( int current44kHzTime ) {
 		return;
 	}
 
+	PROFILE_SCOPE( "Sound_ForegroundUpdate" );
+
 	Sys_EnterCriticalSection();
 
 	//
@@ -1570,7 +1583,7 @@ void idSoundWorldLocal::AddChannelContribution( idSoundEmitterLocal *sound, idSo
 	//
 	// allocate and initialize hardware source
 	//
-	if ( sound->removeStatus < REMOVE_STATUS_SAMPLEFINISHED ) {
+	if ( sound->removeStatus < REMOVE_STATUS_SAMPLEFINISHED && !soundSystemLocal.waveFile ) {
 		if ( !alIsSource( chan->openalSource ) ) {
 			chan->openalSource = soundSystemLocal.AllocOpenALSource( chan, !chan->leadinSample->hardwareBuffer || !chan->soundShader->entries[0]->hardwareBuffer || looping, chan->leadinSample->objectInfo.nChannels == 2 );
 		}
@@ -335,6 +335,12 @@ public:
 
 	// is EFX support present - -1: disabled at compile time, 0: no suitable hardware, 1: ok
 	virtual int				IsEFXAvailable( void ) = 0;
+
+	// mixes the playing sound world in software and writes it to a wave file,
+	// with the sound clock following the listener game time instead of the device
+	virtual bool			StartWritingWave( const char *fileName ) = 0;
+	virtual void			StopWritingWave( void ) = 0;
+	virtual bool			IsWritingWave( void ) const = 0;
 };
 
 extern idSoundSystem	*soundSystem;
@@ -273,7 +273,8 @@ GLimp_SetGamma
 */
 void GLimp_SetGamma(unsigned short red[256], unsigned short green[256], unsigned short blue[256]) {
   if (!window) {
-    common->Warning("GLimp_SetGamma called without window");
+    if (!r_headless.GetBool())
+      common->Warning("GLimp_SetGamma called without window");
     return;
   }
 
@@ -310,7 +311,8 @@ void GLimp_GrabInput(int flags) {
     grab = false;
 
   if (!window) {
-    common->Warning("GLimp_GrabInput called without window");
+    if (!r_headless.GetBool())
+      common->Warning("GLimp_GrabInput called without window");
     return;
   }
 
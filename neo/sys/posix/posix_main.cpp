@@ -321,6 +321,44 @@ ID_TIME_T Sys_FileTimeStamp(FILE * fp) {
 	return st.st_mtime;
 }
 
+/*
+================
+Sys_MapFile
+
+Emscripten emulates mmap by copying the file into the heap, which would
+double the memory used by the paks, so it never maps.
+================
+*/
+const void *Sys_MapFile( FILE *fp, int length ) {
+#ifdef __EMSCRIPTEN__
+	return NULL;
+#else
+	void *data;
+
+	if ( length <= 0 ) {
+		return NULL;
+	}
+	data = mmap( NULL, length, PROT_READ, MAP_SHARED, fileno( fp ), 0 );
+	if ( data == MAP_FAILED ) {
+		return NULL;
+	}
+	return data;
+#endif
+}
+
+/*
+================
+Sys_UnmapFile
+================
+*/
+void Sys_UnmapFile( const void *data, int length ) {
+#ifndef __EMSCRIPTEN__
+	if ( data ) {
+		munmap( const_cast<void *>( data ), length );
+	}
+#endif
+}
+
 char *Sys_GetClipboardData(void) {
 	Sys_Printf( "TODO: Sys_GetClipboardData\n" );
 	return NULL;
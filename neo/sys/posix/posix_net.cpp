@@ -407,6 +407,10 @@ idPort::idPort
 idPort::idPort() {
 	netSocket = 0;
 	memset( &bound_to, 0, sizeof( bound_to ) );
+	packetsRead = 0;
+	bytesRead = 0;
+	packetsWritten = 0;
+	bytesWritten = 0;
 }
 
 /*
@@ -461,6 +465,8 @@ bool idPort::GetPacket( netadr_t &net_from, void *data, int &size, int maxSize )
 
 	SockadrToNetadr( &from, &net_from );
 	size = ret;
+	packetsRead++;
+	bytesRead += ret;
 	return true;
 }
 
@@ -513,6 +519,8 @@ bool idPort::GetPacketBlocking( netadr_t &net_from, void *data, int &size, int m
 	assert( ret < maxSize );
 	SockadrToNetadr( &from, &net_from );
 	size = ret;
+	packetsRead++;
+	bytesRead += ret;
 	return true;
 }
 
@@ -539,7 +547,10 @@ void idPort::SendPacket( const netadr_t to, const void *data, int size ) {
 	ret = sendto( netSocket, data, size, 0, (struct sockaddr *) &addr, sizeof(addr) );
 	if ( ret == -1 ) {
 		common->Printf( "idPort::SendPacket ERROR: to %s: %s\n", Sys_NetAdrToString( to ), strerror( errno ) );
+		return;
 	}
+	packetsWritten++;
+	bytesWritten += ret;
 }
 
 /*
@@ -0,0 +1,97 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// The dedicated server links this instead of OpenAL.  InitGame forces
+// s_noSound there, so the sound system never opens a device and none of
+// these is expected to succeed.
+
+#include <AL/al.h>
+#include <AL/alc.h>
+
+#include <stddef.h>
+
+AL_API ALenum AL_APIENTRY alGetError( void ) {
+	return AL_INVALID_OPERATION;
+}
+
+AL_API const ALchar * AL_APIENTRY alGetString( ALenum param ) {
+	return "";
+}
+
+AL_API void * AL_APIENTRY alGetProcAddress( const ALchar *fname ) {
+	return NULL;
+}
+
+AL_API void AL_APIENTRY alGenBuffers( ALsizei n, ALuint *buffers ) { }
+AL_API void AL_APIENTRY alDeleteBuffers( ALsizei n, const ALuint *buffers ) { }
+AL_API ALboolean AL_APIENTRY alIsBuffer( ALuint buffer ) {
+	return AL_FALSE;
+}
+AL_API void AL_APIENTRY alBufferData( ALuint buffer, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq ) { }
+
+AL_API void AL_APIENTRY alGenSources( ALsizei n, ALuint *sources ) { }
+AL_API void AL_APIENTRY alDeleteSources( ALsizei n, const ALuint *sources ) { }
+AL_API ALboolean AL_APIENTRY alIsSource( ALuint source ) {
+	return AL_FALSE;
+}
+AL_API void AL_APIENTRY alSourcef( ALuint source, ALenum param, ALfloat value ) { }
+AL_API void AL_APIENTRY alSourcei( ALuint source, ALenum param, ALint value ) { }
+AL_API void AL_APIENTRY alSource3f( ALuint source, ALenum param, ALfloat value1, ALfloat value2, ALfloat value3 ) { }
+AL_API void AL_APIENTRY alSource3i( ALuint source, ALenum param, ALint value1, ALint value2, ALint value3 ) { }
+AL_API void AL_APIENTRY alGetSourcei( ALuint source, ALenum param, ALint *value ) {
+	*value = 0;
+}
+AL_API void AL_APIENTRY alSourcePlay( ALuint source ) { }
+AL_API void AL_APIENTRY alSourceStop( ALuint source ) { }
+AL_API void AL_APIENTRY alSourceQueueBuffers( ALuint source, ALsizei nb, const ALuint *buffers ) { }
+AL_API void AL_APIENTRY alSourceUnqueueBuffers( ALuint source, ALsizei nb, ALuint *buffers ) { }
+
+AL_API void AL_APIENTRY alListenerf( ALenum param, ALfloat value ) { }
+AL_API void AL_APIENTRY alListenerfv( ALenum param, const ALfloat *values ) { }
+
+ALC_API ALCdevice * ALC_APIENTRY alcOpenDevice( const ALCchar *devicename ) {
+	return NULL;
+}
+ALC_API ALCboolean ALC_APIENTRY alcCloseDevice( ALCdevice *device ) {
+	return ALC_FALSE;
+}
+ALC_API ALCcontext * ALC_APIENTRY alcCreateContext( ALCdevice *device, const ALCint *attrlist ) {
+	return NULL;
+}
+ALC_API void ALC_APIENTRY alcDestroyContext( ALCcontext *context ) { }
+ALC_API ALCboolean ALC_APIENTRY alcMakeContextCurrent( ALCcontext *context ) {
+	return ALC_FALSE;
+}
+ALC_API void ALC_APIENTRY alcProcessContext( ALCcontext *context ) { }
+ALC_API void ALC_APIENTRY alcSuspendContext( ALCcontext *context ) { }
+ALC_API const ALCchar * ALC_APIENTRY alcGetString( ALCdevice *device, ALCenum param ) {
+	return "";
+}
+ALC_API ALCboolean ALC_APIENTRY alcIsExtensionPresent( ALCdevice *device, const ALCchar *extname ) {
+	return ALC_FALSE;
+}
@@ -0,0 +1,64 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// The dedicated server links this instead of libvorbisfile.  Without a
+// sound cache no sample is ever loaded, so nothing gets decoded.
+
+#define OV_EXCLUDE_STATIC_CALLBACKS
+#include <vorbis/codec.h>
+#include <vorbis/vorbisfile.h>
+
+#include <stddef.h>
+
+int ov_open_callbacks( void *datasource, OggVorbis_File *vf, const char *initial, long ibytes, ov_callbacks callbacks ) {
+	return OV_EFAULT;
+}
+
+int ov_clear( OggVorbis_File *vf ) {
+	return 0;
+}
+
+vorbis_info *ov_info( OggVorbis_File *vf, int link ) {
+	return NULL;
+}
+
+ogg_int64_t ov_pcm_total( OggVorbis_File *vf, int i ) {
+	return OV_EINVAL;
+}
+
+int ov_pcm_seek( OggVorbis_File *vf, ogg_int64_t pos ) {
+	return OV_EINVAL;
+}
+
+long ov_read( OggVorbis_File *vf, char *buffer, int length, int bigendianp, int word, int sgned, int *bitstream ) {
+	return OV_EINVAL;
+}
+
+long ov_read_float( OggVorbis_File *vf, float ***pcm_channels, int samples, int *bitstream ) {
+	return OV_EINVAL;
+}
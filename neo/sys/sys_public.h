@@ -119,6 +119,9 @@ void			Sys_Sleep( int msec );
 // any game related timing information should come from event timestamps
 unsigned int	Sys_Milliseconds( void );
 
+// wraps after about 71 minutes, only use it for measuring short intervals
+unsigned int	Sys_Microseconds( void );
+
 // returns a selection of the CPUID_* flags
 int				Sys_GetProcessorId( void );
 
@@ -188,6 +191,10 @@ void			Sys_ShowConsole( int visLevel, bool quitOnClose );
 
 void			Sys_Mkdir( const char *path );
 ID_TIME_T			Sys_FileTimeStamp( FILE *fp );
+// maps a whole file read-only into memory, NULL if it can't be done on this platform
+// the mapping stays valid after the FILE is closed
+const void *	Sys_MapFile( FILE *fp, int length );
+void			Sys_UnmapFile( const void *data, int length );
 // NOTE: do we need to guarantee the same output on all platforms?
 const char *	Sys_TimeStampToStr( ID_TIME_T timeStamp );
 
@@ -308,13 +315,15 @@ const char *		Sys_GetThreadName( int *index = 0 );
 extern void Sys_InitThreads();
 extern void Sys_ShutdownThreads();
 
-const int MAX_CRITICAL_SECTIONS		= 5;
+const int MAX_CRITICAL_SECTIONS		= 7;
 
 enum {
 	CRITICAL_SECTION_ZERO = 0,
 	CRITICAL_SECTION_ONE,
 	CRITICAL_SECTION_TWO,
 	CRITICAL_SECTION_THREE,
+	CRITICAL_SECTION_FOUR,
+	CRITICAL_SECTION_FIVE,
 	CRITICAL_SECTION_SYS
 };
 
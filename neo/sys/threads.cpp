@@ -93,6 +93,30 @@ unsigned int Sys_Milliseconds() {
 #endif
 }
 
+/*
+================
+Sys_Microseconds
+================
+*/
+unsigned int Sys_Microseconds() {
+#ifdef NOMT
+  static struct timeval start;
+  static const bool   started = InitTicks(&start);
+
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  const Uint32 ticks=(now.tv_sec-start.tv_sec)*1000000+(now.tv_usec-start.tv_usec);
+  return(ticks);
+#elif SDL_VERSION_ATLEAST(2, 0, 0)
+	static const Uint64 start = SDL_GetPerformanceCounter();
+	static const Uint64 frequency = SDL_GetPerformanceFrequency();
+
+	return (unsigned int)( ( SDL_GetPerformanceCounter() - start ) * 1000000 / frequency );
+#else
+	return SDL_GetTicks() * 1000;
+#endif
+}
+
 /*
 ==================
 Sys_InitThreads
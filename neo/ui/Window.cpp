@@ -52,6 +52,12 @@ bool idWindow::registerIsTemporary[MAX_EXPRESSION_REGISTERS];		// statics to ass
 
 idCVar idWindow::gui_debug( "gui_debug", "0", CVAR_GUI | CVAR_BOOL, "" );
 idCVar idWindow::gui_edit( "gui_edit", "0", CVAR_GUI | CVAR_BOOL, "" );
+idCVar idWindow::gui_showExpressions( "gui_showExpressions", "0", CVAR_GUI | CVAR_BOOL, "print the number of gui expression ops evaluated and skipped each frame" );
+
+// per frame expression statistics
+static int guiExpressionFrame;
+static int guiExpressionOps;
+static int guiExpressionOpsSkipped;
 
 extern idCVar r_skipGuiShaders;		// 1 = don't render any gui elements on surfaces
 extern idCVar r_scaleMenusTo43;
@@ -143,6 +149,8 @@ void idWindow::CommonInit() {
 	parent = NULL;
 	saveOps = NULL;
 	saveRegs = NULL;
+	expressionsCompiled = false;
+	lastRegistersValid = false;
 	timeLine = -1;
 	textShadow = 0;
 	hover = false;
@@ -2659,6 +2667,7 @@ wexpOp_t *idWindow::ExpressionOp() {
 	wexpOp_t wop;
 	memset(&wop, 0, sizeof(wexpOp_t));
 	int i = ops.Append(wop);
+	expressionsCompiled = false;
 	return &ops[i];
 }
 
@@ -2920,6 +2929,185 @@ void idWindow::ParseBracedExpression(idParser *src) {
 	src->ExpectTokenString("}");
 }
 
+/*
+================
+R_GuiOpInputs
+
+Returns the registers read by the op.
+================
+*/
+static ID_INLINE int R_GuiOpInputs( const wexpOp_t *op, intptr_t inputs[3] ) {
+	switch( op->opType ) {
+	case WOP_TYPE_VAR:
+		if ( op->b >= 0 ) {
+			inputs[0] = op->b;
+			return 1;
+		}
+		return 0;
+	case WOP_TYPE_VARS:
+	case WOP_TYPE_VARF:
+	case WOP_TYPE_VARI:
+	case WOP_TYPE_VARB:
+		return 0;
+	case WOP_TYPE_TABLE:
+		inputs[0] = op->b;
+		return 1;
+	case WOP_TYPE_COND:
+		inputs[0] = op->a;
+		inputs[1] = op->b;
+		inputs[2] = op->d;
+		return 3;
+	default:
+		inputs[0] = op->a;
+		inputs[1] = op->b;
+		return 2;
+	}
+}
+
+/*
+================
+R_FoldGuiOp
+
+Must match the results of idWindow::EvaluateRegisters.
+================
+*/
+static bool R_FoldGuiOp( const wexpOp_t *op, const float *registers, float &result ) {
+	int b;
+
+	switch( op->opType ) {
+	case WOP_TYPE_ADD:
+		result = registers[op->a] + registers[op->b];
+		return true;
+	case WOP_TYPE_SUBTRACT:
+		result = registers[op->a] - registers[op->b];
+		return true;
+	case WOP_TYPE_MULTIPLY:
+		result = registers[op->a] * registers[op->b];
+		return true;
+	case WOP_TYPE_DIVIDE:
+		// leave the warning to the evaluation
+		if ( registers[op->b] == 0.0f ) {
+			return false;
+		}
+		result = registers[op->a] / registers[op->b];
+		return true;
+	case WOP_TYPE_MOD:
+		b = (int)registers[op->b];
+		b = b != 0 ? b : 1;
+		result = (int)registers[op->a] % b;
+		return true;
+	case WOP_TYPE_GT:
+		result = registers[ op->a ] > registers[op->b];
+		return true;
+	case WOP_TYPE_GE:
+		result = registers[ op->a ] >= registers[op->b];
+		return true;
+	case WOP_TYPE_LT:
+		result = registers[ op->a ] < registers[op->b];
+		return true;
+	case WOP_TYPE_LE:
+		result = registers[ op->a ] <= registers[op->b];
+		return true;
+	case WOP_TYPE_EQ:
+		result = registers[ op->a ] == registers[op->b];
+		return true;
+	case WOP_TYPE_NE:
+		result = registers[ op->a ] != registers[op->b];
+		return true;
+	case WOP_TYPE_COND:
+		result = (registers[ op->a ]) ? registers[op->b] : registers[op->d];
+		return true;
+	case WOP_TYPE_AND:
+		result = registers[ op->a ] && registers[op->b];
+		return true;
+	case WOP_TYPE_OR:
+		result = registers[ op->a ] || registers[op->b];
+		return true;
+	default:
+		// tables can be reloaded and vars change at any time
+		return false;
+	}
+}
+
+/*
+================
+idWindow::CompileExpressions
+
+Folds the ops that only read constants into expressionRegisters, and
+builds the list of ops that EvaluateRegisters still has to run.
+Done on the first evaluation after the ops changed.
+================
+*/
+void idWindow::CompileExpressions() {
+	int			i, j, n;
+	intptr_t	inputs[3];
+
+	int erc = expressionRegisters.Num();
+	int oc = ops.Num();
+
+	idList<bool> constant;
+	idList<bool> readEarly;
+	constant.SetNum( erc );
+	readEarly.SetNum( erc );
+
+	for ( i = 0 ; i < erc ; i++ ) {
+		constant[i] = ( i >= WEXP_REG_NUM_PREDEFINED );
+		readEarly[i] = false;
+	}
+	for ( i = 0 ; i < oc ; i++ ) {
+		constant[ops[i].c] = false;
+	}
+
+	// the else part of a ?: is emitted after the conditional op, so the
+	// conditional reads its register before the op that writes it has run,
+	// folding that op would change the result
+	idList<bool> written;
+	written.SetNum( erc );
+	memset( written.Ptr(), 0, erc * sizeof( bool ) );
+	for ( i = 0 ; i < oc ; i++ ) {
+		n = R_GuiOpInputs( &ops[i], inputs );
+		for ( j = 0 ; j < n ; j++ ) {
+			if ( inputs[j] >= 0 && inputs[j] < erc && !written[inputs[j]] ) {
+				readEarly[inputs[j]] = true;
+			}
+		}
+		written[ops[i].c] = true;
+	}
+
+	evalOps.Clear();
+	for ( i = 0 ; i < oc ; i++ ) {
+		const wexpOp_t *op = &ops[i];
+
+		// var references that FixupParms hasn't resolved yet
+		if ( op->b == -2 ) {
+			continue;
+		}
+
+		if ( !readEarly[op->c] ) {
+			bool allConstant = true;
+			n = R_GuiOpInputs( op, inputs );
+			for ( j = 0 ; j < n ; j++ ) {
+				if ( inputs[j] < 0 || inputs[j] >= erc || !constant[inputs[j]] ) {
+					allConstant = false;
+					break;
+				}
+			}
+			float result;
+			if ( allConstant && R_FoldGuiOp( op, expressionRegisters.Ptr(), result ) ) {
+				expressionRegisters[op->c] = result;
+				constant[op->c] = true;
+				continue;
+			}
+		}
+
+		evalOps.Append( i );
+	}
+
+	lastRegisters.SetNum( erc );
+	lastRegistersValid = false;
+	expressionsCompiled = true;
+}
+
 /*
 ===============
 idWindow::EvaluateRegisters
@@ -2927,15 +3115,35 @@ idWindow::EvaluateRegisters
 Parameters are taken from the localSpace and the renderView,
 then all expressions are evaluated, leaving the shader registers
 set to their apropriate values.
+
+Ops whose input registers didn't change since the previous evaluation of
+this window are not run again, they just restore their previous result.
+Only the var reads and the time register can introduce changes.
 ===============
 */
 void idWindow::EvaluateRegisters(float *registers) {
-	int		i, b;
+	static int	evaluation;
+	static int	changedInEvaluation[MAX_EXPRESSION_REGISTERS];
+	int		i, j, n, b;
+	intptr_t	inputs[3];
 	wexpOp_t	*op;
 	idVec4 v;
 
+	if ( com_frameTime != guiExpressionFrame ) {
+		if ( gui_showExpressions.GetBool() && ( guiExpressionOps || guiExpressionOpsSkipped ) ) {
+			common->Printf( "gui expressionOps:%i  skippedOps:%i\n", guiExpressionOps, guiExpressionOpsSkipped );
+		}
+		guiExpressionFrame = com_frameTime;
+		guiExpressionOps = 0;
+		guiExpressionOpsSkipped = 0;
+	}
+
 	int erc = expressionRegisters.Num();
-	int oc = ops.Num();
+	if ( !expressionsCompiled || lastRegisters.Num() != erc ) {
+		CompileExpressions();
+	}
+
+	int oc = evalOps.Num();
 	// copy the constants
 	for ( i = WEXP_REG_NUM_PREDEFINED ; i < erc ; i++ ) {
 		registers[i] = expressionRegisters[i];
@@ -2944,11 +3152,32 @@ void idWindow::EvaluateRegisters(float *registers) {
 	// copy the local and global parameters
 	registers[WEXP_REG_TIME] = gui->GetTime();
 
+	// a register changed in this evaluation if its entry matches
+	evaluation++;
+	if ( !lastRegistersValid || registers[WEXP_REG_TIME] != lastRegisters[WEXP_REG_TIME] ) {
+		changedInEvaluation[WEXP_REG_TIME] = evaluation;
+		lastRegisters[WEXP_REG_TIME] = registers[WEXP_REG_TIME];
+	}
+
 	for ( i = 0 ; i < oc ; i++ ) {
-		op = &ops[i];
-		if (op->b == -2) {
-			continue;
+		op = &ops[evalOps[i]];
+
+		if ( lastRegistersValid && op->opType != WOP_TYPE_VAR && op->opType != WOP_TYPE_VARS
+			&& op->opType != WOP_TYPE_VARF && op->opType != WOP_TYPE_VARI && op->opType != WOP_TYPE_VARB ) {
+			n = R_GuiOpInputs( op, inputs );
+			for ( j = 0 ; j < n ; j++ ) {
+				if ( changedInEvaluation[inputs[j]] == evaluation ) {
+					break;
+				}
+			}
+			if ( j == n ) {
+				registers[op->c] = lastRegisters[op->c];
+				guiExpressionOpsSkipped++;
+				continue;
+			}
 		}
+		guiExpressionOps++;
+
 		switch( op->opType ) {
 		case WOP_TYPE_ADD:
 			registers[op->c] = registers[op->a] + registers[op->b];
@@ -3053,8 +3282,14 @@ void idWindow::EvaluateRegisters(float *registers) {
 		default:
 			common->FatalError( "R_EvaluateExpression: bad opcode" );
 		}
+
+		if ( !lastRegistersValid || registers[op->c] != lastRegisters[op->c] ) {
+			changedInEvaluation[op->c] = evaluation;
+			lastRegisters[op->c] = registers[op->c];
+		}
 	}
 
+	lastRegistersValid = true;
 }
 
 /*
@@ -3184,6 +3419,7 @@ void idWindow::ReadFromDemoFile( class idDemoFile *f, bool rebuild ) {
 			f->ReadInt( w.d );
 			ops.Append(w);
 		}
+		expressionsCompiled = false;
 
 		f->ReadInt( c );
 		for (i = 0; i < c; i++) {
@@ -3773,6 +4009,7 @@ void idWindow::FixupParms() {
 			ops[i].b = -1;
 		}
 	}
+	expressionsCompiled = false;
 
 
 	if (flags & WIN_DESKTOP) {
@@ -4106,6 +4343,7 @@ bool idWindow::UpdateFromDictionary ( idDict& dict ) {
 	regList.Reset ( );
 	expressionRegisters.Clear ( );
 	ops.Clear ( );
+	expressionsCompiled = false;
 
 	for ( i = 0; i < dict.GetNumKeyVals(); i ++ ) {
 		kv = dict.GetKeyVal ( i );
@@ -361,6 +361,7 @@ protected:
 	intptr_t ParseTerm( idParser *src, idWinVar *var = NULL, intptr_t component = 0 );
 	intptr_t ParseExpressionPriority( idParser *src, int priority, idWinVar *var = NULL, intptr_t component = 0 );
 	void EvaluateRegisters(float *registers);
+	void CompileExpressions();
 	void SaveExpressionParseState();
 	void RestoreExpressionParseState();
 	void ParseBracedExpression(idParser *src);
@@ -434,6 +435,7 @@ protected:
 
 	static idCVar gui_debug;
 	static idCVar gui_edit;
+	static idCVar gui_showExpressions;
 
 	idGuiScriptList *scripts[SCRIPT_COUNT];
 	bool *saveTemps;
@@ -445,6 +447,10 @@ protected:
 
 	idList<wexpOp_t> ops;				// evaluate to make expressionRegisters
 	idList<float> expressionRegisters;
+	idList<int> evalOps;				// ops left after constant folding, built by CompileExpressions
+	idList<float> lastRegisters;		// registers of the previous evaluation, to skip ops with unchanged inputs
+	bool expressionsCompiled;
+	bool lastRegistersValid;
 	idList<wexpOp_t> *saveOps;				// evaluate to make expressionRegisters
 	idList<rvNamedEvent*>		namedEvents;		//  added named events
 	idList<float> *saveRegs;